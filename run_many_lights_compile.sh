@@ -0,0 +1,24 @@
+# Note: You must specify the many lights cpp filename to compile.
+#       e.g., ./run_many_lights_compile.sh ./src/examples/lighting/many_lights/many_lights.cpp
+g++ \
+    ./src/examples/lighting/many_lights/lib/*.cpp \
+    ./deps/imgui/*.cpp \
+    ./deps/imgui/backends/imgui_impl_opengl3.cpp \
+    ./deps/imgui/backends/imgui_impl_glfw.cpp \
+    $1 \
+    ./src/*.c \
+    -o application.exe \
+    -I./include \
+    -I./src/examples/lighting/many_lights/headers \
+    -I./deps/imgui \
+    -I./deps/imgui/backends \
+    -I./deps/glfw/include \
+    -I./deps/assimp/include \
+    -L./deps/glfw/src \
+    -L./deps/assimp/bin \
+    -lglfw3 \
+    -lassimp \
+    -lXrandr \
+    -lXcursor \
+    -lXi \
+    -lXinerama
@@ -0,0 +1,24 @@
+# Note: You must specify the terrain cpp filename to compile.
+#       e.g., ./run_terrain_compile.sh ./src/examples/terrain/terrain_1.cpp
+g++ \
+    ./src/examples/terrain/lib/*.cpp \
+    ./deps/imgui/*.cpp \
+    ./deps/imgui/backends/imgui_impl_opengl3.cpp \
+    ./deps/imgui/backends/imgui_impl_glfw.cpp \
+    $1 \
+    ./src/*.c \
+    -o application.exe \
+    -I./include \
+    -I./src/examples/terrain/headers \
+    -I./deps/imgui \
+    -I./deps/imgui/backends \
+    -I./deps/glfw/include \
+    -I./deps/assimp/include \
+    -L./deps/glfw/src \
+    -L./deps/assimp/bin \
+    -lglfw3 \
+    -lassimp \
+    -lXrandr \
+    -lXcursor \
+    -lXi \
+    -lXinerama
@@ -0,0 +1,388 @@
+#include <glad/glad.h> 
+#include <GLFW/glfw3.h>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#define STB_IMAGE_IMPLEMENTATION
+
+#include "stdlib.h"
+#include <iostream>
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "./headers/shader.hpp"
+#include "./headers/model.hpp"
+#include "./headers/instance_transform.hpp"
+#include "./headers/instance_buffer.hpp"
+#include "./headers/instance_cells.hpp"
+#include "./headers/asteroid_ring.hpp"
+#include "./headers/gl_extensions.hpp"
+#include "../../../../headers/thread_pool.hpp"
+#include "../../../../headers/headless.hpp"
+
+/*
+ * Benchmark of the ways the asteroid demos submit rocks, on a scripted camera path and without a visible window:
+ *   asteroid_field_benchmark [output.csv] [frames per run = 120] [max rocks = 1000000]
+ *
+ * For 1k, 10k, 100k and 1M rocks every strategy draws the same frames:
+ *   per_object        one Model::Draw with a model matrix uniform per rock (asteroid_field_draw_calls)
+ *   instanced         one instanced draw of the whole buffer (asteroid_field_precompute_instances)
+ *   culled_instanced  rocks sorted into cells, one instanced draw per run of visible cells (asteroid_field_impostors)
+ *   indirect          the same visible ranges as indirect commands in one glMultiDrawElementsIndirect
+ * and one CSV row per run records CPU submission time, CPU frame time (submission + glFinish), GPU time from
+ * GL_TIME_ELAPSED queries, and draw calls and triangles per frame.
+ *
+ * Rendering goes to an offscreen framebuffer from a window that is never shown. Without DISPLAY or WAYLAND_DISPLAY,
+ * GLFW 3.4 is started on its null platform with an EGL context as in headless.hpp, so it runs under Mesa's llvmpipe
+ * without a display (LIBGL_ALWAYS_SOFTWARE=1 forces it); older GLFW needs one, Xvfb will do.
+ * Indirect needs GL 4.2 (base instance) and is skipped without it.
+ */
+
+const int FRAMEBUFFER_WIDTH = 1280;
+const int FRAMEBUFFER_HEIGHT = 720;
+
+const size_t ROCK_COUNTS[] = {1000, 10000, 100000, 1000000};
+// One draw call per rock stops being informative (and takes minutes per frame in software) past this.
+const size_t PER_OBJECT_MAX_ROCKS = 100000;
+const int WARMUP_FRAMES = 5;
+// Side of the cells the culled strategies cull by.
+const float CELL_SIZE = 20.0f;
+const uint32_t ASTEROID_SEED = 1;
+
+enum Strategy {
+    PER_OBJECT,
+    INSTANCED,
+    CULLED_INSTANCED,
+    INDIRECT,
+    STRATEGY_COUNT
+};
+
+const char* STRATEGY_NAMES[STRATEGY_COUNT] = {"per_object", "instanced", "culled_instanced", "indirect"};
+
+struct RunResult {
+    double cpuMs = 0.0;
+    double frameMs = 0.0;
+    double gpuMs = 0.0;
+    double drawCalls = 0.0;
+    double triangles = 0.0;
+};
+
+struct Scene {
+    std::vector<PackedInstanceTransform> rocks;   // sorted into cells
+    std::vector<InstanceCell> cells;
+    std::vector<glm::mat4> modelMatrices;         // only for per_object
+};
+
+AsteroidRing asteroidRing;
+ThreadPool asteroidPool;
+float rockRadius = 0.0f;
+
+// Function Declarations.
+void buildScene(size_t rockCount, Scene& scene, InstanceBuffer& instances);
+glm::mat4 cameraPath(int frame, int frameCount, glm::vec3& eye);
+RunResult runStrategy(Strategy strategy, int frameCount, Scene& scene, InstanceBuffer& instances, Shader& rockShader, Shader& objectShader,
+    Model& rockModel, unsigned int indirectBuffer, unsigned int timerQuery);
+
+int main(int argc, char** argv)
+{
+    const char* csvPath = argc > 1 ? argv[1] : "asteroid_benchmark.csv";
+    int frameCount = argc > 2 ? std::max(1, atoi(argv[2])) : 120;
+    size_t maxRocks = argc > 3 ? std::strtoul(argv[3], nullptr, 10) : 1000000;
+
+    // always headless: hidden window, null platform and EGL when there is no display
+    headless.enabled = true;
+    if (!headless.initGlfw())
+    {
+        std::cout << "Failed to initialize GLFW" << std::endl;
+        return -1;
+    }
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+
+    GLFWwindow* window = glfwCreateWindow(FRAMEBUFFER_WIDTH, FRAMEBUFFER_HEIGHT, "Asteroid Benchmark", NULL, NULL);
+    if (window == NULL)
+    {
+        std::cout << "Failed to create GLFW window" << std::endl;
+        glfwTerminate();
+        return -1;
+    }
+    glfwMakeContextCurrent(window);
+
+	if (!gladLoadGLLoader((GLADloadproc) glfwGetProcAddress))
+	{
+		std::cout << "Failed to initialize GLAD" << std::endl;
+		return -1;
+	}  
+
+	// programs linked on earlier runs are loaded from here instead of compiled again
+	programCache.enable("shader_cache", (GLADloadproc) glfwGetProcAddress);
+    loadGlExtensions((GLADloadproc) glfwGetProcAddress);
+    std::cout << "GL " << glExtensions.major << "." << glExtensions.minor << " on " << glGetString(GL_RENDERER)
+              << ", indirect: " << (glExtensions.drawIndirect && glExtensions.baseInstance ? "yes" : "no")
+              << ", multi draw indirect: " << (glExtensions.multiDrawIndirect ? "yes" : "no") << std::endl;
+
+    std::ofstream csv(csvPath);
+    if (!csv)
+    {
+        std::cout << "Failed to open " << csvPath << std::endl;
+        return -1;
+    }
+    csv << "rocks,strategy,frames,cpu_ms,frame_ms,gpu_ms,draw_calls,triangles" << std::endl;
+
+    {
+        // offscreen target, the window's own framebuffer may not exist while it is hidden
+        unsigned int framebuffer, colorBuffer, depthBuffer;
+        glGenFramebuffers(1, &framebuffer);
+        glGenRenderbuffers(1, &colorBuffer);
+        glGenRenderbuffers(1, &depthBuffer);
+        glBindRenderbuffer(GL_RENDERBUFFER, colorBuffer);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, FRAMEBUFFER_WIDTH, FRAMEBUFFER_HEIGHT);
+        glBindRenderbuffer(GL_RENDERBUFFER, depthBuffer);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, FRAMEBUFFER_WIDTH, FRAMEBUFFER_HEIGHT);
+        glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, colorBuffer);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depthBuffer);
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+        {
+            std::cout << "Offscreen framebuffer is incomplete" << std::endl;
+            return -1;
+        }
+        glViewport(0, 0, FRAMEBUFFER_WIDTH, FRAMEBUFFER_HEIGHT);
+        glEnable(GL_DEPTH_TEST);
+
+        Shader rockShader("src/examples/instancing/advanced/asteroid_field/data/shaders/rock_shader.vs", "src/examples/instancing/advanced/asteroid_field/data/shaders/shader.fs");
+        Shader objectShader("src/examples/instancing/advanced/asteroid_field/data/shaders/planet_shader.vs", "src/examples/instancing/advanced/asteroid_field/data/shaders/shader.fs");
+        programCache.printReport();
+
+        char* rockModelPath = "src/examples/instancing/advanced/asteroid_field/data/asteroid/rock.obj";
+        Model rockModel(rockModelPath);
+        // the instanced strategies draw meshes[0] only, per_object draws the whole model: they only compare on one mesh
+        if (rockModel.meshes.size() != 1)
+        {
+            std::cout << "The benchmark needs a rock model with exactly one mesh, " << rockModelPath << " has " << rockModel.meshes.size() << std::endl;
+            return -1;
+        }
+
+        // bounding sphere of the unscaled rock, pads the cell bounds
+        for (Mesh& mesh : rockModel.meshes)
+        {
+            for (Vertex& vertex : mesh.vertices)
+            {
+                rockRadius = std::max(rockRadius, glm::length(vertex.Position));
+            }
+        }
+
+        InstanceBuffer asteroidInstances;
+        unsigned int indirectBuffer, timerQuery;
+        glGenBuffers(1, &indirectBuffer);
+        glGenQueries(1, &timerQuery);
+
+        std::printf("%10s %-18s %10s %10s %10s %12s %14s\n", "rocks", "strategy", "cpu ms", "frame ms", "gpu ms", "draw calls", "triangles");
+        Scene scene;
+        for (size_t rockCount : ROCK_COUNTS)
+        {
+            if (rockCount > maxRocks)
+            {
+                break;
+            }
+            buildScene(rockCount, scene, asteroidInstances);
+
+            for (int strategy = 0; strategy < STRATEGY_COUNT; strategy++)
+            {
+                if ((strategy == PER_OBJECT && rockCount > PER_OBJECT_MAX_ROCKS) ||
+                    (strategy == INDIRECT && !(glExtensions.drawIndirect && glExtensions.baseInstance)))
+                {
+                    continue;
+                }
+                RunResult result = runStrategy(Strategy(strategy), frameCount, scene, asteroidInstances, rockShader, objectShader,
+                    rockModel, indirectBuffer, timerQuery);
+
+                csv << rockCount << "," << STRATEGY_NAMES[strategy] << "," << frameCount << "," << result.cpuMs << "," << result.frameMs << ","
+                    << result.gpuMs << "," << result.drawCalls << "," << static_cast<uint64_t>(result.triangles) << std::endl;
+                std::printf("%10zu %-18s %10.3f %10.3f %10.3f %12.0f %14.0f\n", rockCount, STRATEGY_NAMES[strategy],
+                    result.cpuMs, result.frameMs, result.gpuMs, result.drawCalls, result.triangles);
+            }
+        }
+
+        glDeleteQueries(1, &timerQuery);
+        glDeleteBuffers(1, &indirectBuffer);
+        glDeleteFramebuffers(1, &framebuffer);
+        glDeleteRenderbuffers(1, &colorBuffer);
+        glDeleteRenderbuffers(1, &depthBuffer);
+    }
+
+    std::cout << "Wrote " << csvPath << std::endl;
+    glfwDestroyWindow(window);
+	glfwTerminate();
+    return 0;
+}
+
+// The same rocks for every strategy: generated, sorted into cells and uploaded once.
+void buildScene(size_t rockCount, Scene& scene, InstanceBuffer& instances)
+{
+    InstanceTransforms transforms;
+    transforms.resize(rockCount);
+    generateAsteroidRing(asteroidRing, ASTEROID_SEED, transforms, 0, rockCount, &asteroidPool);
+    sortInstancesIntoCells(transforms, CELL_SIZE, scene.rocks, scene.cells);
+    instances.upload(scene.rocks.data(), scene.rocks.size());
+
+    scene.modelMatrices.clear();
+    if (rockCount > PER_OBJECT_MAX_ROCKS)
+    {
+        return;
+    }
+    for (const PackedInstanceTransform& rock : scene.rocks)
+    {
+        glm::quat rotation = glm::normalize(glm::quat(rock.rotation[3] / 32767.0f, rock.rotation[0] / 32767.0f, rock.rotation[1] / 32767.0f, rock.rotation[2] / 32767.0f));
+        glm::mat4 model = glm::translate(glm::mat4(1.0f), glm::vec3(rock.positionScale)) * glm::mat4_cast(rotation);
+        scene.modelMatrices.push_back(glm::scale(model, glm::vec3(rock.positionScale.w)));
+    }
+}
+
+// One lap just outside the ring, looking ahead at it, so part of the belt is always off screen.
+glm::mat4 cameraPath(int frame, int frameCount, glm::vec3& eye)
+{
+    float angle = 6.2831853f * frame / frameCount;
+    eye = glm::vec3(std::sin(angle) * 200.0f, 25.0f + 10.0f * std::sin(3.0f * angle), std::cos(angle) * 200.0f);
+    glm::vec3 target(std::sin(angle + 0.6f) * asteroidRing.radius, 0.0f, std::cos(angle + 0.6f) * asteroidRing.radius);
+    return glm::lookAt(eye, target, glm::vec3(0.0f, 1.0f, 0.0f));
+}
+
+RunResult runStrategy(Strategy strategy, int frameCount, Scene& scene, InstanceBuffer& instances, Shader& rockShader, Shader& objectShader,
+    Model& rockModel, unsigned int indirectBuffer, unsigned int timerQuery)
+{
+    glm::mat4 projection = glm::perspective(glm::radians(45.0f), (float)FRAMEBUFFER_WIDTH / (float)FRAMEBUFFER_HEIGHT, 0.1f, 1000.0f);
+    Mesh& rockMesh = rockModel.meshes[0];
+    GLsizei indexCount = static_cast<GLsizei>(rockMesh.indices.size());
+    unsigned int rockTexture = rockModel.textures_loaded[0].id;
+
+    std::vector<InstanceRange> visibleRanges, unusedRanges;
+    std::vector<DrawElementsIndirectCommand> commands;
+    RunResult result;
+
+    for (int frame = -WARMUP_FRAMES; frame < frameCount; frame++)
+    {
+        glm::vec3 eye;
+        glm::mat4 view = cameraPath(std::max(frame, 0), frameCount, eye);
+        size_t drawCalls = 0;
+        size_t drawnRocks = 0;
+
+        auto start = std::chrono::steady_clock::now();
+        glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        glBeginQuery(GL_TIME_ELAPSED, timerQuery);
+
+        Shader& shader = strategy == PER_OBJECT ? objectShader : rockShader;
+        shader.use();
+        shader.setMat4("projection", projection);
+        shader.setMat4("view", view);
+        shader.setInt("texture_diffuse1", 0);
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, rockTexture);
+
+        if (strategy == CULLED_INSTANCED || strategy == INDIRECT)
+        {
+            // no impostors here, every visible cell is drawn as meshes
+            bucketInstanceCells(scene.cells, projection * view, eye, std::numeric_limits<float>::max(), asteroidRing.scaleMax * rockRadius,
+                visibleRanges, unusedRanges);
+        }
+
+        switch (strategy)
+        {
+            case PER_OBJECT:
+                for (const glm::mat4& model : scene.modelMatrices)
+                {
+                    shader.setMat4("model", model);
+                    rockModel.Draw(shader);
+                }
+                drawCalls = scene.modelMatrices.size() * rockModel.meshes.size();
+                drawnRocks = scene.modelMatrices.size();
+                break;
+
+            case INSTANCED:
+                bindInstanceAttributes(rockMesh.VAO, instances.id());
+                glBindVertexArray(rockMesh.VAO);
+                glDrawElementsInstanced(GL_TRIANGLES, indexCount, GL_UNSIGNED_INT, 0, instances.size());
+                drawCalls = 1;
+                drawnRocks = instances.size();
+                break;
+
+            case CULLED_INSTANCED:
+                for (const InstanceRange& range : visibleRanges)
+                {
+                    // GL 3.3 has no base instance, each range re-points the instance attributes
+                    bindInstanceAttributes(rockMesh.VAO, instances.id(), range.first);
+                    glBindVertexArray(rockMesh.VAO);
+                    glDrawElementsInstanced(GL_TRIANGLES, indexCount, GL_UNSIGNED_INT, 0, range.count);
+                    drawnRocks += range.count;
+                }
+                drawCalls = visibleRanges.size();
+                break;
+
+            case INDIRECT:
+                commands.clear();
+                for (const InstanceRange& range : visibleRanges)
+                {
+                    commands.push_back({static_cast<GLuint>(indexCount), static_cast<GLuint>(range.count), 0, 0, static_cast<GLuint>(range.first)});
+                    drawnRocks += range.count;
+                }
+                bindInstanceAttributes(rockMesh.VAO, instances.id());
+                glBindVertexArray(rockMesh.VAO);
+                glBindBuffer(GL_DRAW_INDIRECT_BUFFER, indirectBuffer);
+                glBufferData(GL_DRAW_INDIRECT_BUFFER, commands.size() * sizeof(DrawElementsIndirectCommand), commands.data(), GL_STREAM_DRAW);
+                if (glExtensions.multiDrawIndirect)
+                {
+                    glExtensions.multiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, 0, static_cast<GLsizei>(commands.size()), 0);
+                    drawCalls = commands.empty() ? 0 : 1;
+                }
+                else
+                {
+                    for (size_t i = 0; i < commands.size(); i++)
+                    {
+                        glExtensions.drawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, (void*)(i * sizeof(DrawElementsIndirectCommand)));
+                    }
+                    drawCalls = commands.size();
+                }
+                glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+                break;
+
+            default:
+                break;
+        }
+        glBindVertexArray(0);
+        glEndQuery(GL_TIME_ELAPSED);
+        double cpuMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        // waiting here keeps frames from overlapping, so every number belongs to this frame alone
+        glFinish();
+        double frameMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        GLuint64 elapsed = 0;
+        glGetQueryObjectui64v(timerQuery, GL_QUERY_RESULT, &elapsed);
+
+        if (frame < 0)
+        {
+            continue;
+        }
+        result.cpuMs += cpuMs;
+        result.frameMs += frameMs;
+        result.gpuMs += elapsed / 1e6;
+        result.drawCalls += drawCalls;
+        result.triangles += double(drawnRocks) * indexCount / 3;
+    }
+
+    result.cpuMs /= frameCount;
+    result.frameMs /= frameCount;
+    result.gpuMs /= frameCount;
+    result.drawCalls /= frameCount;
+    result.triangles /= frameCount;
+    return result;
+}
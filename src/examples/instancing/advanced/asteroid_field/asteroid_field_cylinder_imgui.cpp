@@ -18,6 +18,9 @@
 
 #include "./headers/shader.hpp"
 #include "./headers/model.hpp"
+#include "./headers/instance_transform.hpp"
+#include "./headers/instance_buffer.hpp"
+#include "./headers/asteroid_ring.hpp"
 
 struct Joystick {
     float leftX;
@@ -68,10 +71,18 @@ void joystick_callback(GLFWwindow* window, double xpos, double ypos);
 void scroll_callback(GLFWwindow* window, double xoffset, double yoffset);
 
 void render(GLFWwindow* window);
-void storeVertexDataOnGpu(Model& rock);
+void storeVertexDataOnGpu(Model& rock, InstanceBuffer& instances);
+void updateAsteroidInstances(InstanceBuffer& instances);
 void draw(Shader& rockShader, Model& rockModel);
 
-glm::mat4* modelMatrices;
+InstanceTransforms asteroidTransforms;
+std::vector<PackedInstanceTransform> packedTransforms;
+
+// A tall cylinder of rocks rather than a flat ring.
+AsteroidRing asteroidRing = {150.0f, 25.0f, -10.0f, 990.0f, 0.05f, 1.05f};
+int asteroidSeed = 1;
+ThreadPool asteroidGenerationPool;
+double generationMilliseconds = 0.0;
 
 int main() 
 {
@@ -100,6 +111,9 @@ int main()
 		return -1;
 	}  
 
+	// programs linked on earlier runs are loaded from here instead of compiled again
+	programCache.enable("shader_cache", (GLADloadproc) glfwGetProcAddress);
+
 	// Viewport dictates how we want to display the data and coordinates with respect to the window
 	glfwSetFramebufferSizeCallback(window, framebuffer_size_callback); 
     glfwSetKeyCallback(window, key_callback);
@@ -145,6 +159,7 @@ int main()
 void render(GLFWwindow* window)
 {
     Shader rockShader("src/examples/instancing/advanced/asteroid_field/data/shaders/rock_shader.vs", "src/examples/instancing/advanced/asteroid_field/data/shaders/shader.fs");
+    programCache.printReport();
 
     char* rockModelPath = "src/examples/instancing/advanced/asteroid_field/data/asteroid/rock.obj";
     Model rockModel(rockModelPath);
@@ -152,7 +167,9 @@ void render(GLFWwindow* window)
     bool show_window = true;
     ImVec4 clear_color = ImVec4(0.00f, 0.00f, 0.00f, 1.00f);
 
-	storeVertexDataOnGpu(rockModel);
+    // Lives for the whole loop so the GL buffer is released before the context goes away.
+    InstanceBuffer asteroidInstances;
+	storeVertexDataOnGpu(rockModel, asteroidInstances);
 
 	while(!glfwWindowShouldClose(window))
 	{
@@ -183,13 +200,20 @@ void render(GLFWwindow* window)
 
             // Pass a pointer to our bool variable (the window will have a closing button that will clear the bool when clicked)
             ImGui::Text("Hello from ImGuI!");
-            ImGui::SliderInt("Rock Amount", &ASTEROID_AMOUNT, 0, 50000);            // Edit 1 float using a slider from 0.0f to 1.0f
-            ImGui::ColorEdit3("clear color", (float*)&clear_color); // Edit 3 floats representing a color
-
-            if (ImGui::Button("Confirm"))
+            // Only rocks past the ones already generated are created and uploaded, shrinking just draws fewer.
+            if (ImGui::SliderInt("Rock Amount", &ASTEROID_AMOUNT, 0, 50000))
+            {
+                updateAsteroidInstances(asteroidInstances);
+            }
+            // Same seed, same field: a new seed throws away every rock and starts over.
+            if (ImGui::InputInt("Seed", &asteroidSeed))
             {
-	            storeVertexDataOnGpu(rockModel);
+                asteroidTransforms.resize(0);
+                updateAsteroidInstances(asteroidInstances);
             }
+            ImGui::ColorEdit3("clear color", (float*)&clear_color); // Edit 3 floats representing a color
+            ImGui::Text("Generated: %zu, buffer capacity: %zu", asteroidTransforms.size(), asteroidInstances.capacity());
+            ImGui::Text("Last generation: %.2f ms on %u threads", generationMilliseconds, asteroidGenerationPool.size() + 1);
 
             if (ImGui::Button("Close"))
             {
@@ -407,73 +431,34 @@ void draw(Shader& rockShader, Model& rockModel)
     }
 }
 
-void storeVertexDataOnGpu(Model& rock)
+void storeVertexDataOnGpu(Model& rock, InstanceBuffer& instances)
 {
-    // generate a large list of semi-random model transformation matrices
-    // ------------------------------------------------------------------
-    modelMatrices = new glm::mat4[ASTEROID_AMOUNT];
-    srand(static_cast<unsigned int>(glfwGetTime())); // initialize random seed
-    float radius = 150.0;
-    float offset = 25.0f;
-    for (unsigned int i = 0; i < ASTEROID_AMOUNT; i++)
-    {
-        glm::mat4 model = glm::mat4(1.0f);
-        // 1. translation: displace along circle with 'radius' in range [-offset, offset]
-        float angle = (float)i / (float)ASTEROID_AMOUNT * 360.0f;
-        float displacement = (rand() % (int)(2 * offset * 100)) / 100.0f - offset;
-        float x = sin(angle) * radius + displacement;
-
-        displacement = (rand() % (int)(100 * offset * 100)) / 100.0f - offset;
-        float y = displacement * 0.4f; // keep height of asteroid field smaller compared to width of x and z
-                                       //
-        displacement = (rand() % (int)(2 * offset * 100)) / 100.0f - offset;
-        float z = cos(angle) * radius + displacement;
-
-        model = glm::translate(model, glm::vec3(x, y, z));
-
-        // 2. scale: Scale between 0.05 and 0.25f
-        float scale = static_cast<float>((rand() % 100) / 100.0 + 0.05);
-        model = glm::scale(model, glm::vec3(scale));
-
-        // 3. rotation: add random rotation around a (semi)randomly picked rotation axis vector
-        float rotAngle = static_cast<float>((rand() % 360));
-        model = glm::rotate(model, rotAngle, glm::vec3(0.4f, 0.6f, 0.8f));
-
-        // 4. now add to list of matrices
-        modelMatrices[i] = model;
-    }
-    
-    // configure instanced array
-    // -------------------------
-    unsigned int buffer;
-    glGenBuffers(1, &buffer);
-    glBindBuffer(GL_ARRAY_BUFFER, buffer);
-    glBufferData(GL_ARRAY_BUFFER, ASTEROID_AMOUNT * sizeof(glm::mat4), &modelMatrices[0], GL_STATIC_DRAW);
-
-    // set transformation matrices as an instance vertex attribute (with divisor 1)
-    // note: we're cheating a little by taking the, now publicly declared, VAO of the model's mesh(es) and adding new vertexAttribPointers
-    // normally you'd want to do this in a more organized fashion, but for learning purposes this will do.
+    updateAsteroidInstances(instances);
+
+    // position/scale and rotation as instance vertex attributes (with divisor 1), rebuilt into a transform in rock_shader.vs
     std::cout << "Total Rock Meshes: " << rock.meshes.size() << std::endl;
-    for (unsigned int i = 0; i < rock.meshes.size(); i++)
-    {
-        unsigned int VAO = rock.meshes[i].VAO;
-        glBindVertexArray(VAO);
-        // set attribute pointers for matrix (4 times vec4)
-        glEnableVertexAttribArray(3);
-        glVertexAttribPointer(3, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4), (void*)0);
-        glEnableVertexAttribArray(4);
-        glVertexAttribPointer(4, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4), (void*)(sizeof(glm::vec4)));
-        glEnableVertexAttribArray(5);
-        glVertexAttribPointer(5, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4), (void*)(2 * sizeof(glm::vec4)));
-        glEnableVertexAttribArray(6);
-        glVertexAttribPointer(6, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4), (void*)(3 * sizeof(glm::vec4)));
-
-        glVertexAttribDivisor(3, 1);
-        glVertexAttribDivisor(4, 1);
-        glVertexAttribDivisor(5, 1);
-        glVertexAttribDivisor(6, 1);
+    instances.attach(rock);
+}
 
-        glBindVertexArray(0);
+void updateAsteroidInstances(InstanceBuffer& instances)
+{
+    size_t first = asteroidTransforms.size();
+    size_t amount = static_cast<size_t>(ASTEROID_AMOUNT);
+    if (amount <= first)
+    {
+        return;
     }
-}
 
+    // generate semi-random instance transforms for the rocks that don't exist yet
+    // ------------------------------------------------------------------
+    double start = glfwGetTime();
+    asteroidTransforms.resize(amount);
+    generateAsteroidRing(asteroidRing, static_cast<uint32_t>(asteroidSeed), asteroidTransforms, first, amount - first, &asteroidGenerationPool);
+    generationMilliseconds = (glfwGetTime() - start) * 1000.0;
+
+    // upload only the new range, the buffer keeps the rocks it already has when it grows
+    // -------------------------
+    packedTransforms.resize(amount - first);
+    asteroidTransforms.pack(first, amount - first, packedTransforms.data());
+    instances.update(first, amount - first, packedTransforms.data());
+}
@@ -91,6 +91,9 @@ int main()
 		return -1;
 	}  
 
+	// programs linked on earlier runs are loaded from here instead of compiled again
+	programCache.enable("shader_cache", (GLADloadproc) glfwGetProcAddress);
+
 	// Viewport dictates how we want to display the data and coordinates with respect to the window
 	glfwSetFramebufferSizeCallback(window, framebuffer_size_callback); 
 
@@ -126,6 +129,7 @@ void render(GLFWwindow* window)
 {
     Shader planetShader("src/examples/instancing/advanced/asteroid_field/data/shaders/planet_shader.vs", "src/examples/instancing/advanced/asteroid_field/data/shaders/shader.fs");
     Shader rockShader("src/examples/instancing/advanced/asteroid_field/data/shaders/rock_shader_v2.vs", "src/examples/instancing/advanced/asteroid_field/data/shaders/shader.fs");
+    programCache.printReport();
 
     char* planetModelPath = "src/examples/instancing/advanced/asteroid_field/data/planet/planet.obj";
     Model planetModel(planetModelPath);
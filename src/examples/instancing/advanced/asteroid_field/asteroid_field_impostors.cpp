@@ -0,0 +1,653 @@
+#include <glad/glad.h> 
+#include <GLFW/glfw3.h>
+
+#include "imgui.h"
+#include "imgui_impl_glfw.h"
+#include "imgui_impl_opengl3.h"
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#define STB_IMAGE_IMPLEMENTATION
+
+#include "stdlib.h"
+#include <iostream>
+#include <algorithm>
+#include <limits>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+#include "./headers/shader.hpp"
+#include "./headers/model.hpp"
+#include "./headers/instance_transform.hpp"
+#include "./headers/instance_buffer.hpp"
+#include "./headers/asteroid_ring.hpp"
+#include "./headers/instance_cells.hpp"
+#include "./headers/impostor_atlas.hpp"
+#include "../../../../headers/thread_pool.hpp"
+
+/*
+ * Impostors: rocks further away than the impostor distance are drawn as one camera facing quad each, showing the view
+ * of rock.obj closest to the camera direction from an atlas rendered at startup (and cached next to the model).
+ * The instances are sorted into grid cells once, every frame the visible cells are split into mesh and impostor
+ * ranges, so the instance buffer is never touched after generation. "Run comparison" times 50k, 500k and 5M rocks
+ * with and without impostors and prints the table to stdout.
+ */
+
+struct Joystick {
+    float leftX;
+    float leftY;
+    float L2;
+    float rightX;
+    float rightY;
+    float R2;
+};
+
+// Variables
+size_t WINDOW_WIDTH = 1280;
+size_t WINDOW_HEIGHT = 720;
+
+float lastMouseX = WINDOW_WIDTH / 2;
+float lastMouseY = WINDOW_HEIGHT / 2;
+
+float pitch = 0.0f;
+float yaw = -90.0f;
+
+bool joystickPresent = false;
+bool firstMouse = true;
+bool imGuiMode = false;
+
+float fov = 45.0f;
+
+Joystick joystick = {0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f};
+
+unsigned int vaoId;
+
+glm::vec3 cameraPos   = glm::vec3(0.0f, 20.0f,  200.0f);
+glm::vec3 cameraFront = glm::vec3(0.0f, 0.0f, -1.0f);
+glm::vec3 cameraUp    = glm::vec3(0.0f, 1.0f,  0.0f);
+
+// The view matrix is shifted by this after lookAt, the eye really sits at cameraPos - VIEW_OFFSET.
+const glm::vec3 VIEW_OFFSET = glm::vec3(0.0f, 0.0f, -8.0f);
+
+float deltaTime = 0.0f;	// Time between current frame and last frame
+float lastFrame = 0.0f; // Time of last frame
+
+const char* IMPOSTOR_CACHE_PATH = "src/examples/instancing/advanced/asteroid_field/data/asteroid/rock.impostor";
+const int IMPOSTOR_GRID_SIZE = 8;   // views per side of the atlas
+const int IMPOSTOR_TILE_SIZE = 64;  // pixels per view
+
+// Side of the grid cells the rocks are sorted into, the unit of culling and of the mesh/impostor split.
+const float CELL_SIZE = 40.0f;
+
+int ASTEROID_AMOUNT = 500000;
+int generatedAmount = -1;
+AsteroidRing asteroidRing = {600.0f, 450.0f, -20.0f, 20.0f, 0.05f, 0.25f};
+const uint32_t ASTEROID_SEED = 1;
+
+bool useImpostors = true;
+float impostorDistance = 150.0f;
+
+ThreadPool asteroidPool;
+std::vector<InstanceCell> instanceCells;
+std::vector<InstanceRange> meshRanges;
+std::vector<InstanceRange> impostorRanges;
+float rockRadius = 1.0f;
+
+// Timings, averaged over the last second.
+struct FrameStats {
+    double frameMs = 0.0;
+    double gpuRocksMs = 0.0;
+};
+FrameStats frameStats;
+size_t meshRocks = 0;
+size_t impostorRocks = 0;
+size_t drawCalls = 0;
+
+// "Run comparison": every amount with impostors off and on, each timed over COMPARISON_FRAMES after a short warm up.
+const int COMPARISON_AMOUNTS[3] = {50000, 500000, 5000000};
+const int COMPARISON_WARMUP_FRAMES = 10;
+const int COMPARISON_FRAMES = 60;
+struct Comparison {
+    bool running = false;
+    int step = 0;       // amount index * 2 + impostors on
+    int frame = 0;
+    double frameMs = 0.0;
+    double gpuMs = 0.0;
+    double results[6][2];   // frame ms, GPU ms
+};
+Comparison comparison;
+
+// Function Declarations.
+void framebuffer_size_callback(GLFWwindow* window, int width, int height);
+void key_callback(GLFWwindow* window, int key, int scancode, int action, int mods);
+
+void processInput(GLFWwindow* window);
+void mouse_callback(GLFWwindow* window, double xpos, double ypos);
+void joystick_callback(GLFWwindow* window, double xpos, double ypos);
+void scroll_callback(GLFWwindow* window, double xoffset, double yoffset);
+
+void render(GLFWwindow* window);
+void generateAsteroids(InstanceBuffer& instances);
+void updateComparison(double gpuMs);
+void draw(Shader& rockShader, Shader& impostorShader, Model& rockModel, ImpostorAtlas& atlas, unsigned int quadVao, InstanceBuffer& instances, unsigned int timerQuery);
+
+int main() 
+{
+    std::cout << "Hello, Cosmos!" << std::endl;
+
+    glfwInit();
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+
+    GLFWwindow* window = glfwCreateWindow(WINDOW_WIDTH, WINDOW_HEIGHT, "Application", NULL, NULL);
+    if (window == NULL)
+    {
+        std::cout << "Failed to create GLFW window" << std::endl;
+        glfwTerminate();
+        return -1;
+    }
+
+	// Open Window
+    glfwMakeContextCurrent(window);
+
+	// Load openGL functions for this specific openGL Implementation via GLAD
+	if (!gladLoadGLLoader((GLADloadproc) glfwGetProcAddress))
+	{
+		std::cout << "Failed to initialize GLAD" << std::endl;
+		return -1;
+	}  
+
+	// programs linked on earlier runs are loaded from here instead of compiled again
+	programCache.enable("shader_cache", (GLADloadproc) glfwGetProcAddress);
+
+	// Viewport dictates how we want to display the data and coordinates with respect to the window
+	glfwSetFramebufferSizeCallback(window, framebuffer_size_callback); 
+    glfwSetKeyCallback(window, key_callback);
+    glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+
+    glEnable(GL_DEPTH_TEST);
+
+    // Register mouse callback - Each time mouse moves this will be called with the (x,y) coords of the mouse.
+    glfwSetCursorPosCallback(window, mouse_callback); 
+
+    // Scroll callback (change fov of perspective project based on y coordinate)
+    glfwSetScrollCallback(window, scroll_callback); 
+
+    // Setup Dear ImGui context
+    IMGUI_CHECKVERSION();
+    ImGui::CreateContext();
+    ImGuiIO& io = ImGui::GetIO(); (void)io;
+    io.ConfigFlags |= ImGuiConfigFlags_NavEnableKeyboard;     // Enable Keyboard Controls
+    io.ConfigFlags |= ImGuiConfigFlags_NavEnableGamepad;      // Enable Gamepad Controls
+
+    // Setup Dear ImGui style
+    ImGui::StyleColorsDark();
+    //ImGui::StyleColorsLight();
+
+    // Setup Platform/Renderer backends
+    ImGui_ImplGlfw_InitForOpenGL(window, true);
+    ImGui_ImplOpenGL3_Init("#version 330");
+
+	render(window);
+
+    // Cleanup
+	glDeleteVertexArrays(1, &vaoId);
+
+    ImGui_ImplOpenGL3_Shutdown();
+    ImGui_ImplGlfw_Shutdown();
+    ImGui::DestroyContext();
+
+    glfwDestroyWindow(window);
+	glfwTerminate();
+    return 0;
+}
+
+void render(GLFWwindow* window)
+{
+    Shader rockShader("src/examples/instancing/advanced/asteroid_field/data/shaders/rock_shader.vs", "src/examples/instancing/advanced/asteroid_field/data/shaders/shader.fs");
+    Shader impostorShader("src/examples/instancing/advanced/asteroid_field/data/shaders/impostor.vs", "src/examples/instancing/advanced/asteroid_field/data/shaders/impostor.fs");
+    Shader captureShader("src/examples/instancing/advanced/asteroid_field/data/shaders/planet_shader.vs", "src/examples/instancing/advanced/asteroid_field/data/shaders/shader.fs");
+    programCache.printReport();
+
+    char* rockModelPath = "src/examples/instancing/advanced/asteroid_field/data/asteroid/rock.obj";
+    Model rockModel(rockModelPath);
+
+    // bounding sphere of the unscaled rock, pads the cell bounds
+    for (Mesh& mesh : rockModel.meshes)
+    {
+        for (Vertex& vertex : mesh.vertices)
+        {
+            rockRadius = std::max(rockRadius, glm::length(vertex.Position));
+        }
+    }
+
+    ImpostorAtlas impostorAtlas;
+    double atlasStart = glfwGetTime();
+    bool atlasCached = impostorAtlas.loadOrBuild(rockModel, captureShader, rockModelPath, IMPOSTOR_CACHE_PATH, IMPOSTOR_GRID_SIZE, IMPOSTOR_TILE_SIZE);
+    std::cout << "Impostor atlas " << (atlasCached ? "read from " : "rendered to ") << IMPOSTOR_CACHE_PATH << " in "
+              << (glfwGetTime() - atlasStart) * 1000.0 << " ms" << std::endl;
+
+    // one quad, corners in [-1, 1], stretched and oriented per rock by impostor.vs
+    float quadCorners[] = {
+        -1.0f, -1.0f,
+         1.0f, -1.0f,
+        -1.0f,  1.0f,
+         1.0f,  1.0f,
+    };
+    unsigned int quadVao, quadVbo;
+    glGenVertexArrays(1, &quadVao);
+    glGenBuffers(1, &quadVbo);
+    glBindVertexArray(quadVao);
+    glBindBuffer(GL_ARRAY_BUFFER, quadVbo);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(quadCorners), quadCorners, GL_STATIC_DRAW);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*)0);
+    glBindVertexArray(0);
+
+    InstanceBuffer asteroidInstances;
+
+    // GPU time of the rock draws, read a couple of frames late so the query never stalls the pipeline
+    unsigned int timerQueries[2];
+    glGenQueries(2, timerQueries);
+    bool queryPending[2] = {false, false};
+    int frameIndex = 0;
+
+    FrameStats accumulated;
+    int accumulatedFrames = 0;
+    double statsStart = glfwGetTime();
+
+    bool show_window = true;
+    ImVec4 clear_color = ImVec4(0.00f, 0.00f, 0.00f, 1.00f);
+
+	while(!glfwWindowShouldClose(window))
+	{
+		glfwPollEvents();    
+
+        // Start the Dear ImGui frame
+        ImGui_ImplOpenGL3_NewFrame();
+        ImGui_ImplGlfw_NewFrame();
+        ImGui::NewFrame();
+
+        joystickPresent = glfwJoystickPresent(GLFW_JOYSTICK_1);
+
+        if (joystickPresent)
+        {
+            int axesCount;
+            const float *axes = glfwGetJoystickAxes(GLFW_JOYSTICK_1, &axesCount);
+            joystick = {axes[0], axes[1], axes[2], axes[3], axes[4], axes[5]};
+        }
+
+		// Input
+		processInput(window);
+
+        // ImGui Windows
+        if (show_window)
+        {
+            ImGui::Begin("Asteroid Impostors", &show_window);   
+
+            ImGui::Checkbox("Impostors", &useImpostors);
+            ImGui::SliderFloat("Impostor Distance", &impostorDistance, 0.0f, 1000.0f);
+            ImGui::SliderInt("Rock Amount", &ASTEROID_AMOUNT, 0, 5000000);
+            for (int amount : COMPARISON_AMOUNTS)
+            {
+                ImGui::SameLine();
+                if (ImGui::Button(std::to_string(amount / 1000).append("k").c_str()))
+                {
+                    ASTEROID_AMOUNT = amount;
+                }
+            }
+            if (!comparison.running && ImGui::Button("Run comparison"))
+            {
+                comparison = Comparison();
+                comparison.running = true;
+                ASTEROID_AMOUNT = COMPARISON_AMOUNTS[0];
+                useImpostors = false;
+            }
+            if (comparison.running)
+            {
+                ImGui::Text("Comparing... %d/6", comparison.step + 1);
+            }
+
+            ImGui::Text("Atlas: %dx%d views, %s", IMPOSTOR_GRID_SIZE, IMPOSTOR_GRID_SIZE, atlasCached ? "cached" : "rendered at startup");
+            ImGui::Text("Rocks as meshes: %zu, as impostors: %zu, draw calls: %zu", meshRocks, impostorRocks, drawCalls);
+            ImGui::Text("Frame: %.2f ms, rocks on GPU: %.2f ms", frameStats.frameMs, frameStats.gpuRocksMs);
+
+            if (ImGui::Button("Close"))
+            {
+                show_window = false;
+            }
+            ImGui::End();
+        }
+
+        if (generatedAmount != ASTEROID_AMOUNT)
+        {
+            generateAsteroids(asteroidInstances);
+        }
+
+        ImGui::Render();
+
+        // Clear the screen with a colour
+        glClearColor(clear_color.x * clear_color.w, clear_color.y * clear_color.w, clear_color.z * clear_color.w, clear_color.w);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT); // also clear the depth buffer now!
+
+        int query = frameIndex % 2;
+        double gpuRocksMs = 0.0;
+        if (queryPending[query])
+        {
+            GLuint64 elapsed;
+            glGetQueryObjectui64v(timerQueries[query], GL_QUERY_RESULT, &elapsed);
+            gpuRocksMs = elapsed / 1e6;
+        }
+
+		// Rendering commands
+		draw(rockShader, impostorShader, rockModel, impostorAtlas, quadVao, asteroidInstances, timerQueries[query]);
+        queryPending[query] = true;
+        frameIndex++;
+
+        ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+
+		// check and call events and swap the buffers
+		glfwSwapBuffers(window);
+
+        if (comparison.running)
+        {
+            updateComparison(gpuRocksMs);
+        }
+
+        accumulated.frameMs += deltaTime * 1000.0;
+        accumulated.gpuRocksMs += gpuRocksMs;
+        accumulatedFrames++;
+        if (glfwGetTime() - statsStart >= 1.0)
+        {
+            frameStats.frameMs = accumulated.frameMs / accumulatedFrames;
+            frameStats.gpuRocksMs = accumulated.gpuRocksMs / accumulatedFrames;
+            accumulated = FrameStats();
+            accumulatedFrames = 0;
+            statsStart = glfwGetTime();
+        }
+	}
+
+    glDeleteQueries(2, timerQueries);
+    glDeleteVertexArrays(1, &quadVao);
+    glDeleteBuffers(1, &quadVbo);
+}
+
+void framebuffer_size_callback(GLFWwindow* window, int width, int height)
+{
+    glViewport(0, 0, width, height);
+}
+
+void key_callback(GLFWwindow* window, int key, int scancode, int action, int mods)
+{
+    if (key == GLFW_KEY_F && action == GLFW_PRESS)
+    {
+        if (imGuiMode) 
+        {
+            glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+        } 
+        else
+        {
+            glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_NORMAL);
+        }
+        imGuiMode = !imGuiMode;
+    }
+}
+
+void processInput(GLFWwindow *window)
+{
+    if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS) 
+    {
+		glfwSetWindowShouldClose(window, true);
+	}
+
+    float currentFrame = glfwGetTime();
+    deltaTime = currentFrame - lastFrame;
+    lastFrame = currentFrame;
+
+    const float cameraSpeed = 50.0f * deltaTime; // adjust accordingly
+                                                //
+    if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS || joystick.leftY < -0.3)
+    {
+        cameraPos += (cameraSpeed * cameraFront);
+    }
+    if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS || joystick.leftY > 0.3)
+    {
+        cameraPos -= (cameraSpeed * cameraFront);
+    }
+    if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS || joystick.leftX < -0.3)
+    {
+        cameraPos -= (glm::normalize(glm::cross(cameraFront, cameraUp)) * cameraSpeed);
+    }
+    if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS || joystick.leftX > 0.3)
+    {
+        cameraPos += (glm::normalize(glm::cross(cameraFront, cameraUp)) * cameraSpeed);
+    }
+
+    if (joystickPresent)
+    {
+        if (joystick.R2 > -0.3)
+        {
+            fov -= (joystick.R2 + 1);
+        }
+        if (joystick.L2 > -0.3)
+        {
+            fov += (joystick.L2);
+        }
+    }
+
+    if (fov < 1.0f)
+    {
+        fov = 1.0f;
+    }
+    if (fov > 45.0f)
+    {
+        fov = 45.0f; 
+    }
+
+    joystick_callback(window, joystick.rightX, joystick.rightY);
+}
+
+/*
+    1. Calculate the mouse's offset since the last frame.
+    2. Add the offset values to the camera's yaw and pitch values.
+    3. Add some constraints to the minimum/maximum pitch values.
+    4. Calculate the direction vector.
+*/
+void mouse_callback(GLFWwindow* window, double xpos, double ypos)
+{
+    if (imGuiMode) 
+    {
+        return;
+    }
+    if (firstMouse)
+    {
+        lastMouseX = xpos;
+        lastMouseY = ypos;
+        firstMouse = false;
+    }
+
+    float xoffset = xpos - lastMouseX;
+    float yoffset = lastMouseY - ypos; // reversed since y-coordinates range from bottom to top
+    lastMouseX = xpos;
+    lastMouseY = ypos;
+
+    const float sensitivity = 0.1f;
+    xoffset *= sensitivity;
+    yoffset *= sensitivity;
+
+    yaw   += xoffset;
+    pitch += yoffset;
+
+    if (pitch > 89.0f)
+    {
+        pitch =  89.0f;
+    }
+    if (pitch < -89.0f)
+    {
+        pitch = -89.0f;
+    }
+
+    glm::vec3 direction;
+    direction.x = cos(glm::radians(yaw)) * cos(glm::radians(pitch));
+    direction.y = sin(glm::radians(pitch));
+    direction.z = sin(glm::radians(yaw)) * cos(glm::radians(pitch));
+    cameraFront = glm::normalize(direction);
+}
+
+void joystick_callback(GLFWwindow* window, double xpos, double ypos)
+{
+    if (xpos > 0.3 || xpos < -0.3 || ypos > 0.3 || ypos < -0.3)
+    {
+        lastMouseX -= xpos;
+        lastMouseY += ypos;
+        
+        const float sensitivity = 3.0f;
+        float xoffset = xpos * sensitivity;
+        float yoffset = ypos * sensitivity;
+
+        yaw   += xoffset;
+        pitch -= yoffset;
+
+        if (pitch > 89.0f)
+        {
+            pitch =  89.0f;
+        }
+        if (pitch < -89.0f)
+        {
+            pitch = -89.0f;
+        }
+
+        glm::vec3 direction;
+        direction.x = cos(glm::radians(yaw)) * cos(glm::radians(pitch));
+        direction.y = sin(glm::radians(pitch));
+        direction.z = sin(glm::radians(yaw)) * cos(glm::radians(pitch));
+        cameraFront = glm::normalize(direction);
+    }
+}
+
+void scroll_callback(GLFWwindow* window, double xoffset, double yoffset)
+{
+    fov -= (float)yoffset;
+}
+
+// Generate the ring, sort it into cells and upload it once, drawing only ever picks ranges out of it.
+void generateAsteroids(InstanceBuffer& instances)
+{
+    double start = glfwGetTime();
+    InstanceTransforms transforms;
+    transforms.resize(ASTEROID_AMOUNT);
+    generateAsteroidRing(asteroidRing, ASTEROID_SEED, transforms, 0, ASTEROID_AMOUNT, &asteroidPool);
+
+    std::vector<PackedInstanceTransform> sorted;
+    sortInstancesIntoCells(transforms, CELL_SIZE, sorted, instanceCells);
+    instances.upload(sorted.data(), sorted.size());
+    generatedAmount = ASTEROID_AMOUNT;
+
+    std::cout << "Generated " << ASTEROID_AMOUNT << " rocks in " << instanceCells.size() << " cells in "
+              << (glfwGetTime() - start) * 1000.0 << " ms" << std::endl;
+}
+
+// Advance the comparison by one frame, switching configuration once the current one has been timed.
+void updateComparison(double gpuMs)
+{
+    comparison.frame++;
+    if (comparison.frame <= COMPARISON_WARMUP_FRAMES)
+    {
+        return;
+    }
+    comparison.frameMs += deltaTime * 1000.0;
+    comparison.gpuMs += gpuMs;
+    if (comparison.frame < COMPARISON_WARMUP_FRAMES + COMPARISON_FRAMES)
+    {
+        return;
+    }
+
+    comparison.results[comparison.step][0] = comparison.frameMs / COMPARISON_FRAMES;
+    comparison.results[comparison.step][1] = comparison.gpuMs / COMPARISON_FRAMES;
+    comparison.frame = 0;
+    comparison.frameMs = 0.0;
+    comparison.gpuMs = 0.0;
+    comparison.step++;
+
+    if (comparison.step < 6)
+    {
+        ASTEROID_AMOUNT = COMPARISON_AMOUNTS[comparison.step / 2];
+        useImpostors = comparison.step % 2 == 1;
+        return;
+    }
+
+    comparison.running = false;
+    std::cout << "Impostor comparison (impostor distance " << impostorDistance << ", averaged over " << COMPARISON_FRAMES << " frames)" << std::endl;
+    std::printf("%10s | %22s | %22s\n", "rocks", "meshes frame / GPU ms", "impostors frame / GPU ms");
+    for (int i = 0; i < 3; i++)
+    {
+        std::printf("%10d | %10.2f / %9.2f | %10.2f / %9.2f\n", COMPARISON_AMOUNTS[i],
+            comparison.results[i * 2][0], comparison.results[i * 2][1], comparison.results[i * 2 + 1][0], comparison.results[i * 2 + 1][1]);
+    }
+}
+
+void draw(Shader& rockShader, Shader& impostorShader, Model& rockModel, ImpostorAtlas& atlas, unsigned int quadVao, InstanceBuffer& instances, unsigned int timerQuery)
+{
+    glm::mat4 view = glm::lookAt(cameraPos, // Camera Pos
+                                 cameraPos + cameraFront, // Target Pos
+                                 cameraUp); // Up Vector
+    view = glm::translate(view, VIEW_OFFSET);
+    glm::mat4 projection = glm::perspective(glm::radians(fov), (float)WINDOW_WIDTH / (float)WINDOW_HEIGHT, 0.1f, 3000.0f);
+    glm::vec3 eye = cameraPos - VIEW_OFFSET;
+
+    // without impostors every visible cell is "near"
+    float distance = useImpostors ? impostorDistance : std::numeric_limits<float>::max();
+    bucketInstanceCells(instanceCells, projection * view, eye, distance, asteroidRing.scaleMax * rockRadius, meshRanges, impostorRanges);
+
+    meshRocks = 0;
+    impostorRocks = 0;
+    drawCalls = 0;
+
+    glBeginQuery(GL_TIME_ELAPSED, timerQuery);
+
+    rockShader.use();
+    rockShader.setMat4("projection", projection);
+    rockShader.setMat4("view", view);
+    rockShader.setInt("texture_diffuse1", 0);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, rockModel.textures_loaded[0].id); // note: we also made the textures_loaded vector public (instead of private) from the model class.
+    for (const InstanceRange& range : meshRanges)
+    {
+        for (unsigned int i = 0; i < rockModel.meshes.size(); i++)
+        {
+            // GL 3.3 has no base instance: point the instance attributes at the first rock of the range instead
+            bindInstanceAttributes(rockModel.meshes[i].VAO, instances.id(), range.first);
+            glBindVertexArray(rockModel.meshes[i].VAO);
+            glDrawElementsInstanced(GL_TRIANGLES, static_cast<unsigned int>(rockModel.meshes[i].indices.size()), GL_UNSIGNED_INT, 0, range.count);
+            drawCalls++;
+        }
+        meshRocks += range.count;
+    }
+
+    if (!impostorRanges.empty())
+    {
+        impostorShader.use();
+        impostorShader.setMat4("projection", projection);
+        impostorShader.setMat4("view", view);
+        impostorShader.setVec3("cameraPosition", eye);
+        impostorShader.setInt("atlasGridSize", atlas.getGridSize());
+        impostorShader.setFloat("impostorRadius", atlas.getRadius());
+        impostorShader.setInt("impostorAtlas", 0);
+        glBindTexture(GL_TEXTURE_2D, atlas.getTexture());
+        for (const InstanceRange& range : impostorRanges)
+        {
+            bindInstanceAttributes(quadVao, instances.id(), range.first);
+            glBindVertexArray(quadVao);
+            glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, range.count);
+            drawCalls++;
+            impostorRocks += range.count;
+        }
+    }
+    glBindVertexArray(0);
+
+    glEndQuery(GL_TIME_ELAPSED);
+}
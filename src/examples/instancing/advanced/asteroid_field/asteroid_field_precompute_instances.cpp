@@ -8,11 +8,18 @@
 
 #include "stdlib.h"
 #include <iostream>
+#include <algorithm>
 #include <cstdint>
 #include <filesystem>
 
 #include "./headers/shader.hpp"
 #include "./headers/model.hpp"
+#include "./headers/instance_transform.hpp"
+#include "./headers/instance_buffer.hpp"
+#include "./headers/asteroid_ring.hpp"
+#include "./headers/orbit_simulation.hpp"
+#include "./headers/spatial_hash.hpp"
+#include "./headers/texture_array.hpp"
 
 struct Joystick {
     float leftX;
@@ -54,16 +61,33 @@ unsigned int ASTEROID_AMOUNT = 10000;
 
 // Function Declarations.
 void framebuffer_size_callback(GLFWwindow* window, int width, int height);
+void key_callback(GLFWwindow* window, int key, int scancode, int action, int mods);
 void processInput(GLFWwindow* window);
 void mouse_callback(GLFWwindow* window, double xpos, double ypos);
 void joystick_callback(GLFWwindow* window, double xpos, double ypos);
 void scroll_callback(GLFWwindow* window, double xoffset, double yoffset);
 
 void render(GLFWwindow* window);
-void storeVertexDataOnGpu(Model& rock);
-void draw(Shader& planetShader, Model& planetModel, Shader& rockShader, Model& rockModel);
+void storeVertexDataOnGpu(Model& rock, InstanceBuffer& instances);
+void storeTextureLayersOnGpu(Model& rock, Model& planet, TextureArray& textures);
+void draw(Shader& planetShader, Model& planetModel, Shader& rockShader, Model& rockModel, TextureArray& rockTextures);
+void pickAsteroid();
 
-glm::mat4* modelMatrices;
+InstanceTransforms asteroidTransforms;
+
+const uint32_t ASTEROID_SEED = 1;
+ThreadPool asteroidGenerationPool;
+OrbitSimulation asteroidOrbits(asteroidGenerationPool);
+double lastOrbitReport = 0.0;
+
+// Follows the orbiting rocks for picking (P) and proximity queries, cells a few rock radii wide.
+SpatialHashGrid asteroidGrid(4.0f, 16384);
+float rockRadius = 0.0f;
+bool pickRequested = false;
+
+// Texture array layer of every rock, one in VARIANT_EVERY rocks is wrapped in the planet's texture instead of its own.
+unsigned int asteroidLayerBuffer = 0;
+const unsigned int VARIANT_EVERY = 4;
 
 int main() 
 {
@@ -92,8 +116,12 @@ int main()
 		return -1;
 	}  
 
+	// programs linked on earlier runs are loaded from here instead of compiled again
+	programCache.enable("shader_cache", (GLADloadproc) glfwGetProcAddress);
+
 	// Viewport dictates how we want to display the data and coordinates with respect to the window
 	glfwSetFramebufferSizeCallback(window, framebuffer_size_callback); 
+    glfwSetKeyCallback(window, key_callback);
 
     /* 
         Tell GLFW that it should hide the cursor but still capture it. 
@@ -118,6 +146,7 @@ int main()
 
 	render(window);
 
+    glDeleteBuffers(1, &asteroidLayerBuffer);
 	glDeleteVertexArrays(1, &vaoId);
 	glfwTerminate();
     return 0;
@@ -126,7 +155,13 @@ int main()
 void render(GLFWwindow* window)
 {
     Shader planetShader("src/examples/instancing/advanced/asteroid_field/data/shaders/planet_shader.vs", "src/examples/instancing/advanced/asteroid_field/data/shaders/shader.fs");
-    Shader rockShader("src/examples/instancing/advanced/asteroid_field/data/shaders/rock_shader.vs", "src/examples/instancing/advanced/asteroid_field/data/shaders/shader.fs");
+    Shader rockShader("src/examples/instancing/advanced/asteroid_field/data/shaders/rock_layered.vs", "src/examples/instancing/advanced/asteroid_field/data/shaders/layered.fs");
+    programCache.printReport();
+
+    // edit data/shaders/*.vs/*.fs while running, they are recompiled without restarting
+    ShaderWatcher shaderWatcher((GLADloadproc) glfwGetProcAddress);
+    shaderWatcher.add(planetShader);
+    shaderWatcher.add(rockShader);
 
     char* planetModelPath = "src/examples/instancing/advanced/asteroid_field/data/planet/planet.obj";
     Model planetModel(planetModelPath);
@@ -134,10 +169,25 @@ void render(GLFWwindow* window)
     char* rockModelPath = "src/examples/instancing/advanced/asteroid_field/data/asteroid/rock.obj";
     Model rockModel(rockModelPath);
 
-	storeVertexDataOnGpu(rockModel);
+    // bounding sphere of the unscaled rock, scaled per instance in the grid
+    for (Mesh& mesh : rockModel.meshes)
+    {
+        for (Vertex& vertex : mesh.vertices)
+        {
+            rockRadius = std::max(rockRadius, glm::length(vertex.Position));
+        }
+    }
+
+    InstanceBuffer asteroidInstances;
+	storeVertexDataOnGpu(rockModel, asteroidInstances);
+
+    TextureArray rockTextures;
+    storeTextureLayersOnGpu(rockModel, planetModel, rockTextures);
 
 	while(!glfwWindowShouldClose(window))
 	{
+        shaderWatcher.update();
+
         joystickPresent = glfwJoystickPresent(GLFW_JOYSTICK_1);
 
         if (joystickPresent)
@@ -150,8 +200,27 @@ void render(GLFWwindow* window)
 		// Input
 		processInput(window);
 
+        // The orbits simulated while the previous frame was drawn become this frame's instances,
+        // and the next step runs on the workers while this one is uploaded and drawn.
+        const std::vector<PackedInstanceTransform>& asteroidFrame = asteroidOrbits.finish();
+        asteroidOrbits.start(std::min(deltaTime, 0.1f));
+        asteroidInstances.upload(asteroidFrame.data(), asteroidFrame.size());
+        asteroidGrid.updateAll(asteroidFrame.data(), asteroidFrame.size(), rockRadius);
+
+        if (pickRequested)
+        {
+            pickRequested = false;
+            pickAsteroid();
+        }
+
+        if (glfwGetTime() - lastOrbitReport > 5.0)
+        {
+            std::cout << "Orbit step: " << asteroidOrbits.getLastStepMilliseconds() << " ms for " << asteroidOrbits.size() << " asteroids" << std::endl;
+            lastOrbitReport = glfwGetTime();
+        }
+
 		// Rendering commands
-		draw(planetShader, planetModel, rockShader, rockModel);
+		draw(planetShader, planetModel, rockShader, rockModel, rockTextures);
 
 		// check and call events and swap the buffers
 		glfwSwapBuffers(window);
@@ -164,6 +233,14 @@ void framebuffer_size_callback(GLFWwindow* window, int width, int height)
     glViewport(0, 0, width, height);
 }
 
+void key_callback(GLFWwindow* window, int key, int scancode, int action, int mods)
+{
+    if (key == GLFW_KEY_P && action == GLFW_PRESS)
+    {
+        pickRequested = true;
+    }
+}
+
 void processInput(GLFWwindow *window)
 {
     if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS) {
@@ -296,7 +373,7 @@ void scroll_callback(GLFWwindow* window, double xoffset, double yoffset)
     fov -= (float)yoffset;
 }
 
-void draw(Shader& planetShader, Model& planetModel, Shader& rockShader, Model& rockModel)
+void draw(Shader& planetShader, Model& planetModel, Shader& rockShader, Model& rockModel, TextureArray& rockTextures)
 {
 	// Clear the screen with a colour
 	// glClearColor(0.0f, 0.0f, 0.5f, 0.2f);
@@ -331,7 +408,7 @@ void draw(Shader& planetShader, Model& planetModel, Shader& rockShader, Model& r
     rockShader.use();
     rockShader.setMat4("projection", projection);
     rockShader.setMat4("view", view);
-    rockShader.setInt("texture_diffuse1", 0);
+    rockShader.setInt("texture_diffuse_array", 0);
 
     // OLD SOLUTION, ONE DRAW CALL PER OBJECT WITH A NEW MODEL MATRIX
     /*
@@ -342,8 +419,8 @@ void draw(Shader& planetShader, Model& planetModel, Shader& rockShader, Model& r
     }
     */
 
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, rockModel.textures_loaded[0].id); // note: we also made the textures_loaded vector public (instead of private) from the model class.
+    // every variant is a layer of the same texture, so they all go in one draw per mesh
+    rockTextures.bind(0);
     for (unsigned int i = 0; i < rockModel.meshes.size(); i++)
     {
         glBindVertexArray(rockModel.meshes[i].VAO);
@@ -352,70 +429,73 @@ void draw(Shader& planetShader, Model& planetModel, Shader& rockShader, Model& r
     }
 }
 
-void storeVertexDataOnGpu(Model& rock)
+void storeVertexDataOnGpu(Model& rock, InstanceBuffer& instances)
 {
-    // generate a large list of semi-random model transformation matrices
+    // generate a large list of semi-random instance transforms
     // ------------------------------------------------------------------
-    modelMatrices = new glm::mat4[ASTEROID_AMOUNT];
-    srand(static_cast<unsigned int>(glfwGetTime())); // initialize random seed
-    float radius = 150.0;
-    float offset = 25.0f;
-    for (unsigned int i = 0; i < ASTEROID_AMOUNT; i++)
-    {
-        glm::mat4 model = glm::mat4(1.0f);
-        // 1. translation: displace along circle with 'radius' in range [-offset, offset]
-        float angle = (float)i / (float)ASTEROID_AMOUNT * 360.0f;
-        float displacement = (rand() % (int)(2 * offset * 100)) / 100.0f - offset;
-        float x = sin(angle) * radius + displacement;
-        displacement = (rand() % (int)(2 * offset * 100)) / 100.0f - offset;
-        float y = displacement * 0.4f; // keep height of asteroid field smaller compared to width of x and z
-        displacement = (rand() % (int)(2 * offset * 100)) / 100.0f - offset;
-        float z = cos(angle) * radius + displacement;
-        model = glm::translate(model, glm::vec3(x, y, z));
-
-        // 2. scale: Scale between 0.05 and 0.25f
-        float scale = static_cast<float>((rand() % 20) / 100.0 + 0.05);
-        model = glm::scale(model, glm::vec3(scale));
-
-        // 3. rotation: add random rotation around a (semi)randomly picked rotation axis vector
-        float rotAngle = static_cast<float>((rand() % 360));
-        model = glm::rotate(model, rotAngle, glm::vec3(0.4f, 0.6f, 0.8f));
-
-        // 4. now add to list of matrices
-        modelMatrices[i] = model;
-    }
+    asteroidTransforms.resize(ASTEROID_AMOUNT);
+    generateAsteroidRing(AsteroidRing(), ASTEROID_SEED, asteroidTransforms, 0, ASTEROID_AMOUNT, &asteroidGenerationPool);
     
-    // configure instanced array
+    // the rocks orbit from here on, the simulation produces the instance data every frame
     // -------------------------
-    unsigned int buffer;
-    glGenBuffers(1, &buffer);
-    glBindBuffer(GL_ARRAY_BUFFER, buffer);
-    glBufferData(GL_ARRAY_BUFFER, ASTEROID_AMOUNT * sizeof(glm::mat4), &modelMatrices[0], GL_STATIC_DRAW);
-
-    // set transformation matrices as an instance vertex attribute (with divisor 1)
-    // note: we're cheating a little by taking the, now publicly declared, VAO of the model's mesh(es) and adding new vertexAttribPointers
-    // normally you'd want to do this in a more organized fashion, but for learning purposes this will do.
+    asteroidOrbits.reset(AsteroidRing(), ASTEROID_SEED, asteroidTransforms);
+    const std::vector<PackedInstanceTransform>& firstFrame = asteroidOrbits.finish();
+    instances.upload(firstFrame.data(), firstFrame.size());
+
+    // position/scale and rotation as instance vertex attributes (with divisor 1), rebuilt into a transform in rock_shader.vs
     std::cout << "Total Rock Meshes: " << rock.meshes.size() << std::endl;
-    for (unsigned int i = 0; i < rock.meshes.size(); i++)
+    instances.attach(rock);
+}
+
+void storeTextureLayersOnGpu(Model& rock, Model& planet, TextureArray& textures)
+{
+    // rock.png is the layer size, the (much larger) planet texture is resampled down to it
+    int rockLayer = rock.addTextureLayers(textures);
+    int variantLayer = planet.addTextureLayers(textures);
+    if (variantLayer < 0)
     {
-        unsigned int VAO = rock.meshes[i].VAO;
-        glBindVertexArray(VAO);
-        // set attribute pointers for matrix (4 times vec4)
-        glEnableVertexAttribArray(3);
-        glVertexAttribPointer(3, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4), (void*)0);
-        glEnableVertexAttribArray(4);
-        glVertexAttribPointer(4, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4), (void*)(sizeof(glm::vec4)));
-        glEnableVertexAttribArray(5);
-        glVertexAttribPointer(5, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4), (void*)(2 * sizeof(glm::vec4)));
-        glEnableVertexAttribArray(6);
-        glVertexAttribPointer(6, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4), (void*)(3 * sizeof(glm::vec4)));
-
-        glVertexAttribDivisor(3, 1);
-        glVertexAttribDivisor(4, 1);
-        glVertexAttribDivisor(5, 1);
-        glVertexAttribDivisor(6, 1);
+        variantLayer = rockLayer;
+    }
+    textures.upload();
+    std::cout << "Rock texture array: " << textures.getLayerCount() << " layers of " << textures.getWidth() << "x" << textures.getHeight() << std::endl;
 
-        glBindVertexArray(0);
+    // the orbit simulation keeps the instance order, so the layers are written once
+    std::vector<uint16_t> layers(ASTEROID_AMOUNT);
+    for (unsigned int i = 0; i < ASTEROID_AMOUNT; i++)
+    {
+        layers[i] = (uint16_t)std::max(0, i % VARIANT_EVERY == 0 ? variantLayer : rockLayer);
     }
+
+    glGenBuffers(1, &asteroidLayerBuffer);
+    glBindBuffer(GL_ARRAY_BUFFER, asteroidLayerBuffer);
+    glBufferData(GL_ARRAY_BUFFER, layers.size() * sizeof(uint16_t), layers.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    bindInstanceLayers(rock, asteroidLayerBuffer);
 }
 
+// Report the rock in the centre of the screen and what is around the camera.
+void pickAsteroid()
+{
+    // the view is shifted by (0, 0, -8) after lookAt, see draw()
+    glm::vec3 eye = cameraPos + glm::vec3(0.0f, 0.0f, 8.0f);
+    SpatialHit picked = asteroidGrid.raycast(eye, glm::normalize(cameraFront), 1000.0f);
+    if (picked.id >= 0)
+    {
+        std::cout << "Picked asteroid #" << picked.id << " at distance " << picked.distance << std::endl;
+    }
+    else
+    {
+        std::cout << "No asteroid under the crosshair" << std::endl;
+    }
+
+    std::vector<uint32_t> nearby;
+    asteroidGrid.querySphere(eye, 25.0f, nearby);
+    std::vector<SpatialHit> closest;
+    asteroidGrid.nearest(eye, 1, closest);
+    std::cout << nearby.size() << " asteroids within 25 units";
+    if (!closest.empty())
+    {
+        std::cout << ", closest #" << closest[0].id << " at " << closest[0].distance;
+    }
+    std::cout << std::endl;
+}
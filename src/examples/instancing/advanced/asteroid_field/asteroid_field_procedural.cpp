@@ -0,0 +1,549 @@
+#include <glad/glad.h> 
+#include <GLFW/glfw3.h>
+
+#include "imgui.h"
+#include "imgui_impl_glfw.h"
+#include "imgui_impl_opengl3.h"
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#define STB_IMAGE_IMPLEMENTATION
+
+#include "stdlib.h"
+#include <iostream>
+#include <algorithm>
+#include <cstdint>
+#include <filesystem>
+
+#include "./headers/shader.hpp"
+#include "./headers/model.hpp"
+#include "./headers/instance_transform.hpp"
+#include "./headers/instance_buffer.hpp"
+#include "./headers/procedural_asteroid.hpp"
+#include "./headers/instance_cells.hpp"
+
+/*
+ * Procedural instancing: in procedural mode rock_procedural.vs builds every rock from gl_InstanceID, the seed and the time,
+ * so the belt costs no memory per rock. Buffer mode evaluates the same rocks on the CPU into an instance buffer every frame,
+ * to compare memory and frame time against. Press P to pick the rock in the centre of the screen.
+ */
+
+struct Joystick {
+    float leftX;
+    float leftY;
+    float L2;
+    float rightX;
+    float rightY;
+    float R2;
+};
+
+// Variables
+size_t WINDOW_WIDTH = 1280;
+size_t WINDOW_HEIGHT = 720;
+
+float lastMouseX = WINDOW_WIDTH / 2;
+float lastMouseY = WINDOW_HEIGHT / 2;
+
+float pitch = 0.0f;
+float yaw = -90.0f;
+
+bool joystickPresent = false;
+bool firstMouse = true;
+bool imGuiMode = false;
+
+float fov = 45.0f;
+
+Joystick joystick = {0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f};
+
+unsigned int vaoId;
+
+glm::vec3 cameraPos   = glm::vec3(0.0f, 20.0f,  200.0f);
+glm::vec3 cameraFront = glm::vec3(0.0f, 0.0f, -1.0f);
+glm::vec3 cameraUp    = glm::vec3(0.0f, 1.0f,  0.0f);
+
+// The view matrix is shifted by this after lookAt, the eye really sits at cameraPos - VIEW_OFFSET.
+const glm::vec3 VIEW_OFFSET = glm::vec3(0.0f, 0.0f, -8.0f);
+
+float deltaTime = 0.0f;	// Time between current frame and last frame
+float lastFrame = 0.0f; // Time of last frame
+
+const char* PROCEDURAL_VERTEX_PATH = "src/examples/instancing/advanced/asteroid_field/data/shaders/rock_procedural.vs";
+
+// Rocks checked against the CPU generator at startup, and the (arbitrary) time they're checked at.
+const size_t CHECK_ROCK_COUNT = 4096;
+const float CHECK_TIME = 123.25f;
+
+int ASTEROID_AMOUNT = 200000;
+AsteroidRing asteroidRing = {150.0f, 40.0f, -10.0f, 10.0f, 0.05f, 0.25f};
+int asteroidSeed = 1;
+
+bool proceduralMode = true;
+bool animate = true;
+float simulationTime = 0.0f;
+
+ThreadPool asteroidPool;
+std::vector<PackedInstanceTransform> packedTransforms;
+
+ProceduralShaderCheck shaderCheck;
+float rockRadius = 1.0f;
+bool pickRequested = false;
+long pickedRock = -1;
+
+// Timings, averaged over the last second.
+struct FrameStats {
+    double frameMs = 0.0;
+    double gpuRocksMs = 0.0;
+    double instanceUpdateMs = 0.0;
+};
+FrameStats frameStats;
+bool beltCulled = false;
+
+// Function Declarations.
+void framebuffer_size_callback(GLFWwindow* window, int width, int height);
+void key_callback(GLFWwindow* window, int key, int scancode, int action, int mods);
+
+void processInput(GLFWwindow* window);
+void mouse_callback(GLFWwindow* window, double xpos, double ypos);
+void joystick_callback(GLFWwindow* window, double xpos, double ypos);
+void scroll_callback(GLFWwindow* window, double xoffset, double yoffset);
+
+void render(GLFWwindow* window);
+double updateInstanceBuffer(InstanceBuffer& instances);
+void draw(Shader& rockShader, Shader& proceduralShader, Model& rockModel, unsigned int timerQuery);
+
+int main() 
+{
+    std::cout << "Hello, Cosmos!" << std::endl;
+
+    glfwInit();
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+
+    GLFWwindow* window = glfwCreateWindow(WINDOW_WIDTH, WINDOW_HEIGHT, "Application", NULL, NULL);
+    if (window == NULL)
+    {
+        std::cout << "Failed to create GLFW window" << std::endl;
+        glfwTerminate();
+        return -1;
+    }
+
+	// Open Window
+    glfwMakeContextCurrent(window);
+
+	// Load openGL functions for this specific openGL Implementation via GLAD
+	if (!gladLoadGLLoader((GLADloadproc) glfwGetProcAddress))
+	{
+		std::cout << "Failed to initialize GLAD" << std::endl;
+		return -1;
+	}  
+
+	// programs linked on earlier runs are loaded from here instead of compiled again
+	programCache.enable("shader_cache", (GLADloadproc) glfwGetProcAddress);
+
+	// Viewport dictates how we want to display the data and coordinates with respect to the window
+	glfwSetFramebufferSizeCallback(window, framebuffer_size_callback); 
+    glfwSetKeyCallback(window, key_callback);
+    glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+
+    glEnable(GL_DEPTH_TEST);
+
+    // Register mouse callback - Each time mouse moves this will be called with the (x,y) coords of the mouse.
+    glfwSetCursorPosCallback(window, mouse_callback); 
+
+    // Scroll callback (change fov of perspective project based on y coordinate)
+    glfwSetScrollCallback(window, scroll_callback); 
+
+    // Setup Dear ImGui context
+    IMGUI_CHECKVERSION();
+    ImGui::CreateContext();
+    ImGuiIO& io = ImGui::GetIO(); (void)io;
+    io.ConfigFlags |= ImGuiConfigFlags_NavEnableKeyboard;     // Enable Keyboard Controls
+    io.ConfigFlags |= ImGuiConfigFlags_NavEnableGamepad;      // Enable Gamepad Controls
+
+    // Setup Dear ImGui style
+    ImGui::StyleColorsDark();
+    //ImGui::StyleColorsLight();
+
+    // Setup Platform/Renderer backends
+    ImGui_ImplGlfw_InitForOpenGL(window, true);
+    ImGui_ImplOpenGL3_Init("#version 330");
+
+	render(window);
+
+    // Cleanup
+	glDeleteVertexArrays(1, &vaoId);
+
+    ImGui_ImplOpenGL3_Shutdown();
+    ImGui_ImplGlfw_Shutdown();
+    ImGui::DestroyContext();
+
+    glfwDestroyWindow(window);
+	glfwTerminate();
+    return 0;
+}
+
+void render(GLFWwindow* window)
+{
+    Shader rockShader("src/examples/instancing/advanced/asteroid_field/data/shaders/rock_shader.vs", "src/examples/instancing/advanced/asteroid_field/data/shaders/shader.fs");
+    Shader proceduralShader(PROCEDURAL_VERTEX_PATH, "src/examples/instancing/advanced/asteroid_field/data/shaders/shader.fs");
+    programCache.printReport();
+
+    char* rockModelPath = "src/examples/instancing/advanced/asteroid_field/data/asteroid/rock.obj";
+    Model rockModel(rockModelPath);
+
+    // bounding sphere of the unscaled rock, for picking
+    for (Mesh& mesh : rockModel.meshes)
+    {
+        for (Vertex& vertex : mesh.vertices)
+        {
+            rockRadius = std::max(rockRadius, glm::length(vertex.Position));
+        }
+    }
+
+    shaderCheck = checkProceduralShader(PROCEDURAL_VERTEX_PATH, asteroidRing, static_cast<uint32_t>(asteroidSeed), CHECK_TIME, CHECK_ROCK_COUNT);
+    std::cout << "Procedural shader check: " << (shaderCheck.passed ? "passed" : "FAILED") << ", " << shaderCheck.bitMismatches << " hash mismatches in "
+              << shaderCheck.checked << " rocks, max position error " << shaderCheck.maxPositionError << ", max rotation error " << shaderCheck.maxRotationError << std::endl;
+
+    InstanceBuffer asteroidInstances;
+    asteroidInstances.attach(rockModel);
+
+    // GPU time of the rock draw, read a couple of frames late so the query never stalls the pipeline
+    unsigned int timerQueries[2];
+    glGenQueries(2, timerQueries);
+    bool queryPending[2] = {false, false};
+    int frameIndex = 0;
+
+    FrameStats accumulated;
+    int accumulatedFrames = 0;
+    double statsStart = glfwGetTime();
+
+    bool show_window = true;
+    ImVec4 clear_color = ImVec4(0.00f, 0.00f, 0.00f, 1.00f);
+
+	while(!glfwWindowShouldClose(window))
+	{
+		glfwPollEvents();    
+
+        // Start the Dear ImGui frame
+        ImGui_ImplOpenGL3_NewFrame();
+        ImGui_ImplGlfw_NewFrame();
+        ImGui::NewFrame();
+
+        joystickPresent = glfwJoystickPresent(GLFW_JOYSTICK_1);
+
+        if (joystickPresent)
+        {
+            int axesCount;
+            const float *axes = glfwGetJoystickAxes(GLFW_JOYSTICK_1, &axesCount);
+            joystick = {axes[0], axes[1], axes[2], axes[3], axes[4], axes[5]};
+        }
+
+		// Input
+		processInput(window);
+
+        if (animate)
+        {
+            simulationTime += std::min(deltaTime, 0.1f);
+        }
+
+        if (pickRequested)
+        {
+            pickRequested = false;
+            pickedRock = pickProceduralAsteroid(asteroidRing, static_cast<uint32_t>(asteroidSeed), ASTEROID_AMOUNT, simulationTime,
+                cameraPos - VIEW_OFFSET, glm::normalize(cameraFront), rockRadius, &asteroidPool);
+        }
+
+        // ImGui Windows
+        if (show_window)
+        {
+            ImGui::Begin("Procedural Asteroids", &show_window);   
+
+            ImGui::Checkbox("Procedural (no instance buffer)", &proceduralMode);
+            ImGui::Checkbox("Animate", &animate);
+            ImGui::SliderInt("Rock Amount", &ASTEROID_AMOUNT, 0, 2000000);
+            ImGui::InputInt("Seed", &asteroidSeed);
+            if (ImGui::Button("Check shader against CPU"))
+            {
+                shaderCheck = checkProceduralShader(PROCEDURAL_VERTEX_PATH, asteroidRing, static_cast<uint32_t>(asteroidSeed), CHECK_TIME, CHECK_ROCK_COUNT);
+            }
+            ImGui::Text("Shader check: %s (%zu hash mismatches in %zu rocks, position error %.2g, rotation error %.2g)", shaderCheck.passed ? "passed" : "FAILED",
+                shaderCheck.bitMismatches, shaderCheck.checked, shaderCheck.maxPositionError, shaderCheck.maxRotationError);
+
+            // per-rock memory: nothing in procedural mode, the GPU buffer plus its CPU staging copy otherwise
+            size_t instanceBytes = proceduralMode ? 0 : (asteroidInstances.capacity() + packedTransforms.capacity()) * sizeof(PackedInstanceTransform);
+            ImGui::Text("Instance memory: %.2f MB", instanceBytes / (1024.0 * 1024.0));
+            ImGui::Text("Frame: %.2f ms, rocks on GPU: %.2f ms, instance update: %.2f ms", frameStats.frameMs, frameStats.gpuRocksMs, frameStats.instanceUpdateMs);
+            ImGui::Text("Belt %s", beltCulled ? "culled (bounds outside the view)" : "visible");
+            if (pickedRock >= 0)
+            {
+                ProceduralAsteroid picked = evaluateProceduralAsteroid(asteroidRing, static_cast<uint32_t>(asteroidSeed), static_cast<uint32_t>(pickedRock), simulationTime);
+                ImGui::Text("Picked rock #%ld at (%.1f, %.1f, %.1f)", pickedRock, picked.position.x, picked.position.y, picked.position.z);
+            }
+            else
+            {
+                ImGui::Text("Press P to pick the rock in the centre of the screen");
+            }
+
+            if (ImGui::Button("Close"))
+            {
+                show_window = false;
+            }
+            ImGui::End();
+        }
+
+        double instanceUpdateMs = proceduralMode ? 0.0 : updateInstanceBuffer(asteroidInstances);
+
+        ImGui::Render();
+
+        // Clear the screen with a colour
+        glClearColor(clear_color.x * clear_color.w, clear_color.y * clear_color.w, clear_color.z * clear_color.w, clear_color.w);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT); // also clear the depth buffer now!
+
+        int query = frameIndex % 2;
+        if (queryPending[query])
+        {
+            GLuint64 elapsed;
+            glGetQueryObjectui64v(timerQueries[query], GL_QUERY_RESULT, &elapsed);
+            accumulated.gpuRocksMs += elapsed / 1e6;
+        }
+
+		// Rendering commands
+		draw(rockShader, proceduralShader, rockModel, timerQueries[query]);
+        queryPending[query] = true;
+        frameIndex++;
+
+        ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+
+		// check and call events and swap the buffers
+		glfwSwapBuffers(window);
+
+        accumulated.frameMs += deltaTime * 1000.0;
+        accumulated.instanceUpdateMs += instanceUpdateMs;
+        accumulatedFrames++;
+        if (glfwGetTime() - statsStart >= 1.0)
+        {
+            frameStats.frameMs = accumulated.frameMs / accumulatedFrames;
+            frameStats.gpuRocksMs = accumulated.gpuRocksMs / accumulatedFrames;
+            frameStats.instanceUpdateMs = accumulated.instanceUpdateMs / accumulatedFrames;
+            accumulated = FrameStats();
+            accumulatedFrames = 0;
+            statsStart = glfwGetTime();
+        }
+	}
+
+    glDeleteQueries(2, timerQueries);
+}
+
+void framebuffer_size_callback(GLFWwindow* window, int width, int height)
+{
+    glViewport(0, 0, width, height);
+}
+
+void key_callback(GLFWwindow* window, int key, int scancode, int action, int mods)
+{
+    if (key == GLFW_KEY_F && action == GLFW_PRESS)
+    {
+        if (imGuiMode) 
+        {
+            glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+        } 
+        else
+        {
+            glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_NORMAL);
+        }
+        imGuiMode = !imGuiMode;
+    }
+    if (key == GLFW_KEY_P && action == GLFW_PRESS)
+    {
+        pickRequested = true;
+    }
+}
+
+void processInput(GLFWwindow *window)
+{
+    if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS) 
+    {
+		glfwSetWindowShouldClose(window, true);
+	}
+
+    float currentFrame = glfwGetTime();
+    deltaTime = currentFrame - lastFrame;
+    lastFrame = currentFrame;
+
+    const float cameraSpeed = 50.0f * deltaTime; // adjust accordingly
+                                                //
+    if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS || joystick.leftY < -0.3)
+    {
+        cameraPos += (cameraSpeed * cameraFront);
+    }
+    if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS || joystick.leftY > 0.3)
+    {
+        cameraPos -= (cameraSpeed * cameraFront);
+    }
+    if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS || joystick.leftX < -0.3)
+    {
+        cameraPos -= (glm::normalize(glm::cross(cameraFront, cameraUp)) * cameraSpeed);
+    }
+    if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS || joystick.leftX > 0.3)
+    {
+        cameraPos += (glm::normalize(glm::cross(cameraFront, cameraUp)) * cameraSpeed);
+    }
+
+    if (joystickPresent)
+    {
+        if (joystick.R2 > -0.3)
+        {
+            fov -= (joystick.R2 + 1);
+        }
+        if (joystick.L2 > -0.3)
+        {
+            fov += (joystick.L2);
+        }
+    }
+
+    if (fov < 1.0f)
+    {
+        fov = 1.0f;
+    }
+    if (fov > 45.0f)
+    {
+        fov = 45.0f; 
+    }
+
+    joystick_callback(window, joystick.rightX, joystick.rightY);
+}
+
+/*
+    1. Calculate the mouse's offset since the last frame.
+    2. Add the offset values to the camera's yaw and pitch values.
+    3. Add some constraints to the minimum/maximum pitch values.
+    4. Calculate the direction vector.
+*/
+void mouse_callback(GLFWwindow* window, double xpos, double ypos)
+{
+    if (imGuiMode) 
+    {
+        return;
+    }
+    if (firstMouse)
+    {
+        lastMouseX = xpos;
+        lastMouseY = ypos;
+        firstMouse = false;
+    }
+
+    float xoffset = xpos - lastMouseX;
+    float yoffset = lastMouseY - ypos; // reversed since y-coordinates range from bottom to top
+    lastMouseX = xpos;
+    lastMouseY = ypos;
+
+    const float sensitivity = 0.1f;
+    xoffset *= sensitivity;
+    yoffset *= sensitivity;
+
+    yaw   += xoffset;
+    pitch += yoffset;
+
+    if (pitch > 89.0f)
+    {
+        pitch =  89.0f;
+    }
+    if (pitch < -89.0f)
+    {
+        pitch = -89.0f;
+    }
+
+    glm::vec3 direction;
+    direction.x = cos(glm::radians(yaw)) * cos(glm::radians(pitch));
+    direction.y = sin(glm::radians(pitch));
+    direction.z = sin(glm::radians(yaw)) * cos(glm::radians(pitch));
+    cameraFront = glm::normalize(direction);
+}
+
+void joystick_callback(GLFWwindow* window, double xpos, double ypos)
+{
+    if (xpos > 0.3 || xpos < -0.3 || ypos > 0.3 || ypos < -0.3)
+    {
+        lastMouseX -= xpos;
+        lastMouseY += ypos;
+        
+        const float sensitivity = 3.0f;
+        float xoffset = xpos * sensitivity;
+        float yoffset = ypos * sensitivity;
+
+        yaw   += xoffset;
+        pitch -= yoffset;
+
+        if (pitch > 89.0f)
+        {
+            pitch =  89.0f;
+        }
+        if (pitch < -89.0f)
+        {
+            pitch = -89.0f;
+        }
+
+        glm::vec3 direction;
+        direction.x = cos(glm::radians(yaw)) * cos(glm::radians(pitch));
+        direction.y = sin(glm::radians(pitch));
+        direction.z = sin(glm::radians(yaw)) * cos(glm::radians(pitch));
+        cameraFront = glm::normalize(direction);
+    }
+}
+
+void scroll_callback(GLFWwindow* window, double xoffset, double yoffset)
+{
+    fov -= (float)yoffset;
+}
+
+// Buffer mode: the CPU evaluates every rock for this frame and uploads them, returns the time it took in ms.
+double updateInstanceBuffer(InstanceBuffer& instances)
+{
+    double start = glfwGetTime();
+    packedTransforms.resize(ASTEROID_AMOUNT);
+    evaluateProceduralAsteroids(asteroidRing, static_cast<uint32_t>(asteroidSeed), 0, ASTEROID_AMOUNT, simulationTime, packedTransforms.data(), &asteroidPool);
+    instances.upload(packedTransforms.data(), packedTransforms.size());
+    return (glfwGetTime() - start) * 1000.0;
+}
+
+void draw(Shader& rockShader, Shader& proceduralShader, Model& rockModel, unsigned int timerQuery)
+{
+    glm::mat4 view = glm::lookAt(cameraPos, // Camera Pos
+                                 cameraPos + cameraFront, // Target Pos
+                                 cameraUp); // Up Vector
+    view = glm::translate(view, VIEW_OFFSET);
+    glm::mat4 projection = glm::perspective(glm::radians(fov), (float)WINDOW_WIDTH / (float)WINDOW_HEIGHT, 0.1f, 3000.0f);
+
+    // the CPU knows where every rock can be, so the whole belt is skipped when its bounds are off screen
+    glm::vec3 boundsMin, boundsMax;
+    proceduralRingBounds(asteroidRing, boundsMin, boundsMax);
+    glm::vec3 margin(asteroidRing.scaleMax * rockRadius);
+    beltCulled = !boxInFrustum(projection * view, boundsMin - margin, boundsMax + margin);
+
+    Shader& shader = proceduralMode ? proceduralShader : rockShader;
+    shader.use();
+    shader.setMat4("projection", projection);
+    shader.setMat4("view", view);
+    shader.setInt("texture_diffuse1", 0);
+    if (proceduralMode)
+    {
+        setProceduralUniforms(shader.ID, asteroidRing, static_cast<uint32_t>(asteroidSeed), simulationTime);
+    }
+
+    glBeginQuery(GL_TIME_ELAPSED, timerQuery);
+    if (!beltCulled)
+    {
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, rockModel.textures_loaded[0].id); // note: we also made the textures_loaded vector public (instead of private) from the model class.
+        for (unsigned int i = 0; i < rockModel.meshes.size(); i++)
+        {
+            glBindVertexArray(rockModel.meshes[i].VAO);
+            glDrawElementsInstanced(GL_TRIANGLES, static_cast<unsigned int>(rockModel.meshes[i].indices.size()), GL_UNSIGNED_INT, 0, ASTEROID_AMOUNT);
+            glBindVertexArray(0);
+        }
+    }
+    glEndQuery(GL_TIME_ELAPSED);
+}
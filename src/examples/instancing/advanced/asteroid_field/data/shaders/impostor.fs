@@ -0,0 +1,16 @@
+#version 330 core
+out vec4 FragColor;
+
+in vec2 AtlasCoords;
+
+uniform sampler2D impostorAtlas;
+
+void main()
+{
+    vec4 color = texture(impostorAtlas, AtlasCoords);
+    if (color.a < 0.5)
+    {
+        discard;
+    }
+    FragColor = vec4(color.rgb, 1.0);
+}
@@ -0,0 +1,70 @@
+#version 330 core
+layout (location = 0) in vec2 aCorner;
+layout (location = 3) in vec4 aInstancePositionScale;
+layout (location = 4) in vec4 aInstanceRotation;
+
+out vec2 AtlasCoords;
+
+uniform mat4 projection;
+uniform mat4 view;
+uniform vec3 cameraPosition;
+uniform int atlasGridSize;
+uniform float impostorRadius;
+
+// Rotate v by the unit quaternion q (xyz = vector part, w = scalar part).
+vec3 rotate(vec4 q, vec3 v)
+{
+    vec3 t = 2.0 * cross(q.xyz, v);
+    return v + q.w * t + cross(q.xyz, t);
+}
+
+vec2 signNotZero(vec2 v)
+{
+    return vec2(v.x >= 0.0 ? 1.0 : -1.0, v.y >= 0.0 ? 1.0 : -1.0);
+}
+
+// Same octahedral mapping and view basis the atlas was captured with (impostor_atlas.cpp).
+vec2 octahedralEncode(vec3 direction)
+{
+    direction /= abs(direction.x) + abs(direction.y) + abs(direction.z);
+    vec2 coordinates = direction.xz;
+    if (direction.y < 0.0)
+    {
+        coordinates = (1.0 - abs(coordinates.yx)) * signNotZero(coordinates);
+    }
+    return coordinates;
+}
+
+vec3 octahedralDecode(vec2 coordinates)
+{
+    vec3 direction = vec3(coordinates.x, 1.0 - abs(coordinates.x) - abs(coordinates.y), coordinates.y);
+    if (direction.y < 0.0)
+    {
+        direction.xz = (1.0 - abs(direction.zx)) * signNotZero(direction.xz);
+    }
+    return normalize(direction);
+}
+
+void main()
+{
+    vec4 rotation = normalize(aInstanceRotation);
+    vec3 position = aInstancePositionScale.xyz;
+    vec4 inverseRotation = vec4(-rotation.xyz, rotation.w);
+
+    // direction to the camera in the rock's own space, snapped to the nearest captured view
+    vec3 toCamera = rotate(inverseRotation, normalize(cameraPosition - position));
+    float lastCell = float(atlasGridSize - 1);
+    vec2 cell = floor((octahedralEncode(toCamera) * 0.5 + 0.5) * lastCell + 0.5);
+    vec3 direction = octahedralDecode(cell / lastCell * 2.0 - 1.0);
+
+    vec3 reference = abs(direction.y) > 0.999 ? vec3(0.0, 0.0, 1.0) : vec3(0.0, 1.0, 0.0);
+    vec3 right = normalize(cross(-direction, reference));
+    vec3 up = cross(right, -direction);
+
+    // the quad lies in the plane the view was captured on, rotated along with the rock
+    vec3 offset = (right * aCorner.x + up * aCorner.y) * impostorRadius * aInstancePositionScale.w;
+    vec3 worldPos = position + rotate(rotation, offset);
+
+    AtlasCoords = (cell + aCorner * 0.5 + 0.5) / float(atlasGridSize);
+    gl_Position = projection * view * vec4(worldPos, 1.0);
+}
@@ -0,0 +1,31 @@
+#version 330 core
+layout (location = 0) in vec3 aPos;
+layout (location = 2) in vec2 aTexCoords;
+layout (location = 3) in vec4 aInstancePositionScale;
+layout (location = 4) in vec4 aInstanceRotation;
+layout (location = 5) in uint aInstanceLayer;
+
+out vec2 TexCoords;
+flat out uint Layer;
+
+uniform mat4 projection;
+uniform mat4 view;
+
+// Rotate v by the unit quaternion q (xyz = vector part, w = scalar part).
+vec3 rotate(vec4 q, vec3 v)
+{
+    vec3 t = 2.0 * cross(q.xyz, v);
+    return v + q.w * t + cross(q.xyz, t);
+}
+
+// rock_shader.vs plus the texture array layer of each instance, drawn with layered.fs.
+void main()
+{
+    // The 16 bit quaternion is only approximately unit length, renormalise it before use.
+    vec4 rotation = normalize(aInstanceRotation);
+    vec3 worldPos = rotate(rotation, aPos * aInstancePositionScale.w) + aInstancePositionScale.xyz;
+
+    TexCoords = aTexCoords;
+    Layer = aInstanceLayer;
+    gl_Position = projection * view * vec4(worldPos, 1.0f);
+}
@@ -0,0 +1,116 @@
+#version 330 core
+layout (location = 0) in vec3 aPos;
+layout (location = 2) in vec2 aTexCoords;
+
+out vec2 TexCoords;
+
+// Only read back by the transform feedback check, the fragment shader ignores them.
+out vec4 vProceduralPositionScale;
+out vec4 vProceduralRotation;
+flat out uvec4 vProceduralBits;
+flat out uvec2 vProceduralShapeBits;
+
+uniform mat4 projection;
+uniform mat4 view;
+
+// Everything that defines the field, no per-instance data: each rock is derived from gl_InstanceID.
+// Mirrors evaluateProceduralAsteroid in lib/procedural_asteroid.cpp, keep the two in sync.
+uniform uint seed;
+uniform float time;
+uniform float gravity;
+uniform float ringRadius;
+uniform float ringWidth;
+uniform float ringHeightMin;
+uniform float ringHeightMax;
+uniform float ringScaleMin;
+uniform float ringScaleMax;
+uniform vec3 rotationAxis;      // normalised
+uniform float minSpinSpeed;
+uniform float maxSpinSpeed;
+
+const uint STREAM_RING_ANGLE = 0u;
+const uint STREAM_OFFSET_X = 1u;
+const uint STREAM_OFFSET_Y = 2u;
+const uint STREAM_SCALE = 4u;
+const uint STREAM_ROTATION = 5u;
+const uint STREAM_SPIN = 6u;
+
+const float PI = 3.14159265358979;
+const float TWO_PI = 6.28318530717959;
+
+uint pcgHash(uint value)
+{
+    uint state = value * 747796405u + 2891336453u;
+    uint word = ((state >> ((state >> 28u) + 4u)) ^ state) * 277803737u;
+    return (word >> 22u) ^ word;
+}
+
+uint counterRandom(uint hashedIndex, uint stream)
+{
+    return pcgHash(hashedIndex ^ pcgHash(seed ^ pcgHash(stream)));
+}
+
+float unitFloat(uint bits)
+{
+    return float(bits >> 8u) * (1.0 / 16777216.0);
+}
+
+float wrapAngle(float angle)
+{
+    return angle - TWO_PI * floor((angle + PI) * (1.0 / TWO_PI));
+}
+
+// sin and cos for x in [-pi/2, pi/2], the same series as fast_trig.hpp.
+vec2 sinCosHalfRange(float x)
+{
+    float x2 = x * x;
+    float s = x * (1.0 + x2 * (-1.0 / 6.0 + x2 * (1.0 / 120.0 + x2 * (-1.0 / 5040.0 + x2 * (1.0 / 362880.0)))));
+    float c = 1.0 + x2 * (-0.5 + x2 * (1.0 / 24.0 + x2 * (-1.0 / 720.0 + x2 * (1.0 / 40320.0 + x2 * (-1.0 / 3628800.0)))));
+    return vec2(s, c);
+}
+
+vec3 rotate(vec4 q, vec3 v)
+{
+    vec3 t = 2.0 * cross(q.xyz, v);
+    return v + q.w * t + cross(q.xyz, t);
+}
+
+void main()
+{
+    uint hashedIndex = pcgHash(uint(gl_InstanceID));
+    uint angleBits = counterRandom(hashedIndex, STREAM_RING_ANGLE);
+    uint radiusBits = counterRandom(hashedIndex, STREAM_OFFSET_X);
+    uint heightBits = counterRandom(hashedIndex, STREAM_OFFSET_Y);
+    uint scaleBits = counterRandom(hashedIndex, STREAM_SCALE);
+    uint rotationBits = counterRandom(hashedIndex, STREAM_ROTATION);
+    uint spinBits = counterRandom(hashedIndex, STREAM_SPIN);
+
+    float radius = ringRadius + (unitFloat(radiusBits) * 2.0 - 1.0) * ringWidth;
+    float angularVelocity = sqrt(gravity / (radius * radius * radius));
+    float angle = wrapAngle((unitFloat(angleBits) - 0.5) * 2.0 * PI + angularVelocity * time);
+
+    float spinSpeed = minSpinSpeed + unitFloat(spinBits) * (maxSpinSpeed - minSpinSpeed);
+    if ((spinBits & 1u) == 0u)
+    {
+        spinSpeed = -spinSpeed;
+    }
+    float spin = wrapAngle((unitFloat(rotationBits) - 0.5) * 2.0 * PI + spinSpeed * time);
+
+    vec2 orbit = sinCosHalfRange(angle * 0.5);
+    float sinAngle = 2.0 * orbit.x * orbit.y;
+    float cosAngle = orbit.y * orbit.y - orbit.x * orbit.x;
+    vec3 position = vec3(sinAngle * radius, ringHeightMin + unitFloat(heightBits) * (ringHeightMax - ringHeightMin), cosAngle * radius);
+    float scale = ringScaleMin + unitFloat(scaleBits) * (ringScaleMax - ringScaleMin);
+
+    vec2 spinHalf = sinCosHalfRange(spin * 0.5);
+    vec4 rotation = vec4(rotationAxis * spinHalf.x, spinHalf.y);
+
+    vProceduralPositionScale = vec4(position, scale);
+    vProceduralRotation = rotation;
+    vProceduralBits = uvec4(angleBits, radiusBits, rotationBits, spinBits);
+    vProceduralShapeBits = uvec2(heightBits, scaleBits);
+
+    vec3 worldPos = rotate(rotation, aPos * scale) + position;
+    TexCoords = aTexCoords;
+    gl_Position = projection * view * vec4(worldPos, 1.0f);
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include "./instance_transform.hpp"
+#include "../../../../../headers/thread_pool.hpp"
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+
+/*
+ * Counter-based random numbers: every value is a pure function of (seed, index, stream),
+ * so instances can be generated in any order, on any thread, and always come out the same for a given seed.
+ * Each instance draws from its own index and each property (angle, scale, ...) from its own stream.
+ */
+uint32_t pcgHash(uint32_t value);
+uint32_t counterRandom(uint32_t seed, uint32_t index, uint32_t stream);
+// Uniform in [0, 1), 24 bits of precision.
+float counterRandomFloat(uint32_t seed, uint32_t index, uint32_t stream);
+
+enum AsteroidRandomStream : uint32_t {
+    ASTEROID_STREAM_RING_ANGLE = 0,
+    ASTEROID_STREAM_OFFSET_X,
+    ASTEROID_STREAM_OFFSET_Y,
+    ASTEROID_STREAM_OFFSET_Z,
+    ASTEROID_STREAM_SCALE,
+    ASTEROID_STREAM_ROTATION,
+    ASTEROID_STREAM_SPIN
+};
+
+// Orbits and spins of moving rocks (OrbitSimulation and the procedural shader):
+// angular velocity = sqrt(ASTEROID_ORBIT_GRAVITY / radius^3), spin speeds in [MIN, MAX] radians per second in either direction.
+const float ASTEROID_ORBIT_GRAVITY = 37000.0f;
+const float ASTEROID_MIN_SPIN_SPEED = 0.2f;
+const float ASTEROID_MAX_SPIN_SPEED = 1.5f;
+
+// Shape of the field: rocks scattered around a circle of `radius` in the xz plane.
+struct AsteroidRing {
+    float radius = 150.0f;
+    float width = 25.0f;        // xz displacement in [-width, width)
+    float heightMin = -10.0f;
+    float heightMax = 10.0f;
+    float scaleMin = 0.05f;
+    float scaleMax = 0.25f;
+    glm::vec3 rotationAxis = glm::vec3(0.4f, 0.6f, 0.8f);
+};
+
+/*
+ * Fill instances [first, first + count) of `transforms` (which must already be large enough).
+ * Instance i only depends on (ring, seed, i), so growing a field generates just the new rocks
+ * and the existing ones stay where they were. With a pool the range is split across its workers.
+ */
+void generateAsteroidRing(const AsteroidRing& ring, uint32_t seed, InstanceTransforms& transforms, size_t first, size_t count, ThreadPool* pool = nullptr);
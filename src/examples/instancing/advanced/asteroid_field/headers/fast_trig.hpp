@@ -0,0 +1,49 @@
+#pragma once
+
+/*
+ * Sine and cosine for angles in [-pi/2, pi/2] as plain polynomials, shared by the asteroid generation and simulation.
+ * Accurate to ~3e-5 in that range, which is plenty for placing and spinning rocks, and several times cheaper than
+ * std::sin/std::cos. Full angles go through the half angle: sin(a) = 2 sin(a/2) cos(a/2), cos(a) = cos^2(a/2) - sin^2(a/2).
+ * The AVX2 versions evaluate in the same order without fused multiply-adds, so both give bit-identical results.
+ */
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define ASTEROID_X86 1
+#endif
+
+inline void sinCosHalfRange(float x, float& s, float& c)
+{
+    float x2 = x * x;
+    s = x * (1.0f + x2 * (-1.0f / 6.0f + x2 * (1.0f / 120.0f + x2 * (-1.0f / 5040.0f + x2 * (1.0f / 362880.0f)))));
+    c = 1.0f + x2 * (-0.5f + x2 * (1.0f / 24.0f + x2 * (-1.0f / 720.0f + x2 * (1.0f / 40320.0f + x2 * (-1.0f / 3628800.0f)))));
+}
+
+#ifdef ASTEROID_X86
+inline bool hasAvx2()
+{
+    static const bool supported = __builtin_cpu_supports("avx2");
+    return supported;
+}
+
+__attribute__((target("avx2")))
+inline __m256 evaluatePolynomial8(__m256 x2, const float* coefficients, int count)
+{
+    __m256 result = _mm256_set1_ps(coefficients[count - 1]);
+    for (int i = count - 2; i >= 0; i--)
+    {
+        result = _mm256_add_ps(_mm256_set1_ps(coefficients[i]), _mm256_mul_ps(x2, result));
+    }
+    return result;
+}
+
+__attribute__((target("avx2")))
+inline void sinCosHalfRange8(__m256 x, __m256& s, __m256& c)
+{
+    static const float SIN_COEFFICIENTS[5] = {1.0f, -1.0f / 6.0f, 1.0f / 120.0f, -1.0f / 5040.0f, 1.0f / 362880.0f};
+    static const float COS_COEFFICIENTS[6] = {1.0f, -0.5f, 1.0f / 24.0f, -1.0f / 720.0f, 1.0f / 40320.0f, -1.0f / 3628800.0f};
+    __m256 x2 = _mm256_mul_ps(x, x);
+    s = _mm256_mul_ps(x, evaluatePolynomial8(x2, SIN_COEFFICIENTS, 5));
+    c = evaluatePolynomial8(x2, COS_COEFFICIENTS, 6);
+}
+#endif
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <glad/glad.h>
+
+/*
+ * The GL entry points past 3.3 the benchmark can use when the driver has them. glad is generated for 3.3 core only,
+ * so these are looked up by hand after the context is current; every pointer stays null when unsupported.
+ *   drawIndirect       GL 4.0 / ARB_draw_indirect        glDrawElementsIndirect
+ *   multiDrawIndirect  GL 4.3 / ARB_multi_draw_indirect  glMultiDrawElementsIndirect
+ *   baseInstance       GL 4.2 / ARB_base_instance        indirect commands may start past instance 0
+ */
+
+#ifndef GL_DRAW_INDIRECT_BUFFER
+#define GL_DRAW_INDIRECT_BUFFER 0x8F3F
+#endif
+
+typedef void (APIENTRYP DrawElementsIndirectProc)(GLenum mode, GLenum type, const void* indirect);
+typedef void (APIENTRYP MultiDrawElementsIndirectProc)(GLenum mode, GLenum type, const void* indirect, GLsizei drawCount, GLsizei stride);
+
+// Layout of one command in GL_DRAW_INDIRECT_BUFFER, fixed by the spec.
+struct DrawElementsIndirectCommand {
+    GLuint count;
+    GLuint instanceCount;
+    GLuint firstIndex;
+    GLint baseVertex;
+    GLuint baseInstance;
+};
+
+struct GlExtensions {
+    int major = 0;
+    int minor = 0;
+    bool drawIndirect = false;
+    bool multiDrawIndirect = false;
+    bool baseInstance = false;
+    DrawElementsIndirectProc drawElementsIndirect = nullptr;
+    MultiDrawElementsIndirectProc multiDrawElementsIndirect = nullptr;
+};
+
+extern GlExtensions glExtensions;
+
+// Fill glExtensions for the current context with `load` (e.g. glfwGetProcAddress), after gladLoadGLLoader.
+void loadGlExtensions(GLADloadproc load);
+bool hasGlExtension(const char* name);
@@ -0,0 +1,51 @@
+#pragma once
+
+#include "./model.hpp"
+#include "./shader.hpp"
+
+#include <glm/glm.hpp>
+
+/*
+ * A model pre-rendered from gridSize x gridSize view directions into one texture, so distant instances can be
+ * drawn as a single textured quad. The directions are an octahedral map of the whole sphere: tile (x, y) holds
+ * the view from octahedralDecode((x, y) / (gridSize - 1) * 2 - 1), looking at the origin with impostorViewBasis.
+ * data/shaders/impostor.vs picks the tile closest to the camera with the same functions, keep them in sync.
+ */
+class ImpostorAtlas
+{
+    public:
+        ImpostorAtlas() = default;
+        ~ImpostorAtlas();
+
+        ImpostorAtlas(const ImpostorAtlas&) = delete;
+        ImpostorAtlas& operator=(const ImpostorAtlas&) = delete;
+
+        // Read the atlas from `cachePath` if it is newer than `modelPath` and has the same layout, otherwise render it
+        // with `captureShader` (model/view/projection uniforms, e.g. planet_shader.vs) and write the cache. True if it was cached.
+        bool loadOrBuild(Model& model, Shader& captureShader, const char* modelPath, const char* cachePath, int gridSize = 8, int tileSize = 64);
+
+        void build(Model& model, Shader& captureShader, int gridSize, int tileSize);
+        bool readCache(const char* path, int gridSize, int tileSize);
+        bool writeCache(const char* path) const;
+
+        unsigned int getTexture() const;
+        int getGridSize() const;
+        // Bounding sphere of the model around its origin, every tile covers [-radius, radius] in both directions.
+        float getRadius() const;
+
+    private:
+        void upload(const unsigned char* pixels);
+
+    private:
+        unsigned int texture = 0;
+        int gridSize = 0;
+        int tileSize = 0;
+        float radius = 1.0f;
+        std::vector<unsigned char> pixels;
+};
+
+// Octahedral mapping between unit directions and [-1, 1]^2, y is the pole axis.
+glm::vec2 octahedralEncode(glm::vec3 direction);
+glm::vec3 octahedralDecode(glm::vec2 coordinates);
+// Right and up of a camera at `direction` looking at the origin (as glm::lookAt builds it).
+void impostorViewBasis(const glm::vec3& direction, glm::vec3& right, glm::vec3& up);
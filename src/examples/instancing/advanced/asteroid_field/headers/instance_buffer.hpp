@@ -0,0 +1,47 @@
+#pragma once
+
+#include "./instance_transform.hpp"
+
+#include <unordered_set>
+
+/*
+ * GPU buffer of PackedInstanceTransform records that can be resized without leaking or re-binding.
+ *
+ * Capacity grows by doubling, so growing one instance at a time doesn't reallocate every time,
+ * and shrinking keeps the storage. Full rewrites orphan the old storage first (glBufferData with NULL)
+ * so the driver can hand back fresh memory instead of waiting for draws still reading the old contents.
+ * The buffer name never changes, so a mesh only needs its attributes bound once via attach().
+ */
+class InstanceBuffer
+{
+    public:
+        InstanceBuffer();
+        ~InstanceBuffer();
+
+        InstanceBuffer(const InstanceBuffer&) = delete;
+        InstanceBuffer& operator=(const InstanceBuffer&) = delete;
+
+        // Bind the instance attributes of every mesh VAO, meshes that are already attached are skipped.
+        void attach(Model& model);
+        void attach(Mesh& mesh);
+        void attach(unsigned int vao);
+
+        // Replace the whole contents with `count` instances.
+        void upload(const PackedInstanceTransform* instances, size_t count);
+        // Overwrite instances [first, first + count), growing the buffer (and keeping [0, first)) if needed.
+        void update(size_t first, size_t count, const PackedInstanceTransform* instances);
+
+        size_t size() const;
+        size_t capacity() const;
+        unsigned int id() const;
+
+    private:
+        size_t grownCapacity(size_t required) const;
+        void reallocate(size_t newCapacity);
+
+    private:
+        unsigned int bufferId = 0;
+        size_t instanceCount = 0;
+        size_t instanceCapacity = 0;
+        std::unordered_set<unsigned int> attachedVaos;
+};
@@ -0,0 +1,37 @@
+#pragma once
+
+#include "./instance_transform.hpp"
+
+#include <glm/glm.hpp>
+
+#include <vector>
+
+/*
+ * Instances sorted by a grid over the xz plane so every cell is one contiguous range of the instance buffer.
+ * Each frame the cells are culled and split by distance into ranges drawn as meshes and ranges drawn as impostors,
+ * without touching the per-instance data (the draws just start at a different instance, see bindInstanceAttributes).
+ */
+struct InstanceCell {
+    size_t first = 0;
+    size_t count = 0;
+    glm::vec3 boundsMin;    // around the instance centres, the caller pads by the largest instance radius
+    glm::vec3 boundsMax;
+};
+
+struct InstanceRange {
+    size_t first = 0;
+    size_t count = 0;
+};
+
+// Pack `transforms` into `sorted` in cell order, `cells` gets the non-empty cells in the same order.
+void sortInstancesIntoCells(const InstanceTransforms& transforms, float cellSize, std::vector<PackedInstanceTransform>& sorted, std::vector<InstanceCell>& cells);
+
+/*
+ * Skip cells outside the frustum, cells closer than `impostorDistance` to `eye` go to `meshRanges`, the rest to
+ * `impostorRanges`. Neighbouring cells in the same bucket are merged into one range, so one draw each.
+ */
+void bucketInstanceCells(const std::vector<InstanceCell>& cells, const glm::mat4& viewProjection, const glm::vec3& eye, float impostorDistance,
+    float padding, std::vector<InstanceRange>& meshRanges, std::vector<InstanceRange>& impostorRanges);
+
+// A box is outside if all 8 corners are beyond the same clip plane.
+bool boxInFrustum(const glm::mat4& viewProjection, const glm::vec3& boundsMin, const glm::vec3& boundsMax);
@@ -0,0 +1,59 @@
+#pragma once
+
+#include "./model.hpp"
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <cstdint>
+#include <vector>
+
+// First vertex attribute location used by the instance data, after position (0), normal (1) and tex coords (2).
+const unsigned int INSTANCE_ATTRIBUTE_LOCATION = 3;
+// Texture array layer of each instance, a separate stream of uint16_t next to the transforms (see TextureArray).
+const unsigned int INSTANCE_LAYER_ATTRIBUTE_LOCATION = 5;
+
+/*
+ * Per-instance data as it is stored on the GPU, 24 bytes instead of the 64 of a mat4.
+ * Instances are limited to translate * uniform scale * rotate, which is all the asteroid demos need,
+ * and the vertex shader rebuilds the transform from it (see rock_shader.vs).
+ *   location 3: position (xyz) and uniform scale (w), floats
+ *   location 4: rotation quaternion (xyzw), normalised 16 bit signed integers
+ */
+struct PackedInstanceTransform {
+    glm::vec4 positionScale;
+    int16_t rotation[4];
+
+    // A quaternion component as stored in `rotation`: clamped to [-1, 1] and rounded half to even like
+    // _mm256_cvtps_epi32, so every path that packs rotations (SIMD or not) produces the same values.
+    static int16_t toSnorm16(float value);
+};
+static_assert(sizeof(PackedInstanceTransform) == 24, "PackedInstanceTransform must stay tightly packed");
+
+/*
+ * CPU side copy of the instance transforms, one array per component (structure of arrays),
+ * so loops that only touch some components (e.g. positions) stream through contiguous memory.
+ */
+struct InstanceTransforms {
+    std::vector<float> positionX, positionY, positionZ;
+    std::vector<float> scale;
+    std::vector<float> rotationX, rotationY, rotationZ, rotationW;
+
+    size_t size() const;
+    void resize(size_t count);
+    void set(size_t index, const glm::vec3& position, float uniformScale, const glm::quat& rotation);
+
+    // Convert [first, first + count) into the GPU layout, `out` must hold `count` entries.
+    void pack(size_t first, size_t count, PackedInstanceTransform* out) const;
+};
+
+// Point the instance attributes of every mesh VAO in `model` at `instanceBuffer` (divisor 1).
+// GL 3.3 has no base instance, so drawing a sub-range of the buffer means re-pointing them at `firstInstance`.
+void bindInstanceAttributes(Model& model, unsigned int instanceBuffer, size_t firstInstance = 0);
+void bindInstanceAttributes(Mesh& mesh, unsigned int instanceBuffer, size_t firstInstance = 0);
+void bindInstanceAttributes(unsigned int vao, unsigned int instanceBuffer, size_t firstInstance = 0);
+
+// Point the layer attribute of every mesh VAO at `layerBuffer`, a tightly packed uint16_t per instance (divisor 1).
+// Sub-range draws re-point it at `firstInstance` together with the transforms.
+void bindInstanceLayers(Model& model, unsigned int layerBuffer, size_t firstInstance = 0);
+void bindInstanceLayers(unsigned int vao, unsigned int layerBuffer, size_t firstInstance = 0);
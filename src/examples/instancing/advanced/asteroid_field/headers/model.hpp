@@ -8,11 +8,15 @@
 
 #include "../../../../../headers/stb_image.h"
 
+class TextureArray;
+
 class Model 
 {
     public:
         Model(char* path);
         void Draw(Shader &shader);	
+        // Add every loaded texture of type `typeName` as a layer of `layers`, returns the layer of the first one (-1 if none).
+        int addTextureLayers(TextureArray& layers, const std::string& typeName = "texture_diffuse");
 
     public:
         std::vector<Mesh> meshes;
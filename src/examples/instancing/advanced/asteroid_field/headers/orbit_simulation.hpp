@@ -0,0 +1,58 @@
+#pragma once
+
+#include "./asteroid_ring.hpp"
+#include "./instance_transform.hpp"
+#include "../../../../../headers/thread_pool.hpp"
+
+#include <future>
+#include <vector>
+
+/*
+ * Moves every asteroid along its own circular orbit and spins it around the ring's rotation axis.
+ * Orbits follow Kepler's third law, angular velocity = sqrt(gravity / radius^3), so the inner rocks overtake the outer ones.
+ *
+ * The state is kept as a structure of arrays and stepped on the thread pool (8 rocks at a time with AVX2).
+ * Results go into two PackedInstanceTransform buffers: start() simulates the next frame into the back buffer
+ * on the workers while the render thread uploads and draws the front one, finish() waits and swaps them.
+ */
+class OrbitSimulation
+{
+    public:
+        OrbitSimulation(ThreadPool& pool, float gravity = ASTEROID_ORBIT_GRAVITY);
+        ~OrbitSimulation();
+
+        OrbitSimulation(const OrbitSimulation&) = delete;
+        OrbitSimulation& operator=(const OrbitSimulation&) = delete;
+
+        // Take the orbits from generated instances (orbit radius and angle from the xz position, spin from the rotation),
+        // spin speeds are drawn from the counter-based RNG so they're reproducible for a seed. Waits for a running step.
+        void reset(const AsteroidRing& ring, uint32_t seed, const InstanceTransforms& transforms);
+
+        // Begin advancing by `deltaTime` seconds on the pool, the front buffer stays untouched until finish().
+        void start(float deltaTime);
+        // Wait for the step started last (if any), make it the front buffer and return it.
+        const std::vector<PackedInstanceTransform>& finish();
+
+        size_t size() const;
+        double getLastStepMilliseconds() const;
+
+        // Step [begin, end) by `deltaTime` into `out`, synchronously on the calling thread.
+        void step(size_t begin, size_t end, float deltaTime, PackedInstanceTransform* out);
+
+    private:
+        void waitForStep();
+
+    private:
+        ThreadPool& pool;
+        float gravity;
+        glm::vec3 spinAxis = glm::vec3(0.0f, 1.0f, 0.0f);
+
+        std::vector<float> orbitRadius, orbitAngle, angularVelocity;
+        std::vector<float> height, scale;
+        std::vector<float> spinAngle, spinSpeed;
+
+        std::vector<PackedInstanceTransform> buffers[2];
+        int frontBuffer = 0;
+        std::future<double> pendingStep;
+        double lastStepMilliseconds = 0.0;
+};
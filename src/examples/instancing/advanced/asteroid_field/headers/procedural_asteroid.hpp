@@ -0,0 +1,68 @@
+#pragma once
+
+#include "./asteroid_ring.hpp"
+#include "./instance_transform.hpp"
+#include "../../../../../headers/thread_pool.hpp"
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <cstdint>
+
+/*
+ * Asteroids that exist only as a function of (ring, seed, index, time), with no per-instance memory.
+ * data/shaders/rock_procedural.vs evaluates the same function from gl_InstanceID, this is the CPU copy
+ * for culling bounds, picking and filling instance buffers; keep the two in sync.
+ *
+ * Each rock circles the centre on its own orbit:
+ *   orbit radius  ring.radius + [-width, width)        (ASTEROID_STREAM_OFFSET_X)
+ *   orbit angle   [-pi, pi) + sqrt(gravity / r^3) * t   (ASTEROID_STREAM_RING_ANGLE)
+ *   height        [heightMin, heightMax)               (ASTEROID_STREAM_OFFSET_Y)
+ *   scale         [scaleMin, scaleMax)                 (ASTEROID_STREAM_SCALE)
+ *   spin          [-pi, pi) + speed * t around ring.rotationAxis (ASTEROID_STREAM_ROTATION, ASTEROID_STREAM_SPIN)
+ */
+struct ProceduralAsteroid {
+    glm::vec3 position;
+    float scale;
+    glm::quat rotation;
+};
+
+// The raw hash bits the values above are derived from, compared bit for bit against the shader's by the startup check.
+struct ProceduralAsteroidBits {
+    uint32_t angle, radius, height, scale;
+    uint32_t rotation, spin;
+};
+
+ProceduralAsteroid evaluateProceduralAsteroid(const AsteroidRing& ring, uint32_t seed, uint32_t index, float time, float gravity = ASTEROID_ORBIT_GRAVITY);
+ProceduralAsteroidBits proceduralAsteroidBits(uint32_t seed, uint32_t index);
+
+// Fill out[0, count) with instances [first, first + count) in the GPU layout, split across the pool if given.
+void evaluateProceduralAsteroids(const AsteroidRing& ring, uint32_t seed, size_t first, size_t count, float time, PackedInstanceTransform* out,
+    ThreadPool* pool = nullptr, float gravity = ASTEROID_ORBIT_GRAVITY);
+
+// Box around every rock's centre at any time (the field is rotationally symmetric around y).
+void proceduralRingBounds(const AsteroidRing& ring, glm::vec3& boundsMin, glm::vec3& boundsMax);
+
+/*
+ * Closest of the first `count` rocks whose bounding sphere (scale * rockRadius) the ray hits, or -1.
+ * `rayDirection` must be normalised.
+ */
+long pickProceduralAsteroid(const AsteroidRing& ring, uint32_t seed, size_t count, float time, const glm::vec3& rayOrigin, const glm::vec3& rayDirection,
+    float rockRadius, ThreadPool* pool = nullptr, float gravity = ASTEROID_ORBIT_GRAVITY);
+
+// Upload everything rock_procedural.vs needs for the field to `program`, which must be in use.
+void setProceduralUniforms(unsigned int program, const AsteroidRing& ring, uint32_t seed, float time, float gravity = ASTEROID_ORBIT_GRAVITY);
+
+struct ProceduralShaderCheck {
+    size_t checked = 0;
+    size_t bitMismatches = 0;       // hash outputs must agree exactly
+    float maxPositionError = 0.0f;  // the float maths only has to agree closely, GLSL doesn't promise IEEE rounding
+    float maxRotationError = 0.0f;
+    bool passed = false;
+};
+
+/*
+ * Run the procedural vertex shader for the first `count` rocks through transform feedback and compare
+ * what it computed with evaluateProceduralAsteroid. Needs a current context, unbinds everything it used.
+ */
+ProceduralShaderCheck checkProceduralShader(const char* vertexPath, const AsteroidRing& ring, uint32_t seed, float time, size_t count);
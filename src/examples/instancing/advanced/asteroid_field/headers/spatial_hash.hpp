@@ -0,0 +1,80 @@
+#pragma once
+
+#include "./instance_transform.hpp"
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <vector>
+
+struct SpatialHit {
+    long id = -1;           // -1 if nothing was hit
+    float distance = 0.0f;  // along the ray, or from the query point to the bounding sphere (0 inside it)
+};
+
+/*
+ * A loose uniform grid over instance bounding spheres for picking and proximity queries.
+ * Every instance lives in the one cell holding its centre, so moving it is O(1): it only changes buckets when it
+ * crosses into another cell. Queries widen their cell range by the largest radius seen to catch the overhang.
+ *
+ * The cells are hashed into a fixed number of buckets instead of being allocated over the bounds, so the grid needs
+ * no extent up front; cells sharing a bucket are told apart by the cell stored with every instance.
+ * Pick the cell size a few times the typical radius, and about one bucket per instance.
+ *
+ * Ids are dense indices (e.g. into the instance buffer). Queries are const and safe to run from several threads,
+ * edits aren't.
+ */
+class SpatialHashGrid
+{
+    public:
+        SpatialHashGrid(float cellSize, size_t bucketCount = 1 << 16);
+
+        void clear();
+        size_t size() const;
+        bool contains(uint32_t id) const;
+
+        void insert(uint32_t id, const glm::vec3& center, float radius);
+        // Inserts ids that aren't in the grid yet. True if the instance moved to another cell.
+        bool update(uint32_t id, const glm::vec3& center, float radius);
+        void remove(uint32_t id);
+        // Insert or update instances [0, count) from the GPU layout, radius = scale * baseRadius. Returns how many changed cell.
+        size_t updateAll(const PackedInstanceTransform* instances, size_t count, float baseRadius);
+
+        // Closest bounding sphere hit by the ray within `maxDistance`, `direction` must be normalised.
+        SpatialHit raycast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance) const;
+        // Ids of every bounding sphere overlapping the sphere / box, appended to `out` in no particular order.
+        void querySphere(const glm::vec3& center, float radius, std::vector<uint32_t>& out) const;
+        void queryBox(const glm::vec3& boundsMin, const glm::vec3& boundsMax, std::vector<uint32_t>& out) const;
+        // The `k` bounding spheres closest to `point`, nearest first (fewer if the grid holds fewer).
+        void nearest(const glm::vec3& point, size_t k, std::vector<SpatialHit>& out) const;
+
+    private:
+        // Indexed by id, so moving within a cell only writes here. Buckets hold the ids of the instances in their cells.
+        struct Entry {
+            glm::vec3 center;
+            float radius;
+            glm::ivec3 cell;
+            uint32_t slot;      // position in the bucket of `cell`, UINT32_MAX if the id isn't in the grid
+        };
+
+        glm::ivec3 cellOf(const glm::vec3& position) const;
+        size_t bucketOf(const glm::ivec3& cell) const;
+        void removeFromBucket(const Entry& entry);
+        // Cell range an axis aligned box (already padded by the overhang) covers, clamped to the occupied cells; false if empty.
+        bool cellRange(const glm::vec3& boundsMin, const glm::vec3& boundsMax, glm::ivec3& cellMin, glm::ivec3& cellMax) const;
+        // Call `visit(id, entry)` once for every instance in the cells [cellMin, cellMax].
+        template <typename Visit>
+        void visitCells(const glm::ivec3& cellMin, const glm::ivec3& cellMax, Visit&& visit) const;
+
+    private:
+        float cellSize;
+        float inverseCellSize;
+        std::vector<std::vector<uint32_t>> buckets;
+        std::vector<Entry> entries;
+        size_t count = 0;
+
+        // Only ever grow (until clear), which keeps queries correct without rescanning on removal.
+        float maxRadius = 0.0f;
+        glm::ivec3 occupiedMin = glm::ivec3(INT32_MAX);
+        glm::ivec3 occupiedMax = glm::ivec3(INT32_MIN);
+};
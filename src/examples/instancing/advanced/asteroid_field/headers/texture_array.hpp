@@ -0,0 +1,51 @@
+#pragma once
+
+#include "./model.hpp"
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/*
+ * Same-size RGBA images packed into the layers of one GL_TEXTURE_2D_ARRAY, so instances that only differ in
+ * their texture can share a single instanced draw and pick their layer with a per-instance index
+ * (see bindInstanceLayers and rock_layered.vs).
+ *
+ * Layers are collected on the CPU first and the texture is created by upload(), since the layer count
+ * has to be known up front. Images of another size are resampled to the layer size when they are added,
+ * the layer size is the one given to the constructor, or the size of the first image.
+ */
+class TextureArray
+{
+    public:
+        TextureArray(int width = 0, int height = 0);
+        ~TextureArray();
+
+        TextureArray(const TextureArray&) = delete;
+        TextureArray& operator=(const TextureArray&) = delete;
+
+        // Add an image file as a new layer and return its index, or -1 if it can't be loaded.
+        // A path that was added before returns its existing layer.
+        int addFile(const std::string& path);
+        // Add `width` x `height` RGBA pixels as a new layer and return its index.
+        int addPixels(const unsigned char* rgba, int width, int height);
+
+        // Create (or recreate) the GL texture from the layers added so far, with mipmaps.
+        void upload();
+        void bind(unsigned int unit) const;
+
+        unsigned int getTexture() const;
+        int getLayerCount() const;
+        int getWidth() const;
+        int getHeight() const;
+
+    private:
+        unsigned int texture = 0;
+        int width = 0;
+        int height = 0;
+        std::vector<std::vector<unsigned char>> layers;
+        std::unordered_map<std::string, int> fileLayers;
+};
+
+// Resample an RGBA image, averaging the covered source pixels when shrinking and filtering bilinearly when growing.
+std::vector<unsigned char> resampleRgba(const unsigned char* rgba, int width, int height, int newWidth, int newHeight);
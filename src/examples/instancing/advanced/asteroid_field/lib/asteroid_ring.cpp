@@ -0,0 +1,180 @@
+#include "../headers/asteroid_ring.hpp"
+#include "../headers/fast_trig.hpp"
+
+#include <glm/gtc/constants.hpp>
+
+// Instances per parallelFor batch, large enough that the per-batch overhead disappears.
+const size_t GENERATION_BATCH_SIZE = 16384;
+
+// The output permutation of the PCG random number generator used as a hash ("Hash Functions for GPU Rendering", Jarzynski & Olano).
+uint32_t pcgHash(uint32_t value)
+{
+    uint32_t state = value * 747796405u + 2891336453u;
+    uint32_t word = ((state >> ((state >> 28u) + 4u)) ^ state) * 277803737u;
+    return (word >> 22u) ^ word;
+}
+
+// The index is hashed on its own before the key is mixed in, so neighbouring seeds don't give shifted copies of the same sequence.
+uint32_t counterRandom(uint32_t seed, uint32_t index, uint32_t stream)
+{
+    uint32_t key = pcgHash(seed ^ pcgHash(stream));
+    return pcgHash(pcgHash(index) ^ key);
+}
+
+float counterRandomFloat(uint32_t seed, uint32_t index, uint32_t stream)
+{
+    return (counterRandom(seed, index, stream) >> 8) * (1.0f / 16777216.0f);
+}
+
+namespace
+{
+    const int STREAM_COUNT = 6;
+    const int LANES = 8;
+
+    // Everything in the generation that doesn't depend on the instance index.
+    struct RingConstants {
+        uint32_t keys[STREAM_COUNT];    // counterRandom's per-stream key, so only the index part is hashed per instance
+        glm::vec3 axis;
+        float pi;
+    };
+
+    RingConstants makeRingConstants(const AsteroidRing& ring, uint32_t seed)
+    {
+        RingConstants constants;
+        for (uint32_t stream = 0; stream < STREAM_COUNT; stream++)
+        {
+            constants.keys[stream] = pcgHash(seed ^ pcgHash(stream));
+        }
+        constants.axis = glm::normalize(ring.rotationAxis);
+        constants.pi = glm::pi<float>();
+        return constants;
+    }
+
+    inline float keyedRandom(uint32_t hashedIndex, uint32_t key)
+    {
+        return (pcgHash(hashedIndex ^ key) >> 8) * (1.0f / 16777216.0f);
+    }
+
+    void generateScalar(const AsteroidRing& ring, const RingConstants& constants, InstanceTransforms& transforms, size_t begin, size_t end)
+    {
+        for (size_t i = begin; i < end; i++)
+        {
+            uint32_t hashedIndex = pcgHash(static_cast<uint32_t>(i));
+
+            // 1. translation: a random point on the circle (from the half angle, so the series stays in range),
+            //    displaced by up to `width` in x and z, height has its own range
+            float halfAngle = (keyedRandom(hashedIndex, constants.keys[ASTEROID_STREAM_RING_ANGLE]) - 0.5f) * constants.pi;
+            float sinHalf, cosHalf;
+            sinCosHalfRange(halfAngle, sinHalf, cosHalf);
+            float sinAngle = 2.0f * sinHalf * cosHalf;
+            float cosAngle = cosHalf * cosHalf - sinHalf * sinHalf;
+
+            transforms.positionX[i] = sinAngle * ring.radius + (keyedRandom(hashedIndex, constants.keys[ASTEROID_STREAM_OFFSET_X]) * 2.0f - 1.0f) * ring.width;
+            transforms.positionY[i] = ring.heightMin + keyedRandom(hashedIndex, constants.keys[ASTEROID_STREAM_OFFSET_Y]) * (ring.heightMax - ring.heightMin);
+            transforms.positionZ[i] = cosAngle * ring.radius + (keyedRandom(hashedIndex, constants.keys[ASTEROID_STREAM_OFFSET_Z]) * 2.0f - 1.0f) * ring.width;
+
+            // 2. scale
+            transforms.scale[i] = ring.scaleMin + keyedRandom(hashedIndex, constants.keys[ASTEROID_STREAM_SCALE]) * (ring.scaleMax - ring.scaleMin);
+
+            // 3. rotation: a random angle in [-pi, pi) around the ring's axis, as the quaternion (axis * sin(angle / 2), cos(angle / 2))
+            float halfRotation = (keyedRandom(hashedIndex, constants.keys[ASTEROID_STREAM_ROTATION]) - 0.5f) * constants.pi;
+            float sinRotation, cosRotation;
+            sinCosHalfRange(halfRotation, sinRotation, cosRotation);
+            transforms.rotationX[i] = constants.axis.x * sinRotation;
+            transforms.rotationY[i] = constants.axis.y * sinRotation;
+            transforms.rotationZ[i] = constants.axis.z * sinRotation;
+            transforms.rotationW[i] = cosRotation;
+        }
+    }
+
+#ifdef ASTEROID_X86
+    __attribute__((target("avx2")))
+    inline __m256i pcgHash8(__m256i value)
+    {
+        __m256i state = _mm256_add_epi32(_mm256_mullo_epi32(value, _mm256_set1_epi32(747796405u)), _mm256_set1_epi32(2891336453u));
+        __m256i shift = _mm256_add_epi32(_mm256_srli_epi32(state, 28), _mm256_set1_epi32(4));
+        __m256i word = _mm256_mullo_epi32(_mm256_xor_si256(_mm256_srlv_epi32(state, shift), state), _mm256_set1_epi32(277803737u));
+        return _mm256_xor_si256(_mm256_srli_epi32(word, 22), word);
+    }
+
+    __attribute__((target("avx2")))
+    inline __m256 keyedRandom8(__m256i hashedIndex, uint32_t key)
+    {
+        __m256i bits = _mm256_srli_epi32(pcgHash8(_mm256_xor_si256(hashedIndex, _mm256_set1_epi32(key))), 8);
+        return _mm256_mul_ps(_mm256_cvtepi32_ps(bits), _mm256_set1_ps(1.0f / 16777216.0f));
+    }
+
+    // Eight instances at a time, bit-identical to generateScalar.
+    __attribute__((target("avx2")))
+    void generateAvx2(const AsteroidRing& ring, const RingConstants& constants, InstanceTransforms& transforms, size_t begin, size_t end)
+    {
+        const __m256 half = _mm256_set1_ps(0.5f);
+        const __m256 one = _mm256_set1_ps(1.0f);
+        const __m256 two = _mm256_set1_ps(2.0f);
+        const __m256 pi = _mm256_set1_ps(constants.pi);
+        const __m256 radius = _mm256_set1_ps(ring.radius);
+        const __m256 width = _mm256_set1_ps(ring.width);
+        const __m256 heightMin = _mm256_set1_ps(ring.heightMin);
+        const __m256 heightRange = _mm256_set1_ps(ring.heightMax - ring.heightMin);
+        const __m256 scaleMin = _mm256_set1_ps(ring.scaleMin);
+        const __m256 scaleRange = _mm256_set1_ps(ring.scaleMax - ring.scaleMin);
+
+        size_t i = begin;
+        for (; i + LANES <= end; i += LANES)
+        {
+            __m256i index = _mm256_add_epi32(_mm256_set1_epi32(static_cast<uint32_t>(i)), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+            __m256i hashedIndex = pcgHash8(index);
+
+            __m256 halfAngle = _mm256_mul_ps(_mm256_sub_ps(keyedRandom8(hashedIndex, constants.keys[ASTEROID_STREAM_RING_ANGLE]), half), pi);
+            __m256 sinHalf, cosHalf;
+            sinCosHalfRange8(halfAngle, sinHalf, cosHalf);
+            __m256 sinAngle = _mm256_mul_ps(_mm256_mul_ps(two, sinHalf), cosHalf);
+            __m256 cosAngle = _mm256_sub_ps(_mm256_mul_ps(cosHalf, cosHalf), _mm256_mul_ps(sinHalf, sinHalf));
+
+            __m256 offsetX = _mm256_mul_ps(_mm256_sub_ps(_mm256_mul_ps(keyedRandom8(hashedIndex, constants.keys[ASTEROID_STREAM_OFFSET_X]), two), one), width);
+            __m256 offsetZ = _mm256_mul_ps(_mm256_sub_ps(_mm256_mul_ps(keyedRandom8(hashedIndex, constants.keys[ASTEROID_STREAM_OFFSET_Z]), two), one), width);
+            _mm256_storeu_ps(&transforms.positionX[i], _mm256_add_ps(_mm256_mul_ps(sinAngle, radius), offsetX));
+            _mm256_storeu_ps(&transforms.positionY[i], _mm256_add_ps(heightMin, _mm256_mul_ps(keyedRandom8(hashedIndex, constants.keys[ASTEROID_STREAM_OFFSET_Y]), heightRange)));
+            _mm256_storeu_ps(&transforms.positionZ[i], _mm256_add_ps(_mm256_mul_ps(cosAngle, radius), offsetZ));
+
+            _mm256_storeu_ps(&transforms.scale[i], _mm256_add_ps(scaleMin, _mm256_mul_ps(keyedRandom8(hashedIndex, constants.keys[ASTEROID_STREAM_SCALE]), scaleRange)));
+
+            __m256 halfRotation = _mm256_mul_ps(_mm256_sub_ps(keyedRandom8(hashedIndex, constants.keys[ASTEROID_STREAM_ROTATION]), half), pi);
+            __m256 sinRotation, cosRotation;
+            sinCosHalfRange8(halfRotation, sinRotation, cosRotation);
+            _mm256_storeu_ps(&transforms.rotationX[i], _mm256_mul_ps(_mm256_set1_ps(constants.axis.x), sinRotation));
+            _mm256_storeu_ps(&transforms.rotationY[i], _mm256_mul_ps(_mm256_set1_ps(constants.axis.y), sinRotation));
+            _mm256_storeu_ps(&transforms.rotationZ[i], _mm256_mul_ps(_mm256_set1_ps(constants.axis.z), sinRotation));
+            _mm256_storeu_ps(&transforms.rotationW[i], cosRotation);
+        }
+        generateScalar(ring, constants, transforms, i, end);
+    }
+#endif
+
+    void generateRange(const AsteroidRing& ring, const RingConstants& constants, InstanceTransforms& transforms, size_t begin, size_t end)
+    {
+#ifdef ASTEROID_X86
+        if (hasAvx2())
+        {
+            generateAvx2(ring, constants, transforms, begin, end);
+            return;
+        }
+#endif
+        generateScalar(ring, constants, transforms, begin, end);
+    }
+}
+
+void generateAsteroidRing(const AsteroidRing& ring, uint32_t seed, InstanceTransforms& transforms, size_t first, size_t count, ThreadPool* pool)
+{
+    RingConstants constants = makeRingConstants(ring, seed);
+    if (pool == nullptr)
+    {
+        generateRange(ring, constants, transforms, first, first + count);
+        return;
+    }
+
+    pool->parallelFor(count, GENERATION_BATCH_SIZE, [&](size_t begin, size_t end)
+    {
+        generateRange(ring, constants, transforms, first + begin, first + end);
+    });
+}
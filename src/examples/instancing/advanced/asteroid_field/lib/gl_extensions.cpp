@@ -0,0 +1,40 @@
+#include "../headers/gl_extensions.hpp"
+
+#include <cstring>
+
+GlExtensions glExtensions;
+
+bool hasGlExtension(const char* name)
+{
+    GLint count = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+    for (GLint i = 0; i < count; i++)
+    {
+        const char* extension = reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, i));
+        if (extension != nullptr && std::strcmp(extension, name) == 0)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+void loadGlExtensions(GLADloadproc load)
+{
+    glExtensions = GlExtensions();
+    glGetIntegerv(GL_MAJOR_VERSION, &glExtensions.major);
+    glGetIntegerv(GL_MINOR_VERSION, &glExtensions.minor);
+    int version = glExtensions.major * 10 + glExtensions.minor;
+
+    if (version >= 40 || hasGlExtension("GL_ARB_draw_indirect"))
+    {
+        glExtensions.drawElementsIndirect = reinterpret_cast<DrawElementsIndirectProc>(load("glDrawElementsIndirect"));
+    }
+    if (version >= 43 || hasGlExtension("GL_ARB_multi_draw_indirect"))
+    {
+        glExtensions.multiDrawElementsIndirect = reinterpret_cast<MultiDrawElementsIndirectProc>(load("glMultiDrawElementsIndirect"));
+    }
+    glExtensions.drawIndirect = glExtensions.drawElementsIndirect != nullptr;
+    glExtensions.multiDrawIndirect = glExtensions.multiDrawElementsIndirect != nullptr;
+    glExtensions.baseInstance = version >= 42 || hasGlExtension("GL_ARB_base_instance");
+}
@@ -0,0 +1,235 @@
+#include "../headers/impostor_atlas.hpp"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+
+const char IMPOSTOR_MAGIC[4] = {'I', 'M', 'P', '1'};
+
+// Mip levels generated for the atlas, kept low so tiles don't bleed into each other.
+const int IMPOSTOR_MAX_MIP_LEVEL = 3;
+
+ImpostorAtlas::~ImpostorAtlas()
+{
+    if (texture != 0)
+    {
+        glDeleteTextures(1, &texture);
+    }
+}
+
+bool ImpostorAtlas::loadOrBuild(Model& model, Shader& captureShader, const char* modelPath, const char* cachePath, int gridSize, int tileSize)
+{
+    std::error_code error;
+    if (std::filesystem::exists(cachePath, error) &&
+        std::filesystem::last_write_time(cachePath, error) >= std::filesystem::last_write_time(modelPath, error) &&
+        readCache(cachePath, gridSize, tileSize))
+    {
+        return true;
+    }
+
+    build(model, captureShader, gridSize, tileSize);
+    if (!writeCache(cachePath))
+    {
+        std::cout << "WARNING::IMPOSTOR::FAILED_TO_WRITE_CACHE: " << cachePath << std::endl;
+    }
+    return false;
+}
+
+void ImpostorAtlas::build(Model& model, Shader& captureShader, int gridSize, int tileSize)
+{
+    this->gridSize = gridSize;
+    this->tileSize = tileSize;
+    radius = 0.0f;
+    for (Mesh& mesh : model.meshes)
+    {
+        for (Vertex& vertex : mesh.vertices)
+        {
+            radius = std::max(radius, glm::length(vertex.Position));
+        }
+    }
+
+    int size = gridSize * tileSize;
+    unsigned int captureTexture, depthBuffer, framebuffer;
+    glGenTextures(1, &captureTexture);
+    glBindTexture(GL_TEXTURE_2D, captureTexture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, size, size, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+    glGenRenderbuffers(1, &depthBuffer);
+    glBindRenderbuffer(GL_RENDERBUFFER, depthBuffer);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, size, size);
+    glGenFramebuffers(1, &framebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, captureTexture, 0);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depthBuffer);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+    {
+        std::cout << "ERROR::IMPOSTOR::FRAMEBUFFER_INCOMPLETE" << std::endl;
+    }
+
+    GLint previousViewport[4];
+    glGetIntegerv(GL_VIEWPORT, previousViewport);
+    GLfloat previousClearColor[4];
+    glGetFloatv(GL_COLOR_CLEAR_VALUE, previousClearColor);
+
+    // transparent background, the impostor shader discards whatever the rock doesn't cover
+    glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+    glm::mat4 projection = glm::ortho(-radius, radius, -radius, radius, 0.0f, 4.0f * radius);
+    captureShader.use();
+    captureShader.setMat4("projection", projection);
+    captureShader.setMat4("model", glm::mat4(1.0f));
+    for (int y = 0; y < gridSize; y++)
+    {
+        for (int x = 0; x < gridSize; x++)
+        {
+            glm::vec2 cell = glm::vec2(x, y) / float(gridSize - 1) * 2.0f - 1.0f;
+            glm::vec3 direction = octahedralDecode(cell);
+            glm::vec3 right, up;
+            impostorViewBasis(direction, right, up);
+
+            glViewport(x * tileSize, y * tileSize, tileSize, tileSize);
+            captureShader.setMat4("view", glm::lookAt(direction * 2.0f * radius, glm::vec3(0.0f), up));
+            model.Draw(captureShader);
+        }
+    }
+
+    pixels.resize(size_t(size) * size * 4);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, size, size, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glViewport(previousViewport[0], previousViewport[1], previousViewport[2], previousViewport[3]);
+    glClearColor(previousClearColor[0], previousClearColor[1], previousClearColor[2], previousClearColor[3]);
+    glDeleteFramebuffers(1, &framebuffer);
+    glDeleteRenderbuffers(1, &depthBuffer);
+    glDeleteTextures(1, &captureTexture);
+
+    upload(pixels.data());
+}
+
+void ImpostorAtlas::upload(const unsigned char* data)
+{
+    int size = gridSize * tileSize;
+    if (texture == 0)
+    {
+        glGenTextures(1, &texture);
+    }
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, size, size, 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, IMPOSTOR_MAX_MIP_LEVEL);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glGenerateMipmap(GL_TEXTURE_2D);
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+/*
+ * Cache layout, little endian:
+ *   "IMP1", int32 grid size, int32 tile size, float32 radius,
+ *   (grid size * tile size)^2 RGBA8 pixels, bottom row first.
+ */
+bool ImpostorAtlas::writeCache(const char* path) const
+{
+    std::ofstream file(path, std::ios::binary);
+    if (!file || pixels.empty())
+    {
+        return false;
+    }
+    int32_t layout[2] = {gridSize, tileSize};
+    file.write(IMPOSTOR_MAGIC, sizeof(IMPOSTOR_MAGIC));
+    file.write(reinterpret_cast<const char*>(layout), sizeof(layout));
+    file.write(reinterpret_cast<const char*>(&radius), sizeof(radius));
+    file.write(reinterpret_cast<const char*>(pixels.data()), pixels.size());
+    return bool(file);
+}
+
+bool ImpostorAtlas::readCache(const char* path, int gridSize, int tileSize)
+{
+    std::ifstream file(path, std::ios::binary);
+    char magic[4];
+    int32_t layout[2];
+    float cachedRadius;
+    if (!file.read(magic, sizeof(magic)) || std::memcmp(magic, IMPOSTOR_MAGIC, sizeof(magic)) != 0 ||
+        !file.read(reinterpret_cast<char*>(layout), sizeof(layout)) || layout[0] != gridSize || layout[1] != tileSize ||
+        !file.read(reinterpret_cast<char*>(&cachedRadius), sizeof(cachedRadius)))
+    {
+        return false;
+    }
+
+    size_t size = size_t(gridSize) * tileSize;
+    std::vector<unsigned char> cachedPixels(size * size * 4);
+    if (!file.read(reinterpret_cast<char*>(cachedPixels.data()), cachedPixels.size()))
+    {
+        return false;
+    }
+
+    this->gridSize = gridSize;
+    this->tileSize = tileSize;
+    radius = cachedRadius;
+    pixels = std::move(cachedPixels);
+    upload(pixels.data());
+    return true;
+}
+
+unsigned int ImpostorAtlas::getTexture() const
+{
+    return texture;
+}
+
+int ImpostorAtlas::getGridSize() const
+{
+    return gridSize;
+}
+
+float ImpostorAtlas::getRadius() const
+{
+    return radius;
+}
+
+namespace
+{
+    glm::vec2 signNotZero(glm::vec2 v)
+    {
+        return glm::vec2(v.x >= 0.0f ? 1.0f : -1.0f, v.y >= 0.0f ? 1.0f : -1.0f);
+    }
+}
+
+glm::vec2 octahedralEncode(glm::vec3 direction)
+{
+    direction /= std::abs(direction.x) + std::abs(direction.y) + std::abs(direction.z);
+    glm::vec2 coordinates(direction.x, direction.z);
+    if (direction.y < 0.0f)
+    {
+        coordinates = (1.0f - glm::abs(glm::vec2(coordinates.y, coordinates.x))) * signNotZero(coordinates);
+    }
+    return coordinates;
+}
+
+glm::vec3 octahedralDecode(glm::vec2 coordinates)
+{
+    glm::vec3 direction(coordinates.x, 1.0f - std::abs(coordinates.x) - std::abs(coordinates.y), coordinates.y);
+    if (direction.y < 0.0f)
+    {
+        glm::vec2 folded = (1.0f - glm::abs(glm::vec2(direction.z, direction.x))) * signNotZero(glm::vec2(direction.x, direction.z));
+        direction.x = folded.x;
+        direction.z = folded.y;
+    }
+    return glm::normalize(direction);
+}
+
+void impostorViewBasis(const glm::vec3& direction, glm::vec3& right, glm::vec3& up)
+{
+    // world up, unless looking straight along it
+    glm::vec3 reference = std::abs(direction.y) > 0.999f ? glm::vec3(0.0f, 0.0f, 1.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+    right = glm::normalize(glm::cross(-direction, reference));
+    up = glm::cross(right, -direction);
+}
@@ -0,0 +1,125 @@
+#include "../headers/instance_buffer.hpp"
+
+#include <algorithm>
+
+const size_t MIN_INSTANCE_CAPACITY = 64;
+
+InstanceBuffer::InstanceBuffer()
+{
+    glGenBuffers(1, &bufferId);
+}
+
+InstanceBuffer::~InstanceBuffer()
+{
+    glDeleteBuffers(1, &bufferId);
+}
+
+void InstanceBuffer::attach(Model& model)
+{
+    for (Mesh& mesh : model.meshes)
+    {
+        attach(mesh);
+    }
+}
+
+void InstanceBuffer::attach(Mesh& mesh)
+{
+    attach(mesh.VAO);
+}
+
+void InstanceBuffer::attach(unsigned int vao)
+{
+    if (attachedVaos.insert(vao).second)
+    {
+        bindInstanceAttributes(vao, bufferId);
+    }
+}
+
+size_t InstanceBuffer::grownCapacity(size_t required) const
+{
+    size_t newCapacity = std::max(instanceCapacity, MIN_INSTANCE_CAPACITY);
+    while (newCapacity < required)
+    {
+        newCapacity *= 2;
+    }
+    return newCapacity;
+}
+
+void InstanceBuffer::reallocate(size_t newCapacity)
+{
+    glBindBuffer(GL_ARRAY_BUFFER, bufferId);
+    glBufferData(GL_ARRAY_BUFFER, newCapacity * sizeof(PackedInstanceTransform), NULL, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    instanceCapacity = newCapacity;
+}
+
+void InstanceBuffer::upload(const PackedInstanceTransform* instances, size_t count)
+{
+    // Growing allocates new storage anyway, otherwise this orphans the current storage at the same size.
+    reallocate(grownCapacity(count));
+
+    if (count > 0)
+    {
+        glBindBuffer(GL_ARRAY_BUFFER, bufferId);
+        glBufferSubData(GL_ARRAY_BUFFER, 0, count * sizeof(PackedInstanceTransform), instances);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+    instanceCount = count;
+}
+
+void InstanceBuffer::update(size_t first, size_t count, const PackedInstanceTransform* instances)
+{
+    if (count == 0)
+    {
+        return;
+    }
+
+    size_t end = first + count;
+    if (end > instanceCapacity)
+    {
+        // Reallocating drops the contents, park the instances that are kept in a scratch buffer meanwhile.
+        size_t keptBytes = std::min(first, instanceCount) * sizeof(PackedInstanceTransform);
+        unsigned int scratchId = 0;
+        if (keptBytes > 0)
+        {
+            glGenBuffers(1, &scratchId);
+            glBindBuffer(GL_COPY_WRITE_BUFFER, scratchId);
+            glBufferData(GL_COPY_WRITE_BUFFER, keptBytes, NULL, GL_STREAM_COPY);
+            glBindBuffer(GL_COPY_READ_BUFFER, bufferId);
+            glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, keptBytes);
+        }
+
+        reallocate(grownCapacity(end));
+
+        if (keptBytes > 0)
+        {
+            glBindBuffer(GL_COPY_READ_BUFFER, scratchId);
+            glBindBuffer(GL_COPY_WRITE_BUFFER, bufferId);
+            glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, keptBytes);
+            glBindBuffer(GL_COPY_READ_BUFFER, 0);
+            glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+            glDeleteBuffers(1, &scratchId);
+        }
+        instanceCount = std::min(first, instanceCount);
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER, bufferId);
+    glBufferSubData(GL_ARRAY_BUFFER, first * sizeof(PackedInstanceTransform), count * sizeof(PackedInstanceTransform), instances);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    instanceCount = std::max(instanceCount, end);
+}
+
+size_t InstanceBuffer::size() const
+{
+    return instanceCount;
+}
+
+size_t InstanceBuffer::capacity() const
+{
+    return instanceCapacity;
+}
+
+unsigned int InstanceBuffer::id() const
+{
+    return bufferId;
+}
@@ -0,0 +1,130 @@
+#include "../headers/instance_cells.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+void sortInstancesIntoCells(const InstanceTransforms& transforms, float cellSize, std::vector<PackedInstanceTransform>& sorted, std::vector<InstanceCell>& cells)
+{
+    size_t count = transforms.size();
+    sorted.resize(count);
+    cells.clear();
+    if (count == 0)
+    {
+        return;
+    }
+
+    float minX = *std::min_element(transforms.positionX.begin(), transforms.positionX.end());
+    float maxX = *std::max_element(transforms.positionX.begin(), transforms.positionX.end());
+    float minZ = *std::min_element(transforms.positionZ.begin(), transforms.positionZ.end());
+    float maxZ = *std::max_element(transforms.positionZ.begin(), transforms.positionZ.end());
+    size_t cellsX = static_cast<size_t>((maxX - minX) / cellSize) + 1;
+    size_t cellsZ = static_cast<size_t>((maxZ - minZ) / cellSize) + 1;
+
+    // counting sort by cell: count, prefix sum, scatter
+    std::vector<uint32_t> cellOf(count);
+    std::vector<size_t> cellStart(cellsX * cellsZ + 1, 0);
+    for (size_t i = 0; i < count; i++)
+    {
+        size_t x = std::min(static_cast<size_t>((transforms.positionX[i] - minX) / cellSize), cellsX - 1);
+        size_t z = std::min(static_cast<size_t>((transforms.positionZ[i] - minZ) / cellSize), cellsZ - 1);
+        cellOf[i] = static_cast<uint32_t>(x + cellsX * z);
+        cellStart[cellOf[i] + 1]++;
+    }
+    for (size_t cell = 0; cell < cellsX * cellsZ; cell++)
+    {
+        cellStart[cell + 1] += cellStart[cell];
+    }
+
+    std::vector<size_t> next(cellStart.begin(), cellStart.end() - 1);
+    for (size_t i = 0; i < count; i++)
+    {
+        transforms.pack(i, 1, &sorted[next[cellOf[i]]++]);
+    }
+
+    for (size_t cell = 0; cell < cellsX * cellsZ; cell++)
+    {
+        if (cellStart[cell + 1] == cellStart[cell])
+        {
+            continue;
+        }
+        InstanceCell instanceCell;
+        instanceCell.first = cellStart[cell];
+        instanceCell.count = cellStart[cell + 1] - cellStart[cell];
+        instanceCell.boundsMin = glm::vec3(std::numeric_limits<float>::max());
+        instanceCell.boundsMax = glm::vec3(-std::numeric_limits<float>::max());
+        for (size_t i = instanceCell.first; i < instanceCell.first + instanceCell.count; i++)
+        {
+            glm::vec3 position(sorted[i].positionScale);
+            instanceCell.boundsMin = glm::min(instanceCell.boundsMin, position);
+            instanceCell.boundsMax = glm::max(instanceCell.boundsMax, position);
+        }
+        cells.push_back(instanceCell);
+    }
+}
+
+namespace
+{
+    void appendRange(std::vector<InstanceRange>& ranges, const InstanceCell& cell)
+    {
+        if (!ranges.empty() && ranges.back().first + ranges.back().count == cell.first)
+        {
+            ranges.back().count += cell.count;
+            return;
+        }
+        ranges.push_back({cell.first, cell.count});
+    }
+}
+
+void bucketInstanceCells(const std::vector<InstanceCell>& cells, const glm::mat4& viewProjection, const glm::vec3& eye, float impostorDistance,
+    float padding, std::vector<InstanceRange>& meshRanges, std::vector<InstanceRange>& impostorRanges)
+{
+    meshRanges.clear();
+    impostorRanges.clear();
+    glm::vec3 pad(padding);
+
+    for (const InstanceCell& cell : cells)
+    {
+        glm::vec3 boundsMin = cell.boundsMin - pad;
+        glm::vec3 boundsMax = cell.boundsMax + pad;
+        if (!boxInFrustum(viewProjection, boundsMin, boundsMax))
+        {
+            continue;
+        }
+
+        // distance to the nearest point of the box, so a cell only turns into impostors once all of it is far away
+        glm::vec3 nearest = glm::clamp(eye, boundsMin, boundsMax);
+        if (glm::length(nearest - eye) < impostorDistance)
+        {
+            appendRange(meshRanges, cell);
+        }
+        else
+        {
+            appendRange(impostorRanges, cell);
+        }
+    }
+}
+
+bool boxInFrustum(const glm::mat4& viewProjection, const glm::vec3& boundsMin, const glm::vec3& boundsMax)
+{
+    glm::vec4 corners[8];
+    for (int i = 0; i < 8; i++)
+    {
+        glm::vec3 corner((i & 1) ? boundsMax.x : boundsMin.x, (i & 2) ? boundsMax.y : boundsMin.y, (i & 4) ? boundsMax.z : boundsMin.z);
+        corners[i] = viewProjection * glm::vec4(corner, 1.0f);
+    }
+    for (int axis = 0; axis < 3; axis++)
+    {
+        int below = 0, above = 0;
+        for (const glm::vec4& corner : corners)
+        {
+            below += corner[axis] < -corner.w;
+            above += corner[axis] > corner.w;
+        }
+        if (below == 8 || above == 8)
+        {
+            return false;
+        }
+    }
+    return true;
+}
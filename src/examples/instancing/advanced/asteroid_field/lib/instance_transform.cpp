@@ -0,0 +1,104 @@
+#include "../headers/instance_transform.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+
+size_t InstanceTransforms::size() const
+{
+    return positionX.size();
+}
+
+void InstanceTransforms::resize(size_t count)
+{
+    for (std::vector<float>* component : {&positionX, &positionY, &positionZ, &scale, &rotationX, &rotationY, &rotationZ, &rotationW})
+    {
+        component->resize(count);
+    }
+}
+
+void InstanceTransforms::set(size_t index, const glm::vec3& position, float uniformScale, const glm::quat& rotation)
+{
+    positionX[index] = position.x;
+    positionY[index] = position.y;
+    positionZ[index] = position.z;
+    scale[index] = uniformScale;
+    rotationX[index] = rotation.x;
+    rotationY[index] = rotation.y;
+    rotationZ[index] = rotation.z;
+    rotationW[index] = rotation.w;
+}
+
+int16_t PackedInstanceTransform::toSnorm16(float value)
+{
+    return (int16_t)std::nearbyint(std::clamp(value, -1.0f, 1.0f) * 32767.0f);
+}
+
+void InstanceTransforms::pack(size_t first, size_t count, PackedInstanceTransform* out) const
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        size_t index = first + i;
+        out[i].positionScale = glm::vec4(positionX[index], positionY[index], positionZ[index], scale[index]);
+        out[i].rotation[0] = PackedInstanceTransform::toSnorm16(rotationX[index]);
+        out[i].rotation[1] = PackedInstanceTransform::toSnorm16(rotationY[index]);
+        out[i].rotation[2] = PackedInstanceTransform::toSnorm16(rotationZ[index]);
+        out[i].rotation[3] = PackedInstanceTransform::toSnorm16(rotationW[index]);
+    }
+}
+
+void bindInstanceAttributes(unsigned int vao, unsigned int instanceBuffer, size_t firstInstance)
+{
+    size_t base = firstInstance * sizeof(PackedInstanceTransform);
+    glBindVertexArray(vao);
+    glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+
+    glEnableVertexAttribArray(INSTANCE_ATTRIBUTE_LOCATION);
+    glVertexAttribPointer(INSTANCE_ATTRIBUTE_LOCATION, 4, GL_FLOAT, GL_FALSE, sizeof(PackedInstanceTransform),
+        (void*)(base + offsetof(PackedInstanceTransform, positionScale)));
+    glVertexAttribDivisor(INSTANCE_ATTRIBUTE_LOCATION, 1);
+
+    glEnableVertexAttribArray(INSTANCE_ATTRIBUTE_LOCATION + 1);
+    glVertexAttribPointer(INSTANCE_ATTRIBUTE_LOCATION + 1, 4, GL_SHORT, GL_TRUE, sizeof(PackedInstanceTransform),
+        (void*)(base + offsetof(PackedInstanceTransform, rotation)));
+    glVertexAttribDivisor(INSTANCE_ATTRIBUTE_LOCATION + 1, 1);
+
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void bindInstanceAttributes(Mesh& mesh, unsigned int instanceBuffer, size_t firstInstance)
+{
+    bindInstanceAttributes(mesh.VAO, instanceBuffer, firstInstance);
+}
+
+void bindInstanceAttributes(Model& model, unsigned int instanceBuffer, size_t firstInstance)
+{
+    for (Mesh& mesh : model.meshes)
+    {
+        bindInstanceAttributes(mesh, instanceBuffer, firstInstance);
+    }
+}
+
+void bindInstanceLayers(unsigned int vao, unsigned int layerBuffer, size_t firstInstance)
+{
+    glBindVertexArray(vao);
+    glBindBuffer(GL_ARRAY_BUFFER, layerBuffer);
+
+    // integer attribute, the shader uses it as an index and not as a normalised value
+    glEnableVertexAttribArray(INSTANCE_LAYER_ATTRIBUTE_LOCATION);
+    glVertexAttribIPointer(INSTANCE_LAYER_ATTRIBUTE_LOCATION, 1, GL_UNSIGNED_SHORT, sizeof(uint16_t),
+        (void*)(firstInstance * sizeof(uint16_t)));
+    glVertexAttribDivisor(INSTANCE_LAYER_ATTRIBUTE_LOCATION, 1);
+
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void bindInstanceLayers(Model& model, unsigned int layerBuffer, size_t firstInstance)
+{
+    for (Mesh& mesh : model.meshes)
+    {
+        bindInstanceLayers(mesh.VAO, layerBuffer, firstInstance);
+    }
+}
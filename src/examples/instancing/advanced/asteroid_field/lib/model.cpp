@@ -1,4 +1,5 @@
 #include "../headers/model.hpp"
+#include "../headers/texture_array.hpp"
 
 Model::Model(char* path)
 {
@@ -13,6 +14,24 @@ void Model::Draw(Shader &shader)
     }
 }
 
+int Model::addTextureLayers(TextureArray& layers, const std::string& typeName)
+{
+    int firstLayer = -1;
+    for (Texture& texture : textures_loaded)
+    {
+        if (texture.type != typeName)
+        {
+            continue;
+        }
+        int layer = layers.addFile(directory + '/' + texture.path);
+        if (firstLayer < 0)
+        {
+            firstLayer = layer;
+        }
+    }
+    return firstLayer;
+}
+
 void Model::loadModel(const std::string path)
 {
     Assimp::Importer import;
@@ -0,0 +1,229 @@
+#include "../headers/orbit_simulation.hpp"
+#include "../headers/fast_trig.hpp"
+
+#include <glm/gtc/constants.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <memory>
+
+// Rocks per parallelFor batch.
+const size_t STEP_BATCH_SIZE = 16384;
+
+namespace
+{
+    const int LANES = 8;
+
+    // Wrap into [-pi, pi) so the half angle stays in the range of sinCosHalfRange.
+    inline float wrapAngle(float angle)
+    {
+        return angle - glm::two_pi<float>() * std::floor((angle + glm::pi<float>()) * glm::one_over_two_pi<float>());
+    }
+
+#ifdef ASTEROID_X86
+    __attribute__((target("avx2")))
+    inline __m256 wrapAngle8(__m256 angle)
+    {
+        __m256 turns = _mm256_floor_ps(_mm256_mul_ps(_mm256_add_ps(angle, _mm256_set1_ps(glm::pi<float>())), _mm256_set1_ps(glm::one_over_two_pi<float>())));
+        return _mm256_sub_ps(angle, _mm256_mul_ps(_mm256_set1_ps(glm::two_pi<float>()), turns));
+    }
+
+    __attribute__((target("avx2")))
+    inline __m256i toSnorm16x8(__m256 value)
+    {
+        // clamped to [-1, 1] first like PackedInstanceTransform::toSnorm16, so every lane fits an int16_t
+        __m256 clamped = _mm256_min_ps(_mm256_max_ps(value, _mm256_set1_ps(-1.0f)), _mm256_set1_ps(1.0f));
+        return _mm256_cvtps_epi32(_mm256_mul_ps(clamped, _mm256_set1_ps(32767.0f)));
+    }
+
+    struct OrbitArrays {
+        float* orbitRadius;
+        float* orbitAngle;
+        const float* angularVelocity;
+        const float* height;
+        const float* scale;
+        float* spinAngle;
+        const float* spinSpeed;
+    };
+
+    // Returns the index of the first rock it didn't handle, the remaining (< 8) ones go through the scalar path.
+    __attribute__((target("avx2")))
+    size_t stepAvx2(const OrbitArrays& arrays, glm::vec3 spinAxis, size_t begin, size_t end, float deltaTime, PackedInstanceTransform* out)
+    {
+        const __m256 dt = _mm256_set1_ps(deltaTime);
+        const __m256 half = _mm256_set1_ps(0.5f);
+        const __m256 two = _mm256_set1_ps(2.0f);
+
+        alignas(32) float lanes[8][LANES];
+        alignas(32) int32_t rotationLanes[4][LANES];
+
+        size_t i = begin;
+        for (; i + LANES <= end; i += LANES)
+        {
+            __m256 angle = wrapAngle8(_mm256_add_ps(_mm256_loadu_ps(arrays.orbitAngle + i), _mm256_mul_ps(_mm256_loadu_ps(arrays.angularVelocity + i), dt)));
+            __m256 spin = wrapAngle8(_mm256_add_ps(_mm256_loadu_ps(arrays.spinAngle + i), _mm256_mul_ps(_mm256_loadu_ps(arrays.spinSpeed + i), dt)));
+            _mm256_storeu_ps(arrays.orbitAngle + i, angle);
+            _mm256_storeu_ps(arrays.spinAngle + i, spin);
+
+            __m256 sinHalf, cosHalf;
+            sinCosHalfRange8(_mm256_mul_ps(angle, half), sinHalf, cosHalf);
+            __m256 sinAngle = _mm256_mul_ps(_mm256_mul_ps(two, sinHalf), cosHalf);
+            __m256 cosAngle = _mm256_sub_ps(_mm256_mul_ps(cosHalf, cosHalf), _mm256_mul_ps(sinHalf, sinHalf));
+            __m256 radius = _mm256_loadu_ps(arrays.orbitRadius + i);
+            _mm256_store_ps(lanes[0], _mm256_mul_ps(sinAngle, radius));
+            _mm256_store_ps(lanes[1], _mm256_loadu_ps(arrays.height + i));
+            _mm256_store_ps(lanes[2], _mm256_mul_ps(cosAngle, radius));
+            _mm256_store_ps(lanes[3], _mm256_loadu_ps(arrays.scale + i));
+
+            __m256 sinSpin, cosSpin;
+            sinCosHalfRange8(_mm256_mul_ps(spin, half), sinSpin, cosSpin);
+            _mm256_store_si256((__m256i*)rotationLanes[0], toSnorm16x8(_mm256_mul_ps(_mm256_set1_ps(spinAxis.x), sinSpin)));
+            _mm256_store_si256((__m256i*)rotationLanes[1], toSnorm16x8(_mm256_mul_ps(_mm256_set1_ps(spinAxis.y), sinSpin)));
+            _mm256_store_si256((__m256i*)rotationLanes[2], toSnorm16x8(_mm256_mul_ps(_mm256_set1_ps(spinAxis.z), sinSpin)));
+            _mm256_store_si256((__m256i*)rotationLanes[3], toSnorm16x8(cosSpin));
+
+            // The GPU layout interleaves the components, write the eight rocks out one by one.
+            for (int lane = 0; lane < LANES; lane++)
+            {
+                PackedInstanceTransform& instance = out[i + lane];
+                instance.positionScale = glm::vec4(lanes[0][lane], lanes[1][lane], lanes[2][lane], lanes[3][lane]);
+                for (int component = 0; component < 4; component++)
+                {
+                    instance.rotation[component] = (int16_t)rotationLanes[component][lane];
+                }
+            }
+        }
+        return i;
+    }
+#endif
+}
+
+OrbitSimulation::OrbitSimulation(ThreadPool& pool, float gravity)
+    : pool(pool), gravity(gravity)
+{
+}
+
+OrbitSimulation::~OrbitSimulation()
+{
+    waitForStep();
+}
+
+void OrbitSimulation::reset(const AsteroidRing& ring, uint32_t seed, const InstanceTransforms& transforms)
+{
+    waitForStep();
+
+    size_t count = transforms.size();
+    for (std::vector<float>* component : {&orbitRadius, &orbitAngle, &angularVelocity, &height, &scale, &spinAngle, &spinSpeed})
+    {
+        component->resize(count);
+    }
+    spinAxis = glm::normalize(ring.rotationAxis);
+
+    for (size_t i = 0; i < count; i++)
+    {
+        float x = transforms.positionX[i];
+        float z = transforms.positionZ[i];
+        float radius = std::max(std::sqrt(x * x + z * z), 1.0f);
+        orbitRadius[i] = radius;
+        orbitAngle[i] = std::atan2(x, z);
+        angularVelocity[i] = std::sqrt(gravity / (radius * radius * radius));
+        height[i] = transforms.positionY[i];
+        scale[i] = transforms.scale[i];
+
+        // the generated rotation is (axis * sin(angle / 2), cos(angle / 2))
+        glm::vec3 vectorPart(transforms.rotationX[i], transforms.rotationY[i], transforms.rotationZ[i]);
+        spinAngle[i] = wrapAngle(2.0f * std::atan2(glm::dot(vectorPart, spinAxis), transforms.rotationW[i]));
+
+        // the lowest bit picks the direction, counterRandomFloat only uses the upper 24
+        uint32_t bits = counterRandom(seed, static_cast<uint32_t>(i), ASTEROID_STREAM_SPIN);
+        float speed = ASTEROID_MIN_SPIN_SPEED + counterRandomFloat(seed, static_cast<uint32_t>(i), ASTEROID_STREAM_SPIN) * (ASTEROID_MAX_SPIN_SPEED - ASTEROID_MIN_SPIN_SPEED);
+        spinSpeed[i] = (bits & 1) ? speed : -speed;
+    }
+
+    buffers[0].resize(count);
+    buffers[1].resize(count);
+    frontBuffer = 0;
+    step(0, count, 0.0f, buffers[frontBuffer].data());
+}
+
+void OrbitSimulation::start(float deltaTime)
+{
+    waitForStep();
+
+    auto result = std::make_shared<std::promise<double>>();
+    pendingStep = result->get_future();
+    PackedInstanceTransform* out = buffers[1 - frontBuffer].data();
+    size_t count = size();
+
+    pool.submit([this, result, out, count, deltaTime]()
+    {
+        auto begin = std::chrono::steady_clock::now();
+        pool.parallelFor(count, STEP_BATCH_SIZE, [&](size_t first, size_t last)
+        {
+            step(first, last, deltaTime, out);
+        });
+        result->set_value(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count());
+    });
+}
+
+const std::vector<PackedInstanceTransform>& OrbitSimulation::finish()
+{
+    if (pendingStep.valid())
+    {
+        lastStepMilliseconds = pendingStep.get();
+        frontBuffer = 1 - frontBuffer;
+    }
+    return buffers[frontBuffer];
+}
+
+void OrbitSimulation::waitForStep()
+{
+    if (pendingStep.valid())
+    {
+        pendingStep.wait();
+    }
+}
+
+size_t OrbitSimulation::size() const
+{
+    return orbitRadius.size();
+}
+
+double OrbitSimulation::getLastStepMilliseconds() const
+{
+    return lastStepMilliseconds;
+}
+
+void OrbitSimulation::step(size_t begin, size_t end, float deltaTime, PackedInstanceTransform* out)
+{
+    size_t i = begin;
+#ifdef ASTEROID_X86
+    if (hasAvx2())
+    {
+        OrbitArrays arrays = {orbitRadius.data(), orbitAngle.data(), angularVelocity.data(), height.data(), scale.data(), spinAngle.data(), spinSpeed.data()};
+        i = stepAvx2(arrays, spinAxis, begin, end, deltaTime, out);
+    }
+#endif
+
+    for (; i < end; i++)
+    {
+        float angle = wrapAngle(orbitAngle[i] + angularVelocity[i] * deltaTime);
+        float spin = wrapAngle(spinAngle[i] + spinSpeed[i] * deltaTime);
+        orbitAngle[i] = angle;
+        spinAngle[i] = spin;
+
+        float sinHalf, cosHalf;
+        sinCosHalfRange(angle * 0.5f, sinHalf, cosHalf);
+        float sinAngle = 2.0f * sinHalf * cosHalf;
+        float cosAngle = cosHalf * cosHalf - sinHalf * sinHalf;
+        out[i].positionScale = glm::vec4(sinAngle * orbitRadius[i], height[i], cosAngle * orbitRadius[i], scale[i]);
+
+        float sinSpin, cosSpin;
+        sinCosHalfRange(spin * 0.5f, sinSpin, cosSpin);
+        out[i].rotation[0] = PackedInstanceTransform::toSnorm16(spinAxis.x * sinSpin);
+        out[i].rotation[1] = PackedInstanceTransform::toSnorm16(spinAxis.y * sinSpin);
+        out[i].rotation[2] = PackedInstanceTransform::toSnorm16(spinAxis.z * sinSpin);
+        out[i].rotation[3] = PackedInstanceTransform::toSnorm16(cosSpin);
+    }
+}
@@ -0,0 +1,270 @@
+#include "../headers/procedural_asteroid.hpp"
+#include "../headers/fast_trig.hpp"
+
+#include <glm/gtc/constants.hpp>
+
+#include <glad/glad.h>
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Rocks per parallelFor batch.
+const size_t PROCEDURAL_BATCH_SIZE = 16384;
+
+namespace
+{
+    inline float unitFloat(uint32_t bits)
+    {
+        return (bits >> 8) * (1.0f / 16777216.0f);
+    }
+
+    inline float wrapAngle(float angle)
+    {
+        return angle - glm::two_pi<float>() * std::floor((angle + glm::pi<float>()) * glm::one_over_two_pi<float>());
+    }
+}
+
+ProceduralAsteroidBits proceduralAsteroidBits(uint32_t seed, uint32_t index)
+{
+    ProceduralAsteroidBits bits;
+    bits.angle = counterRandom(seed, index, ASTEROID_STREAM_RING_ANGLE);
+    bits.radius = counterRandom(seed, index, ASTEROID_STREAM_OFFSET_X);
+    bits.height = counterRandom(seed, index, ASTEROID_STREAM_OFFSET_Y);
+    bits.scale = counterRandom(seed, index, ASTEROID_STREAM_SCALE);
+    bits.rotation = counterRandom(seed, index, ASTEROID_STREAM_ROTATION);
+    bits.spin = counterRandom(seed, index, ASTEROID_STREAM_SPIN);
+    return bits;
+}
+
+ProceduralAsteroid evaluateProceduralAsteroid(const AsteroidRing& ring, uint32_t seed, uint32_t index, float time, float gravity)
+{
+    ProceduralAsteroidBits bits = proceduralAsteroidBits(seed, index);
+    float pi = glm::pi<float>();
+
+    float radius = ring.radius + (unitFloat(bits.radius) * 2.0f - 1.0f) * ring.width;
+    float angularVelocity = std::sqrt(gravity / (radius * radius * radius));
+    float angle = wrapAngle((unitFloat(bits.angle) - 0.5f) * 2.0f * pi + angularVelocity * time);
+
+    float spinSpeed = ASTEROID_MIN_SPIN_SPEED + unitFloat(bits.spin) * (ASTEROID_MAX_SPIN_SPEED - ASTEROID_MIN_SPIN_SPEED);
+    if ((bits.spin & 1u) == 0)
+    {
+        spinSpeed = -spinSpeed;
+    }
+    float spin = wrapAngle((unitFloat(bits.rotation) - 0.5f) * 2.0f * pi + spinSpeed * time);
+
+    float sinHalf, cosHalf;
+    sinCosHalfRange(angle * 0.5f, sinHalf, cosHalf);
+    float sinAngle = 2.0f * sinHalf * cosHalf;
+    float cosAngle = cosHalf * cosHalf - sinHalf * sinHalf;
+
+    float sinSpin, cosSpin;
+    sinCosHalfRange(spin * 0.5f, sinSpin, cosSpin);
+    glm::vec3 axis = glm::normalize(ring.rotationAxis);
+
+    ProceduralAsteroid asteroid;
+    asteroid.position = glm::vec3(sinAngle * radius, ring.heightMin + unitFloat(bits.height) * (ring.heightMax - ring.heightMin), cosAngle * radius);
+    asteroid.scale = ring.scaleMin + unitFloat(bits.scale) * (ring.scaleMax - ring.scaleMin);
+    asteroid.rotation = glm::quat(cosSpin, axis.x * sinSpin, axis.y * sinSpin, axis.z * sinSpin);
+    return asteroid;
+}
+
+void evaluateProceduralAsteroids(const AsteroidRing& ring, uint32_t seed, size_t first, size_t count, float time, PackedInstanceTransform* out,
+    ThreadPool* pool, float gravity)
+{
+    auto evaluateRange = [&](size_t begin, size_t end)
+    {
+        for (size_t i = begin; i < end; i++)
+        {
+            ProceduralAsteroid asteroid = evaluateProceduralAsteroid(ring, seed, static_cast<uint32_t>(first + i), time, gravity);
+            out[i].positionScale = glm::vec4(asteroid.position, asteroid.scale);
+            out[i].rotation[0] = PackedInstanceTransform::toSnorm16(asteroid.rotation.x);
+            out[i].rotation[1] = PackedInstanceTransform::toSnorm16(asteroid.rotation.y);
+            out[i].rotation[2] = PackedInstanceTransform::toSnorm16(asteroid.rotation.z);
+            out[i].rotation[3] = PackedInstanceTransform::toSnorm16(asteroid.rotation.w);
+        }
+    };
+
+    if (pool == nullptr)
+    {
+        evaluateRange(0, count);
+        return;
+    }
+    pool->parallelFor(count, PROCEDURAL_BATCH_SIZE, evaluateRange);
+}
+
+void proceduralRingBounds(const AsteroidRing& ring, glm::vec3& boundsMin, glm::vec3& boundsMax)
+{
+    float outer = ring.radius + ring.width;
+    boundsMin = glm::vec3(-outer, ring.heightMin, -outer);
+    boundsMax = glm::vec3(outer, ring.heightMax, outer);
+}
+
+long pickProceduralAsteroid(const AsteroidRing& ring, uint32_t seed, size_t count, float time, const glm::vec3& rayOrigin, const glm::vec3& rayDirection,
+    float rockRadius, ThreadPool* pool, float gravity)
+{
+    std::mutex closestMutex;
+    long closest = -1;
+    float closestDistance = std::numeric_limits<float>::max();
+
+    auto pickRange = [&](size_t begin, size_t end)
+    {
+        long rangeClosest = -1;
+        float rangeDistance = std::numeric_limits<float>::max();
+        for (size_t i = begin; i < end; i++)
+        {
+            ProceduralAsteroid asteroid = evaluateProceduralAsteroid(ring, seed, static_cast<uint32_t>(i), time, gravity);
+            glm::vec3 toCentre = asteroid.position - rayOrigin;
+            float along = glm::dot(toCentre, rayDirection);
+            float radius = asteroid.scale * rockRadius;
+            float missSquared = glm::dot(toCentre, toCentre) - along * along;
+            if (along > 0.0f && missSquared <= radius * radius && along < rangeDistance)
+            {
+                rangeDistance = along;
+                rangeClosest = static_cast<long>(i);
+            }
+        }
+
+        std::lock_guard<std::mutex> lock(closestMutex);
+        if (rangeClosest >= 0 && (rangeDistance < closestDistance || (rangeDistance == closestDistance && rangeClosest < closest)))
+        {
+            closestDistance = rangeDistance;
+            closest = rangeClosest;
+        }
+    };
+
+    if (pool == nullptr)
+    {
+        pickRange(0, count);
+    }
+    else
+    {
+        pool->parallelFor(count, PROCEDURAL_BATCH_SIZE, pickRange);
+    }
+    return closest;
+}
+
+void setProceduralUniforms(unsigned int program, const AsteroidRing& ring, uint32_t seed, float time, float gravity)
+{
+    glm::vec3 axis = glm::normalize(ring.rotationAxis);
+    glUniform1ui(glGetUniformLocation(program, "seed"), seed);
+    glUniform1f(glGetUniformLocation(program, "time"), time);
+    glUniform1f(glGetUniformLocation(program, "gravity"), gravity);
+    glUniform1f(glGetUniformLocation(program, "ringRadius"), ring.radius);
+    glUniform1f(glGetUniformLocation(program, "ringWidth"), ring.width);
+    glUniform1f(glGetUniformLocation(program, "ringHeightMin"), ring.heightMin);
+    glUniform1f(glGetUniformLocation(program, "ringHeightMax"), ring.heightMax);
+    glUniform1f(glGetUniformLocation(program, "ringScaleMin"), ring.scaleMin);
+    glUniform1f(glGetUniformLocation(program, "ringScaleMax"), ring.scaleMax);
+    glUniform3f(glGetUniformLocation(program, "rotationAxis"), axis.x, axis.y, axis.z);
+    glUniform1f(glGetUniformLocation(program, "minSpinSpeed"), ASTEROID_MIN_SPIN_SPEED);
+    glUniform1f(glGetUniformLocation(program, "maxSpinSpeed"), ASTEROID_MAX_SPIN_SPEED);
+}
+
+namespace
+{
+    // What the shader writes per instance, in the order of the transform feedback varyings below.
+    struct CapturedAsteroid {
+        glm::vec4 positionScale;
+        glm::vec4 rotation;
+        uint32_t bits[4];         // angle, radius, rotation, spin
+        uint32_t shapeBits[2];    // height, scale
+    };
+
+    const float MAX_POSITION_ERROR = 0.01f;
+    const float MAX_ROTATION_ERROR = 1e-4f;
+}
+
+ProceduralShaderCheck checkProceduralShader(const char* vertexPath, const AsteroidRing& ring, uint32_t seed, float time, size_t count)
+{
+    ProceduralShaderCheck check;
+
+    std::ifstream file(vertexPath);
+    if (!file)
+    {
+        std::cout << "ERROR::PROCEDURAL_CHECK::FILE_NOT_SUCCESSFULLY_READ: " << vertexPath << std::endl;
+        return check;
+    }
+    std::stringstream source;
+    source << file.rdbuf();
+    std::string code = source.str();
+    const char* codePointer = code.c_str();
+
+    // A vertex shader on its own is enough, nothing gets rasterised.
+    unsigned int vertex = glCreateShader(GL_VERTEX_SHADER);
+    glShaderSource(vertex, 1, &codePointer, NULL);
+    glCompileShader(vertex);
+    unsigned int program = glCreateProgram();
+    glAttachShader(program, vertex);
+    const char* varyings[] = {"vProceduralPositionScale", "vProceduralRotation", "vProceduralBits", "vProceduralShapeBits"};
+    glTransformFeedbackVaryings(program, 4, varyings, GL_INTERLEAVED_ATTRIBS);
+    glLinkProgram(program);
+    glDeleteShader(vertex);
+
+    GLint linked;
+    glGetProgramiv(program, GL_LINK_STATUS, &linked);
+    if (!linked)
+    {
+        char infoLog[1024];
+        glGetProgramInfoLog(program, 1024, NULL, infoLog);
+        std::cout << "ERROR::PROCEDURAL_CHECK::PROGRAM_LINKING_ERROR\n" << infoLog << std::endl;
+        glDeleteProgram(program);
+        return check;
+    }
+
+    unsigned int vao, captureBuffer;
+    glGenVertexArrays(1, &vao);
+    glGenBuffers(1, &captureBuffer);
+    glBindBuffer(GL_TRANSFORM_FEEDBACK_BUFFER, captureBuffer);
+    glBufferData(GL_TRANSFORM_FEEDBACK_BUFFER, count * sizeof(CapturedAsteroid), NULL, GL_STREAM_READ);
+
+    // One point per instance, so every instance is captured exactly once.
+    glUseProgram(program);
+    setProceduralUniforms(program, ring, seed, time);
+    glBindVertexArray(vao);
+    glEnable(GL_RASTERIZER_DISCARD);
+    glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, captureBuffer);
+    glBeginTransformFeedback(GL_POINTS);
+    glDrawArraysInstanced(GL_POINTS, 0, 1, static_cast<GLsizei>(count));
+    glEndTransformFeedback();
+    glDisable(GL_RASTERIZER_DISCARD);
+
+    std::vector<CapturedAsteroid> captured(count);
+    glGetBufferSubData(GL_TRANSFORM_FEEDBACK_BUFFER, 0, count * sizeof(CapturedAsteroid), captured.data());
+
+    glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, 0);
+    glBindBuffer(GL_TRANSFORM_FEEDBACK_BUFFER, 0);
+    glBindVertexArray(0);
+    glUseProgram(0);
+    glDeleteBuffers(1, &captureBuffer);
+    glDeleteVertexArrays(1, &vao);
+    glDeleteProgram(program);
+
+    for (size_t i = 0; i < count; i++)
+    {
+        uint32_t index = static_cast<uint32_t>(i);
+        ProceduralAsteroidBits bits = proceduralAsteroidBits(seed, index);
+        ProceduralAsteroid asteroid = evaluateProceduralAsteroid(ring, seed, index, time);
+        const CapturedAsteroid& gpu = captured[i];
+
+        if (gpu.bits[0] != bits.angle || gpu.bits[1] != bits.radius || gpu.bits[2] != bits.rotation || gpu.bits[3] != bits.spin
+            || gpu.shapeBits[0] != bits.height || gpu.shapeBits[1] != bits.scale)
+        {
+            check.bitMismatches++;
+        }
+        glm::vec4 expectedRotation(asteroid.rotation.x, asteroid.rotation.y, asteroid.rotation.z, asteroid.rotation.w);
+        glm::vec4 positionError = glm::abs(gpu.positionScale - glm::vec4(asteroid.position, asteroid.scale));
+        glm::vec4 rotationError = glm::abs(gpu.rotation - expectedRotation);
+        check.maxPositionError = std::max({check.maxPositionError, positionError.x, positionError.y, positionError.z, positionError.w});
+        check.maxRotationError = std::max({check.maxRotationError, rotationError.x, rotationError.y, rotationError.z, rotationError.w});
+    }
+    check.checked = count;
+    check.passed = check.bitMismatches == 0 && check.maxPositionError <= MAX_POSITION_ERROR && check.maxRotationError <= MAX_ROTATION_ERROR;
+    return check;
+}
@@ -0,0 +1,434 @@
+#include "../headers/spatial_hash.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+SpatialHashGrid::SpatialHashGrid(float cellSize, size_t bucketCount)
+    : cellSize(cellSize), inverseCellSize(1.0f / cellSize)
+{
+    // a power of two so the hash can be masked
+    size_t powerOfTwo = 1;
+    while (powerOfTwo < bucketCount)
+    {
+        powerOfTwo *= 2;
+    }
+    buckets.resize(powerOfTwo);
+}
+
+void SpatialHashGrid::clear()
+{
+    for (std::vector<uint32_t>& bucket : buckets)
+    {
+        bucket.clear();
+    }
+    entries.clear();
+    count = 0;
+    maxRadius = 0.0f;
+    occupiedMin = glm::ivec3(INT32_MAX);
+    occupiedMax = glm::ivec3(INT32_MIN);
+}
+
+size_t SpatialHashGrid::size() const
+{
+    return count;
+}
+
+bool SpatialHashGrid::contains(uint32_t id) const
+{
+    return id < entries.size() && entries[id].slot != UINT32_MAX;
+}
+
+void SpatialHashGrid::insert(uint32_t id, const glm::vec3& center, float radius)
+{
+    if (contains(id))
+    {
+        update(id, center, radius);
+        return;
+    }
+    if (id >= entries.size())
+    {
+        entries.resize(size_t(id) + 1, {glm::vec3(0.0f), 0.0f, glm::ivec3(0), UINT32_MAX});
+    }
+
+    glm::ivec3 cell = cellOf(center);
+    std::vector<uint32_t>& bucket = buckets[bucketOf(cell)];
+    entries[id] = {center, radius, cell, static_cast<uint32_t>(bucket.size())};
+    bucket.push_back(id);
+    count++;
+
+    maxRadius = std::max(maxRadius, radius);
+    occupiedMin = glm::min(occupiedMin, cell);
+    occupiedMax = glm::max(occupiedMax, cell);
+}
+
+bool SpatialHashGrid::update(uint32_t id, const glm::vec3& center, float radius)
+{
+    if (!contains(id))
+    {
+        insert(id, center, radius);
+        return true;
+    }
+
+    Entry& entry = entries[id];
+    glm::ivec3 cell = cellOf(center);
+    entry.center = center;
+    entry.radius = radius;
+    maxRadius = std::max(maxRadius, radius);
+    if (cell == entry.cell)
+    {
+        return false;
+    }
+
+    removeFromBucket(entry);
+    std::vector<uint32_t>& bucket = buckets[bucketOf(cell)];
+    entry.cell = cell;
+    entry.slot = static_cast<uint32_t>(bucket.size());
+    bucket.push_back(id);
+    occupiedMin = glm::min(occupiedMin, cell);
+    occupiedMax = glm::max(occupiedMax, cell);
+    return true;
+}
+
+void SpatialHashGrid::remove(uint32_t id)
+{
+    if (!contains(id))
+    {
+        return;
+    }
+    removeFromBucket(entries[id]);
+    entries[id].slot = UINT32_MAX;
+    count--;
+}
+
+size_t SpatialHashGrid::updateAll(const PackedInstanceTransform* instances, size_t instanceCount, float baseRadius)
+{
+    size_t moved = 0;
+    for (size_t i = 0; i < instanceCount; i++)
+    {
+        moved += update(static_cast<uint32_t>(i), glm::vec3(instances[i].positionScale), instances[i].positionScale.w * baseRadius);
+    }
+    return moved;
+}
+
+// Swap the last id of the bucket into the hole.
+void SpatialHashGrid::removeFromBucket(const Entry& entry)
+{
+    std::vector<uint32_t>& bucket = buckets[bucketOf(entry.cell)];
+    if (entry.slot + 1 != bucket.size())
+    {
+        bucket[entry.slot] = bucket.back();
+        entries[bucket[entry.slot]].slot = entry.slot;
+    }
+    bucket.pop_back();
+}
+
+glm::ivec3 SpatialHashGrid::cellOf(const glm::vec3& position) const
+{
+    return glm::ivec3(glm::floor(position * inverseCellSize));
+}
+
+size_t SpatialHashGrid::bucketOf(const glm::ivec3& cell) const
+{
+    uint32_t hash = (uint32_t(cell.x) * 73856093u) ^ (uint32_t(cell.y) * 19349663u) ^ (uint32_t(cell.z) * 83492791u);
+    return hash & (buckets.size() - 1);
+}
+
+bool SpatialHashGrid::cellRange(const glm::vec3& boundsMin, const glm::vec3& boundsMax, glm::ivec3& cellMin, glm::ivec3& cellMax) const
+{
+    if (count == 0)
+    {
+        return false;
+    }
+    // clamp while still in float, far away bounds would overflow the conversion to int
+    glm::vec3 low = glm::floor(boundsMin * inverseCellSize);
+    glm::vec3 high = glm::floor(boundsMax * inverseCellSize);
+    if (glm::any(glm::lessThan(high, glm::vec3(occupiedMin))) || glm::any(glm::greaterThan(low, glm::vec3(occupiedMax))))
+    {
+        return false;
+    }
+    cellMin = glm::ivec3(glm::max(low, glm::vec3(occupiedMin)));
+    cellMax = glm::ivec3(glm::min(high, glm::vec3(occupiedMax)));
+    return true;
+}
+
+/*
+ * Ranges covering more cells than there are buckets visit every bucket once instead,
+ * which also keeps huge queries from walking millions of empty cells.
+ */
+template <typename Visit>
+void SpatialHashGrid::visitCells(const glm::ivec3& cellMin, const glm::ivec3& cellMax, Visit&& visit) const
+{
+    glm::dvec3 extent = glm::dvec3(cellMax - cellMin) + 1.0;
+    if (extent.x * extent.y * extent.z > double(buckets.size()))
+    {
+        for (const std::vector<uint32_t>& bucket : buckets)
+        {
+            for (uint32_t id : bucket)
+            {
+                const Entry& entry = entries[id];
+                if (glm::all(glm::greaterThanEqual(entry.cell, cellMin)) && glm::all(glm::lessThanEqual(entry.cell, cellMax)))
+                {
+                    visit(id, entry);
+                }
+            }
+        }
+        return;
+    }
+
+    for (int z = cellMin.z; z <= cellMax.z; z++)
+    {
+        for (int y = cellMin.y; y <= cellMax.y; y++)
+        {
+            for (int x = cellMin.x; x <= cellMax.x; x++)
+            {
+                glm::ivec3 cell(x, y, z);
+                for (uint32_t id : buckets[bucketOf(cell)])
+                {
+                    // other cells can hash to the same bucket
+                    const Entry& entry = entries[id];
+                    if (entry.cell == cell)
+                    {
+                        visit(id, entry);
+                    }
+                }
+            }
+        }
+    }
+}
+
+void SpatialHashGrid::querySphere(const glm::vec3& center, float radius, std::vector<uint32_t>& out) const
+{
+    glm::ivec3 cellMin, cellMax;
+    glm::vec3 reach(radius + maxRadius);
+    if (!cellRange(center - reach, center + reach, cellMin, cellMax))
+    {
+        return;
+    }
+    visitCells(cellMin, cellMax, [&](uint32_t id, const Entry& entry)
+    {
+        glm::vec3 offset = entry.center - center;
+        float touching = radius + entry.radius;
+        if (glm::dot(offset, offset) <= touching * touching)
+        {
+            out.push_back(id);
+        }
+    });
+}
+
+void SpatialHashGrid::queryBox(const glm::vec3& boundsMin, const glm::vec3& boundsMax, std::vector<uint32_t>& out) const
+{
+    glm::ivec3 cellMin, cellMax;
+    glm::vec3 reach(maxRadius);
+    if (!cellRange(boundsMin - reach, boundsMax + reach, cellMin, cellMax))
+    {
+        return;
+    }
+    visitCells(cellMin, cellMax, [&](uint32_t id, const Entry& entry)
+    {
+        glm::vec3 offset = glm::clamp(entry.center, boundsMin, boundsMax) - entry.center;
+        if (glm::dot(offset, offset) <= entry.radius * entry.radius)
+        {
+            out.push_back(id);
+        }
+    });
+}
+
+/*
+ * Walks the cells along the ray (Amanatides & Woo) and tests the items of every cell within `reach` of them,
+ * since a sphere can stick out of its centre cell by up to maxRadius. Stepping one cell along an axis only adds
+ * the far slab of the neighbourhood, so every cell is tested once. A hit at distance t can't be beaten by a centre
+ * further along the ray than t + maxRadius, so the walk stops there.
+ */
+SpatialHit SpatialHashGrid::raycast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance) const
+{
+    SpatialHit best;
+    best.distance = maxDistance;
+    if (count == 0)
+    {
+        return best;
+    }
+
+    int reach = static_cast<int>(std::ceil(maxRadius * inverseCellSize));
+    glm::ivec3 walkMin = occupiedMin - reach;
+    glm::ivec3 walkMax = occupiedMax + reach;
+
+    // clip the ray to the cells that can hold a hit
+    float tNear = 0.0f;
+    float tFar = maxDistance + maxRadius;
+    glm::vec3 boxMin = glm::vec3(walkMin) * cellSize;
+    glm::vec3 boxMax = glm::vec3(walkMax + 1) * cellSize;
+    for (int axis = 0; axis < 3; axis++)
+    {
+        if (direction[axis] == 0.0f)
+        {
+            if (origin[axis] < boxMin[axis] || origin[axis] > boxMax[axis])
+            {
+                return best;
+            }
+            continue;
+        }
+        float t0 = (boxMin[axis] - origin[axis]) / direction[axis];
+        float t1 = (boxMax[axis] - origin[axis]) / direction[axis];
+        tNear = std::max(tNear, std::min(t0, t1));
+        tFar = std::min(tFar, std::max(t0, t1));
+    }
+    if (tNear > tFar)
+    {
+        return best;
+    }
+
+    glm::ivec3 cell = glm::clamp(cellOf(origin + direction * tNear), walkMin, walkMax);
+    glm::ivec3 step;
+    glm::vec3 tNext, tDelta;
+    for (int axis = 0; axis < 3; axis++)
+    {
+        step[axis] = direction[axis] > 0.0f ? 1 : -1;
+        if (direction[axis] == 0.0f)
+        {
+            tNext[axis] = std::numeric_limits<float>::infinity();
+            tDelta[axis] = std::numeric_limits<float>::infinity();
+            continue;
+        }
+        float boundary = (cell[axis] + (step[axis] > 0 ? 1 : 0)) * cellSize;
+        tNext[axis] = (boundary - origin[axis]) / direction[axis];
+        tDelta[axis] = cellSize / std::abs(direction[axis]);
+    }
+
+    auto testItem = [&](uint32_t id, const Entry& entry)
+    {
+        glm::vec3 offset = entry.center - origin;
+        float along = glm::dot(offset, direction);
+        float squaredMiss = glm::dot(offset, offset) - along * along;
+        float squaredRadius = entry.radius * entry.radius;
+        if (squaredMiss > squaredRadius)
+        {
+            return;
+        }
+        float halfChord = std::sqrt(squaredRadius - squaredMiss);
+        if (along + halfChord < 0.0f)
+        {
+            return;
+        }
+        float distance = std::max(along - halfChord, 0.0f);
+        if (distance <= best.distance)
+        {
+            best.id = id;
+            best.distance = distance;
+        }
+    };
+
+    // the first neighbourhood in full, then one slab per step
+    glm::ivec3 rangeMin = glm::max(cell - reach, occupiedMin);
+    glm::ivec3 rangeMax = glm::min(cell + reach, occupiedMax);
+    if (glm::all(glm::lessThanEqual(rangeMin, rangeMax)))
+    {
+        visitCells(rangeMin, rangeMax, testItem);
+    }
+
+    float tEnter = tNear;
+    while (true)
+    {
+        int axis = tNext.x < tNext.y ? (tNext.x < tNext.z ? 0 : 2) : (tNext.y < tNext.z ? 1 : 2);
+        tEnter = tNext[axis];
+        if (tEnter > tFar || tEnter > best.distance + maxRadius)
+        {
+            break;
+        }
+        cell[axis] += step[axis];
+        tNext[axis] += tDelta[axis];
+        if (cell[axis] < walkMin[axis] || cell[axis] > walkMax[axis])
+        {
+            break;
+        }
+
+        glm::ivec3 slabMin = glm::max(cell - reach, occupiedMin);
+        glm::ivec3 slabMax = glm::min(cell + reach, occupiedMax);
+        int slab = cell[axis] + step[axis] * reach;
+        if (slab < occupiedMin[axis] || slab > occupiedMax[axis])
+        {
+            continue;
+        }
+        slabMin[axis] = slab;
+        slabMax[axis] = slab;
+        if (glm::all(glm::lessThanEqual(slabMin, slabMax)))
+        {
+            visitCells(slabMin, slabMax, testItem);
+        }
+    }
+
+    if (best.id < 0)
+    {
+        best.distance = maxDistance;
+    }
+    return best;
+}
+
+/*
+ * Searches shells of cells around the point's cell, nearest shell first. Items in shell `ring` are at least
+ * (ring - 1) * cellSize - maxRadius away, so once the k found so far are all closer than that the search is done.
+ */
+void SpatialHashGrid::nearest(const glm::vec3& point, size_t k, std::vector<SpatialHit>& out) const
+{
+    out.clear();
+    k = std::min(k, count);
+    if (k == 0)
+    {
+        return;
+    }
+
+    auto closer = [](const SpatialHit& a, const SpatialHit& b) { return a.distance < b.distance; };
+    auto testItem = [&](uint32_t id, const Entry& entry)
+    {
+        float distance = std::max(glm::length(point - entry.center) - entry.radius, 0.0f);
+        if (out.size() < k)
+        {
+            out.push_back({long(id), distance});
+            std::push_heap(out.begin(), out.end(), closer);
+        }
+        else if (distance < out.front().distance)
+        {
+            std::pop_heap(out.begin(), out.end(), closer);
+            out.back() = {long(id), distance};
+            std::push_heap(out.begin(), out.end(), closer);
+        }
+    };
+
+    // a point outside the occupied cells starts from the closest of them
+    glm::vec3 occupiedLow = glm::vec3(occupiedMin) * cellSize;
+    glm::vec3 occupiedHigh = glm::vec3(occupiedMax + 1) * cellSize;
+    glm::ivec3 center = glm::clamp(cellOf(glm::clamp(point, occupiedLow, occupiedHigh)), occupiedMin, occupiedMax);
+    float outside = glm::length(point - glm::clamp(point, occupiedLow, occupiedHigh));
+    glm::ivec3 farthest = glm::max(center - occupiedMin, occupiedMax - center);
+    int lastRing = std::max(farthest.x, std::max(farthest.y, farthest.z));
+
+    for (int ring = 0; ring <= lastRing; ring++)
+    {
+        if (out.size() == k && std::max(outside, (ring - 1) * cellSize) - maxRadius >= out.front().distance)
+        {
+            break;
+        }
+
+        glm::ivec3 shellMin = glm::max(center - ring, occupiedMin);
+        glm::ivec3 shellMax = glm::min(center + ring, occupiedMax);
+        for (int x = shellMin.x; x <= shellMax.x; x++)
+        {
+            for (int y = shellMin.y; y <= shellMax.y; y++)
+            {
+                bool inside = std::abs(x - center.x) < ring && std::abs(y - center.y) < ring;
+                for (int z = shellMin.z; z <= shellMax.z; z++)
+                {
+                    // inner columns only touch the shell at their two ends
+                    if (inside && std::abs(z - center.z) < ring)
+                    {
+                        z = center.z + ring - 1;
+                        continue;
+                    }
+                    visitCells(glm::ivec3(x, y, z), glm::ivec3(x, y, z), testItem);
+                }
+            }
+        }
+    }
+
+    std::sort_heap(out.begin(), out.end(), closer);
+}
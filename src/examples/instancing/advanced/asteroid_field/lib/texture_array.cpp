@@ -0,0 +1,196 @@
+#include "../headers/texture_array.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+namespace
+{
+    struct ResampleTap {
+        int source;
+        float weight;
+    };
+
+    // Source pixels (and their weights) that make up each of the `newSize` destination pixels along one axis.
+    std::vector<std::vector<ResampleTap>> resampleTaps(int size, int newSize)
+    {
+        std::vector<std::vector<ResampleTap>> taps(newSize);
+        float scale = (float)size / (float)newSize;
+        for (int i = 0; i < newSize; i++)
+        {
+            if (scale > 1.0f)
+            {
+                // box filter over the source pixels covered by this one, partially covered ones count partially
+                float start = i * scale;
+                float end = (i + 1) * scale;
+                for (int p = (int)std::floor(start); p < std::min(size, (int)std::ceil(end)); p++)
+                {
+                    float coverage = std::min(end, p + 1.0f) - std::max(start, (float)p);
+                    taps[i].push_back({p, coverage / scale});
+                }
+            }
+            else
+            {
+                float center = (i + 0.5f) * scale - 0.5f;
+                int p = (int)std::floor(center);
+                float t = center - p;
+                taps[i].push_back({std::clamp(p, 0, size - 1), 1.0f - t});
+                taps[i].push_back({std::clamp(p + 1, 0, size - 1), t});
+            }
+        }
+        return taps;
+    }
+}
+
+std::vector<unsigned char> resampleRgba(const unsigned char* rgba, int width, int height, int newWidth, int newHeight)
+{
+    // separable: rows first into a float scratch image, then columns
+    std::vector<std::vector<ResampleTap>> columnTaps = resampleTaps(width, newWidth);
+    std::vector<std::vector<ResampleTap>> rowTaps = resampleTaps(height, newHeight);
+
+    std::vector<float> horizontal((size_t)newWidth * height * 4, 0.0f);
+    for (int y = 0; y < height; y++)
+    {
+        const unsigned char* sourceRow = rgba + (size_t)y * width * 4;
+        float* row = &horizontal[(size_t)y * newWidth * 4];
+        for (int x = 0; x < newWidth; x++)
+        {
+            for (const ResampleTap& tap : columnTaps[x])
+            {
+                for (int c = 0; c < 4; c++)
+                {
+                    row[x * 4 + c] += sourceRow[tap.source * 4 + c] * tap.weight;
+                }
+            }
+        }
+    }
+
+    std::vector<unsigned char> resampled((size_t)newWidth * newHeight * 4);
+    for (int y = 0; y < newHeight; y++)
+    {
+        for (int x = 0; x < newWidth * 4; x++)
+        {
+            float value = 0.0f;
+            for (const ResampleTap& tap : rowTaps[y])
+            {
+                value += horizontal[(size_t)tap.source * newWidth * 4 + x] * tap.weight;
+            }
+            resampled[(size_t)y * newWidth * 4 + x] = (unsigned char)std::clamp(std::lround(value), 0L, 255L);
+        }
+    }
+    return resampled;
+}
+
+TextureArray::TextureArray(int width, int height)
+    : width(width), height(height)
+{
+}
+
+TextureArray::~TextureArray()
+{
+    if (texture != 0)
+    {
+        glDeleteTextures(1, &texture);
+    }
+}
+
+int TextureArray::addFile(const std::string& path)
+{
+    auto existing = fileLayers.find(path);
+    if (existing != fileLayers.end())
+    {
+        return existing->second;
+    }
+
+    int imageWidth, imageHeight, nrComponents;
+    unsigned char* data = stbi_load(path.c_str(), &imageWidth, &imageHeight, &nrComponents, 4);
+    if (!data)
+    {
+        std::cout << "Texture failed to load at path: " << path << std::endl;
+        return -1;
+    }
+
+    int layer = addPixels(data, imageWidth, imageHeight);
+    stbi_image_free(data);
+    fileLayers[path] = layer;
+    return layer;
+}
+
+int TextureArray::addPixels(const unsigned char* rgba, int width, int height)
+{
+    if (this->width == 0 || this->height == 0)
+    {
+        this->width = width;
+        this->height = height;
+    }
+
+    if (width == this->width && height == this->height)
+    {
+        layers.emplace_back(rgba, rgba + (size_t)width * height * 4);
+    }
+    else
+    {
+        layers.push_back(resampleRgba(rgba, width, height, this->width, this->height));
+    }
+    return (int)layers.size() - 1;
+}
+
+void TextureArray::upload()
+{
+    if (layers.empty())
+    {
+        return;
+    }
+
+    GLint maxLayers = 0;
+    glGetIntegerv(GL_MAX_ARRAY_TEXTURE_LAYERS, &maxLayers);
+    if ((GLint)layers.size() > maxLayers)
+    {
+        std::cout << "ERROR::TEXTURE_ARRAY::TOO_MANY_LAYERS: " << layers.size() << " > " << maxLayers << std::endl;
+        return;
+    }
+
+    if (texture == 0)
+    {
+        glGenTextures(1, &texture);
+    }
+    glBindTexture(GL_TEXTURE_2D_ARRAY, texture);
+    glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA8, width, height, (GLsizei)layers.size(), 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+    for (size_t layer = 0; layer < layers.size(); layer++)
+    {
+        glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, (GLint)layer, width, height, 1, GL_RGBA, GL_UNSIGNED_BYTE, layers[layer].data());
+    }
+    glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+}
+
+void TextureArray::bind(unsigned int unit) const
+{
+    glActiveTexture(GL_TEXTURE0 + unit);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, texture);
+}
+
+unsigned int TextureArray::getTexture() const
+{
+    return texture;
+}
+
+int TextureArray::getLayerCount() const
+{
+    return (int)layers.size();
+}
+
+int TextureArray::getWidth() const
+{
+    return width;
+}
+
+int TextureArray::getHeight() const
+{
+    return height;
+}
@@ -0,0 +1,246 @@
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+#include "./headers/asteroid_ring.hpp"
+#include "./headers/instance_transform.hpp"
+#include "./headers/orbit_simulation.hpp"
+#include "./headers/spatial_hash.hpp"
+#include "../../../../headers/thread_pool.hpp"
+
+/*
+ * Console benchmark for SpatialHashGrid over the default asteroid ring:
+ *   spatial_hash_benchmark [rock count = 1000000] [cell size = 2]
+ * Times building the grid, one incremental update after an orbit step, and each query type,
+ * and checks the first queries of every type against a brute force scan over all rocks.
+ */
+
+// Largest vertex distance of rock.obj, the unscaled bounding sphere.
+const float ROCK_RADIUS = 2.15f;
+const uint32_t ASTEROID_SEED = 1;
+const int QUERY_COUNT = 1000;
+const int CHECKED_QUERIES = 25;
+
+std::vector<PackedInstanceTransform> rocks;
+
+double millisecondsSince(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+glm::vec3 rockCenter(size_t i)
+{
+    return glm::vec3(rocks[i].positionScale);
+}
+
+float rockRadius(size_t i)
+{
+    return rocks[i].positionScale.w * ROCK_RADIUS;
+}
+
+SpatialHit bruteForceRaycast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance)
+{
+    SpatialHit best;
+    best.distance = maxDistance;
+    for (size_t i = 0; i < rocks.size(); i++)
+    {
+        glm::vec3 offset = rockCenter(i) - origin;
+        float along = glm::dot(offset, direction);
+        float squaredMiss = glm::dot(offset, offset) - along * along;
+        float squaredRadius = rockRadius(i) * rockRadius(i);
+        if (squaredMiss > squaredRadius || along + std::sqrt(squaredRadius - squaredMiss) < 0.0f)
+        {
+            continue;
+        }
+        float distance = std::max(along - std::sqrt(squaredRadius - squaredMiss), 0.0f);
+        if (distance <= best.distance)
+        {
+            best.id = i;
+            best.distance = distance;
+        }
+    }
+    return best;
+}
+
+std::vector<uint32_t> bruteForceSphere(const glm::vec3& center, float radius)
+{
+    std::vector<uint32_t> ids;
+    for (size_t i = 0; i < rocks.size(); i++)
+    {
+        if (glm::length(rockCenter(i) - center) <= radius + rockRadius(i))
+        {
+            ids.push_back(i);
+        }
+    }
+    return ids;
+}
+
+std::vector<uint32_t> bruteForceBox(const glm::vec3& boundsMin, const glm::vec3& boundsMax)
+{
+    std::vector<uint32_t> ids;
+    for (size_t i = 0; i < rocks.size(); i++)
+    {
+        if (glm::length(glm::clamp(rockCenter(i), boundsMin, boundsMax) - rockCenter(i)) <= rockRadius(i))
+        {
+            ids.push_back(i);
+        }
+    }
+    return ids;
+}
+
+std::vector<float> bruteForceNearest(const glm::vec3& point, size_t k)
+{
+    std::vector<float> distances(rocks.size());
+    for (size_t i = 0; i < rocks.size(); i++)
+    {
+        distances[i] = std::max(glm::length(point - rockCenter(i)) - rockRadius(i), 0.0f);
+    }
+    k = std::min(k, distances.size());
+    std::partial_sort(distances.begin(), distances.begin() + k, distances.end());
+    distances.resize(k);
+    return distances;
+}
+
+bool sameIds(std::vector<uint32_t> a, std::vector<uint32_t> b)
+{
+    std::sort(a.begin(), a.end());
+    std::sort(b.begin(), b.end());
+    return a == b;
+}
+
+void report(const char* name, double milliseconds, int mismatches, double resultsPerQuery)
+{
+    std::printf("%-14s %10.2f us/query  %8.1f results/query  %s\n", name, milliseconds * 1000.0 / QUERY_COUNT, resultsPerQuery,
+        mismatches == 0 ? "matches brute force" : "MISMATCH");
+}
+
+int main(int argc, char** argv)
+{
+    size_t rockCount = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 1000000;
+    float cellSize = argc > 2 ? std::strtof(argv[2], nullptr) : 2.0f;
+
+    ThreadPool pool;
+    AsteroidRing ring;
+    InstanceTransforms transforms;
+    transforms.resize(rockCount);
+    generateAsteroidRing(ring, ASTEROID_SEED, transforms, 0, rockCount, &pool);
+    OrbitSimulation orbits(pool);
+    orbits.reset(ring, ASTEROID_SEED, transforms);
+    rocks = orbits.finish();
+
+    std::printf("%zu rocks, cell size %.2f, %u threads for generation\n", rockCount, cellSize, pool.size() + 1);
+
+    SpatialHashGrid grid(cellSize, rockCount);
+    auto start = std::chrono::steady_clock::now();
+    grid.updateAll(rocks.data(), rocks.size(), ROCK_RADIUS);
+    std::printf("%-14s %10.2f ms\n", "build", millisecondsSince(start));
+
+    // one 60 Hz frame of orbiting, most rocks stay in their cell
+    std::vector<PackedInstanceTransform> stepped(rocks.size());
+    orbits.step(0, rocks.size(), 1.0f / 60.0f, stepped.data());
+    rocks = stepped;
+    start = std::chrono::steady_clock::now();
+    size_t moved = grid.updateAll(rocks.data(), rocks.size(), ROCK_RADIUS);
+    std::printf("%-14s %10.2f ms (%zu rocks changed cell)\n", "update", millisecondsSince(start), moved);
+
+    // query points on the ring, ray origins around it
+    std::mt19937 random(1234);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    auto ringPoint = [&]()
+    {
+        size_t i = std::min(size_t(unit(random) * rocks.size()), rocks.size() - 1);
+        return rockCenter(i) + (glm::vec3(unit(random), unit(random), unit(random)) - 0.5f) * 4.0f;
+    };
+    std::vector<glm::vec3> points(QUERY_COUNT), origins(QUERY_COUNT), directions(QUERY_COUNT);
+    for (int i = 0; i < QUERY_COUNT; i++)
+    {
+        points[i] = ringPoint();
+        float angle = unit(random) * 6.2831853f;
+        origins[i] = glm::vec3(std::cos(angle) * 250.0f, 40.0f * (unit(random) - 0.5f), std::sin(angle) * 250.0f);
+        directions[i] = glm::normalize(ringPoint() - origins[i]);
+    }
+
+    int mismatches = 0;
+    double results = 0.0;
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < QUERY_COUNT; i++)
+    {
+        results += grid.raycast(origins[i], directions[i], 1000.0f).id >= 0;
+    }
+    double milliseconds = millisecondsSince(start);
+    for (int i = 0; i < CHECKED_QUERIES; i++)
+    {
+        SpatialHit hit = grid.raycast(origins[i], directions[i], 1000.0f);
+        SpatialHit expected = bruteForceRaycast(origins[i], directions[i], 1000.0f);
+        mismatches += hit.id != expected.id && std::abs(hit.distance - expected.distance) > 1e-4f;
+    }
+    report("ray pick", milliseconds, mismatches, results / QUERY_COUNT);
+
+    std::vector<uint32_t> ids;
+    mismatches = 0;
+    results = 0.0;
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < QUERY_COUNT; i++)
+    {
+        ids.clear();
+        grid.querySphere(points[i], 5.0f, ids);
+        results += ids.size();
+    }
+    milliseconds = millisecondsSince(start);
+    for (int i = 0; i < CHECKED_QUERIES; i++)
+    {
+        ids.clear();
+        grid.querySphere(points[i], 5.0f, ids);
+        mismatches += !sameIds(ids, bruteForceSphere(points[i], 5.0f));
+    }
+    report("sphere r=5", milliseconds, mismatches, results / QUERY_COUNT);
+
+    mismatches = 0;
+    results = 0.0;
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < QUERY_COUNT; i++)
+    {
+        ids.clear();
+        grid.queryBox(points[i] - 4.0f, points[i] + 4.0f, ids);
+        results += ids.size();
+    }
+    milliseconds = millisecondsSince(start);
+    for (int i = 0; i < CHECKED_QUERIES; i++)
+    {
+        ids.clear();
+        grid.queryBox(points[i] - 4.0f, points[i] + 4.0f, ids);
+        mismatches += !sameIds(ids, bruteForceBox(points[i] - 4.0f, points[i] + 4.0f));
+    }
+    report("box 8^3", milliseconds, mismatches, results / QUERY_COUNT);
+
+    std::vector<SpatialHit> hits;
+    mismatches = 0;
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < QUERY_COUNT; i++)
+    {
+        grid.nearest(points[i], 16, hits);
+    }
+    milliseconds = millisecondsSince(start);
+    for (int i = 0; i < CHECKED_QUERIES; i++)
+    {
+        grid.nearest(points[i], 16, hits);
+        std::vector<float> expected = bruteForceNearest(points[i], 16);
+        bool same = hits.size() == expected.size();
+        for (size_t j = 0; same && j < hits.size(); j++)
+        {
+            same = std::abs(hits[j].distance - expected[j]) <= 1e-4f;
+        }
+        mismatches += !same;
+    }
+    report("16 nearest", milliseconds, mismatches, 16.0);
+
+    start = std::chrono::steady_clock::now();
+    bruteForceRaycast(origins[0], directions[0], 1000.0f);
+    std::printf("%-14s %10.2f us/query\n", "brute force ray", millisecondsSince(start) * 1000.0);
+    return 0;
+}
@@ -10,6 +10,9 @@
 #include "../../../headers/stb_image.h"
 
 #include <filesystem>
+#include <vector>
+
+#include "../../../headers/instance_batch.hpp"
 
 struct Joystick {
     float leftX;
@@ -20,6 +23,12 @@ struct Joystick {
     float R2;
 };
 
+// One per wall piece, read by the vertex shader as an instanced attribute (location 2) instead of a uniform array.
+struct WallInstance {
+    glm::vec3 offset;
+    static constexpr auto attributes = std::make_tuple(&WallInstance::offset);
+};
+
 // Variables
 size_t WINDOW_WIDTH = 800;
 size_t WINDOW_HEIGHT = 600;
@@ -53,14 +62,13 @@ glm::vec3 cubePositions[] = {
 const char *vertexShaderSource = 
 	"#version 330 core \n"
 	"layout (location = 0) in vec3 aPos; \n"
+	"layout (location = 2) in vec3 aOffset; \n"
     "uniform mat4 model; \n"
     "uniform mat4 view; \n"
     "uniform mat4 projection; \n"
-    "uniform vec3 offsets[100]; \n"
     "void main() \n"
     "{\n"
-    "   vec3 offset = offsets[gl_InstanceID];           \n"
-    "   gl_Position = projection * view * model * vec4(aPos + offset, 1.0); \n"
+    "   gl_Position = projection * view * model * vec4(aPos + aOffset, 1.0); \n"
     "}\0";
 
 const char *fragmentShaderSource = 
@@ -136,7 +144,9 @@ int indices[] = {
     4, 12, 13
 };
 
-glm::vec3 translations[100];
+// Pieces per row and column of the wall, 1000 gives a million instances.
+int WALL_SIDE = 10;
+std::vector<WallInstance> wallInstances;
 
 glm::vec3 cameraPos   = glm::vec3(0.0f, 0.0f,  3.0f);
 glm::vec3 cameraFront = glm::vec3(0.0f, 0.0f, -1.0f);
@@ -158,7 +168,7 @@ void render(GLFWwindow* window);
 unsigned int applyShader(GLenum shaderType, const char *source);
 void buildShaderProgram();
 void storeVertexDataOnGpu();
-void draw();
+void draw(const InstanceBatch<WallInstance>& wallBatch);
 void debug(unsigned int shaderRef, size_t mode);
 
 int main() 
@@ -230,20 +240,24 @@ void render(GLFWwindow* window)
 	buildShaderProgram();
 	storeVertexDataOnGpu();
 
-    // build intancing offset array
-    int index = 0;
+    // build the instance offsets once, drawing them costs no CPU work per instance
     float offset = 0.1f;
-    for(int y = -10; y < 10; y += 2)
+    wallInstances.resize(WALL_SIDE * WALL_SIDE);
+    for (int row = 0; row < WALL_SIDE; row++)
     {
-        for(int x = -100; x < 100; x += 20)
+        for (int column = 0; column < WALL_SIDE; column++)
         {
             glm::vec3 translation;
-            translation.x = (float)x / 10.0f + offset;
-            translation.y = (float)y / 10.0f + offset;
+            translation.x = (column - WALL_SIDE / 2) * 2.0f + offset;
+            translation.y = (row - WALL_SIDE / 2) * 0.2f + offset;
             translation.z = 0;
-            translations[index++] = translation;
+            wallInstances[row * WALL_SIDE + column].offset = translation;
         }
-    }  
+    }
+
+    InstanceBatch<WallInstance> wallBatch(2);
+    wallBatch.attach(vaoId);
+    wallBatch.upload(wallInstances);
 
 	while(!glfwWindowShouldClose(window))
 	{
@@ -260,7 +274,7 @@ void render(GLFWwindow* window)
 		processInput(window);
 
 		// Rendering commands
-		draw();
+		draw(wallBatch);
 
 		// check and call events and swap the buffers
 		glfwSwapBuffers(window);
@@ -407,7 +421,7 @@ void scroll_callback(GLFWwindow* window, double xoffset, double yoffset)
     fov -= (float)yoffset;
 }
 
-void draw()
+void draw(const InstanceBatch<WallInstance>& wallBatch)
 {
 	// Clear the screen with a colour
 	// glClearColor(0.0f, 0.0f, 0.5f, 0.2f);
@@ -440,22 +454,15 @@ void draw()
     glm::mat4 projection = glm::perspective(glm::radians(fov), (float)WINDOW_WIDTH / (float)WINDOW_HEIGHT, 0.1f, 100.0f);
     glUniformMatrix4fv(glGetUniformLocation(shaderProgramId, "projection"), 1, GL_FALSE, glm::value_ptr(projection));
 
-	glBindVertexArray(vaoId);
     glm::mat4 model = glm::mat4(1.0f);
     model = glm::translate(model, cubePositions[0]);
     float angle = 45.0f * (1.5f); 
     model = glm::rotate(model, glm::radians(angle) * (float)glfwGetTime(), glm::vec3(0.0f, 1.0f, 0.0f));
     glUniformMatrix4fv(glGetUniformLocation(shaderProgramId, "model"), 1, GL_FALSE, glm::value_ptr(model));
 
-    // Instancing stuff
-    for (unsigned int i = 0; i < 100; i++)
-    {
-        std::string name = "offsets[" + std::to_string(i) + "]";
-        glUniform3fv(glGetUniformLocation(shaderProgramId, &name[0]), 1, glm::value_ptr(translations[i]));
-    }
-    
+    // Instancing stuff, the offsets already live in the batch's buffer
     //glDrawElements(GL_TRIANGLES, TOTAL_VERTICES, GL_UNSIGNED_INT, 0);
-    glDrawElementsInstanced(GL_TRIANGLES, TOTAL_VERTICES, GL_UNSIGNED_INT, 0, 100);
+    wallBatch.drawElements(GL_TRIANGLES, TOTAL_VERTICES);
 }
 
 void storeVertexDataOnGpu()
@@ -13,61 +13,18 @@
 
 #define STB_IMAGE_IMPLEMENTATION
 #include "../../headers/stb_image.h"
+#include "../../headers/program_cache.hpp"
+#include "../../headers/shader_permutations.hpp"
+#include "lighting_cube_shaders.hpp"
 
 #include <filesystem>
 
-const char *vertexShaderSource = 
-	"#version 330 core \n"
-	"layout (location = 0) in vec3 aPos; \n"
-	"layout (location = 1) in vec2 aTexCoord; \n"
-	"out vec2 TexCoord; \n"
-    "uniform mat4 model; \n"
-    "uniform mat4 view; \n"
-    "uniform mat4 projection; \n"
-    "void main() \n"
-    "{\n"
-    // Note: The order of matrix multiplication here is important.
-    "   gl_Position = projection * view * model * vec4(aPos, 1.0); \n"
-    "	TexCoord = aTexCoord; \n"
-    "}\0";
-
-const char *fragmentShaderSource = 
-	"#version 330 core \n"
-    "out vec4 myOutput; \n"
-	"in vec2 TexCoord; \n"
-	"uniform sampler2D ourTexture; \n"
-	"uniform sampler2D ourTexture2; \n"
-	"uniform vec3 lightColour; \n"
-    "void main() \n"
-    "{\n"
-	//"    myOutput = vec4(lightColour * mix(texture(ourTexture, TexCoord), texture(ourTexture2, TexCoord), 0.5)); \n"
-	"    myOutput = mix(texture(ourTexture, TexCoord), texture(ourTexture2, TexCoord), 0.5); \n"
-    "}\0";
-
-const char *lightSourceVertexShader = 
-	"#version 330 core \n"
-	"layout (location = 0) in vec3 aPos; \n"
-    "uniform mat4 model; \n"
-    "uniform mat4 view; \n"
-    "uniform mat4 projection; \n"
-    "void main() \n"
-    "{\n"
-    "   gl_Position = projection * view * model * vec4(aPos, 1.0); \n"
-    "}\0";
-
-const char *lightSourceFragmentShader = 
-	"#version 330 core  \n"
-    "out vec4 myOutput; \n"
-    "                   \n"
-    "void main()        \n"
-    "{\n"
-    "    myOutput = vec4(1.0);"
-    "}\0";
+// The step of the walkthrough in lighting_cube_shaders.hpp this file shows.
+const size_t LIGHTING_STEP = 0;
 
 uint32_t vboId;
 uint32_t cubeVaoIds[2];
 uint32_t textures[2];
-uint32_t vertexShaderId, fragmentShaderId, lightSourceVertexShaderId, lightSourceFragmentShaderId;
 uint32_t cubeShaderProgramId, lightSourceShaderProgramId;
 
 float vertices[] = {
@@ -146,12 +103,9 @@ void mouse_callback(GLFWwindow* window, double xpos, double ypos);
 void scroll_callback(GLFWwindow* window, double xoffset, double yoffset);
 
 void render(GLFWwindow* window);
-uint32_t applyShader(GLenum shaderType, const char *source);
-uint32_t buildShaderProgram(uint32_t vShaderId, uint32_t fShaderId);
 void storeVertexDataOnGpu();
 void draw();
 void loadTexture(std::string path, uint32_t textureId, GLenum rgbTypeA, GLenum rgbTypeB);
-void debug(uint32_t shaderRef, size_t mode);
 
 int main() 
 {
@@ -180,6 +134,9 @@ int main()
 		return -1;
 	}  
 
+	// programs linked on earlier runs are loaded from here instead of compiled again
+	programCache.enable("shader_cache", (GLADloadproc) glfwGetProcAddress);
+
 	// Viewport dictates how we want to display the data and coordinates with respect to the window
 	glfwSetFramebufferSizeCallback(window, framebuffer_size_callback); 
 
@@ -208,8 +165,6 @@ int main()
 
 	glDeleteVertexArrays(2, cubeVaoIds);
     glDeleteBuffers(1, &vboId);
-    glDeleteProgram(cubeShaderProgramId);
-    glDeleteProgram(lightSourceShaderProgramId);
 
 	glfwTerminate();
     return 0;
@@ -217,14 +172,12 @@ int main()
 
 void render(GLFWwindow* window)
 {
-	vertexShaderId = applyShader(GL_VERTEX_SHADER, vertexShaderSource);
-	fragmentShaderId = applyShader(GL_FRAGMENT_SHADER, fragmentShaderSource);
-
-	lightSourceVertexShaderId = applyShader(GL_VERTEX_SHADER, lightSourceVertexShader);
-	lightSourceFragmentShaderId = applyShader(GL_FRAGMENT_SHADER, lightSourceFragmentShader);
-
-	cubeShaderProgramId = buildShaderProgram(vertexShaderId, fragmentShaderId);
-	lightSourceShaderProgramId = buildShaderProgram(lightSourceVertexShaderId, lightSourceFragmentShaderId);
+	// One source for every step of the walkthrough, this step only compiles the lighting it uses.
+	ShaderPermutations cubeShaders("cube", lightingCubeVertexShader, lightingCubeFragmentShader, LIGHTING_FEATURE_NAMES);
+	ShaderPermutations lightSourceShaders("light source", lightSourceVertexShader, lightSourceFragmentShader, {});
+	cubeShaderProgramId = cubeShaders.get(LIGHTING_STEPS[LIGHTING_STEP].features);
+	lightSourceShaderProgramId = lightSourceShaders.get(0);
+	programCache.printReport();
 	storeVertexDataOnGpu();
 
 	while(!glfwWindowShouldClose(window))
@@ -366,6 +319,7 @@ void draw()
 
 	// Every shader and rendering call after the `glUseProgram` call will now use this program object (and thus the shaders).
 	glUseProgram(cubeShaderProgramId);
+	setLightingUniforms(cubeShaderProgramId, LIGHTING_STEPS[LIGHTING_STEP]);
 
     glUniform3f(glGetUniformLocation(cubeShaderProgramId, "lightColour"), 1.0f, 1.0f, 1.0f);
 
@@ -453,33 +407,6 @@ void storeVertexDataOnGpu()
     glBindVertexArray(0); 
 }
 
-uint32_t applyShader(GLenum shaderType, const char *source)
-{
-	uint32_t shaderReferenceId = glCreateShader(shaderType);
-	glShaderSource(shaderReferenceId, 1, &source, NULL);
-	glCompileShader(shaderReferenceId);
-	debug(shaderReferenceId, shaderType == GL_VERTEX_SHADER ? 1 : 2);
-	return shaderReferenceId;
-}
-
-uint32_t buildShaderProgram(uint32_t vShaderId, uint32_t fShaderId)
-{
-	// Same `id` reference patern as with the complation of the Vertex and Fragment shaders. 
-	uint32_t shaderProgramId = glCreateProgram();
-
-	// Self-explanatory, link the shaders to the `shaderProgram`
-	glAttachShader(shaderProgramId, vShaderId);
-	glAttachShader(shaderProgramId, fShaderId);
-	glLinkProgram(shaderProgramId);
-
-	// Delete the shader objects once we've linked them into the program object; we no longer need them anymore.
-	glDeleteShader(vShaderId);
-	glDeleteShader(fShaderId);
-
-	debug(shaderProgramId, 0);
-    return shaderProgramId;
-}
-
 void loadTexture(std::string path, uint32_t textureId, GLenum rgbTypeA, GLenum rgbTypeB)
 {
     glBindTexture(GL_TEXTURE_2D, textures[textureId]); // all upcoming GL_TEXTURE_2D operations now have an effect on this texture object
@@ -507,38 +434,3 @@ void loadTexture(std::string path, uint32_t textureId, GLenum rgbTypeA, GLenum r
     }
     stbi_image_free(data);
 }
-
-void debug(uint32_t shaderRef, size_t mode)
-{
-	int success;
-	char infoLog[512];
-	if (mode > 0)
-	{
-		glGetShaderiv(shaderRef, GL_COMPILE_STATUS, &success);
-		if(!success)
-		{
-			glGetShaderInfoLog(shaderRef, 512, NULL, infoLog);
-			std::string shaderName;
-			if (mode == 1)
-			{
-				shaderName = "VERTEX";
-			}
-			else if (mode == 2)
-			{
-				shaderName = "FRAGMENT";
-			}
-			else {
-				shaderName == "NO DEBUG SHADER NAME";
-			}
-			std::cout << "ERROR::SHADER::" << shaderName << "::COMPILATION_FAILED\n" << infoLog << std::endl;
-		}
-	} else if (mode == 0)
-	{
-		glGetProgramiv(shaderRef, GL_LINK_STATUS, &success);
-		if(!success)
-		{
-    		glGetProgramInfoLog(shaderRef, 512, NULL, infoLog);
-			std::cout << "ERROR::SHADER::PROGRAM::COMPILATION_FAILED\n" << infoLog << std::endl;
-		}
-	}
-}
@@ -13,103 +13,18 @@
 
 #define STB_IMAGE_IMPLEMENTATION
 #include "../../headers/stb_image.h"
+#include "../../headers/program_cache.hpp"
+#include "../../headers/shader_permutations.hpp"
+#include "lighting_cube_shaders.hpp"
 
 #include <filesystem>
 
-/*
- * Inversing matrices is a costly operation for shaders, so wherever possible try to avoid doing inverse operations since 
- * they have to be done on each vertex of your scene. For learning purposes this is fine, but for an efficient application you'll likely 
- * want to calculate the normal matrix on the CPU and send it to the shaders via a uniform before drawing (just like the model matrix).
- */
-const char *vertexShaderSource = 
-	"#version 330 core \n"
-	"layout (location = 0) in vec3 aPos; \n"
-	"layout (location = 1) in vec2 aTexCoord; \n"
-	"layout (location = 2) in vec3 aNormal; \n"
-	"out vec2 TexCoord; \n"
-	"out vec3 Normal; \n"
-	"out vec3 FragmentPos; \n"
-    "uniform mat4 model; \n"
-    "uniform mat4 view; \n"
-    "uniform mat4 projection; \n"
-    "void main() \n"
-    "{\n"
-    // Note: The order of matrix multiplication here is important.
-    "   gl_Position = projection * view * model * vec4(aPos, 1.0); \n"
-    "   FragmentPos = vec3(model * vec4(aPos, 1.0));             \n"
-    "	TexCoord = aTexCoord; \n"
-    // This is absolutely necessary for non-unform scale / transformation operation, e.g., rotation#
-    "	Normal = mat3(transpose(inverse(model))) * aNormal; \n"
-    "}\0";
-
-/*
- * We need is the actual fragment's position. We're going to do all the lighting calculations in world space so 
- * we want a vertex position that is in world space first. 
- * We can accomplish this by multiplying the vertex position attribute with the model matrix only (not the view and projection matrix) 
- * to transform it to world space coordinates.
- *
- * When calculating lighting we usually do not care about the magnitude of a vector or their position; we only care about their direction. 
- * Because we only care about their direction almost all the calculations are done with unit vectors since it simplifies 
- * most calculations (like the dot product). So when doing lighting calculations, make sure you always normalize the relevant vectors to 
- * ensure they're actual unit vectors. Forgetting to normalize a vector is a popular mistake.
- */
-
-/*
- * If the angle between both vectors is greater than 90 degrees then the result of the dot product will actually become negative 
- * and we end up with a negative diffuse component. For that reason we use the max function that returns the highest of both its 
- * parameters to make sure the diffuse component (and thus the colors) never become negative.
- */
-const char *fragmentShaderSource = 
-	"#version 330 core \n"
-    "out vec4 myOutput; \n"
-	"in vec2 TexCoord; \n"
-	"in vec3 Normal; \n"
-	"in vec3 FragmentPos; \n"
-	"uniform sampler2D ourTexture; \n"
-	"uniform sampler2D ourTexture2; \n"
-	"uniform vec3 lightColour; \n"
-	"uniform vec3 lightPos; \n"
-	"uniform float ambientStrength; \n"
-    "void main() \n"
-    "{\n"
-    "    vec3 objectColour = vec3(0.0f, 0.75f, 0.70f);                                \n"
-    "    vec3 lightingWithAmbient = lightColour * ambientStrength;                         \n"
-
-    "    vec3 norm = normalize(Normal);                           \n"
-    "    vec3 lightDir = normalize(lightPos - FragmentPos);                           \n"
-    "    float diff = max(dot(norm, lightDir), 0.0);                           \n"
-    "    vec3 lightingWithDiffuse = diff * lightColour;                           \n"
-
-    "    vec3 result = objectColour * (lightingWithAmbient + lightingWithDiffuse);                           \n"
-    "    myOutput = vec4(result, 1.0);                          \n"
-	//"    myOutput = vec4(lightColour * mix(texture(ourTexture, TexCoord), texture(ourTexture2, TexCoord), 0.5)); \n"
-	//"    myOutput = mix(texture(ourTexture, TexCoord), texture(ourTexture2, TexCoord), 0.5); \n"
-    "}\0";
-
-const char *lightSourceVertexShader = 
-	"#version 330 core \n"
-	"layout (location = 0) in vec3 aPos; \n"
-    "uniform mat4 model; \n"
-    "uniform mat4 view; \n"
-    "uniform mat4 projection; \n"
-    "void main() \n"
-    "{\n"
-    "   gl_Position = projection * view * model * vec4(aPos, 1.0); \n"
-    "}\0";
-
-const char *lightSourceFragmentShader = 
-	"#version 330 core  \n"
-    "out vec4 myOutput; \n"
-    "                   \n"
-    "void main()        \n"
-    "{\n"
-    "    myOutput = vec4(1.0);"
-    "}\0";
+// The step of the walkthrough in lighting_cube_shaders.hpp this file shows.
+const size_t LIGHTING_STEP = 2;
 
 uint32_t vboId;
 uint32_t cubeVaoIds[2];
 uint32_t textures[2];
-uint32_t vertexShaderId, fragmentShaderId, lightSourceVertexShaderId, lightSourceFragmentShaderId;
 uint32_t cubeShaderProgramId, lightSourceShaderProgramId;
 
 float vertices[] = {
@@ -189,12 +104,9 @@ void mouse_callback(GLFWwindow* window, double xpos, double ypos);
 void scroll_callback(GLFWwindow* window, double xoffset, double yoffset);
 
 void render(GLFWwindow* window);
-uint32_t applyShader(GLenum shaderType, const char *source);
-uint32_t buildShaderProgram(uint32_t vShaderId, uint32_t fShaderId);
 void storeVertexDataOnGpu();
 void draw();
 void loadTexture(std::string path, uint32_t textureId, GLenum rgbTypeA, GLenum rgbTypeB);
-void debug(uint32_t shaderRef, size_t mode);
 
 int main() 
 {
@@ -223,6 +135,9 @@ int main()
 		return -1;
 	}  
 
+	// programs linked on earlier runs are loaded from here instead of compiled again
+	programCache.enable("shader_cache", (GLADloadproc) glfwGetProcAddress);
+
 	// Viewport dictates how we want to display the data and coordinates with respect to the window
 	glfwSetFramebufferSizeCallback(window, framebuffer_size_callback); 
 
@@ -251,8 +166,6 @@ int main()
 
 	glDeleteVertexArrays(2, cubeVaoIds);
     glDeleteBuffers(1, &vboId);
-    glDeleteProgram(cubeShaderProgramId);
-    glDeleteProgram(lightSourceShaderProgramId);
 
 	glfwTerminate();
     return 0;
@@ -260,14 +173,12 @@ int main()
 
 void render(GLFWwindow* window)
 {
-	vertexShaderId = applyShader(GL_VERTEX_SHADER, vertexShaderSource);
-	fragmentShaderId = applyShader(GL_FRAGMENT_SHADER, fragmentShaderSource);
-
-	lightSourceVertexShaderId = applyShader(GL_VERTEX_SHADER, lightSourceVertexShader);
-	lightSourceFragmentShaderId = applyShader(GL_FRAGMENT_SHADER, lightSourceFragmentShader);
-
-	cubeShaderProgramId = buildShaderProgram(vertexShaderId, fragmentShaderId);
-	lightSourceShaderProgramId = buildShaderProgram(lightSourceVertexShaderId, lightSourceFragmentShaderId);
+	// One source for every step of the walkthrough, this step only compiles the lighting it uses.
+	ShaderPermutations cubeShaders("cube", lightingCubeVertexShader, lightingCubeFragmentShader, LIGHTING_FEATURE_NAMES);
+	ShaderPermutations lightSourceShaders("light source", lightSourceVertexShader, lightSourceFragmentShader, {});
+	cubeShaderProgramId = cubeShaders.get(LIGHTING_STEPS[LIGHTING_STEP].features);
+	lightSourceShaderProgramId = lightSourceShaders.get(0);
+	programCache.printReport();
 	storeVertexDataOnGpu();
 
 	while(!glfwWindowShouldClose(window))
@@ -424,6 +335,7 @@ void draw()
 
 	// Every shader and rendering call after the `glUseProgram` call will now use this program object (and thus the shaders).
 	glUseProgram(cubeShaderProgramId);
+	setLightingUniforms(cubeShaderProgramId, LIGHTING_STEPS[LIGHTING_STEP]);
 
     glUniform1f(glGetUniformLocation(cubeShaderProgramId, "ambientStrength"), ambientStrength);
     glUniform3f(glGetUniformLocation(cubeShaderProgramId, "lightColour"), 1.0f, 1.0f, 1.0f);
@@ -517,33 +429,6 @@ void storeVertexDataOnGpu()
     glBindVertexArray(0); 
 }
 
-uint32_t applyShader(GLenum shaderType, const char *source)
-{
-	uint32_t shaderReferenceId = glCreateShader(shaderType);
-	glShaderSource(shaderReferenceId, 1, &source, NULL);
-	glCompileShader(shaderReferenceId);
-	debug(shaderReferenceId, shaderType == GL_VERTEX_SHADER ? 1 : 2);
-	return shaderReferenceId;
-}
-
-uint32_t buildShaderProgram(uint32_t vShaderId, uint32_t fShaderId)
-{
-	// Same `id` reference patern as with the complation of the Vertex and Fragment shaders. 
-	uint32_t shaderProgramId = glCreateProgram();
-
-	// Self-explanatory, link the shaders to the `shaderProgram`
-	glAttachShader(shaderProgramId, vShaderId);
-	glAttachShader(shaderProgramId, fShaderId);
-	glLinkProgram(shaderProgramId);
-
-	// Delete the shader objects once we've linked them into the program object; we no longer need them anymore.
-	glDeleteShader(vShaderId);
-	glDeleteShader(fShaderId);
-
-	debug(shaderProgramId, 0);
-    return shaderProgramId;
-}
-
 void loadTexture(std::string path, uint32_t textureId, GLenum rgbTypeA, GLenum rgbTypeB)
 {
     glBindTexture(GL_TEXTURE_2D, textures[textureId]); // all upcoming GL_TEXTURE_2D operations now have an effect on this texture object
@@ -571,38 +456,3 @@ void loadTexture(std::string path, uint32_t textureId, GLenum rgbTypeA, GLenum r
     }
     stbi_image_free(data);
 }
-
-void debug(uint32_t shaderRef, size_t mode)
-{
-	int success;
-	char infoLog[512];
-	if (mode > 0)
-	{
-		glGetShaderiv(shaderRef, GL_COMPILE_STATUS, &success);
-		if(!success)
-		{
-			glGetShaderInfoLog(shaderRef, 512, NULL, infoLog);
-			std::string shaderName;
-			if (mode == 1)
-			{
-				shaderName = "VERTEX";
-			}
-			else if (mode == 2)
-			{
-				shaderName = "FRAGMENT";
-			}
-			else {
-				shaderName == "NO DEBUG SHADER NAME";
-			}
-			std::cout << "ERROR::SHADER::" << shaderName << "::COMPILATION_FAILED\n" << infoLog << std::endl;
-		}
-	} else if (mode == 0)
-	{
-		glGetProgramiv(shaderRef, GL_LINK_STATUS, &success);
-		if(!success)
-		{
-    		glGetProgramInfoLog(shaderRef, 512, NULL, infoLog);
-			std::cout << "ERROR::SHADER::PROGRAM::COMPILATION_FAILED\n" << infoLog << std::endl;
-		}
-	}
-}
@@ -17,93 +17,18 @@
 
 #define STB_IMAGE_IMPLEMENTATION
 #include "../../headers/stb_image.h"
+#include "../../headers/program_cache.hpp"
+#include "../../headers/shader_permutations.hpp"
+#include "lighting_cube_shaders.hpp"
 
 #include <filesystem>
 
-const char *vertexShaderSource = 
-	"#version 330 core \n"
-	"layout (location = 0) in vec3 aPos; \n"
-	"layout (location = 1) in vec2 aTexCoord; \n"
-	"layout (location = 2) in vec3 aNormal; \n"
-	"out vec2 TexCoord; \n"
-	"out vec3 Normal; \n"
-	"out vec3 FragmentPos; \n"
-    "uniform mat4 model; \n"
-    "uniform mat4 view; \n"
-    "uniform mat4 projection; \n"
-    "void main() \n"
-    "{\n"
-    "   gl_Position = projection * view * model * vec4(aPos, 1.0); \n"
-    "   FragmentPos = vec3(model * vec4(aPos, 1.0));             \n"
-    "	TexCoord = aTexCoord; \n"
-    "	Normal = mat3(transpose(inverse(model))) * aNormal; \n"
-    "}\0";
-
-const char *fragmentShaderSource = 
-	"#version 330 core \n"
-    "out vec4 myOutput; \n"
-	"in vec2 TexCoord; \n"
-	"in vec3 Normal; \n"
-	"in vec3 FragmentPos; \n"
-	"uniform sampler2D ourTexture; \n"
-	"uniform sampler2D ourTexture2; \n"
-	"uniform vec3 lightColour; \n"
-	"uniform vec3 lightPos; \n"
-	"uniform float ambientStrength; \n"
-	"uniform vec3 cameraPos; \n"
-    "                                                                           \n"
-    "void main() \n"
-    "{\n"
-    "    vec3 objectColour = vec3(1.0f, 0.5f, 0.30f);                                \n"
-    "    vec3 ambient = lightColour * ambientStrength;                         \n"
-
-    "    vec3 norm = normalize(Normal);                           \n"
-    "    vec3 lightDir = normalize(lightPos - FragmentPos);                           \n"
-    "    float diff = max(dot(norm, lightDir), 0.0);                           \n"
-    "    vec3 diffuse = diff * lightColour;                           \n"
-
-    "    float specularStrength = 1.0;                           \n"
-    "    vec3 cameraDirection = normalize(cameraPos - FragmentPos);                           \n"
-    "    vec3 reflectDir = reflect(-lightDir, norm);                           \n"
-    "    float spec = pow(max(dot(cameraDirection, reflectDir), 0.0), 128);                 \n"
-    "    vec3 specular = specularStrength * spec * lightColour;                            \n"
-
-    "    if (diff > 0.0)                           \n"
-    "    {                                             \n"
-    "        vec3 result = objectColour * (ambient + diffuse + specular);                           \n"
-    "        myOutput = vec4(result, 1.0);                          \n"
-    "    }                                              \n"
-    "    else                                              \n"
-    "    {                                             \n"
-    "        vec3 result = objectColour * (ambient + diffuse);                           \n"
-    "        myOutput = vec4(result, 1.0);                          \n"
-    "    }                                              \n"
-    "}\0";
-
-const char *lightSourceVertexShader = 
-	"#version 330 core \n"
-	"layout (location = 0) in vec3 aPos; \n"
-    "uniform mat4 model; \n"
-    "uniform mat4 view; \n"
-    "uniform mat4 projection; \n"
-    "void main() \n"
-    "{\n"
-    "   gl_Position = projection * view * model * vec4(aPos, 1.0); \n"
-    "}\0";
-
-const char *lightSourceFragmentShader = 
-	"#version 330 core  \n"
-    "out vec4 myOutput; \n"
-    "                   \n"
-    "void main()        \n"
-    "{\n"
-    "    myOutput = vec4(1.0);"
-    "}\0";
+// The step of the walkthrough in lighting_cube_shaders.hpp this file shows.
+const size_t LIGHTING_STEP = 4;
 
 uint32_t vboId;
 uint32_t cubeVaoIds[2];
 uint32_t textures[2];
-uint32_t vertexShaderId, fragmentShaderId, lightSourceVertexShaderId, lightSourceFragmentShaderId;
 uint32_t cubeShaderProgramId, lightSourceShaderProgramId;
 
 float vertices[] = {
@@ -183,12 +108,9 @@ void mouse_callback(GLFWwindow* window, double xpos, double ypos);
 void scroll_callback(GLFWwindow* window, double xoffset, double yoffset);
 
 void render(GLFWwindow* window);
-uint32_t applyShader(GLenum shaderType, const char *source);
-uint32_t buildShaderProgram(uint32_t vShaderId, uint32_t fShaderId);
 void storeVertexDataOnGpu();
 void draw();
 void loadTexture(std::string path, uint32_t textureId, GLenum rgbTypeA, GLenum rgbTypeB);
-void debug(uint32_t shaderRef, size_t mode);
 
 int main() 
 {
@@ -217,6 +139,9 @@ int main()
 		return -1;
 	}  
 
+	// programs linked on earlier runs are loaded from here instead of compiled again
+	programCache.enable("shader_cache", (GLADloadproc) glfwGetProcAddress);
+
 	// Viewport dictates how we want to display the data and coordinates with respect to the window
 	glfwSetFramebufferSizeCallback(window, framebuffer_size_callback); 
 
@@ -245,8 +170,6 @@ int main()
 
 	glDeleteVertexArrays(2, cubeVaoIds);
     glDeleteBuffers(1, &vboId);
-    glDeleteProgram(cubeShaderProgramId);
-    glDeleteProgram(lightSourceShaderProgramId);
 
 	glfwTerminate();
     return 0;
@@ -254,14 +177,12 @@ int main()
 
 void render(GLFWwindow* window)
 {
-	vertexShaderId = applyShader(GL_VERTEX_SHADER, vertexShaderSource);
-	fragmentShaderId = applyShader(GL_FRAGMENT_SHADER, fragmentShaderSource);
-
-	lightSourceVertexShaderId = applyShader(GL_VERTEX_SHADER, lightSourceVertexShader);
-	lightSourceFragmentShaderId = applyShader(GL_FRAGMENT_SHADER, lightSourceFragmentShader);
-
-	cubeShaderProgramId = buildShaderProgram(vertexShaderId, fragmentShaderId);
-	lightSourceShaderProgramId = buildShaderProgram(lightSourceVertexShaderId, lightSourceFragmentShaderId);
+	// One source for every step of the walkthrough, this step only compiles the lighting it uses.
+	ShaderPermutations cubeShaders("cube", lightingCubeVertexShader, lightingCubeFragmentShader, LIGHTING_FEATURE_NAMES);
+	ShaderPermutations lightSourceShaders("light source", lightSourceVertexShader, lightSourceFragmentShader, {});
+	cubeShaderProgramId = cubeShaders.get(LIGHTING_STEPS[LIGHTING_STEP].features);
+	lightSourceShaderProgramId = lightSourceShaders.get(0);
+	programCache.printReport();
 	storeVertexDataOnGpu();
 
 	while(!glfwWindowShouldClose(window))
@@ -418,6 +339,7 @@ void draw()
 
 	// Every shader and rendering call after the `glUseProgram` call will now use this program object (and thus the shaders).
 	glUseProgram(cubeShaderProgramId);
+	setLightingUniforms(cubeShaderProgramId, LIGHTING_STEPS[LIGHTING_STEP]);
 
     // Lighting attributes required in cube fragment shader.
     glUniform1f(glGetUniformLocation(cubeShaderProgramId, "ambientStrength"), ambientStrength);
@@ -519,33 +441,6 @@ void storeVertexDataOnGpu()
     glBindVertexArray(0); 
 }
 
-uint32_t applyShader(GLenum shaderType, const char *source)
-{
-	uint32_t shaderReferenceId = glCreateShader(shaderType);
-	glShaderSource(shaderReferenceId, 1, &source, NULL);
-	glCompileShader(shaderReferenceId);
-	debug(shaderReferenceId, shaderType == GL_VERTEX_SHADER ? 1 : 2);
-	return shaderReferenceId;
-}
-
-uint32_t buildShaderProgram(uint32_t vShaderId, uint32_t fShaderId)
-{
-	// Same `id` reference patern as with the complation of the Vertex and Fragment shaders. 
-	uint32_t shaderProgramId = glCreateProgram();
-
-	// Self-explanatory, link the shaders to the `shaderProgram`
-	glAttachShader(shaderProgramId, vShaderId);
-	glAttachShader(shaderProgramId, fShaderId);
-	glLinkProgram(shaderProgramId);
-
-	// Delete the shader objects once we've linked them into the program object; we no longer need them anymore.
-	glDeleteShader(vShaderId);
-	glDeleteShader(fShaderId);
-
-	debug(shaderProgramId, 0);
-    return shaderProgramId;
-}
-
 void loadTexture(std::string path, uint32_t textureId, GLenum rgbTypeA, GLenum rgbTypeB)
 {
     glBindTexture(GL_TEXTURE_2D, textures[textureId]); // all upcoming GL_TEXTURE_2D operations now have an effect on this texture object
@@ -573,38 +468,3 @@ void loadTexture(std::string path, uint32_t textureId, GLenum rgbTypeA, GLenum r
     }
     stbi_image_free(data);
 }
-
-void debug(uint32_t shaderRef, size_t mode)
-{
-	int success;
-	char infoLog[512];
-	if (mode > 0)
-	{
-		glGetShaderiv(shaderRef, GL_COMPILE_STATUS, &success);
-		if(!success)
-		{
-			glGetShaderInfoLog(shaderRef, 512, NULL, infoLog);
-			std::string shaderName;
-			if (mode == 1)
-			{
-				shaderName = "VERTEX";
-			}
-			else if (mode == 2)
-			{
-				shaderName = "FRAGMENT";
-			}
-			else {
-				shaderName == "NO DEBUG SHADER NAME";
-			}
-			std::cout << "ERROR::SHADER::" << shaderName << "::COMPILATION_FAILED\n" << infoLog << std::endl;
-		}
-	} else if (mode == 0)
-	{
-		glGetProgramiv(shaderRef, GL_LINK_STATUS, &success);
-		if(!success)
-		{
-    		glGetProgramInfoLog(shaderRef, 512, NULL, infoLog);
-			std::cout << "ERROR::SHADER::PROGRAM::COMPILATION_FAILED\n" << infoLog << std::endl;
-		}
-	}
-}
@@ -1,6 +1,7 @@
 /*
  * This file has Blinn-Phong lighting applied in View/Camera space and can be adjusted using the UP/DOWN arrow keys.
  * The light source will rotate around the xz-axis using sin/cos 
+ * The number keys 0-6 switch to the lighting of lighting_cube_0..6, all of them compiled together at startup.
  *
  * Note: Specular lighting will only apply on the cube face adjacent to the light source.
  *       This needs to be checked conditionally since openGL's reflect() glsl function does not ignore back-facing normal vectors.
@@ -17,89 +18,16 @@
 
 #define STB_IMAGE_IMPLEMENTATION
 #include "../../headers/stb_image.h"
+#include "../../headers/parallel_shader_compile.hpp"
+#include "../../headers/program_cache.hpp"
+#include "../../headers/shader_permutations.hpp"
+#include "lighting_cube_shaders.hpp"
 
 #include <filesystem>
 
-const char *vertexShaderSource = 
-	"#version 330 core \n"
-	"layout (location = 0) in vec3 aPos; \n"
-	"layout (location = 1) in vec2 aTexCoord; \n"
-	"layout (location = 2) in vec3 aNormal; \n"
-	"out vec2 TexCoord; \n"
-	"out vec3 Normal; \n"
-	"out vec3 FragmentPos; \n"
-    "out vec3 LightPos;  \n"
-    "uniform mat4 model; \n"
-    "uniform mat4 view; \n"
-    "uniform mat4 projection; \n"
-	"uniform vec3 lightPos; \n"
-    "void main() \n"
-    "{\n"
-    "   mat4 vm = view * model;  \n"
-    "   gl_Position = projection * vm * vec4(aPos, 1.0); \n"
-    "   FragmentPos = vec3(vm * vec4(aPos, 1.0));             \n"       
-    "   LightPos = vec3(view * vec4(lightPos, 1.0));        "
-    "   TexCoord = aTexCoord; \n"
-    "	Normal = mat3(transpose(inverse(vm))) * aNormal; \n"
-    "}\0";
-
-const char *fragmentShaderSource = 
-	"#version 330 core \n"
-    "out vec4 myOutput; \n"
-	"in vec2 TexCoord; \n"
-	"in vec3 Normal; \n"
-	"in vec3 FragmentPos; \n"
-	"in vec3 LightPos; \n"
-	"uniform sampler2D ourTexture; \n"
-	"uniform sampler2D ourTexture2; \n"
-	"uniform vec3 lightColour; \n"
-	"uniform float ambientStrength; \n"
-	"uniform vec3 cameraPos; \n"
-    "                                                                           \n"
-    "void main() \n"
-    "{\n"
-    "    vec3 objectColour = vec3(1.0f, 0.5f, 0.30f);                                \n"
-    "    vec3 ambient = lightColour * ambientStrength;                         \n"
-
-    "    vec3 norm = normalize(Normal);                           \n"
-    "    vec3 lightDir = normalize(LightPos - FragmentPos);                           \n"
-    "    float diff = max(dot(norm, lightDir), 0.0);                           \n"
-    "    vec3 diffuse = diff * lightColour;                           \n"
-
-         // the viewer is always at (0,0,0) in view-space, so viewDir is (0,0,0) - Position => -Position
-    "    vec3 cameraDirection = normalize(-FragmentPos);                           \n"
-    "    vec3 viewDir = normalize(cameraPos - FragmentPos);                                         \n"
-    "    vec3 halwayDir = normalize(viewDir + lightDir);                                         \n"
-    "    float spec = pow(max(dot(norm, halwayDir), 0.0), 512);                 \n"
-    "    vec3 specular = spec * lightColour;                            \n"
-    "    vec3 result = objectColour * (ambient + diffuse + specular);                           \n"
-    "    myOutput = vec4(result, 1.0);                          \n"
-    "}\0";
-
-const char *lightSourceVertexShader = 
-	"#version 330 core \n"
-	"layout (location = 0) in vec3 aPos; \n"
-    "uniform mat4 model; \n"
-    "uniform mat4 view; \n"
-    "uniform mat4 projection; \n"
-    "void main() \n"
-    "{\n"
-    "   gl_Position = projection * view * model * vec4(aPos, 1.0); \n"
-    "}\0";
-
-const char *lightSourceFragmentShader = 
-	"#version 330 core  \n"
-    "out vec4 myOutput; \n"
-    "                   \n"
-    "void main()        \n"
-    "{\n"
-    "    myOutput = vec4(1.0);"
-    "}\0";
-
 uint32_t vboId;
 uint32_t cubeVaoIds[2];
 uint32_t textures[2];
-uint32_t vertexShaderId, fragmentShaderId, lightSourceVertexShaderId, lightSourceFragmentShaderId;
 uint32_t cubeShaderProgramId, lightSourceShaderProgramId;
 
 float vertices[] = {
@@ -169,6 +97,9 @@ glm::vec3 lightPos(0.0f, 0.0f, 0.0f);
 
 static float ambientStrength = 0.5f;
 
+// The step of the walkthrough in lighting_cube_shaders.hpp on screen, 0-6 on the keyboard.
+size_t lightingStep = 6;
+
 float deltaTime = 0.0f;	// Time between current frame and last frame
 float lastFrame = 0.0f; // Time of last frame
 
@@ -179,12 +110,9 @@ void mouse_callback(GLFWwindow* window, double xpos, double ypos);
 void scroll_callback(GLFWwindow* window, double xoffset, double yoffset);
 
 void render(GLFWwindow* window);
-uint32_t applyShader(GLenum shaderType, const char *source);
-uint32_t buildShaderProgram(uint32_t vShaderId, uint32_t fShaderId);
 void storeVertexDataOnGpu();
 void draw();
 void loadTexture(std::string path, uint32_t textureId, GLenum rgbTypeA, GLenum rgbTypeB);
-void debug(uint32_t shaderRef, size_t mode);
 
 int main() 
 {
@@ -213,6 +141,10 @@ int main()
 		return -1;
 	}  
 
+	// programs linked on earlier runs are loaded from here instead of compiled again
+	programCache.enable("shader_cache", (GLADloadproc) glfwGetProcAddress);
+	enableParallelShaderCompile((GLADloadproc) glfwGetProcAddress);
+
 	// Viewport dictates how we want to display the data and coordinates with respect to the window
 	glfwSetFramebufferSizeCallback(window, framebuffer_size_callback); 
 
@@ -241,8 +173,6 @@ int main()
 
 	glDeleteVertexArrays(2, cubeVaoIds);
     glDeleteBuffers(1, &vboId);
-    glDeleteProgram(cubeShaderProgramId);
-    glDeleteProgram(lightSourceShaderProgramId);
 
 	glfwTerminate();
     return 0;
@@ -250,20 +180,26 @@ int main()
 
 void render(GLFWwindow* window)
 {
-	vertexShaderId = applyShader(GL_VERTEX_SHADER, vertexShaderSource);
-	fragmentShaderId = applyShader(GL_FRAGMENT_SHADER, fragmentShaderSource);
-
-	lightSourceVertexShaderId = applyShader(GL_VERTEX_SHADER, lightSourceVertexShader);
-	lightSourceFragmentShaderId = applyShader(GL_FRAGMENT_SHADER, lightSourceFragmentShader);
-
-	cubeShaderProgramId = buildShaderProgram(vertexShaderId, fragmentShaderId);
-	lightSourceShaderProgramId = buildShaderProgram(lightSourceVertexShaderId, lightSourceFragmentShaderId);
+	// One source for every step of the walkthrough, each variant only compiles the lighting it uses.
+	ShaderPermutations cubeShaders("cube", lightingCubeVertexShader, lightingCubeFragmentShader, LIGHTING_FEATURE_NAMES);
+	ShaderPermutations lightSourceShaders("light source", lightSourceVertexShader, lightSourceFragmentShader, {});
+	// every step is queued before any is waited on, so a driver with parallel compiles builds them side by side
+	std::vector<uint32_t> stepKeys;
+	for (const LightingStep& step : LIGHTING_STEPS)
+	{
+		stepKeys.push_back(step.features);
+	}
+	cubeShaders.precompile(stepKeys);
+	cubeShaderProgramId = cubeShaders.get(LIGHTING_STEPS[lightingStep].features);
+	lightSourceShaderProgramId = lightSourceShaders.get(0);
+	programCache.printReport();
 	storeVertexDataOnGpu();
 
 	while(!glfwWindowShouldClose(window))
 	{
 		// Input
 		processInput(window);
+		cubeShaderProgramId = cubeShaders.get(LIGHTING_STEPS[lightingStep].features);
 
 		// Rendering commands
 		draw();
@@ -300,6 +236,15 @@ void processInput(GLFWwindow *window)
         }
 	}
 
+    for (size_t step = 0; step < LIGHTING_STEP_COUNT; step++)
+    {
+        if (glfwGetKey(window, GLFW_KEY_0 + (int)step) == GLFW_PRESS && lightingStep != step)
+        {
+            lightingStep = step;
+            std::cout << "Lighting step " << step << ": " << LIGHTING_STEPS[step].description << std::endl;
+        }
+    }
+
     float currentFrame = glfwGetTime();
     deltaTime = currentFrame - lastFrame;
     lastFrame = currentFrame;
@@ -414,6 +359,7 @@ void draw()
 
 	// Every shader and rendering call after the `glUseProgram` call will now use this program object (and thus the shaders).
 	glUseProgram(cubeShaderProgramId);
+	setLightingUniforms(cubeShaderProgramId, LIGHTING_STEPS[lightingStep]);
 
     // Lighting attributes required in cube fragment shader.
     glUniform1f(glGetUniformLocation(cubeShaderProgramId, "ambientStrength"), ambientStrength);
@@ -515,33 +461,6 @@ void storeVertexDataOnGpu()
     glBindVertexArray(0); 
 }
 
-uint32_t applyShader(GLenum shaderType, const char *source)
-{
-	uint32_t shaderReferenceId = glCreateShader(shaderType);
-	glShaderSource(shaderReferenceId, 1, &source, NULL);
-	glCompileShader(shaderReferenceId);
-	debug(shaderReferenceId, shaderType == GL_VERTEX_SHADER ? 1 : 2);
-	return shaderReferenceId;
-}
-
-uint32_t buildShaderProgram(uint32_t vShaderId, uint32_t fShaderId)
-{
-	// Same `id` reference patern as with the complation of the Vertex and Fragment shaders. 
-	uint32_t shaderProgramId = glCreateProgram();
-
-	// Self-explanatory, link the shaders to the `shaderProgram`
-	glAttachShader(shaderProgramId, vShaderId);
-	glAttachShader(shaderProgramId, fShaderId);
-	glLinkProgram(shaderProgramId);
-
-	// Delete the shader objects once we've linked them into the program object; we no longer need them anymore.
-	glDeleteShader(vShaderId);
-	glDeleteShader(fShaderId);
-
-	debug(shaderProgramId, 0);
-    return shaderProgramId;
-}
-
 void loadTexture(std::string path, uint32_t textureId, GLenum rgbTypeA, GLenum rgbTypeB)
 {
     glBindTexture(GL_TEXTURE_2D, textures[textureId]); // all upcoming GL_TEXTURE_2D operations now have an effect on this texture object
@@ -569,38 +488,3 @@ void loadTexture(std::string path, uint32_t textureId, GLenum rgbTypeA, GLenum r
     }
     stbi_image_free(data);
 }
-
-void debug(uint32_t shaderRef, size_t mode)
-{
-	int success;
-	char infoLog[512];
-	if (mode > 0)
-	{
-		glGetShaderiv(shaderRef, GL_COMPILE_STATUS, &success);
-		if(!success)
-		{
-			glGetShaderInfoLog(shaderRef, 512, NULL, infoLog);
-			std::string shaderName;
-			if (mode == 1)
-			{
-				shaderName = "VERTEX";
-			}
-			else if (mode == 2)
-			{
-				shaderName = "FRAGMENT";
-			}
-			else {
-				shaderName == "NO DEBUG SHADER NAME";
-			}
-			std::cout << "ERROR::SHADER::" << shaderName << "::COMPILATION_FAILED\n" << infoLog << std::endl;
-		}
-	} else if (mode == 0)
-	{
-		glGetProgramiv(shaderRef, GL_LINK_STATUS, &success);
-		if(!success)
-		{
-    		glGetProgramInfoLog(shaderRef, 512, NULL, infoLog);
-			std::cout << "ERROR::SHADER::PROGRAM::COMPILATION_FAILED\n" << infoLog << std::endl;
-		}
-	}
-}
@@ -0,0 +1,195 @@
+#pragma once
+
+/*
+ * The shaders shared by lighting_cube_0..6. Each step of the lighting walkthrough used to carry its own copy of the
+ * cube shaders; they are now one source with a feature toggle per step, built as permutations (see shader_permutations.hpp),
+ * so a variant only contains the lighting it uses instead of branching on uniforms in the fragment shader.
+ */
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Bits of a cube shader permutation key, in the order of LIGHTING_FEATURE_NAMES.
+enum LightingFeature : uint32_t
+{
+    LIGHTING_TEXTURED = 1 << 0,             // the two container textures, unlit
+    LIGHTING_AMBIENT = 1 << 1,
+    LIGHTING_DIFFUSE = 1 << 2,
+    LIGHTING_SPECULAR = 1 << 3,
+    LIGHTING_SPECULAR_FRONT_FACES = 1 << 4, // no highlight on faces turned away from the light
+    LIGHTING_BLINN_PHONG = 1 << 5,          // halfway vector instead of the reflected light direction
+    LIGHTING_VIEW_SPACE = 1 << 6,           // light in view space, where the camera sits at the origin
+};
+
+const std::vector<std::string> LIGHTING_FEATURE_NAMES = {
+    "TEXTURED", "AMBIENT", "DIFFUSE", "SPECULAR", "SPECULAR_FRONT_FACES", "BLINN_PHONG", "VIEW_SPACE"
+};
+
+/*
+ * Lighting is done in world space unless VIEW_SPACE is defined, in which case the fragment position, normal and light
+ * position are moved into view space by the vertex shader.
+ *
+ * Inversing matrices is a costly operation for shaders, so wherever possible try to avoid doing inverse operations since
+ * they have to be done on each vertex of your scene. For learning purposes this is fine, but for an efficient application you'll likely
+ * want to calculate the normal matrix on the CPU and send it to the shaders via a uniform before drawing (just like the model matrix).
+ */
+const char *lightingCubeVertexShader =
+	"#version 330 core \n"
+	"#if defined(DIFFUSE) || defined(SPECULAR) \n"
+	"#define LIT \n"
+	"#endif \n"
+	"layout (location = 0) in vec3 aPos; \n"
+	"layout (location = 1) in vec2 aTexCoord; \n"
+	"layout (location = 2) in vec3 aNormal; \n"
+	"out vec2 TexCoord; \n"
+	"out vec3 Normal; \n"
+	"out vec3 FragmentPos; \n"
+	"out vec3 LightPos; \n"
+    "uniform mat4 model; \n"
+    "uniform mat4 view; \n"
+    "uniform mat4 projection; \n"
+	"uniform vec3 lightPos; \n"
+    "void main() \n"
+    "{\n"
+    // Note: The order of matrix multiplication here is important.
+    "   gl_Position = projection * view * model * vec4(aPos, 1.0); \n"
+    "	TexCoord = aTexCoord; \n"
+    "#ifdef LIT \n"
+    "#ifdef VIEW_SPACE \n"
+    "   mat4 space = view * model; \n"
+    "   LightPos = vec3(view * vec4(lightPos, 1.0)); \n"
+    "#else \n"
+    "   mat4 space = model; \n"
+    "   LightPos = lightPos; \n"
+    "#endif \n"
+    "   FragmentPos = vec3(space * vec4(aPos, 1.0)); \n"
+    // This is absolutely necessary for non-unform scale / transformation operation, e.g., rotation
+    "	Normal = mat3(transpose(inverse(space))) * aNormal; \n"
+    "#endif \n"
+    "}\0";
+
+/*
+ * If the angle between both vectors is greater than 90 degrees then the result of the dot product will actually become negative
+ * and we end up with a negative diffuse component. For that reason we use the max function that returns the highest of both its
+ * parameters to make sure the diffuse component (and thus the colors) never become negative.
+ *
+ * `float spec = pow(max(dot(cameraDirection, reflectDir), 0.0), shininess)`
+ *
+ * We calculate the dot product between the view direction and the reflect direction (and make sure it's not negative) and
+ * then raise it to the power of the shininess value of the highlight. Blinn-Phong uses the vector halfway between the
+ * view and light directions instead, which doesn't cut the highlight off once the angle between them passes 90 degrees.
+ */
+const char *lightingCubeFragmentShader =
+	"#version 330 core \n"
+    "out vec4 myOutput; \n"
+	"in vec2 TexCoord; \n"
+	"in vec3 Normal; \n"
+	"in vec3 FragmentPos; \n"
+	"in vec3 LightPos; \n"
+	"uniform sampler2D ourTexture; \n"
+	"uniform sampler2D ourTexture2; \n"
+	"uniform vec3 lightColour; \n"
+	"uniform float ambientStrength; \n"
+	"uniform vec3 cameraPos; \n"
+	"uniform vec3 objectColour; \n"
+	"uniform float specularStrength; \n"
+	"uniform float shininess; \n"
+    "void main() \n"
+    "{\n"
+    "#ifdef TEXTURED \n"
+	"    myOutput = mix(texture(ourTexture, TexCoord), texture(ourTexture2, TexCoord), 0.5); \n"
+    "#else \n"
+    "    vec3 lighting = vec3(0.0); \n"
+    "#ifdef AMBIENT \n"
+    "    lighting += lightColour * ambientStrength; \n"
+    "#endif \n"
+    "#if defined(DIFFUSE) || defined(SPECULAR) \n"
+    "    vec3 norm = normalize(Normal); \n"
+    "    vec3 lightDir = normalize(LightPos - FragmentPos); \n"
+    "    float diff = max(dot(norm, lightDir), 0.0); \n"
+    "#endif \n"
+    "#ifdef DIFFUSE \n"
+    "    lighting += diff * lightColour; \n"
+    "#endif \n"
+    "#ifdef SPECULAR \n"
+    "#ifdef VIEW_SPACE \n"
+         // the viewer is always at (0,0,0) in view-space, so viewDir is (0,0,0) - Position => -Position
+    "    vec3 cameraDirection = normalize(-FragmentPos); \n"
+    "#else \n"
+    "    vec3 cameraDirection = normalize(cameraPos - FragmentPos); \n"
+    "#endif \n"
+    "#ifdef BLINN_PHONG \n"
+    "    vec3 halfwayDir = normalize(cameraDirection + lightDir); \n"
+    "    float spec = pow(max(dot(norm, halfwayDir), 0.0), shininess); \n"
+    "#else \n"
+    "    vec3 reflectDir = reflect(-lightDir, norm); \n"
+    "    float spec = pow(max(dot(cameraDirection, reflectDir), 0.0), shininess); \n"
+    "#endif \n"
+    "#ifdef SPECULAR_FRONT_FACES \n"
+         // reflect() doesn't care which side the normal faces, so faces turned away from the light would still get a highlight
+    "    spec *= float(diff > 0.0); \n"
+    "#endif \n"
+    "    lighting += specularStrength * spec * lightColour; \n"
+    "#endif \n"
+    "    myOutput = vec4(objectColour * lighting, 1.0); \n"
+    "#endif \n"
+    "}\0";
+
+const char *lightSourceVertexShader =
+	"#version 330 core \n"
+	"layout (location = 0) in vec3 aPos; \n"
+    "uniform mat4 model; \n"
+    "uniform mat4 view; \n"
+    "uniform mat4 projection; \n"
+    "void main() \n"
+    "{\n"
+    "   gl_Position = projection * view * model * vec4(aPos, 1.0); \n"
+    "}\0";
+
+const char *lightSourceFragmentShader =
+	"#version 330 core  \n"
+    "out vec4 myOutput; \n"
+    "                   \n"
+    "void main()        \n"
+    "{\n"
+    "    myOutput = vec4(1.0);"
+    "}\0";
+
+// One step of the walkthrough: the features of its cube shader and the material it lights.
+struct LightingStep {
+    const char* description;
+    uint32_t features;
+    glm::vec3 objectColour;
+    float specularStrength;
+    float shininess;
+};
+
+const LightingStep LIGHTING_STEPS[] = {
+    {"no lighting, textured", LIGHTING_TEXTURED, glm::vec3(1.0f), 0.0f, 1.0f},
+    {"ambient", LIGHTING_AMBIENT, glm::vec3(1.0f, 0.75f, 0.0f), 0.0f, 1.0f},
+    {"ambient + diffuse", LIGHTING_AMBIENT | LIGHTING_DIFFUSE, glm::vec3(0.0f, 0.75f, 0.70f), 0.0f, 1.0f},
+    {"ambient + diffuse + specular", LIGHTING_AMBIENT | LIGHTING_DIFFUSE | LIGHTING_SPECULAR, glm::vec3(0.0f, 0.75f, 0.70f), 0.5f, 32.0f},
+    {"phong, world space", LIGHTING_AMBIENT | LIGHTING_DIFFUSE | LIGHTING_SPECULAR | LIGHTING_SPECULAR_FRONT_FACES,
+        glm::vec3(1.0f, 0.5f, 0.30f), 1.0f, 128.0f},
+    {"phong, view space", LIGHTING_AMBIENT | LIGHTING_DIFFUSE | LIGHTING_SPECULAR | LIGHTING_SPECULAR_FRONT_FACES | LIGHTING_VIEW_SPACE,
+        glm::vec3(1.0f, 0.5f, 0.30f), 1.0f, 128.0f},
+    {"blinn-phong, view space", LIGHTING_AMBIENT | LIGHTING_DIFFUSE | LIGHTING_SPECULAR | LIGHTING_SPECULAR_FRONT_FACES | LIGHTING_BLINN_PHONG | LIGHTING_VIEW_SPACE,
+        glm::vec3(1.0f, 0.5f, 0.30f), 1.0f, 512.0f},
+};
+
+const size_t LIGHTING_STEP_COUNT = sizeof(LIGHTING_STEPS) / sizeof(LIGHTING_STEPS[0]);
+
+// The material of `step`; the cube program has to be in use.
+inline void setLightingUniforms(uint32_t program, const LightingStep& step)
+{
+    glUniform3fv(glGetUniformLocation(program, "objectColour"), 1, glm::value_ptr(step.objectColour));
+    glUniform1f(glGetUniformLocation(program, "specularStrength"), step.specularStrength);
+    glUniform1f(glGetUniformLocation(program, "shininess"), step.shininess);
+    glUniform1i(glGetUniformLocation(program, "ourTexture"), 0);
+    glUniform1i(glGetUniformLocation(program, "ourTexture2"), 1);
+}
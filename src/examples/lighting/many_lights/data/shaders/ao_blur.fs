@@ -0,0 +1,28 @@
+#version 330 core
+// One direction of a separable gaussian blur, weighted down where the depth jumps so edges stay sharp.
+out vec4 Blurred;
+
+uniform sampler2D occlusion;
+uniform sampler2D linearDepth;
+uniform ivec2 direction;
+uniform int blurRadius;
+
+void main()
+{
+    ivec2 pixel = ivec2(gl_FragCoord.xy);
+    ivec2 last = textureSize(occlusion, 0) - 1;
+    float centreDepth = texelFetch(linearDepth, pixel, 0).r;
+    float sigma = float(blurRadius) * 0.5 + 0.5;
+
+    float total = 0.0;
+    float weights = 0.0;
+    for (int i = -blurRadius; i <= blurRadius; i++)
+    {
+        ivec2 texel = clamp(pixel + direction * i, ivec2(0), last);
+        float depth = texelFetch(linearDepth, texel, 0).r;
+        float weight = exp(-float(i * i) / (2.0 * sigma * sigma)) * exp(-abs(depth - centreDepth) / (0.03 * centreDepth));
+        total += texelFetch(occlusion, texel, 0).r * weight;
+        weights += weight;
+    }
+    Blurred = vec4(total / weights);
+}
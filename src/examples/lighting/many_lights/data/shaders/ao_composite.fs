@@ -0,0 +1,45 @@
+#version 330 core
+// Bilateral upsampling: the 4 low resolution texels around the pixel weighted bilinearly and by how close their depth
+// is to the pixel's own, so occlusion from a box doesn't smear onto the floor behind it.
+out vec4 FragColour;
+
+uniform sampler2D sceneColour;
+uniform sampler2D sceneDepth;
+uniform sampler2D occlusion;
+uniform sampler2D linearDepth;
+uniform int downsample;
+uniform vec2 nearFar;
+uniform float strength;
+
+float linearize(float depth)
+{
+    float z = depth * 2.0 - 1.0;
+    return 2.0 * nearFar.x * nearFar.y / (nearFar.y + nearFar.x - z * (nearFar.y - nearFar.x));
+}
+
+void main()
+{
+    ivec2 pixel = ivec2(gl_FragCoord.xy);
+    vec3 colour = texelFetch(sceneColour, pixel, 0).rgb;
+    float depth = linearize(texelFetch(sceneDepth, pixel, 0).r);
+
+    vec2 lowPos = gl_FragCoord.xy / float(downsample) - 0.5;
+    ivec2 base = ivec2(floor(lowPos));
+    vec2 f = fract(lowPos);
+    ivec2 last = textureSize(occlusion, 0) - 1;
+    vec4 bilinear = vec4((1.0 - f.x) * (1.0 - f.y), f.x * (1.0 - f.y), (1.0 - f.x) * f.y, f.x * f.y);
+    ivec2 offsets[4] = ivec2[](ivec2(0, 0), ivec2(1, 0), ivec2(0, 1), ivec2(1, 1));
+
+    float total = 0.0;
+    float weights = 0.0;
+    for (int i = 0; i < 4; i++)
+    {
+        ivec2 texel = clamp(base + offsets[i], ivec2(0), last);
+        float lowDepth = texelFetch(linearDepth, texel, 0).r;
+        float weight = bilinear[i] / (0.001 + abs(lowDepth - depth) / depth);
+        total += texelFetch(occlusion, texel, 0).r * weight;
+        weights += weight;
+    }
+    float ao = weights > 0.0 ? total / weights : 1.0;
+    FragColour = vec4(colour * mix(1.0, ao, strength), 1.0);
+}
@@ -0,0 +1,29 @@
+#version 330 core
+// Linear view depth at ambient occlusion resolution: the nearest of the downsample x downsample scene depths under each
+// texel, so thin foreground edges aren't lost between the samples.
+out vec4 LinearDepth;
+
+uniform sampler2D depthTexture;
+uniform int downsample;
+uniform vec2 nearFar;
+
+float linearize(float depth)
+{
+    float z = depth * 2.0 - 1.0;
+    return 2.0 * nearFar.x * nearFar.y / (nearFar.y + nearFar.x - z * (nearFar.y - nearFar.x));
+}
+
+void main()
+{
+    ivec2 base = ivec2(gl_FragCoord.xy) * downsample;
+    ivec2 last = textureSize(depthTexture, 0) - 1;
+    float nearest = 1.0;
+    for (int y = 0; y < downsample; y++)
+    {
+        for (int x = 0; x < downsample; x++)
+        {
+            nearest = min(nearest, texelFetch(depthTexture, min(base + ivec2(x, y), last), 0).r);
+        }
+    }
+    LinearDepth = vec4(linearize(nearest), 0.0, 0.0, 1.0);
+}
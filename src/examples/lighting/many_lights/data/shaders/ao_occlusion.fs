@@ -0,0 +1,77 @@
+#version 330 core
+// Hemisphere ambient occlusion from linear depth only. The normal comes from the neighbours' depths, taking the side
+// with the smaller step so it doesn't bend over silhouettes.
+out vec4 Occlusion;
+
+uniform sampler2D linearDepth;
+uniform vec2 viewRay;           // view space x and y at the right and top edge of the screen, at depth 1
+uniform float farPlane;
+uniform vec3 kernel[32];
+uniform int samples;
+uniform float radius;
+uniform float bias;
+uniform float power;
+
+ivec2 size;
+
+vec3 viewPosition(ivec2 texel)
+{
+    texel = clamp(texel, ivec2(0), size - 1);
+    vec2 uv = (vec2(texel) + 0.5) / vec2(size);
+    float depth = texelFetch(linearDepth, texel, 0).r;
+    return vec3((uv * 2.0 - 1.0) * viewRay * depth, -depth);
+}
+
+vec3 smallerStep(vec3 centre, vec3 before, vec3 after)
+{
+    vec3 forwards = after - centre;
+    vec3 backwards = centre - before;
+    return abs(forwards.z) < abs(backwards.z) ? forwards : backwards;
+}
+
+// a different hemisphere twist per pixel, which the blur passes smooth out
+float interleavedGradientNoise(vec2 pixel)
+{
+    return fract(52.9829189 * fract(dot(pixel, vec2(0.06711056, 0.00583715))));
+}
+
+void main()
+{
+    size = textureSize(linearDepth, 0);
+    ivec2 pixel = ivec2(gl_FragCoord.xy);
+    vec3 centre = viewPosition(pixel);
+    if (-centre.z >= farPlane * 0.999)
+    {
+        Occlusion = vec4(1.0);     // background
+        return;
+    }
+
+    vec3 dx = smallerStep(centre, viewPosition(pixel - ivec2(1, 0)), viewPosition(pixel + ivec2(1, 0)));
+    vec3 dy = smallerStep(centre, viewPosition(pixel - ivec2(0, 1)), viewPosition(pixel + ivec2(0, 1)));
+    vec3 normal = normalize(cross(dx, dy));
+    if (dot(normal, centre) > 0.0)
+    {
+        normal = -normal;
+    }
+
+    float angle = 6.28318530718 * interleavedGradientNoise(gl_FragCoord.xy);
+    vec3 twist = vec3(cos(angle), sin(angle), 0.0);
+    vec3 tangent = normalize(twist - normal * dot(twist, normal));
+    mat3 tbn = mat3(tangent, cross(normal, tangent), normal);
+
+    float occlusion = 0.0;
+    for (int i = 0; i < samples; i++)
+    {
+        vec3 samplePos = centre + tbn * kernel[i] * radius;
+        vec2 uv = samplePos.xy / (-samplePos.z * viewRay) * 0.5 + 0.5;
+        if (any(lessThan(uv, vec2(0.0))) || any(greaterThanEqual(uv, vec2(1.0))))
+        {
+            continue;
+        }
+        float sceneDepth = texelFetch(linearDepth, ivec2(uv * vec2(size)), 0).r;
+        // geometry far in front of the centre doesn't occlude it, it only hides it
+        float rangeCheck = smoothstep(0.0, 1.0, radius / abs(-centre.z - sceneDepth));
+        occlusion += (sceneDepth <= -samplePos.z - bias ? 1.0 : 0.0) * rangeCheck;
+    }
+    Occlusion = vec4(pow(1.0 - occlusion / float(samples), power));
+}
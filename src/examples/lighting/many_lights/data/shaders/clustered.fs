@@ -0,0 +1,83 @@
+#version 330 core
+// Permutations (see shader_permutations.hpp):
+//   LIGHT_COUNT  writes the number of lights in the fragment's cluster instead of a colour
+//   HEATMAP      tints the lit colour by that number
+
+out vec4 FragColour;
+
+in vec3 FragmentPos;
+in vec3 Normal;
+in vec3 Colour;
+
+// Filled by LightClusters, see light_clusters.hpp.
+uniform usamplerBuffer clusterGrid;             // per cluster: first index into clusterLightIndices, light count
+uniform usamplerBuffer clusterLightIndices;
+uniform samplerBuffer clusterLights;            // per light: view space position + radius, then colour
+uniform uvec3 clusterCounts;                    // tiles across, tiles up, depth slices
+uniform float clusterTileSize;                  // in pixels
+uniform vec2 clusterSliceScaleBias;             // slice = log(depth) * x - y
+
+uniform float ambientStrength;
+uniform float specularStrength;
+uniform float shininess;
+
+uint clusterIndex()
+{
+    uvec2 tile = min(uvec2(gl_FragCoord.xy / clusterTileSize), clusterCounts.xy - 1u);
+    float slice = log(-FragmentPos.z) * clusterSliceScaleBias.x - clusterSliceScaleBias.y;
+    uint z = uint(clamp(slice, 0.0, float(clusterCounts.z - 1u)));
+    return (z * clusterCounts.y + tile.y) * clusterCounts.x + tile.x;
+}
+
+vec3 heat(float lights)
+{
+    // blue for a handful of lights, through green to red at 48 or more
+    float t = clamp(lights / 48.0, 0.0, 1.0);
+    return t < 0.5 ? mix(vec3(0.0, 0.0, 1.0), vec3(0.0, 1.0, 0.0), t * 2.0) : mix(vec3(0.0, 1.0, 0.0), vec3(1.0, 0.0, 0.0), t * 2.0 - 1.0);
+}
+
+void main()
+{
+    uvec2 cluster = texelFetch(clusterGrid, int(clusterIndex())).xy;
+#ifdef LIGHT_COUNT
+    FragColour = vec4(float(cluster.y));
+#else
+    vec3 norm = normalize(Normal);
+    // the viewer is always at (0,0,0) in view-space
+    vec3 viewDir = normalize(-FragmentPos);
+
+    vec3 diffuse = vec3(0.0);
+    vec3 specular = vec3(0.0);
+    for (uint i = 0u; i < cluster.y; i++)
+    {
+        int light = int(texelFetch(clusterLightIndices, int(cluster.x + i)).r);
+        vec4 positionRadius = texelFetch(clusterLights, light * 2);
+        vec3 lightColour = texelFetch(clusterLights, light * 2 + 1).rgb;
+
+        vec3 toLight = positionRadius.xyz - FragmentPos;
+        float distanceSquared = dot(toLight, toLight);
+        float radiusSquared = positionRadius.w * positionRadius.w;
+        if (distanceSquared >= radiusSquared)
+        {
+            continue;
+        }
+        // inverse square falloff windowed to reach exactly zero at the radius, so the cluster bounds cut nothing off
+        float window = clamp(1.0 - (distanceSquared / radiusSquared) * (distanceSquared / radiusSquared), 0.0, 1.0);
+        float attenuation = window * window / (1.0 + distanceSquared);
+
+        vec3 lightDir = toLight * inversesqrt(distanceSquared);
+        float diff = max(dot(norm, lightDir), 0.0);
+        vec3 halfwayDir = normalize(lightDir + viewDir);
+        float spec = diff > 0.0 ? pow(max(dot(norm, halfwayDir), 0.0), shininess) : 0.0;
+
+        diffuse += diff * attenuation * lightColour;
+        specular += spec * attenuation * lightColour;
+    }
+
+    vec3 result = Colour * (ambientStrength + diffuse) + specularStrength * specular;
+#ifdef HEATMAP
+    result = mix(result, heat(float(cluster.y)), 0.6);
+#endif
+    FragColour = vec4(result, 1.0);
+#endif
+}
@@ -0,0 +1,30 @@
+#version 330 core
+// The geometry pass of the deferred path: what the light volumes need to light a pixel, written once per pixel
+// no matter how many lights reach it. The depth comes from the depth attachment.
+layout (location = 0) out vec4 AlbedoSpecular;  // RGBA8: colour, specular strength
+layout (location = 1) out vec2 PackedNormal;    // RG16: view space normal, octahedral encoded
+layout (location = 2) out vec4 Lighting;        // where the light volumes add up, starting from the ambient term
+
+in vec3 FragmentPos;
+in vec3 Normal;
+in vec3 Colour;
+
+uniform float ambientStrength;
+uniform float specularStrength;
+
+// A unit vector folded onto the octahedron |x| + |y| + |z| = 1 and flattened, which spends the 2 x 16 bits
+// evenly over all directions, unlike storing x and y and rebuilding z.
+vec2 octahedralEncode(vec3 n)
+{
+    n /= abs(n.x) + abs(n.y) + abs(n.z);
+    vec2 signs = vec2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);
+    vec2 folded = n.z >= 0.0 ? n.xy : (1.0 - abs(n.yx)) * signs;
+    return folded * 0.5 + 0.5;
+}
+
+void main()
+{
+    AlbedoSpecular = vec4(Colour, specularStrength);
+    PackedNormal = octahedralEncode(normalize(Normal));
+    Lighting = vec4(Colour * ambientStrength, 1.0);
+}
@@ -0,0 +1,9 @@
+#version 330 core
+out vec4 FragColour;
+
+in vec3 Colour;
+
+void main()
+{
+    FragColour = vec4(Colour, 1.0);
+}
@@ -0,0 +1,16 @@
+#version 330 core
+layout (location = 0) in vec3 aPos;
+layout (location = 3) in vec3 aLightPosition;
+layout (location = 4) in vec3 aLightColour;
+
+out vec3 Colour;
+
+uniform mat4 view;
+uniform mat4 projection;
+uniform float markerSize;
+
+void main()
+{
+    gl_Position = projection * view * vec4(aLightPosition + aPos * markerSize, 1.0);
+    Colour = aLightColour;
+}
@@ -0,0 +1,57 @@
+#version 330 core
+// The light pass of the deferred path, added up with GL_ONE, GL_ONE blending. The lighting is the loop body of
+// clustered.fs, so both paths give the same picture.
+out vec4 FragColour;
+
+flat in vec4 LightPositionRadius;
+flat in vec3 LightColour;
+
+uniform sampler2D gAlbedoSpecular;
+uniform sampler2D gNormal;
+uniform sampler2D gDepth;
+uniform mat4 inverseProjection;
+uniform float shininess;
+
+vec3 octahedralDecode(vec2 encoded)
+{
+    vec2 e = encoded * 2.0 - 1.0;
+    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    float fold = max(-n.z, 0.0);
+    n.xy += vec2(n.x >= 0.0 ? -fold : fold, n.y >= 0.0 ? -fold : fold);
+    return normalize(n);
+}
+
+void main()
+{
+    ivec2 pixel = ivec2(gl_FragCoord.xy);
+    float depth = texelFetch(gDepth, pixel, 0).r;
+    if (depth == 1.0)
+    {
+        discard;    // nothing was drawn here
+    }
+
+    // back from window coordinates to the view space position the geometry pass wrote
+    vec2 uv = gl_FragCoord.xy / vec2(textureSize(gDepth, 0));
+    vec4 viewPos = inverseProjection * vec4(vec3(uv, depth) * 2.0 - 1.0, 1.0);
+    vec3 FragmentPos = viewPos.xyz / viewPos.w;
+
+    vec3 toLight = LightPositionRadius.xyz - FragmentPos;
+    float distanceSquared = dot(toLight, toLight);
+    float radiusSquared = LightPositionRadius.w * LightPositionRadius.w;
+    if (distanceSquared >= radiusSquared)
+    {
+        discard;
+    }
+    float window = clamp(1.0 - (distanceSquared / radiusSquared) * (distanceSquared / radiusSquared), 0.0, 1.0);
+    float attenuation = window * window / (1.0 + distanceSquared);
+
+    vec4 albedoSpecular = texelFetch(gAlbedoSpecular, pixel, 0);
+    vec3 norm = octahedralDecode(texelFetch(gNormal, pixel, 0).rg);
+    vec3 viewDir = normalize(-FragmentPos);
+    vec3 lightDir = toLight * inversesqrt(distanceSquared);
+    float diff = max(dot(norm, lightDir), 0.0);
+    vec3 halfwayDir = normalize(lightDir + viewDir);
+    float spec = diff > 0.0 ? pow(max(dot(norm, halfwayDir), 0.0), shininess) : 0.0;
+
+    FragColour = vec4((albedoSpecular.rgb * diff + albedoSpecular.a * spec) * attenuation * LightColour, 1.0);
+}
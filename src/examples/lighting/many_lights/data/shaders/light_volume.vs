@@ -0,0 +1,20 @@
+#version 330 core
+layout (location = 0) in vec3 aPos;
+layout (location = 3) in vec3 aLightPosition;
+layout (location = 4) in float aLightRadius;
+layout (location = 5) in vec3 aLightColour;
+
+flat out vec4 LightPositionRadius;  // view space
+flat out vec3 LightColour;
+
+uniform mat4 view;
+uniform mat4 projection;
+
+// One sphere per light, as large as the light reaches: only the pixels it covers run the light pass.
+void main()
+{
+    vec4 viewPos = view * vec4(aLightPosition, 1.0);
+    gl_Position = projection * vec4(viewPos.xyz + aPos * aLightRadius, 1.0);
+    LightPositionRadius = vec4(viewPos.xyz, aLightRadius);
+    LightColour = aLightColour;
+}
@@ -0,0 +1,25 @@
+#version 330 core
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec2 aTexCoord;
+layout (location = 2) in vec3 aNormal;
+layout (location = 3) in vec3 aBoxPosition;
+layout (location = 4) in vec3 aBoxScale;
+layout (location = 5) in vec3 aBoxColour;
+
+out vec3 FragmentPos;
+out vec3 Normal;
+out vec3 Colour;
+
+uniform mat4 view;
+uniform mat4 projection;
+
+// Lighting happens in view space, which is where the light positions in the clusters are.
+void main()
+{
+    vec4 viewPos = view * vec4(aBoxPosition + aPos * aBoxScale, 1.0);
+    gl_Position = projection * viewPos;
+    FragmentPos = viewPos.xyz;
+    // dividing by the scale is the inverse transpose of the scale, so no inverse() per vertex
+    Normal = mat3(view) * (aNormal / aBoxScale);
+    Colour = aBoxColour;
+}
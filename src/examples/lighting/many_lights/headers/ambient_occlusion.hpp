@@ -0,0 +1,95 @@
+#pragma once
+
+#include "../../../../headers/shader_permutations.hpp"
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <memory>
+#include <string>
+
+struct AmbientOcclusionPreset {
+    const char* name;
+    unsigned int downsample;    // 2 for half resolution, 4 for quarter
+    int samples;                // hemisphere samples per pixel, at most AmbientOcclusion::MAX_SAMPLES
+    int blurRadius;             // texels each way of both blur passes
+};
+
+const AmbientOcclusionPreset AMBIENT_OCCLUSION_PRESETS[] = {
+    {"low (quarter resolution)", 4, 8, 2},
+    {"medium (half resolution)", 2, 12, 3},
+    {"high (half resolution)", 2, 24, 4},
+};
+
+const unsigned int AMBIENT_OCCLUSION_PRESET_COUNT = sizeof(AMBIENT_OCCLUSION_PRESETS) / sizeof(AMBIENT_OCCLUSION_PRESETS[0]);
+
+/*
+ * Screen space ambient occlusion as a post process, computed at a fraction of the screen resolution from nothing but
+ * the depth buffer, so it fits a forward renderer that has no normal buffer:
+ *
+ *     ao.resize(width, height);                         // and on every window resize
+ *     ao.downsampleDepth(sceneDepth, nearPlane, farPlane);
+ *     ao.computeOcclusion(projection);
+ *     ao.blur();
+ *     ao.composite(sceneColour, sceneDepth);            // into whatever framebuffer is bound
+ *
+ * Each stage is one full screen triangle, so the caller can time them one by one:
+ *   depth      the nearest linear depth of every 2x2 / 4x4 block of the scene depth
+ *   occlusion  hemisphere samples around the view space position, the normal taken from the depth of the neighbours
+ *   blur       horizontal then vertical, weighted down across depth edges so occlusion doesn't bleed onto the background
+ *   composite  back to full resolution, picking among the 4 nearest low resolution texels by how close their depth is
+ *              (bilateral upsampling), and darkening the scene colour with it
+ */
+class AmbientOcclusion
+{
+    public:
+        static const int MAX_SAMPLES = 32;
+
+        AmbientOcclusion(const std::string& shaderDirectory);
+        ~AmbientOcclusion();
+
+        AmbientOcclusion(const AmbientOcclusion&) = delete;
+        AmbientOcclusion& operator=(const AmbientOcclusion&) = delete;
+
+        void resize(int width, int height);
+        // One of AMBIENT_OCCLUSION_PRESETS, the targets are reallocated when the resolution changes and the kernel
+        // is rebuilt when the sample count does.
+        void setPreset(unsigned int preset);
+
+        void downsampleDepth(unsigned int depthTexture, float nearPlane, float farPlane);
+        void computeOcclusion(const glm::mat4& projection);
+        void blur();
+        void composite(unsigned int colourTexture, unsigned int depthTexture);
+
+        unsigned int getPreset() const;
+        glm::ivec2 getResolution() const;
+
+        float radius = 1.0f;        // world units the hemisphere reaches
+        float bias = 0.05f;         // depth difference below which a sample doesn't occlude
+        float power = 1.5f;         // contrast of the result
+        float strength = 1.0f;      // 0 leaves the scene as it was
+
+    private:
+        void allocateTargets();
+        void buildKernel(int samples);
+        void drawFullScreen(unsigned int framebuffer) const;
+
+    private:
+        std::unique_ptr<ShaderPermutations> depthShaders;
+        std::unique_ptr<ShaderPermutations> occlusionShaders;
+        std::unique_ptr<ShaderPermutations> blurShaders;
+        std::unique_ptr<ShaderPermutations> compositeShaders;
+
+        unsigned int preset = 1;
+        int width = 0;
+        int height = 0;
+        glm::ivec2 resolution = glm::ivec2(0);
+        glm::vec3 kernel[MAX_SAMPLES];
+        float nearPlane = 0.1f;
+        float farPlane = 100.0f;
+
+        unsigned int emptyVao = 0;
+        // linear depth, occlusion, and the occlusion blurred horizontally
+        unsigned int textures[3] = {0, 0, 0};
+        unsigned int framebuffers[3] = {0, 0, 0};
+};
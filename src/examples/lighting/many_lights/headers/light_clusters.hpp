@@ -0,0 +1,131 @@
+#pragma once
+
+#include "../../../../headers/thread_pool.hpp"
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <tuple>
+#include <vector>
+
+struct PointLight {
+    glm::vec3 position;     // world space
+    float radius;           // the light falls off to nothing at this distance
+    glm::vec3 colour;
+    // so the deferred path can draw the lights as an InstanceBatch of light volumes
+    static constexpr auto attributes = std::make_tuple(&PointLight::position, &PointLight::radius, &PointLight::colour);
+};
+
+struct LightClusterStats {
+    unsigned int lights = 0;                // handed to build()
+    unsigned int clusteredLights = 0;       // of those, touching at least one cluster
+    unsigned int assignments = 0;           // (cluster, light) pairs in the lists
+    unsigned int occupiedClusters = 0;
+    unsigned int maxClusterLights = 0;
+    unsigned int droppedAssignments = 0;    // lost to a full cluster, see maxLightsPerCluster
+    float buildMs = 0.0f;                   // assigning and packing on the CPU
+    float uploadMs = 0.0f;
+};
+
+/*
+ * Clustered forward shading: the view frustum is cut into froxels (screen tiles times exponentially spaced depth
+ * slices) and every froxel keeps the list of lights whose sphere touches it, so a fragment only loops over the lights
+ * of the froxel it falls in rather than over every light in the scene:
+ *
+ *     LightClusters clusters;
+ *     clusters.setProjection(glm::radians(fov), width, height, 0.1f, 100.0f);   // and again on resize / zoom
+ *     clusters.build(lights, view, pool);                                       // every frame the lights or camera move
+ *     clusters.upload();
+ *     clusters.bind(program, 0);                                                // texture units 0 .. TEXTURE_UNITS - 1
+ *
+ * Lights are assigned on the CPU, one depth slice per job on the pool: a light is tested only against the tiles its
+ * projected bounds cover, one row of tiles at a time with 8 tiles per AVX2 instruction where the CPU has it.
+ * The result reaches the shader as three texture buffers, see data/shaders/clustered.fs for the lookup.
+ * Light positions are uploaded in view space, so the shader lights in view space as well.
+ */
+class LightClusters
+{
+    public:
+        static const unsigned int TEXTURE_UNITS = 3;
+        // Light indices are stored as 16 bits.
+        static const unsigned int MAX_LIGHTS = 65535;
+
+        LightClusters(unsigned int tileSize = 64, unsigned int depthSlices = 24, unsigned int maxLightsPerCluster = 256);
+        ~LightClusters();
+
+        LightClusters(const LightClusters&) = delete;
+        LightClusters& operator=(const LightClusters&) = delete;
+
+        // Lay the froxels out over a symmetric perspective projection; the clusters are empty until the next build().
+        void setProjection(float fovY, int width, int height, float nearPlane, float farPlane);
+        // Assign `lights` (the first MAX_LIGHTS of them) to the froxels of the camera `view`.
+        void build(const std::vector<PointLight>& lights, const glm::mat4& view, ThreadPool& pool);
+        // Copy the last build into the texture buffers.
+        void upload();
+        // Bind the texture buffers to units [firstUnit, firstUnit + TEXTURE_UNITS) and set the cluster uniforms of `program`, which has to be in use.
+        void bind(unsigned int program, unsigned int firstUnit) const;
+
+        const LightClusterStats& getStats() const;
+        glm::uvec3 getGridSize() const;
+
+    private:
+        // In view space, where depth is -z.
+        struct ViewLight {
+            glm::vec3 position;
+            float radius;
+        };
+
+        // What one slice job adds to the stats.
+        struct SliceStats {
+            unsigned int assignments;
+            unsigned int occupiedClusters;
+            unsigned int maxClusterLights;
+            unsigned int droppedAssignments;
+        };
+
+        unsigned int sliceOf(float depth) const;
+        // Tile range [first, last] along one axis that `low` .. `high` (view space, at depths near .. far) projects to, false if off screen.
+        bool tileRange(float low, float high, float nearDepth, float farDepth, float tanHalfFov, unsigned int tiles, unsigned int pixels,
+            unsigned int& first, unsigned int& last) const;
+        void assignSlice(unsigned int slice);
+
+    private:
+        unsigned int tileSize;
+        unsigned int depthSlices;
+        unsigned int maxLightsPerCluster;
+
+        unsigned int tilesX = 0;
+        unsigned int tilesY = 0;
+        int width = 0;
+        int height = 0;
+        float nearPlane = 0.1f;
+        float farPlane = 100.0f;
+        float tanHalfFovX = 1.0f;
+        float tanHalfFovY = 1.0f;
+        float sliceScale = 0.0f;    // slice = log(depth) * sliceScale - sliceBias
+        float sliceBias = 0.0f;
+
+        // Froxel bounds in view space: x per (slice, tile column), y per (slice, tile row), depth per slice.
+        // The x bounds run 8 floats past the last slice so a row can always be read 8 tiles at a time.
+        std::vector<float> sliceDepths;
+        std::vector<float> tileMinX, tileMaxX;
+        std::vector<float> tileMinY, tileMaxY;
+
+        std::vector<ViewLight> viewLights;
+        std::vector<std::vector<uint32_t>> sliceLights;
+        std::vector<SliceStats> sliceStats;
+
+        // Filled by the slice jobs: maxLightsPerCluster slots per cluster, then packed into clusterLightIndices.
+        std::vector<uint16_t> clusterSlots;
+        std::vector<uint32_t> clusterCounts;
+
+        // What reaches the GPU: (first index, light count) per cluster, the packed indices, and two texels per light.
+        std::vector<glm::uvec2> clusterGrid;
+        std::vector<uint16_t> clusterLightIndices;
+        std::vector<glm::vec4> lightTexels;
+
+        unsigned int buffers[3] = {0, 0, 0};
+        unsigned int textures[3] = {0, 0, 0};
+        LightClusterStats stats;
+};
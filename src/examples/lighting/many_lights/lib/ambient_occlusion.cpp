@@ -0,0 +1,237 @@
+#include "../headers/ambient_occlusion.hpp"
+
+#include <glm/gtc/type_ptr.hpp>
+
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <sstream>
+
+namespace
+{
+    enum AmbientOcclusionTarget { LINEAR_DEPTH, OCCLUSION, BLURRED_ONCE };
+
+    std::string readShaderFile(const std::string& path)
+    {
+        std::ifstream file(path);
+        if (!file)
+        {
+            std::cout << "ERROR::AMBIENT_OCCLUSION::FILE_NOT_SUCCESSFULLY_READ: " << path << std::endl;
+            return "";
+        }
+        std::stringstream source;
+        source << file.rdbuf();
+        return source.str();
+    }
+
+    std::unique_ptr<ShaderPermutations> loadStage(const std::string& name, const std::string& directory, const std::string& fragmentFile)
+    {
+        std::string vertexSource = readShaderFile(directory + "/full_screen.vs");
+        std::string fragmentSource = readShaderFile(directory + "/" + fragmentFile);
+        return std::make_unique<ShaderPermutations>(name, vertexSource.c_str(), fragmentSource.c_str(), std::vector<std::string>());
+    }
+}
+
+AmbientOcclusion::AmbientOcclusion(const std::string& shaderDirectory)
+{
+    depthShaders = loadStage("ao depth", shaderDirectory, "ao_depth.fs");
+    occlusionShaders = loadStage("ao occlusion", shaderDirectory, "ao_occlusion.fs");
+    blurShaders = loadStage("ao blur", shaderDirectory, "ao_blur.fs");
+    compositeShaders = loadStage("ao composite", shaderDirectory, "ao_composite.fs");
+    for (ShaderPermutations* stage : {depthShaders.get(), occlusionShaders.get(), blurShaders.get(), compositeShaders.get()})
+    {
+        stage->precompile({0});
+    }
+
+    buildKernel(AMBIENT_OCCLUSION_PRESETS[preset].samples);
+
+    // full screen triangles come from gl_VertexID, but core profile still wants a vertex array bound
+    glGenVertexArrays(1, &emptyVao);
+    glGenTextures(3, textures);
+    glGenFramebuffers(3, framebuffers);
+}
+
+AmbientOcclusion::~AmbientOcclusion()
+{
+    glDeleteFramebuffers(3, framebuffers);
+    glDeleteTextures(3, textures);
+    glDeleteVertexArrays(1, &emptyVao);
+}
+
+void AmbientOcclusion::resize(int width, int height)
+{
+    this->width = width;
+    this->height = height;
+    allocateTargets();
+}
+
+void AmbientOcclusion::setPreset(unsigned int preset)
+{
+    if (preset >= AMBIENT_OCCLUSION_PRESET_COUNT || preset == this->preset)
+    {
+        return;
+    }
+    bool resolutionChanged = AMBIENT_OCCLUSION_PRESETS[preset].downsample != AMBIENT_OCCLUSION_PRESETS[this->preset].downsample;
+    bool samplesChanged = AMBIENT_OCCLUSION_PRESETS[preset].samples != AMBIENT_OCCLUSION_PRESETS[this->preset].samples;
+    this->preset = preset;
+    if (resolutionChanged)
+    {
+        allocateTargets();
+    }
+    if (samplesChanged)
+    {
+        buildKernel(AMBIENT_OCCLUSION_PRESETS[preset].samples);
+    }
+}
+
+/*
+ * Sample offsets in the +z hemisphere, more of them close to the centre where occlusion matters most.
+ * The occlusion shader turns the hemisphere around the surface normal, with a different twist per pixel.
+ * The lengths are spread over the samples the preset actually takes, so every preset reaches out to `radius`.
+ */
+void AmbientOcclusion::buildKernel(int samples)
+{
+    std::mt19937 random(4);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    for (int i = 0; i < samples; i++)
+    {
+        glm::vec3 sample = glm::normalize(glm::vec3(unit(random) * 2.0f - 1.0f, unit(random) * 2.0f - 1.0f, unit(random)));
+        float scale = (float)i / samples;
+        kernel[i] = sample * unit(random) * (0.1f + 0.9f * scale * scale);
+    }
+}
+
+void AmbientOcclusion::allocateTargets()
+{
+    unsigned int downsample = AMBIENT_OCCLUSION_PRESETS[preset].downsample;
+    resolution = glm::max(glm::ivec2((width + downsample - 1) / downsample, (height + downsample - 1) / downsample), glm::ivec2(1));
+
+    // linear depth needs the precision, occlusion is a 0 - 1 factor
+    const GLint formats[3] = {GL_R32F, GL_R8, GL_R8};
+    const GLenum types[3] = {GL_FLOAT, GL_UNSIGNED_BYTE, GL_UNSIGNED_BYTE};
+    for (unsigned int i = 0; i < 3; i++)
+    {
+        glBindTexture(GL_TEXTURE_2D, textures[i]);
+        glTexImage2D(GL_TEXTURE_2D, 0, formats[i], resolution.x, resolution.y, 0, GL_RED, types[i], NULL);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+        glBindFramebuffer(GL_FRAMEBUFFER, framebuffers[i]);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, textures[i], 0);
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+        {
+            std::cout << "ERROR::AMBIENT_OCCLUSION::FRAMEBUFFER_INCOMPLETE: " << i << std::endl;
+        }
+    }
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+void AmbientOcclusion::downsampleDepth(unsigned int depthTexture, float nearPlane, float farPlane)
+{
+    this->nearPlane = nearPlane;
+    this->farPlane = farPlane;
+
+    unsigned int program = depthShaders->get(0);
+    glUseProgram(program);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, depthTexture);
+    glUniform1i(glGetUniformLocation(program, "depthTexture"), 0);
+    glUniform1i(glGetUniformLocation(program, "downsample"), AMBIENT_OCCLUSION_PRESETS[preset].downsample);
+    glUniform2f(glGetUniformLocation(program, "nearFar"), nearPlane, farPlane);
+    drawFullScreen(framebuffers[LINEAR_DEPTH]);
+}
+
+void AmbientOcclusion::computeOcclusion(const glm::mat4& projection)
+{
+    const AmbientOcclusionPreset& settings = AMBIENT_OCCLUSION_PRESETS[preset];
+    unsigned int program = occlusionShaders->get(0);
+    glUseProgram(program);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, textures[LINEAR_DEPTH]);
+    glUniform1i(glGetUniformLocation(program, "linearDepth"), 0);
+    // x and y of a view space position at depth 1, from the corner of the screen to the other
+    glUniform2f(glGetUniformLocation(program, "viewRay"), 1.0f / projection[0][0], 1.0f / projection[1][1]);
+    glUniform1f(glGetUniformLocation(program, "farPlane"), farPlane);
+    glUniform3fv(glGetUniformLocation(program, "kernel"), settings.samples, glm::value_ptr(kernel[0]));
+    glUniform1i(glGetUniformLocation(program, "samples"), settings.samples);
+    glUniform1f(glGetUniformLocation(program, "radius"), radius);
+    glUniform1f(glGetUniformLocation(program, "bias"), bias);
+    glUniform1f(glGetUniformLocation(program, "power"), power);
+    drawFullScreen(framebuffers[OCCLUSION]);
+}
+
+void AmbientOcclusion::blur()
+{
+    unsigned int program = blurShaders->get(0);
+    glUseProgram(program);
+    glUniform1i(glGetUniformLocation(program, "occlusion"), 0);
+    glUniform1i(glGetUniformLocation(program, "linearDepth"), 1);
+    glUniform1i(glGetUniformLocation(program, "blurRadius"), AMBIENT_OCCLUSION_PRESETS[preset].blurRadius);
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_2D, textures[LINEAR_DEPTH]);
+
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, textures[OCCLUSION]);
+    glUniform2i(glGetUniformLocation(program, "direction"), 1, 0);
+    drawFullScreen(framebuffers[BLURRED_ONCE]);
+
+    glBindTexture(GL_TEXTURE_2D, textures[BLURRED_ONCE]);
+    glUniform2i(glGetUniformLocation(program, "direction"), 0, 1);
+    drawFullScreen(framebuffers[OCCLUSION]);
+}
+
+void AmbientOcclusion::composite(unsigned int colourTexture, unsigned int depthTexture)
+{
+    GLint target;
+    glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &target);
+
+    unsigned int program = compositeShaders->get(0);
+    glUseProgram(program);
+    glUniform1i(glGetUniformLocation(program, "sceneColour"), 0);
+    glUniform1i(glGetUniformLocation(program, "sceneDepth"), 1);
+    glUniform1i(glGetUniformLocation(program, "occlusion"), 2);
+    glUniform1i(glGetUniformLocation(program, "linearDepth"), 3);
+    glUniform1i(glGetUniformLocation(program, "downsample"), AMBIENT_OCCLUSION_PRESETS[preset].downsample);
+    glUniform2f(glGetUniformLocation(program, "nearFar"), nearPlane, farPlane);
+    glUniform1f(glGetUniformLocation(program, "strength"), strength);
+    const unsigned int inputs[4] = {colourTexture, depthTexture, textures[OCCLUSION], textures[LINEAR_DEPTH]};
+    for (unsigned int i = 0; i < 4; i++)
+    {
+        glActiveTexture(GL_TEXTURE0 + i);
+        glBindTexture(GL_TEXTURE_2D, inputs[i]);
+    }
+    glActiveTexture(GL_TEXTURE0);
+
+    glViewport(0, 0, width, height);
+    glDisable(GL_DEPTH_TEST);
+    glBindFramebuffer(GL_FRAMEBUFFER, target);
+    glBindVertexArray(emptyVao);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+    glEnable(GL_DEPTH_TEST);
+}
+
+unsigned int AmbientOcclusion::getPreset() const
+{
+    return preset;
+}
+
+glm::ivec2 AmbientOcclusion::getResolution() const
+{
+    return resolution;
+}
+
+// One triangle over the low resolution target, then back to the full size viewport.
+void AmbientOcclusion::drawFullScreen(unsigned int framebuffer) const
+{
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    glViewport(0, 0, resolution.x, resolution.y);
+    glDisable(GL_DEPTH_TEST);
+    glBindVertexArray(emptyVao);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+    glEnable(GL_DEPTH_TEST);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glViewport(0, 0, width, height);
+}
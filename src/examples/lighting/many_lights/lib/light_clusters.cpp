@@ -0,0 +1,375 @@
+#include "../headers/light_clusters.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define LIGHT_CLUSTERS_X86 1
+#endif
+
+namespace
+{
+    const float NEVER_MATCHES = 1e30f;
+
+    float elapsedMs(std::chrono::steady_clock::time_point start)
+    {
+        return std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    // Distance along one axis from `x` to [low, high], 0 inside.
+    float axisDistance(float x, float low, float high)
+    {
+        return std::max(std::max(low - x, x - high), 0.0f);
+    }
+
+    // Tiles i in [first, end) whose x bounds lie within sqrt(remaining) of `x`, written to `hits`. Returns how many.
+    unsigned int testRow(const float* minX, const float* maxX, unsigned int first, unsigned int end, float x, float remaining, uint16_t* hits)
+    {
+        unsigned int count = 0;
+        for (unsigned int i = first; i < end; i++)
+        {
+            float distance = axisDistance(x, minX[i], maxX[i]);
+            if (distance * distance <= remaining)
+            {
+                hits[count++] = (uint16_t)i;
+            }
+        }
+        return count;
+    }
+
+#ifdef LIGHT_CLUSTERS_X86
+    bool hasAvx2()
+    {
+        static const bool supported = __builtin_cpu_supports("avx2");
+        return supported;
+    }
+
+    // testRow 8 tiles at a time, reads up to 7 floats past `end`.
+    __attribute__((target("avx2")))
+    unsigned int testRow8(const float* minX, const float* maxX, unsigned int first, unsigned int end, float x, float remaining, uint16_t* hits)
+    {
+        const __m256 px = _mm256_set1_ps(x);
+        const __m256 limit = _mm256_set1_ps(remaining);
+        const __m256 zero = _mm256_setzero_ps();
+        unsigned int count = 0;
+        for (unsigned int i = first; i < end; i += 8)
+        {
+            __m256 below = _mm256_sub_ps(_mm256_loadu_ps(minX + i), px);
+            __m256 above = _mm256_sub_ps(px, _mm256_loadu_ps(maxX + i));
+            __m256 distance = _mm256_max_ps(_mm256_max_ps(below, above), zero);
+            unsigned int mask = (unsigned int)_mm256_movemask_ps(_mm256_cmp_ps(_mm256_mul_ps(distance, distance), limit, _CMP_LE_OQ));
+            if (end - i < 8)
+            {
+                mask &= (1u << (end - i)) - 1u;
+            }
+            while (mask != 0)
+            {
+                hits[count++] = (uint16_t)(i + __builtin_ctz(mask));
+                mask &= mask - 1u;
+            }
+        }
+        return count;
+    }
+#endif
+}
+
+LightClusters::LightClusters(unsigned int tileSize, unsigned int depthSlices, unsigned int maxLightsPerCluster)
+    : tileSize(tileSize), depthSlices(depthSlices), maxLightsPerCluster(maxLightsPerCluster)
+{
+    glGenBuffers(3, buffers);
+    glGenTextures(3, textures);
+
+    const GLenum formats[3] = {GL_RG32UI, GL_R16UI, GL_RGBA32F};
+    for (int i = 0; i < 3; i++)
+    {
+        glBindBuffer(GL_TEXTURE_BUFFER, buffers[i]);
+        glBufferData(GL_TEXTURE_BUFFER, 16, NULL, GL_STREAM_DRAW);
+        glBindTexture(GL_TEXTURE_BUFFER, textures[i]);
+        glTexBuffer(GL_TEXTURE_BUFFER, formats[i], buffers[i]);
+    }
+    glBindTexture(GL_TEXTURE_BUFFER, 0);
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+}
+
+LightClusters::~LightClusters()
+{
+    glDeleteTextures(3, textures);
+    glDeleteBuffers(3, buffers);
+}
+
+void LightClusters::setProjection(float fovY, int width, int height, float nearPlane, float farPlane)
+{
+    this->width = std::max(width, 1);
+    this->height = std::max(height, 1);
+    this->nearPlane = nearPlane;
+    this->farPlane = farPlane;
+    tilesX = (this->width + tileSize - 1) / tileSize;
+    tilesY = (this->height + tileSize - 1) / tileSize;
+    tanHalfFovY = std::tan(fovY * 0.5f);
+    tanHalfFovX = tanHalfFovY * (float)this->width / (float)this->height;
+
+    // depth of slice k is near * (far / near)^(k / slices), so slices stay roughly as deep as they are wide
+    float logRatio = std::log(farPlane / nearPlane);
+    sliceScale = depthSlices / logRatio;
+    sliceBias = depthSlices * std::log(nearPlane) / logRatio;
+    sliceDepths.resize(depthSlices + 1);
+    for (unsigned int k = 0; k <= depthSlices; k++)
+    {
+        sliceDepths[k] = nearPlane * std::pow(farPlane / nearPlane, (float)k / depthSlices);
+    }
+
+    // A tile edge at NDC x sits at x * depth * tanHalfFov in view space, so each froxel's box spans both of its depths.
+    auto tileBounds = [&](unsigned int tiles, int pixels, float tanHalfFov, std::vector<float>& minimum, std::vector<float>& maximum, size_t padding)
+    {
+        minimum.assign(depthSlices * tiles + padding, NEVER_MATCHES);
+        maximum.assign(depthSlices * tiles + padding, NEVER_MATCHES);
+        for (unsigned int k = 0; k < depthSlices; k++)
+        {
+            float nearDepth = sliceDepths[k] * tanHalfFov;
+            float farDepth = sliceDepths[k + 1] * tanHalfFov;
+            for (unsigned int i = 0; i < tiles; i++)
+            {
+                float low = -1.0f + 2.0f * (float)(i * tileSize) / pixels;
+                float high = std::min(1.0f, -1.0f + 2.0f * (float)((i + 1) * tileSize) / pixels);
+                minimum[k * tiles + i] = std::min(low * nearDepth, low * farDepth);
+                maximum[k * tiles + i] = std::max(high * nearDepth, high * farDepth);
+            }
+        }
+    };
+    tileBounds(tilesX, this->width, tanHalfFovX, tileMinX, tileMaxX, 8);
+    tileBounds(tilesY, this->height, tanHalfFovY, tileMinY, tileMaxY, 0);
+
+    size_t clusterCount = (size_t)tilesX * tilesY * depthSlices;
+    clusterCounts.assign(clusterCount, 0);
+    clusterSlots.resize(clusterCount * maxLightsPerCluster);
+    clusterGrid.assign(clusterCount, glm::uvec2(0));
+    clusterLightIndices.clear();
+    sliceLights.resize(depthSlices);
+    sliceStats.resize(depthSlices);
+}
+
+unsigned int LightClusters::sliceOf(float depth) const
+{
+    float slice = std::floor(std::log(depth) * sliceScale - sliceBias);
+    return (unsigned int)std::clamp(slice, 0.0f, (float)(depthSlices - 1));
+}
+
+bool LightClusters::tileRange(float low, float high, float nearDepth, float farDepth, float tanHalfFov, unsigned int tiles, unsigned int pixels,
+    unsigned int& first, unsigned int& last) const
+{
+    // projecting divides by depth, so the extremes are at the near or the far end depending on the sign
+    float ndcLow = std::min(low / nearDepth, low / farDepth) / tanHalfFov;
+    float ndcHigh = std::max(high / nearDepth, high / farDepth) / tanHalfFov;
+    if (ndcHigh < -1.0f || ndcLow > 1.0f)
+    {
+        return false;
+    }
+    float pixelsPerTile = (float)tileSize / pixels;
+    first = (unsigned int)std::clamp(std::floor((ndcLow + 1.0f) * 0.5f / pixelsPerTile), 0.0f, (float)(tiles - 1));
+    last = (unsigned int)std::clamp(std::floor((ndcHigh + 1.0f) * 0.5f / pixelsPerTile), 0.0f, (float)(tiles - 1));
+    return true;
+}
+
+void LightClusters::build(const std::vector<PointLight>& lights, const glm::mat4& view, ThreadPool& pool)
+{
+    auto start = std::chrono::steady_clock::now();
+    size_t lightCount = std::min<size_t>(lights.size(), MAX_LIGHTS);
+
+    // bin the lights by the depth slices their sphere spans, so a slice job only looks at its own lights
+    viewLights.resize(lightCount);
+    lightTexels.resize(lightCount * 2);
+    for (std::vector<uint32_t>& slice : sliceLights)
+    {
+        slice.clear();
+    }
+    for (size_t n = 0; n < lightCount; n++)
+    {
+        glm::vec3 position = glm::vec3(view * glm::vec4(lights[n].position, 1.0f));
+        float radius = lights[n].radius;
+        viewLights[n] = {position, radius};
+        lightTexels[n * 2] = glm::vec4(position, radius);
+        lightTexels[n * 2 + 1] = glm::vec4(lights[n].colour, 0.0f);
+
+        float depth = -position.z;
+        if (depth + radius < nearPlane || depth - radius > farPlane)
+        {
+            continue;
+        }
+        unsigned int lastSlice = sliceOf(std::min(depth + radius, farPlane));
+        for (unsigned int k = sliceOf(std::max(depth - radius, nearPlane)); k <= lastSlice; k++)
+        {
+            sliceLights[k].push_back((uint32_t)n);
+        }
+    }
+
+    // every slice owns its clusters, so the jobs never write to the same list
+    std::fill(clusterCounts.begin(), clusterCounts.end(), 0);
+    pool.parallelFor(depthSlices, 1, [this](size_t begin, size_t end)
+    {
+        for (size_t k = begin; k < end; k++)
+        {
+            assignSlice((unsigned int)k);
+        }
+    });
+
+    // pack the fixed size slots into one list and give every cluster its (first, count) pair
+    size_t clusterCount = clusterCounts.size();
+    uint32_t offset = 0;
+    for (size_t cluster = 0; cluster < clusterCount; cluster++)
+    {
+        clusterGrid[cluster] = glm::uvec2(offset, clusterCounts[cluster]);
+        offset += clusterCounts[cluster];
+    }
+    clusterLightIndices.resize(offset);
+    size_t clustersPerSlice = (size_t)tilesX * tilesY;
+    pool.parallelFor(depthSlices, 1, [&](size_t begin, size_t end)
+    {
+        for (size_t cluster = begin * clustersPerSlice; cluster < end * clustersPerSlice; cluster++)
+        {
+            const uint16_t* slots = &clusterSlots[cluster * maxLightsPerCluster];
+            std::copy(slots, slots + clusterGrid[cluster].y, clusterLightIndices.begin() + clusterGrid[cluster].x);
+        }
+    });
+
+    LightClusterStats built;
+    built.lights = (unsigned int)lightCount;
+    for (const SliceStats& slice : sliceStats)
+    {
+        built.assignments += slice.assignments;
+        built.occupiedClusters += slice.occupiedClusters;
+        built.maxClusterLights = std::max(built.maxClusterLights, slice.maxClusterLights);
+        built.droppedAssignments += slice.droppedAssignments;
+    }
+    std::vector<bool> clustered(lightCount, false);
+    for (uint16_t light : clusterLightIndices)
+    {
+        clustered[light] = true;
+    }
+    built.clusteredLights = (unsigned int)std::count(clustered.begin(), clustered.end(), true);
+    built.buildMs = elapsedMs(start);
+    built.uploadMs = stats.uploadMs;
+    stats = built;
+}
+
+void LightClusters::assignSlice(unsigned int slice)
+{
+    const float sliceNear = sliceDepths[slice];
+    const float sliceFar = sliceDepths[slice + 1];
+    const float* minX = &tileMinX[slice * tilesX];
+    const float* maxX = &tileMaxX[slice * tilesX];
+    const float* minY = &tileMinY[slice * tilesY];
+    const float* maxY = &tileMaxY[slice * tilesY];
+    std::vector<uint16_t> hits(tilesX);
+#ifdef LIGHT_CLUSTERS_X86
+    auto rowTest = hasAvx2() ? testRow8 : testRow;
+#else
+    auto rowTest = testRow;
+#endif
+
+    SliceStats local = {0, 0, 0, 0};
+    for (uint32_t n : sliceLights[slice])
+    {
+        const ViewLight& light = viewLights[n];
+        float depth = -light.position.z;
+        float depthDistance = axisDistance(depth, sliceNear, sliceFar);
+        float remaining = light.radius * light.radius - depthDistance * depthDistance;
+        if (remaining < 0.0f)
+        {
+            continue;
+        }
+
+        // only the tiles under the sphere's projection, over the part of the slice the sphere overlaps
+        float nearDepth = std::max(sliceNear, depth - light.radius);
+        float farDepth = std::min(sliceFar, depth + light.radius);
+        unsigned int firstX, lastX, firstY, lastY;
+        if (!tileRange(light.position.x - light.radius, light.position.x + light.radius, nearDepth, farDepth, tanHalfFovX, tilesX, width, firstX, lastX) ||
+            !tileRange(light.position.y - light.radius, light.position.y + light.radius, nearDepth, farDepth, tanHalfFovY, tilesY, height, firstY, lastY))
+        {
+            continue;
+        }
+
+        // sphere against froxel box, squared distance split per axis: depth for the slice, y per row, x per tile
+        for (unsigned int y = firstY; y <= lastY; y++)
+        {
+            float rowDistance = axisDistance(light.position.y, minY[y], maxY[y]);
+            float rowRemaining = remaining - rowDistance * rowDistance;
+            if (rowRemaining < 0.0f)
+            {
+                continue;
+            }
+
+            unsigned int hitCount = rowTest(minX, maxX, firstX, lastX + 1, light.position.x, rowRemaining, hits.data());
+            size_t rowCluster = ((size_t)slice * tilesY + y) * tilesX;
+            for (unsigned int h = 0; h < hitCount; h++)
+            {
+                size_t cluster = rowCluster + hits[h];
+                uint32_t& count = clusterCounts[cluster];
+                if (count < maxLightsPerCluster)
+                {
+                    clusterSlots[cluster * maxLightsPerCluster + count++] = (uint16_t)n;
+                }
+                else
+                {
+                    local.droppedAssignments++;
+                }
+            }
+        }
+    }
+
+    size_t first = (size_t)slice * tilesX * tilesY;
+    for (size_t cluster = first; cluster < first + (size_t)tilesX * tilesY; cluster++)
+    {
+        local.assignments += clusterCounts[cluster];
+        local.occupiedClusters += clusterCounts[cluster] > 0 ? 1 : 0;
+        local.maxClusterLights = std::max(local.maxClusterLights, clusterCounts[cluster]);
+    }
+    sliceStats[slice] = local;
+}
+
+void LightClusters::upload()
+{
+    auto start = std::chrono::steady_clock::now();
+    const void* data[3] = {clusterGrid.data(), clusterLightIndices.data(), lightTexels.data()};
+    size_t sizes[3] = {
+        clusterGrid.size() * sizeof(glm::uvec2),
+        clusterLightIndices.size() * sizeof(uint16_t),
+        lightTexels.size() * sizeof(glm::vec4)
+    };
+    for (int i = 0; i < 3; i++)
+    {
+        // orphaned every frame, so the driver never waits for last frame's draws to finish reading
+        glBindBuffer(GL_TEXTURE_BUFFER, buffers[i]);
+        glBufferData(GL_TEXTURE_BUFFER, std::max<size_t>(sizes[i], 16), NULL, GL_STREAM_DRAW);
+        glBufferSubData(GL_TEXTURE_BUFFER, 0, sizes[i], data[i]);
+    }
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+    stats.uploadMs = elapsedMs(start);
+}
+
+void LightClusters::bind(unsigned int program, unsigned int firstUnit) const
+{
+    const char* samplers[3] = {"clusterGrid", "clusterLightIndices", "clusterLights"};
+    for (unsigned int i = 0; i < 3; i++)
+    {
+        glActiveTexture(GL_TEXTURE0 + firstUnit + i);
+        glBindTexture(GL_TEXTURE_BUFFER, textures[i]);
+        glUniform1i(glGetUniformLocation(program, samplers[i]), firstUnit + i);
+    }
+    glActiveTexture(GL_TEXTURE0);
+
+    glUniform3ui(glGetUniformLocation(program, "clusterCounts"), tilesX, tilesY, depthSlices);
+    glUniform1f(glGetUniformLocation(program, "clusterTileSize"), (float)tileSize);
+    glUniform2f(glGetUniformLocation(program, "clusterSliceScaleBias"), sliceScale, sliceBias);
+}
+
+const LightClusterStats& LightClusters::getStats() const
+{
+    return stats;
+}
+
+glm::uvec3 LightClusters::getGridSize() const
+{
+    return glm::uvec3(tilesX, tilesY, depthSlices);
+}
@@ -0,0 +1,1100 @@
+/*
+ * Thousands of moving point lights over a field of boxes, rendered one of two ways:
+ *   clustered forward  the lights are sorted into froxels on the CPU every frame (see headers/light_clusters.hpp) and
+ *                      every fragment only loops over the lights of its own froxel
+ *   deferred           the boxes are drawn once into a G-buffer, then every light is drawn as a sphere that lights the
+ *                      pixels inside it, so overdrawn fragments never pay for lighting
+ * lighting_cube_6 lights one cube with one light, both paths are the same Blinn-Phong model in view space, scaled up.
+ * Either path can be followed by screen space ambient occlusion at half or quarter resolution (headers/ambient_occlusion.hpp),
+ * which then renders into the lighting target and darkens it on the way to the screen.
+ *
+ * F toggles the ImGui window (and frees the cursor), G switches between forward and deferred, H toggles the light count
+ * heat map of the forward path, O toggles ambient occlusion, SPACE pauses the lights.
+ * Once a second the console gets the GPU time of every pass, the cluster build time and the average number of lights
+ * each forward fragment loops over. --headless runs it offscreen for a fixed number of frames, see headless.hpp.
+ */
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include "imgui.h"
+#include "imgui_impl_glfw.h"
+#include "imgui_impl_opengl3.h"
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include "stdlib.h"
+#include <iostream>
+#include <cstdint>
+#include <fstream>
+#include <sstream>
+#include <vector>
+
+#include "./headers/ambient_occlusion.hpp"
+#include "./headers/light_clusters.hpp"
+#include "../../../headers/thread_pool.hpp"
+#include "../../../headers/headless.hpp"
+#include "../../../headers/instance_batch.hpp"
+#include "../../../headers/parallel_shader_compile.hpp"
+#include "../../../headers/program_cache.hpp"
+#include "../../../headers/shader_permutations.hpp"
+
+#include <chrono>
+#include <random>
+
+// Function Declarations.
+void framebuffer_size_callback(GLFWwindow* window, int width, int height);
+void key_callback(GLFWwindow* window, int key, int scancode, int action, int mods);
+void processInput(GLFWwindow* window);
+void mouse_callback(GLFWwindow* window, double xpos, double ypos);
+void scroll_callback(GLFWwindow* window, double xoffset, double yoffset);
+
+void render(GLFWwindow* window);
+void storeVertexDataOnGpu();
+void buildScene();
+void buildLights();
+void moveLights(float time);
+void storeLightVolumeOnGpu();
+void resizeRenderTargets();
+float measureLightsPerFragment(unsigned int countProgram, const glm::mat4& view, const glm::mat4& projection);
+void setCameraUniforms(unsigned int program, const glm::mat4& view, const glm::mat4& projection);
+void drawLightVolumes(unsigned int program, const InstanceBatch<PointLight>& volumes, const glm::mat4& view, const glm::mat4& projection);
+std::string readShaderFile(const std::string& path);
+
+struct SceneBox {
+    glm::vec3 position;
+    glm::vec3 scale;
+    glm::vec3 colour;
+    static constexpr auto attributes = std::make_tuple(&SceneBox::position, &SceneBox::scale, &SceneBox::colour);
+};
+
+struct LightMarker {
+    glm::vec3 position;
+    glm::vec3 colour;
+    static constexpr auto attributes = std::make_tuple(&LightMarker::position, &LightMarker::colour);
+};
+
+// Where each light circles around, so they move without drifting off the scene.
+struct LightOrbit {
+    glm::vec3 centre;
+    float radius;
+    float speed;
+    float phase;
+};
+
+// Variables
+size_t WINDOW_WIDTH = 1280;
+size_t WINDOW_HEIGHT = 720;
+
+float lastMouseX = WINDOW_WIDTH / 2;
+float lastMouseY = WINDOW_HEIGHT / 2;
+
+float pitch = -20.0f;
+float yaw = -90.0f;
+
+bool firstMouse = true;
+bool imGuiMode = false;
+bool projectionChanged = true;
+
+float fov = 45.0f;
+const float NEAR_PLANE = 0.1f;
+const float FAR_PLANE = 150.0f;
+
+glm::vec3 cameraPos   = glm::vec3(0.0f, 14.0f, 52.0f);
+glm::vec3 cameraFront = glm::vec3(0.0f, -0.34f, -0.94f);
+glm::vec3 cameraUp    = glm::vec3(0.0f, 1.0f,  0.0f);
+
+float deltaTime = 0.0f;	// Time between current frame and last frame
+float lastFrame = 0.0f; // Time of last frame
+
+float CAMERA_BASE_SPEED = 12.0f;
+
+unsigned int vboId;
+unsigned int boxVaoId, markerVaoId;
+unsigned int lightVolumeVaoId, lightVolumeVboId, lightVolumeEboId;
+unsigned int lightVolumeIndexCount;
+unsigned int countFramebuffer, countTexture, countDepthBuffer;
+unsigned int gBufferFramebuffer, gAlbedoSpecular, gNormal, gDepth;
+unsigned int lightingFramebuffer, lightingTexture, lightingDepth;
+
+// Scene: boxes on a floor, the floor being one very flat box
+const float FLOOR_SIZE = 100.0f;
+const int BOX_GRID = 24;
+std::vector<SceneBox> sceneBoxes;
+
+int LIGHT_COUNT = 4096;
+int MAX_LIGHT_COUNT = 16384;
+int builtLightCount = 0; // LIGHT_COUNT follows the slider, this is how many orbits exist
+std::vector<PointLight> lights;
+std::vector<LightOrbit> lightOrbits;
+std::vector<LightMarker> lightMarkers;
+bool lightsMoving = true;
+bool showLightMarkers = true;
+bool heatmapEnabled = false;
+bool deferredShading = false;
+bool ambientOcclusionEnabled = true;
+int ambientOcclusionPreset = 1;
+float lightTime = 0.0f;
+
+float ambientStrength = 0.04f;
+float specularStrength = 0.5f;
+float shininess = 64.0f;
+
+ThreadPool clusterPool;
+
+// Averaged over one REPORT_INTERVAL, shown in ImGui and printed to the console
+const float REPORT_INTERVAL = 1.0f;
+struct ClusterReport {
+    unsigned int frames;
+    unsigned int builds;        // frames of the forward path, the deferred one doesn't use the clusters
+    float frameMs;
+    float buildMs;
+    float uploadMs;
+    float lightsPerFragment;    // over the covered pixels of the last measured frame
+    LightClusterStats last;
+};
+ClusterReport clusterReport = {0, 0, 0.0f, 0.0f, 0.0f, 0.0f, LightClusterStats()};
+
+// GPU time per render pass, see beginPass()
+enum RenderPass {
+    PASS_FORWARD, PASS_GBUFFER, PASS_LIGHTS, PASS_MARKERS, PASS_COMPOSITE,
+    PASS_AO_DEPTH, PASS_AO, PASS_AO_BLUR, PASS_AO_UPSAMPLE, PASS_COUNT
+};
+struct PassTimer {
+    const char* name;
+    unsigned int queries[2] = {0, 0};
+    bool pending[2] = {false, false};
+    float ms = 0.0f;            // the latest result
+    float totalMs = 0.0f;       // since the last report
+    unsigned int samples = 0;
+    unsigned int lastUsed = 0;  // frameIndex
+};
+PassTimer passTimers[PASS_COUNT] = {
+    {"forward shading"}, {"g-buffer"}, {"light volumes"}, {"light markers"}, {"composite"},
+    {"ao depth"}, {"ao"}, {"ao blur"}, {"ao upsample"}
+};
+unsigned int frameIndex = 0;
+void beginPass(RenderPass pass);
+void endPass(RenderPass pass);
+
+float vertices[] = {
+    -0.5f, -0.5f, -0.5f,  0.0f, 0.0f, 0.0f,  0.0f, -1.0f,
+     0.5f, -0.5f, -0.5f,  1.0f, 0.0f, 0.0f,  0.0f, -1.0f,
+     0.5f,  0.5f, -0.5f,  1.0f, 1.0f, 0.0f,  0.0f, -1.0f,
+     0.5f,  0.5f, -0.5f,  1.0f, 1.0f, 0.0f,  0.0f, -1.0f,
+    -0.5f,  0.5f, -0.5f,  0.0f, 1.0f, 0.0f,  0.0f, -1.0f,
+    -0.5f, -0.5f, -0.5f,  0.0f, 0.0f, 0.0f,  0.0f, -1.0f,
+
+    -0.5f, -0.5f,  0.5f,  0.0f, 0.0f, 0.0f,  0.0f, 1.0f,
+     0.5f, -0.5f,  0.5f,  1.0f, 0.0f, 0.0f,  0.0f, 1.0f,
+     0.5f,  0.5f,  0.5f,  1.0f, 1.0f, 0.0f,  0.0f, 1.0f,
+     0.5f,  0.5f,  0.5f,  1.0f, 1.0f, 0.0f,  0.0f, 1.0f,
+    -0.5f,  0.5f,  0.5f,  0.0f, 1.0f, 0.0f,  0.0f, 1.0f,
+    -0.5f, -0.5f,  0.5f,  0.0f, 0.0f, 0.0f,  0.0f, 1.0f,
+
+    -0.5f,  0.5f,  0.5f,  1.0f, 0.0f, -1.0f,  0.0f,  0.0f,
+    -0.5f,  0.5f, -0.5f,  1.0f, 1.0f, -1.0f,  0.0f,  0.0f,
+    -0.5f, -0.5f, -0.5f,  0.0f, 1.0f, -1.0f,  0.0f,  0.0f,
+    -0.5f, -0.5f, -0.5f,  0.0f, 1.0f, -1.0f,  0.0f,  0.0f,
+    -0.5f, -0.5f,  0.5f,  0.0f, 0.0f, -1.0f,  0.0f,  0.0f,
+    -0.5f,  0.5f,  0.5f,  1.0f, 0.0f, -1.0f,  0.0f,  0.0f,
+
+     0.5f,  0.5f,  0.5f,  1.0f, 0.0f, 1.0f,  0.0f,  0.0f,
+     0.5f,  0.5f, -0.5f,  1.0f, 1.0f, 1.0f,  0.0f,  0.0f,
+     0.5f, -0.5f, -0.5f,  0.0f, 1.0f, 1.0f,  0.0f,  0.0f,
+     0.5f, -0.5f, -0.5f,  0.0f, 1.0f, 1.0f,  0.0f,  0.0f,
+     0.5f, -0.5f,  0.5f,  0.0f, 0.0f, 1.0f,  0.0f,  0.0f,
+     0.5f,  0.5f,  0.5f,  1.0f, 0.0f, 1.0f,  0.0f,  0.0f,
+
+    -0.5f, -0.5f, -0.5f,  0.0f, 1.0f, 0.0f, -1.0f,  0.0f,
+     0.5f, -0.5f, -0.5f,  1.0f, 1.0f, 0.0f, -1.0f,  0.0f,
+     0.5f, -0.5f,  0.5f,  1.0f, 0.0f, 0.0f, -1.0f,  0.0f,
+     0.5f, -0.5f,  0.5f,  1.0f, 0.0f, 0.0f, -1.0f,  0.0f,
+    -0.5f, -0.5f,  0.5f,  0.0f, 0.0f, 0.0f, -1.0f,  0.0f,
+    -0.5f, -0.5f, -0.5f,  0.0f, 1.0f, 0.0f, -1.0f,  0.0f,
+
+    -0.5f,  0.5f, -0.5f,  0.0f, 1.0f, 0.0f,  1.0f,  0.0f,
+     0.5f,  0.5f, -0.5f,  1.0f, 1.0f, 0.0f,  1.0f,  0.0f,
+     0.5f,  0.5f,  0.5f,  1.0f, 0.0f, 0.0f,  1.0f,  0.0f,
+     0.5f,  0.5f,  0.5f,  1.0f, 0.0f, 0.0f,  1.0f,  0.0f,
+    -0.5f,  0.5f,  0.5f,  0.0f, 0.0f, 0.0f,  1.0f,  0.0f,
+    -0.5f,  0.5f, -0.5f,  0.0f, 1.0f, 0.0f,  1.0f,  0.0f
+};
+
+int main(int argc, char** argv)
+{
+    std::cout << "Hello, Lights!" << std::endl;
+
+    // --headless renders a fixed number of frames offscreen and prints their statistics, see headless.hpp
+    if (!headless.parseArguments(argc, argv) || !headless.initGlfw())
+    {
+        return -1;
+    }
+    if (headless.enabled)
+    {
+        WINDOW_WIDTH = headless.width;
+        WINDOW_HEIGHT = headless.height;
+    }
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+
+    GLFWwindow* window = glfwCreateWindow(WINDOW_WIDTH, WINDOW_HEIGHT, "Application", NULL, NULL);
+    if (window == NULL)
+    {
+        std::cout << "Failed to create GLFW window" << std::endl;
+        glfwTerminate();
+        return -1;
+    }
+
+	// Open Window
+    glfwMakeContextCurrent(window);
+
+	// Load openGL functions for this specific openGL Implementation via GLAD
+	if (!gladLoadGLLoader((GLADloadproc) glfwGetProcAddress))
+	{
+		std::cout << "Failed to initialize GLAD" << std::endl;
+		return -1;
+	}
+
+	// programs linked on earlier runs are loaded from here instead of compiled again
+	programCache.enable("shader_cache", (GLADloadproc) glfwGetProcAddress);
+	enableParallelShaderCompile((GLADloadproc) glfwGetProcAddress);
+
+	if (!headless.createTarget())
+	{
+		glfwTerminate();
+		return -1;
+	}
+
+	// Viewport dictates how we want to display the data and coordinates with respect to the window
+	glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+    glfwSetKeyCallback(window, key_callback);
+    glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+
+    glEnable(GL_DEPTH_TEST);
+
+    // Register mouse callback - Each time mouse moves this will be called with the (x,y) coords of the mouse.
+    glfwSetCursorPosCallback(window, mouse_callback);
+
+    // Scroll callback (change fov of perspective project based on y coordinate)
+    glfwSetScrollCallback(window, scroll_callback);
+
+    // Setup Dear ImGui context
+    IMGUI_CHECKVERSION();
+    ImGui::CreateContext();
+    ImGuiIO& io = ImGui::GetIO(); (void)io;
+    io.ConfigFlags |= ImGuiConfigFlags_NavEnableKeyboard;     // Enable Keyboard Controls
+
+    // Setup Dear ImGui style
+    ImGui::StyleColorsDark();
+
+    // Setup Platform/Renderer backends
+    ImGui_ImplGlfw_InitForOpenGL(window, true);
+    ImGui_ImplOpenGL3_Init("#version 330");
+
+	render(window);
+
+    // Cleanup
+	glDeleteVertexArrays(1, &boxVaoId);
+	glDeleteVertexArrays(1, &markerVaoId);
+    glDeleteBuffers(1, &vboId);
+    glDeleteFramebuffers(1, &countFramebuffer);
+    glDeleteTextures(1, &countTexture);
+    glDeleteRenderbuffers(1, &countDepthBuffer);
+	glDeleteVertexArrays(1, &lightVolumeVaoId);
+    glDeleteBuffers(1, &lightVolumeVboId);
+    glDeleteBuffers(1, &lightVolumeEboId);
+    glDeleteFramebuffers(1, &gBufferFramebuffer);
+    glDeleteTextures(1, &gAlbedoSpecular);
+    glDeleteTextures(1, &gNormal);
+    glDeleteTextures(1, &gDepth);
+    glDeleteFramebuffers(1, &lightingFramebuffer);
+    glDeleteTextures(1, &lightingTexture);
+    glDeleteTextures(1, &lightingDepth);
+
+    ImGui_ImplOpenGL3_Shutdown();
+    ImGui_ImplGlfw_Shutdown();
+    ImGui::DestroyContext();
+
+    glfwDestroyWindow(window);
+	glfwTerminate();
+    return 0;
+}
+
+void render(GLFWwindow* window)
+{
+    // the light count pass and the heat map are permutations, so the normal shader carries neither
+    ShaderPermutations sceneShaders("clustered scene", readShaderFile("src/examples/lighting/many_lights/data/shaders/scene.vs").c_str(),
+        readShaderFile("src/examples/lighting/many_lights/data/shaders/clustered.fs").c_str(), {"LIGHT_COUNT", "HEATMAP"});
+    ShaderPermutations gBufferShaders("g-buffer", readShaderFile("src/examples/lighting/many_lights/data/shaders/scene.vs").c_str(),
+        readShaderFile("src/examples/lighting/many_lights/data/shaders/gbuffer.fs").c_str(), {});
+    ShaderPermutations lightVolumeShaders("light volume", readShaderFile("src/examples/lighting/many_lights/data/shaders/light_volume.vs").c_str(),
+        readShaderFile("src/examples/lighting/many_lights/data/shaders/light_volume.fs").c_str(), {});
+    ShaderPermutations markerShaders("light marker", readShaderFile("src/examples/lighting/many_lights/data/shaders/light_marker.vs").c_str(),
+        readShaderFile("src/examples/lighting/many_lights/data/shaders/light_marker.fs").c_str(), {});
+    const uint32_t LIGHT_COUNT_PASS = 1 << 0, HEATMAP = 1 << 1;
+    sceneShaders.precompile({0, LIGHT_COUNT_PASS, HEATMAP});
+    unsigned int gBufferProgram = gBufferShaders.get(0);
+    unsigned int lightVolumeProgram = lightVolumeShaders.get(0);
+    unsigned int markerProgram = markerShaders.get(0);
+    AmbientOcclusion ambientOcclusion("src/examples/lighting/many_lights/data/shaders");
+    programCache.printReport();
+
+    storeVertexDataOnGpu();
+    storeLightVolumeOnGpu();
+    buildScene();
+
+    InstanceBatch<SceneBox> boxes(3);
+    boxes.attach(boxVaoId);
+    boxes.upload(sceneBoxes);
+    InstanceBatch<LightMarker> markers(3);
+    markers.attach(markerVaoId);
+    InstanceBatch<PointLight> lightVolumes(3);
+    lightVolumes.attach(lightVolumeVaoId);
+
+    for (PassTimer& timer : passTimers)
+    {
+        glGenQueries(2, timer.queries);
+    }
+
+    LightClusters clusters;
+    std::cout << "Clustering on " << clusterPool.size() << " worker threads" << std::endl;
+
+    float nextReport = (float)glfwGetTime() + REPORT_INTERVAL;
+    bool measureNextFrame = false;
+    bool show_window = true;
+
+	while(!glfwWindowShouldClose(window))
+	{
+        // Start the Dear ImGui frame
+        ImGui_ImplOpenGL3_NewFrame();
+        ImGui_ImplGlfw_NewFrame();
+        ImGui::NewFrame();
+
+		// Input
+		processInput(window);
+
+        if (LIGHT_COUNT != builtLightCount)
+        {
+            buildLights();
+        }
+        if (lightsMoving)
+        {
+            lightTime += deltaTime;
+        }
+        moveLights(lightTime);
+
+        glm::mat4 projection = glm::perspective(glm::radians(fov), (float)WINDOW_WIDTH / (float)WINDOW_HEIGHT, NEAR_PLANE, FAR_PLANE);
+        glm::mat4 view = glm::lookAt(cameraPos, cameraPos + cameraFront, cameraUp);
+        if (projectionChanged)
+        {
+            clusters.setProjection(glm::radians(fov), (int)WINDOW_WIDTH, (int)WINDOW_HEIGHT, NEAR_PLANE, FAR_PLANE);
+            resizeRenderTargets();
+            ambientOcclusion.resize((int)WINDOW_WIDTH, (int)WINDOW_HEIGHT);
+            projectionChanged = false;
+        }
+
+        clusterReport.frames++;
+        clusterReport.frameMs += deltaTime * 1000.0f;
+        if (deferredShading)
+        {
+            // the volumes are the lights themselves, the GPU finds the pixels they cover
+            lightVolumes.upload(lights);
+        }
+        else
+        {
+            // the lights and the camera both move, so the clusters are rebuilt every frame
+            clusters.build(lights, view, clusterPool);
+            clusters.upload();
+
+            const LightClusterStats& stats = clusters.getStats();
+            clusterReport.builds++;
+            clusterReport.buildMs += stats.buildMs;
+            clusterReport.uploadMs += stats.uploadMs;
+            clusterReport.last = stats;
+        }
+
+        // ImGui Windows
+        if (show_window)
+        {
+            const LightClusterStats& stats = clusterReport.last;
+            glm::uvec3 grid = clusters.getGridSize();
+            ImGui::Begin("Many lights", &show_window);
+            ImGui::Checkbox("Deferred shading", &deferredShading);
+            ImGui::SliderInt("Lights", &LIGHT_COUNT, 1, MAX_LIGHT_COUNT);
+            ImGui::Checkbox("Move lights", &lightsMoving);
+            ImGui::Checkbox("Show lights", &showLightMarkers);
+            ImGui::Checkbox("Light count heat map (forward)", &heatmapEnabled);
+            ImGui::SliderFloat("Ambient", &ambientStrength, 0.0f, 0.5f);
+            ImGui::SliderFloat("Specular", &specularStrength, 0.0f, 1.0f);
+            ImGui::SliderFloat("Shininess", &shininess, 2.0f, 256.0f);
+            ImGui::Checkbox("Ambient occlusion", &ambientOcclusionEnabled);
+            if (ambientOcclusionEnabled)
+            {
+                const char* presetNames[AMBIENT_OCCLUSION_PRESET_COUNT];
+                for (unsigned int i = 0; i < AMBIENT_OCCLUSION_PRESET_COUNT; i++)
+                {
+                    presetNames[i] = AMBIENT_OCCLUSION_PRESETS[i].name;
+                }
+                ImGui::Combo("AO quality", &ambientOcclusionPreset, presetNames, AMBIENT_OCCLUSION_PRESET_COUNT);
+                ImGui::SliderFloat("AO radius", &ambientOcclusion.radius, 0.1f, 4.0f);
+                ImGui::SliderFloat("AO strength", &ambientOcclusion.strength, 0.0f, 1.0f);
+                glm::ivec2 resolution = ambientOcclusion.getResolution();
+                ImGui::Text("AO target: %d x %d", resolution.x, resolution.y);
+            }
+            if (!deferredShading)
+            {
+                ImGui::Text("Clusters: %u x %u x %u, %u occupied", grid.x, grid.y, grid.z, stats.occupiedClusters);
+                ImGui::Text("Lights in clusters: %u / %u, max %u in one cluster", stats.clusteredLights, stats.lights, stats.maxClusterLights);
+                ImGui::Text("Cluster build: %.3f ms on %u threads, upload %.3f ms", stats.buildMs, clusterPool.size(), stats.uploadMs);
+                ImGui::Text("Lights per fragment: %.2f", clusterReport.lightsPerFragment);
+                if (stats.droppedAssignments > 0)
+                {
+                    ImGui::Text("Dropped: %u light assignments to full clusters", stats.droppedAssignments);
+                }
+            }
+            for (const PassTimer& timer : passTimers)
+            {
+                if (timer.lastUsed + 1 == frameIndex)
+                {
+                    ImGui::Text("GPU %s: %.3f ms", timer.name, timer.ms);
+                }
+            }
+            ImGui::End();
+        }
+
+        ImGui::Render();
+
+        ambientOcclusion.setPreset((unsigned int)ambientOcclusionPreset);
+
+        // how many lights the visible fragments loop over, once per report from a separate pass
+        if (measureNextFrame && !deferredShading)
+        {
+            unsigned int countProgram = sceneShaders.get(LIGHT_COUNT_PASS);
+            glUseProgram(countProgram);
+            clusters.bind(countProgram, 0);
+            clusterReport.lightsPerFragment = measureLightsPerFragment(countProgram, view, projection);
+        }
+        measureNextFrame = false;
+
+        // Clear the screen (or the offscreen target when headless) with a colour
+        glBindFramebuffer(GL_FRAMEBUFFER, headless.framebuffer());
+        glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT); // also clear the depth buffer now!
+
+		// Rendering commands
+        if (deferredShading)
+        {
+            // Geometry pass: the surface nearest to the camera in every pixel, lit only by the ambient term yet
+            beginPass(PASS_GBUFFER);
+            glBindFramebuffer(GL_FRAMEBUFFER, gBufferFramebuffer);
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+            glUseProgram(gBufferProgram);
+            glUniform1f(glGetUniformLocation(gBufferProgram, "ambientStrength"), ambientStrength);
+            glUniform1f(glGetUniformLocation(gBufferProgram, "specularStrength"), specularStrength);
+            setCameraUniforms(gBufferProgram, view, projection);
+            boxes.drawArrays(GL_TRIANGLES, 0, 36);
+            endPass(PASS_GBUFFER);
+
+            // Light pass: every light adds itself to the pixels inside its volume
+            beginPass(PASS_LIGHTS);
+            glBindFramebuffer(GL_READ_FRAMEBUFFER, gBufferFramebuffer);
+            glBindFramebuffer(GL_DRAW_FRAMEBUFFER, lightingFramebuffer);
+            glBlitFramebuffer(0, 0, (GLint)WINDOW_WIDTH, (GLint)WINDOW_HEIGHT, 0, 0, (GLint)WINDOW_WIDTH, (GLint)WINDOW_HEIGHT, GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+            glBindFramebuffer(GL_FRAMEBUFFER, lightingFramebuffer);
+            drawLightVolumes(lightVolumeProgram, lightVolumes, view, projection);
+            endPass(PASS_LIGHTS);
+        }
+        else
+        {
+            beginPass(PASS_FORWARD);
+            if (ambientOcclusionEnabled)
+            {
+                // the occlusion pass needs the depth as a texture, which the default framebuffer doesn't give
+                glBindFramebuffer(GL_FRAMEBUFFER, lightingFramebuffer);
+                glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+            }
+            unsigned int sceneProgram = sceneShaders.get(heatmapEnabled ? HEATMAP : 0);
+            glUseProgram(sceneProgram);
+            clusters.bind(sceneProgram, 0);
+            glUniform1f(glGetUniformLocation(sceneProgram, "ambientStrength"), ambientStrength);
+            glUniform1f(glGetUniformLocation(sceneProgram, "specularStrength"), specularStrength);
+            glUniform1f(glGetUniformLocation(sceneProgram, "shininess"), shininess);
+            setCameraUniforms(sceneProgram, view, projection);
+            boxes.drawArrays(GL_TRIANGLES, 0, 36);
+            endPass(PASS_FORWARD);
+        }
+
+        // into the lighting target when deferred or with ambient occlusion, which has the depth of the scene
+        if (showLightMarkers)
+        {
+            beginPass(PASS_MARKERS);
+            markers.upload(lightMarkers);
+            glUseProgram(markerProgram);
+            setCameraUniforms(markerProgram, view, projection);
+            glUniform1f(glGetUniformLocation(markerProgram, "markerSize"), 0.12f);
+            markers.drawArrays(GL_TRIANGLES, 0, 36);
+            endPass(PASS_MARKERS);
+        }
+
+        if (ambientOcclusionEnabled)
+        {
+            beginPass(PASS_AO_DEPTH);
+            ambientOcclusion.downsampleDepth(lightingDepth, NEAR_PLANE, FAR_PLANE);
+            endPass(PASS_AO_DEPTH);
+            beginPass(PASS_AO);
+            ambientOcclusion.computeOcclusion(projection);
+            endPass(PASS_AO);
+            beginPass(PASS_AO_BLUR);
+            ambientOcclusion.blur();
+            endPass(PASS_AO_BLUR);
+            // this replaces the composite blit, the lighting target reaches the screen darkened
+            beginPass(PASS_AO_UPSAMPLE);
+            glBindFramebuffer(GL_FRAMEBUFFER, headless.framebuffer());
+            ambientOcclusion.composite(lightingTexture, lightingDepth);
+            endPass(PASS_AO_UPSAMPLE);
+        }
+        else if (deferredShading)
+        {
+            beginPass(PASS_COMPOSITE);
+            glBindFramebuffer(GL_READ_FRAMEBUFFER, lightingFramebuffer);
+            glBindFramebuffer(GL_DRAW_FRAMEBUFFER, headless.framebuffer());
+            glBlitFramebuffer(0, 0, (GLint)WINDOW_WIDTH, (GLint)WINDOW_HEIGHT, 0, 0, (GLint)WINDOW_WIDTH, (GLint)WINDOW_HEIGHT, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+            glBindFramebuffer(GL_FRAMEBUFFER, headless.framebuffer());
+            endPass(PASS_COMPOSITE);
+        }
+
+        // no UI offscreen, its live timings would end up in the screenshot
+        if (!headless.enabled)
+        {
+            ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+        }
+
+        if (glfwGetTime() >= nextReport && clusterReport.frames > 0)
+        {
+            float frames = (float)clusterReport.frames;
+            if (clusterReport.builds > 0)
+            {
+                glm::uvec3 grid = clusters.getGridSize();
+                float builds = (float)clusterReport.builds;
+                std::cout << "Clusters " << grid.x << "x" << grid.y << "x" << grid.z << ": "
+                          << clusterReport.last.lights << " lights (" << clusterReport.last.clusteredLights << " in view), "
+                          << "build " << clusterReport.buildMs / builds << " ms, upload " << clusterReport.uploadMs / builds << " ms, "
+                          << clusterReport.lightsPerFragment << " lights per fragment, "
+                          << "max " << clusterReport.last.maxClusterLights << " per cluster, "
+                          << clusterReport.last.droppedAssignments << " dropped" << std::endl;
+            }
+            std::cout << (deferredShading ? "Deferred" : "Forward") << ", " << lights.size() << " lights, ";
+            if (ambientOcclusionEnabled)
+            {
+                glm::ivec2 resolution = ambientOcclusion.getResolution();
+                std::cout << "AO " << AMBIENT_OCCLUSION_PRESETS[ambientOcclusion.getPreset()].name << " at "
+                          << resolution.x << "x" << resolution.y << ", ";
+            }
+            std::cout
+                      << clusterReport.frameMs / frames << " ms per frame, GPU";
+            for (PassTimer& timer : passTimers)
+            {
+                if (timer.samples > 0)
+                {
+                    std::cout << " | " << timer.name << " " << timer.totalMs / timer.samples << " ms";
+                }
+                timer.totalMs = 0.0f;
+                timer.samples = 0;
+            }
+            std::cout << std::endl;
+
+            clusterReport = {0, 0, 0.0f, 0.0f, 0.0f, clusterReport.lightsPerFragment, clusterReport.last};
+            nextReport += REPORT_INTERVAL;
+            measureNextFrame = true;
+        }
+
+		// check and call events and swap the buffers
+		headless.present(window);
+		glfwPollEvents();
+        frameIndex++;
+	}
+
+    headless.finish();
+
+    for (PassTimer& timer : passTimers)
+    {
+        glDeleteQueries(2, timer.queries);
+    }
+}
+
+/*
+ * GL_TIME_ELAPSED queries can't nest, so the passes are timed one after the other. Each pass has two queries and uses
+ * them on alternating frames, like the asteroid demos: the result read when a query comes round again is a frame old,
+ * so the CPU doesn't wait for the pass it just submitted.
+ */
+void beginPass(RenderPass pass)
+{
+    PassTimer& timer = passTimers[pass];
+    unsigned int query = frameIndex % 2;
+    if (timer.pending[query])
+    {
+        GLuint64 elapsed;
+        glGetQueryObjectui64v(timer.queries[query], GL_QUERY_RESULT, &elapsed);
+        timer.ms = elapsed / 1e6f;
+        timer.totalMs += timer.ms;
+        timer.samples++;
+        timer.pending[query] = false;
+    }
+    glBeginQuery(GL_TIME_ELAPSED, timer.queries[query]);
+}
+
+void endPass(RenderPass pass)
+{
+    glEndQuery(GL_TIME_ELAPSED);
+    passTimers[pass].pending[frameIndex % 2] = true;
+    passTimers[pass].lastUsed = frameIndex;
+}
+
+/*
+ * Only the back faces of the volumes are drawn, and only where they lie behind the surface in the G-buffer: those are
+ * the pixels whose surface can be inside the sphere. This still works with the camera inside a volume, and depth clamping
+ * keeps the back faces beyond the far plane. Surfaces in front of the sphere pass as well and are thrown out by the
+ * radius check in the shader.
+ */
+void drawLightVolumes(unsigned int program, const InstanceBatch<PointLight>& volumes, const glm::mat4& view, const glm::mat4& projection)
+{
+    glUseProgram(program);
+    setCameraUniforms(program, view, projection);
+    glUniformMatrix4fv(glGetUniformLocation(program, "inverseProjection"), 1, GL_FALSE, glm::value_ptr(glm::inverse(projection)));
+    glUniform1f(glGetUniformLocation(program, "shininess"), shininess);
+    glUniform1i(glGetUniformLocation(program, "gAlbedoSpecular"), 0);
+    glUniform1i(glGetUniformLocation(program, "gNormal"), 1);
+    glUniform1i(glGetUniformLocation(program, "gDepth"), 2);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, gAlbedoSpecular);
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_2D, gNormal);
+    glActiveTexture(GL_TEXTURE2);
+    glBindTexture(GL_TEXTURE_2D, gDepth);
+
+    glEnable(GL_CULL_FACE);
+    glCullFace(GL_FRONT);
+    glDepthFunc(GL_GEQUAL);
+    glDepthMask(GL_FALSE);
+    glEnable(GL_DEPTH_CLAMP);
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_ONE, GL_ONE);
+
+    volumes.drawElements(GL_TRIANGLES, lightVolumeIndexCount);
+
+    glDisable(GL_BLEND);
+    glDisable(GL_DEPTH_CLAMP);
+    glDepthMask(GL_TRUE);
+    glDepthFunc(GL_LESS);
+    glCullFace(GL_BACK);
+    glDisable(GL_CULL_FACE);
+    glActiveTexture(GL_TEXTURE0);
+}
+
+// The view and projection uniforms of a box program, which has to be in use.
+void setCameraUniforms(unsigned int program, const glm::mat4& view, const glm::mat4& projection)
+{
+    glUniformMatrix4fv(glGetUniformLocation(program, "view"), 1, GL_FALSE, glm::value_ptr(view));
+    glUniformMatrix4fv(glGetUniformLocation(program, "projection"), 1, GL_FALSE, glm::value_ptr(projection));
+}
+
+/*
+ * Draws the boxes once more with the LIGHT_COUNT permutation into a float target, which holds for every pixel
+ * the length of the light list its fragment looped over, and averages the covered pixels on the CPU.
+ * Reading back stalls the pipeline, which is why it only happens once per report.
+ */
+float measureLightsPerFragment(unsigned int countProgram, const glm::mat4& view, const glm::mat4& projection)
+{
+    glBindFramebuffer(GL_FRAMEBUFFER, countFramebuffer);
+    const float empty[4] = {-1.0f, -1.0f, -1.0f, -1.0f};
+    glClearBufferfv(GL_COLOR, 0, empty);
+    glClear(GL_DEPTH_BUFFER_BIT);
+
+    setCameraUniforms(countProgram, view, projection);
+    glBindVertexArray(boxVaoId);
+    glDrawArraysInstanced(GL_TRIANGLES, 0, 36, (GLsizei)sceneBoxes.size());
+
+    std::vector<float> counts(WINDOW_WIDTH * WINDOW_HEIGHT);
+    glReadPixels(0, 0, (GLsizei)WINDOW_WIDTH, (GLsizei)WINDOW_HEIGHT, GL_RED, GL_FLOAT, counts.data());
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    double total = 0.0;
+    size_t covered = 0;
+    for (float count : counts)
+    {
+        if (count >= 0.0f)
+        {
+            total += count;
+            covered++;
+        }
+    }
+    return covered > 0 ? (float)(total / covered) : 0.0f;
+}
+
+// (Re)allocate a window sized render target texture.
+void allocateTargetTexture(unsigned int texture, GLint internalFormat, GLenum format, GLenum type)
+{
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, (GLsizei)WINDOW_WIDTH, (GLsizei)WINDOW_HEIGHT, 0, format, type, NULL);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+void allocateDepthBuffer(unsigned int renderbuffer)
+{
+    glBindRenderbuffer(GL_RENDERBUFFER, renderbuffer);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, (GLsizei)WINDOW_WIDTH, (GLsizei)WINDOW_HEIGHT);
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+}
+
+void checkFramebuffer(const char* name)
+{
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+    {
+        std::cout << "ERROR::FRAMEBUFFER::INCOMPLETE: " << name << std::endl;
+    }
+}
+
+/*
+ * The light count target of the forward path, and the G-buffer and lighting target of the deferred path:
+ *   G-buffer     RGBA8 albedo + specular strength, RG16 octahedral normal, the lighting texture, 24 bit depth texture
+ *   lighting     the lighting texture again, with a depth texture the G-buffer depth is copied into
+ * The light pass reads the G-buffer depth, so it can't also be the depth buffer the light volumes are tested against.
+ * With ambient occlusion the forward path draws into the lighting target too, for the depth texture.
+ */
+void resizeRenderTargets()
+{
+    if (countFramebuffer == 0)
+    {
+        glGenFramebuffers(1, &countFramebuffer);
+        glGenTextures(1, &countTexture);
+        glGenRenderbuffers(1, &countDepthBuffer);
+        glGenFramebuffers(1, &gBufferFramebuffer);
+        glGenTextures(1, &gAlbedoSpecular);
+        glGenTextures(1, &gNormal);
+        glGenTextures(1, &gDepth);
+        glGenFramebuffers(1, &lightingFramebuffer);
+        glGenTextures(1, &lightingTexture);
+        glGenTextures(1, &lightingDepth);
+    }
+
+    allocateTargetTexture(countTexture, GL_R32F, GL_RED, GL_FLOAT);
+    allocateDepthBuffer(countDepthBuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, countFramebuffer);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, countTexture, 0);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, countDepthBuffer);
+    checkFramebuffer("light count");
+
+    allocateTargetTexture(gAlbedoSpecular, GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE);
+    allocateTargetTexture(gNormal, GL_RG16, GL_RG, GL_UNSIGNED_SHORT);
+    allocateTargetTexture(gDepth, GL_DEPTH_COMPONENT24, GL_DEPTH_COMPONENT, GL_UNSIGNED_INT);
+    // the forward path writes 8 bit colour as well, so both paths clamp the summed light the same way
+    allocateTargetTexture(lightingTexture, GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE);
+    glBindFramebuffer(GL_FRAMEBUFFER, gBufferFramebuffer);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, gAlbedoSpecular, 0);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, gNormal, 0);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT2, GL_TEXTURE_2D, lightingTexture, 0);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, gDepth, 0);
+    const GLenum gBufferOutputs[] = {GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1, GL_COLOR_ATTACHMENT2};
+    glDrawBuffers(3, gBufferOutputs);
+    checkFramebuffer("g-buffer");
+
+    allocateTargetTexture(lightingDepth, GL_DEPTH_COMPONENT24, GL_DEPTH_COMPONENT, GL_UNSIGNED_INT);
+    glBindFramebuffer(GL_FRAMEBUFFER, lightingFramebuffer);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, lightingTexture, 0);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, lightingDepth, 0);
+    checkFramebuffer("lighting");
+
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+void buildScene()
+{
+    std::mt19937 random(7);
+    std::uniform_real_distribution<float> height(0.5f, 5.0f);
+    std::uniform_real_distribution<float> width(1.0f, 2.5f);
+    std::uniform_real_distribution<float> shade(0.45f, 0.9f);
+
+    sceneBoxes.clear();
+    sceneBoxes.push_back({glm::vec3(0.0f, -0.05f, 0.0f), glm::vec3(FLOOR_SIZE, 0.1f, FLOOR_SIZE), glm::vec3(0.6f)});
+
+    float spacing = FLOOR_SIZE / BOX_GRID;
+    for (int z = 0; z < BOX_GRID; z++)
+    {
+        for (int x = 0; x < BOX_GRID; x++)
+        {
+            float boxHeight = height(random);
+            glm::vec3 position((x + 0.5f) * spacing - FLOOR_SIZE * 0.5f, boxHeight * 0.5f, (z + 0.5f) * spacing - FLOOR_SIZE * 0.5f);
+            sceneBoxes.push_back({position, glm::vec3(width(random), boxHeight, width(random)), glm::vec3(shade(random), shade(random), shade(random))});
+        }
+    }
+}
+
+void buildLights()
+{
+    std::mt19937 random(11);
+    std::uniform_real_distribution<float> across(-FLOOR_SIZE * 0.5f, FLOOR_SIZE * 0.5f);
+    std::uniform_real_distribution<float> height(0.3f, 4.0f);
+    std::uniform_real_distribution<float> radius(2.0f, 5.0f);
+    std::uniform_real_distribution<float> orbit(0.5f, 3.0f);
+    std::uniform_real_distribution<float> speed(-1.5f, 1.5f);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+    lights.resize(LIGHT_COUNT);
+    lightOrbits.resize(LIGHT_COUNT);
+    lightMarkers.resize(LIGHT_COUNT);
+    for (int i = 0; i < LIGHT_COUNT; i++)
+    {
+        lightOrbits[i] = {glm::vec3(across(random), height(random), across(random)), orbit(random), speed(random), unit(random) * 6.2831853f};
+
+        // saturated colours, bright enough to show through the inverse square falloff
+        float hue = unit(random) * 6.0f;
+        glm::vec3 colour = glm::clamp(glm::vec3(std::abs(hue - 3.0f) - 1.0f, 2.0f - std::abs(hue - 2.0f), 2.0f - std::abs(hue - 4.0f)), 0.0f, 1.0f);
+        lights[i] = {lightOrbits[i].centre, radius(random), colour * 3.0f};
+        lightMarkers[i] = {lightOrbits[i].centre, colour};
+    }
+    builtLightCount = LIGHT_COUNT;
+}
+
+void moveLights(float time)
+{
+    for (size_t i = 0; i < lights.size(); i++)
+    {
+        const LightOrbit& orbit = lightOrbits[i];
+        float angle = orbit.phase + orbit.speed * time;
+        lights[i].position = orbit.centre + glm::vec3(std::sin(angle) * orbit.radius, 0.0f, std::cos(angle) * orbit.radius);
+        lightMarkers[i].position = lights[i].position;
+    }
+}
+
+std::string readShaderFile(const std::string& path)
+{
+    std::ifstream file(path);
+    if (!file)
+    {
+        std::cout << "ERROR::SHADER::FILE_NOT_SUCCESSFULLY_READ: " << path << std::endl;
+        return "";
+    }
+    std::stringstream source;
+    source << file.rdbuf();
+    return source.str();
+}
+
+void framebuffer_size_callback(GLFWwindow* window, int width, int height)
+{
+    glViewport(0, 0, width, height);
+    if (width > 0 && height > 0)
+    {
+        WINDOW_WIDTH = width;
+        WINDOW_HEIGHT = height;
+        projectionChanged = true;
+    }
+}
+
+void key_callback(GLFWwindow* window, int key, int scancode, int action, int mods)
+{
+    if (key == GLFW_KEY_F && action == GLFW_PRESS)
+    {
+        if (imGuiMode)
+        {
+            glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+        }
+        else
+        {
+            glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_NORMAL);
+        }
+        imGuiMode = !imGuiMode;
+    }
+
+    if (key == GLFW_KEY_H && action == GLFW_PRESS)
+    {
+        heatmapEnabled = !heatmapEnabled;
+    }
+
+    if (key == GLFW_KEY_G && action == GLFW_PRESS)
+    {
+        deferredShading = !deferredShading;
+    }
+
+    if (key == GLFW_KEY_O && action == GLFW_PRESS)
+    {
+        ambientOcclusionEnabled = !ambientOcclusionEnabled;
+    }
+
+    if (key == GLFW_KEY_SPACE && action == GLFW_PRESS)
+    {
+        lightsMoving = !lightsMoving;
+    }
+}
+
+void processInput(GLFWwindow *window)
+{
+    if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
+    {
+		glfwSetWindowShouldClose(window, true);
+	}
+
+    float currentFrame = glfwGetTime();
+    deltaTime = currentFrame - lastFrame;
+    lastFrame = currentFrame;
+
+    const float cameraSpeed = CAMERA_BASE_SPEED * deltaTime; // adjust accordingly
+    if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS)
+    {
+        cameraPos += (cameraSpeed * cameraFront);
+    }
+    if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS)
+    {
+        cameraPos -= (cameraSpeed * cameraFront);
+    }
+    if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS)
+    {
+        cameraPos -= (glm::normalize(glm::cross(cameraFront, cameraUp)) * cameraSpeed);
+    }
+    if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS)
+    {
+        cameraPos += (glm::normalize(glm::cross(cameraFront, cameraUp)) * cameraSpeed);
+    }
+}
+
+/*
+    1. Calculate the mouse's offset since the last frame.
+    2. Add the offset values to the camera's yaw and pitch values.
+    3. Add some constraints to the minimum/maximum pitch values.
+    4. Calculate the direction vector.
+*/
+void mouse_callback(GLFWwindow* window, double xpos, double ypos)
+{
+    if (imGuiMode)
+    {
+        return;
+    }
+    if (firstMouse)
+    {
+        lastMouseX = xpos;
+        lastMouseY = ypos;
+        firstMouse = false;
+    }
+
+    float xoffset = xpos - lastMouseX;
+    float yoffset = lastMouseY - ypos; // reversed since y-coordinates range from bottom to top
+    lastMouseX = xpos;
+    lastMouseY = ypos;
+
+    const float sensitivity = 0.1f;
+    xoffset *= sensitivity;
+    yoffset *= sensitivity;
+
+    yaw   += xoffset;
+    pitch += yoffset;
+
+    if (pitch > 89.0f)
+    {
+        pitch =  89.0f;
+    }
+    if (pitch < -89.0f)
+    {
+        pitch = -89.0f;
+    }
+
+    glm::vec3 direction;
+    direction.x = cos(glm::radians(yaw)) * cos(glm::radians(pitch));
+    direction.y = sin(glm::radians(pitch));
+    direction.z = sin(glm::radians(yaw)) * cos(glm::radians(pitch));
+    cameraFront = glm::normalize(direction);
+}
+
+void scroll_callback(GLFWwindow* window, double xoffset, double yoffset)
+{
+    fov -= (float)yoffset;
+    if (fov < 1.0f)
+    {
+        fov = 1.0f;
+    }
+    if (fov > 45.0f)
+    {
+        fov = 45.0f;
+    }
+    projectionChanged = true;
+}
+
+void storeVertexDataOnGpu()
+{
+	glGenBuffers(1, &vboId);
+	glBindBuffer(GL_ARRAY_BUFFER, vboId);
+	glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+
+    // Boxes: position, texture coordinate, normal (the instance attributes are attached by their InstanceBatch)
+	glGenVertexArrays(1, &boxVaoId);
+	glBindVertexArray(boxVaoId);
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
+	glEnableVertexAttribArray(0);
+	glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(3 * sizeof(float)));
+	glEnableVertexAttribArray(1);
+	glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(5 * sizeof(float)));
+	glEnableVertexAttribArray(2);
+
+    // Light markers only need the position, like the light source cube of the lighting_cube demos.
+	glGenVertexArrays(1, &markerVaoId);
+	glBindVertexArray(markerVaoId);
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
+	glEnableVertexAttribArray(0);
+
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindVertexArray(0);
+}
+
+/*
+ * The mesh every light volume is an instance of: a UV sphere around the unit sphere. Its flat faces lie inside the
+ * vertices, so the vertices are pushed out far enough that no face cuts into the sphere the light reaches.
+ */
+void storeLightVolumeOnGpu()
+{
+    const int SEGMENTS = 12;
+    const int RINGS = 8;
+    const float PI = 3.14159265f;
+    const float scale = 1.0f / (std::cos(PI / SEGMENTS) * std::cos(PI / RINGS));
+
+    std::vector<glm::vec3> positions;
+    for (int ring = 0; ring <= RINGS; ring++)
+    {
+        float theta = PI * ring / RINGS;
+        for (int segment = 0; segment <= SEGMENTS; segment++)
+        {
+            float phi = 2.0f * PI * segment / SEGMENTS;
+            positions.push_back(scale * glm::vec3(std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi)));
+        }
+    }
+
+    // counter-clockwise seen from outside, like the cube faces
+    std::vector<unsigned int> indices;
+    for (int ring = 0; ring < RINGS; ring++)
+    {
+        for (int segment = 0; segment < SEGMENTS; segment++)
+        {
+            unsigned int topLeft = ring * (SEGMENTS + 1) + segment;
+            unsigned int bottomLeft = topLeft + SEGMENTS + 1;
+            indices.insert(indices.end(), {topLeft, bottomLeft + 1, bottomLeft, topLeft, topLeft + 1, bottomLeft + 1});
+        }
+    }
+    lightVolumeIndexCount = (unsigned int)indices.size();
+
+	glGenVertexArrays(1, &lightVolumeVaoId);
+	glBindVertexArray(lightVolumeVaoId);
+	glGenBuffers(1, &lightVolumeVboId);
+	glBindBuffer(GL_ARRAY_BUFFER, lightVolumeVboId);
+	glBufferData(GL_ARRAY_BUFFER, positions.size() * sizeof(glm::vec3), positions.data(), GL_STATIC_DRAW);
+	glGenBuffers(1, &lightVolumeEboId);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, lightVolumeEboId);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), indices.data(), GL_STATIC_DRAW);
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), (void*)0);
+	glEnableVertexAttribArray(0);
+
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
@@ -71,6 +71,9 @@ int main()
         return -1;
     }
 
+    // programs linked on earlier runs are loaded from here instead of compiled again
+    programCache.enable("shader_cache", (GLADloadproc) glfwGetProcAddress);
+
     // tell stb_image.h to flip loaded texture's on the y-axis (before loading model).
     stbi_set_flip_vertically_on_load(true);
 
@@ -81,6 +84,7 @@ int main()
     // build and compile shaders
     // -------------------------
     Shader ourShader("src/examples/models/data/shaders/shader.vs", "src/examples/models/data/shaders/shader.fs");
+    programCache.printReport();
 
     // load models
     // -----------
@@ -1,8 +1,13 @@
 #version 330 core
 
+in vec3 Normal;
+
 out vec4 FragColour;
 
+const vec3 LIGHT_DIRECTION = normalize(vec3(-0.4, 1.0, -0.3));
+
 void main()
 {    
-    FragColour = vec4(1, 1, 1, 1);
+    float diffuse = max(dot(normalize(Normal), LIGHT_DIRECTION), 0.0);
+    FragColour = vec4(vec3(0.25 + 0.75 * diffuse), 1);
 }
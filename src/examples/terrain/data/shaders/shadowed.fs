@@ -0,0 +1,68 @@
+#version 330 core
+
+in vec3 Normal;
+in vec3 WorldPos;
+in float ViewDepth;
+
+out vec4 FragColour;
+
+// Filled by ShadowCascades::bind(), see shadow_cascades.hpp.
+const int MAX_CASCADES = 4;
+uniform sampler2DArrayShadow shadowMap;
+uniform int cascadeCount;
+uniform mat4 lightSpaceMatrices[MAX_CASCADES];
+uniform float cascadeSplits[MAX_CASCADES];      // view depth each cascade ends at
+uniform float cascadeTexelSizes[MAX_CASCADES];  // world size of one shadow map texel
+uniform vec3 lightDirection;
+
+uniform bool showCascades;
+
+const vec3 CASCADE_TINTS[MAX_CASCADES] = vec3[](vec3(1.0, 0.6, 0.6), vec3(0.6, 1.0, 0.6), vec3(0.6, 0.6, 1.0), vec3(1.0, 1.0, 0.6));
+
+// How lit the fragment is, 0 to 1, from the first cascade that reaches it; past the last one there is no shadow.
+float shadow(vec3 normal, int cascade)
+{
+    if (cascade == cascadeCount)
+    {
+        return 1.0;
+    }
+
+    // look the depth up from a texel and a half above the surface, so a surface doesn't shadow itself
+    // where its slope spans more depth than the polygon offset of the shadow pass covers
+    vec3 position = WorldPos + normal * cascadeTexelSizes[cascade] * 1.5;
+    vec3 coords = (lightSpaceMatrices[cascade] * vec4(position, 1.0)).xyz * 0.5 + 0.5;
+
+    // 3x3 taps, each already a bilinear blend of 4 comparisons
+    vec2 texel = 1.0 / vec2(textureSize(shadowMap, 0).xy);
+    float lit = 0.0;
+    for (int x = -1; x <= 1; x++)
+    {
+        for (int y = -1; y <= 1; y++)
+        {
+            lit += texture(shadowMap, vec4(coords.xy + vec2(x, y) * texel, float(cascade), coords.z));
+        }
+    }
+    return lit / 9.0;
+}
+
+void main()
+{
+    vec3 normal = normalize(Normal);
+    int cascade = cascadeCount;
+    for (int i = 0; i < cascadeCount; i++)
+    {
+        if (ViewDepth < cascadeSplits[i])
+        {
+            cascade = i;
+            break;
+        }
+    }
+
+    float diffuse = max(dot(normal, lightDirection), 0.0) * shadow(normal, cascade);
+    vec3 colour = vec3(0.25 + 0.75 * diffuse);
+    if (showCascades && cascade < cascadeCount)
+    {
+        colour *= CASCADE_TINTS[cascade];
+    }
+    FragColour = vec4(colour, 1);
+}
@@ -0,0 +1,21 @@
+#version 330 core
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec3 aNormal;
+
+out vec3 Normal;
+out vec3 WorldPos;
+out float ViewDepth;
+
+uniform mat4 model;
+uniform mat4 view;
+uniform mat4 projection;
+
+void main()
+{
+    vec4 worldPos = model * vec4(aPos, 1.0f);
+    vec4 viewPos = view * worldPos;
+    Normal = mat3(model) * aNormal;
+    WorldPos = worldPos.xyz;
+    ViewDepth = -viewPos.z;
+    gl_Position = projection * viewPos;
+}
@@ -0,0 +1,105 @@
+#pragma once
+
+#include "./noise.hpp"
+#include "../../../headers/thread_pool.hpp"
+
+#include <glm/glm.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+/*
+ * One procedurally generated chunk, ready to upload.
+ * `vertices` holds (chunkSize + 1)^2 interleaved position + normal vertices, row-major with z fastest,
+ * in the same layout as the height map terrain so the strip indices from buildChunkStripIndices() apply.
+ */
+struct GeneratedChunk {
+    glm::ivec2 coord;
+    std::vector<float> vertices;
+    glm::vec3 boundsMin;
+    glm::vec3 boundsMax;
+};
+
+struct ChunkStreamerStats {
+    unsigned int residentChunks;
+    unsigned int pendingChunks;
+    unsigned int generatedChunks;
+    float chunksPerSecond;
+    float averageGenerationMs;
+};
+
+/*
+ * Streams an endless grid of noise generated chunks around the camera.
+ *
+ * Missing chunks near the camera are generated on the thread pool, nearest first, with a cap on how many
+ * are in flight so the queue never falls far behind a moving camera. Finished chunks wait in a queue until the
+ * render thread takes them with takeFinished(), which is where the per-frame upload budget is applied.
+ * Generation is deterministic: a chunk only depends on the noise seed and its coordinate.
+ */
+class ChunkStreamer
+{
+    public:
+        ChunkStreamer(const FbmNoise& noise, ThreadPool& pool, int chunkSize, float heightScale);
+        ~ChunkStreamer();
+
+        ChunkStreamer(const ChunkStreamer&) = delete;
+        ChunkStreamer& operator=(const ChunkStreamer&) = delete;
+
+        // Queue chunks within `viewRadius` chunks of `eyePos`, and report resident chunks that are now out of range.
+        void update(const glm::vec3& eyePos, int viewRadius, std::vector<glm::ivec2>& evicted);
+        // Hand over at most `budget` finished chunks, nearest to the last update first.
+        void takeFinished(size_t budget, std::vector<GeneratedChunk>& ready);
+        // Block until every queued chunk is generated, so takeFinished() hands out the same chunks on every run.
+        void waitForGeneration() const;
+
+        ChunkStreamerStats getStats() const;
+        int getChunkSize() const;
+
+        // Generate a chunk on the calling thread.
+        static GeneratedChunk generateChunk(const FbmNoise& noise, glm::ivec2 coord, int chunkSize, float heightScale);
+
+    private:
+        enum class ChunkState { Pending, Resident };
+
+        // Everything the worker jobs touch, kept alive by the jobs themselves if the streamer goes away first.
+        struct SharedState {
+            SharedState(const FbmNoise& noise, int chunkSize, float heightScale)
+                : noise(noise), chunkSize(chunkSize), heightScale(heightScale) {}
+
+            FbmNoise noise;
+            int chunkSize;
+            float heightScale;
+
+            std::mutex finishedMutex;
+            std::vector<GeneratedChunk> finished;
+            std::atomic<unsigned int> inFlight = 0;
+            std::condition_variable generationDone;     // notified each time a job leaves inFlight
+            std::atomic<unsigned int> generated = 0;
+            std::atomic<uint64_t> generationMicroseconds = 0;
+        };
+
+        static int64_t key(glm::ivec2 coord);
+
+    private:
+        std::shared_ptr<SharedState> shared;
+        ThreadPool& pool;
+        unsigned int maxInFlight;
+
+        std::unordered_map<int64_t, ChunkState> chunks;
+        glm::ivec2 centerChunk = glm::ivec2(0);
+
+        // chunks/sec over a sliding window
+        std::chrono::high_resolution_clock::time_point rateWindowStart;
+        unsigned int rateWindowGenerated = 0;
+        float chunksPerSecond = 0.0f;
+};
+
+// Triangle strip indices (one strip per row, joined with TERRAIN_RESTART_INDEX) for a (chunkSize + 1)^2 vertex grid.
+std::vector<unsigned int> buildChunkStripIndices(int chunkSize);
@@ -0,0 +1,19 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+/*
+ * View frustum represented as 6 planes (left, right, bottom, top, near, far) in world space.
+ * The planes are extracted directly from the combined projection * view matrix (Gribb/Hartmann method),
+ * each plane is stored as (normal.xyz, distance) with the normal pointing into the frustum.
+ */
+class Frustum
+{
+    public:
+        Frustum(const glm::mat4& projectionView);
+
+        bool isBoxVisible(const glm::vec3& boxMin, const glm::vec3& boxMax) const;
+
+    private:
+        glm::vec4 planes[6];
+};
@@ -0,0 +1,84 @@
+#pragma once
+
+#include "../../../headers/thread_pool.hpp"
+
+#include <glm/glm.hpp>
+#include <vector>
+
+struct TerrainRay {
+    glm::vec3 origin;
+    glm::vec3 direction;
+    float maxDistance;
+};
+
+struct TerrainRayHit {
+    bool hit;
+    float distance;
+    glm::vec3 position;
+    glm::vec3 normal;
+};
+
+// Half-open rectangle of samples [xBegin, xEnd) x [zBegin, zEnd).
+struct HeightfieldRegion {
+    int xBegin, zBegin;
+    int xEnd, zEnd;
+
+    bool isEmpty() const { return xBegin >= xEnd || zBegin >= zEnd; }
+};
+
+/*
+ * CPU copy of the terrain heights used for gameplay style queries (ground clamping, picking, line of sight).
+ * This class has no OpenGL dependency so it can be used from worker threads and tested on its own.
+ *
+ * Samples are laid out the same way as the terrain vertices: sample (xIndex, zIndex) lives at
+ * heights[zIndex + zCount * xIndex] and sits at world position origin + (xIndex, height, zIndex) * spacing.
+ *
+ * Ray casts are accelerated with a max-height pyramid: level 0 stores the highest corner of every grid cell,
+ * each level above stores the max of a 2x2 block of the level below. A ray that stays above a cell's max height
+ * cannot hit anything inside it, so the traversal can skip the whole block in a single step.
+ */
+class Heightfield
+{
+    public:
+        Heightfield();
+        Heightfield(int xCount, int zCount, std::vector<float> heights, glm::vec3 origin = glm::vec3(0.0f), float spacing = 1.0f);
+
+        float heightAt(float x, float z) const;
+        glm::vec3 normalAt(float x, float z) const;
+        TerrainRayHit raycast(const TerrainRay& ray) const;
+        bool hasLineOfSight(const glm::vec3& from, const glm::vec3& to) const;
+
+        // Batched versions, `pool` may be null to run on the calling thread.
+        void heightsAt(const std::vector<glm::vec2>& points, std::vector<float>& heightsOut, ThreadPool* pool = nullptr) const;
+        void normalsAt(const std::vector<glm::vec2>& points, std::vector<glm::vec3>& normalsOut, ThreadPool* pool = nullptr) const;
+        void raycasts(const std::vector<TerrainRay>& rays, std::vector<TerrainRayHit>& hitsOut, ThreadPool* pool = nullptr) const;
+
+        float sample(int xIndex, int zIndex) const;
+        glm::vec3 samplePosition(int xIndex, int zIndex) const;
+        glm::vec3 sampleNormal(int xIndex, int zIndex) const;
+
+        // Overwrite the samples of `region` (row-major, z fastest) and refresh only the pyramid cells above them.
+        void setRegion(const HeightfieldRegion& region, const std::vector<float>& regionHeights);
+        HeightfieldRegion clampRegion(const HeightfieldRegion& region) const;
+        int getXCount() const;
+        int getZCount() const;
+        glm::vec3 getOrigin() const;
+        float getSpacing() const;
+
+    private:
+        void buildMaxPyramid();
+        void updateMaxPyramid(const HeightfieldRegion& region);
+        float cellMax(int level, int cellX, int cellZ) const;
+        bool intersectCell(const TerrainRay& ray, int cellX, int cellZ, float tMin, float tMax, TerrainRayHit& hit) const;
+
+    private:
+        int xCount, zCount;
+        glm::vec3 origin;
+        float spacing;
+        std::vector<float> heights;
+
+        // maxPyramid[level] is (levelCellsX[level] x levelCellsZ[level]) cells, indexed cellZ + levelCellsZ * cellX.
+        std::vector<std::vector<float>> maxPyramid;
+        std::vector<int> levelCellsX;
+        std::vector<int> levelCellsZ;
+};
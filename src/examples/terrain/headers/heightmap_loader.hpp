@@ -0,0 +1,22 @@
+#pragma once
+
+#include "./tiled_heightmap.hpp"
+
+#include <string>
+
+/*
+ * Load a height map into `image`, picking the decoder from the file extension:
+ *   .png/.bmp/.tga/... - 8 or 16 bit images converted to one channel (luminance), normalised to [0, 1]
+ *   .hdr               - float images converted to one channel (luminance), heights kept as they are
+ *   .r16/.raw          - headerless little endian 16 bit samples, normalised to [0, 1]
+ *   .r32/.f32          - headerless little endian 32 bit float samples
+ *   .htc               - tiled compressed container, see tiled_heightmap.hpp
+ * Headerless formats need `rawWidth`/`rawHeight`; when left at 0 the map is assumed to be square.
+ */
+bool loadHeightmap(const std::string& path, HeightmapImage& image, int rawWidth = 0, int rawHeight = 0, ThreadPool* pool = nullptr);
+
+/*
+ * Load `sourcePath` through the compressed `cachePath` container: the cache is decoded if it exists,
+ * otherwise the source is loaded and the cache written for the next run.
+ */
+bool loadHeightmapCached(const std::string& sourcePath, const std::string& cachePath, HeightmapImage& image, ThreadPool* pool = nullptr);
@@ -6,7 +6,7 @@
 #include <assimp/scene.h>
 #include <assimp/postprocess.h>
 
-#include "../../../../../headers/stb_image.h"
+#include "../../../headers/stb_image.h"
 
 class Model 
 {
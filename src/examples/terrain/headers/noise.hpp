@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/*
+ * Seedable 2D fractal Brownian motion built from gradient (Perlin) noise.
+ *
+ * The same seed always gives the same heights, on any machine: the AVX2 path performs exactly the
+ * same float operations in the same order as the scalar path (no FMA contraction), so both are bit-identical
+ * and the CPU picks whichever it supports at runtime. Samples are evaluated 8 at a time.
+ */
+class FbmNoise
+{
+    public:
+        FbmNoise(uint32_t seed = 1337, int octaves = 6, float frequency = 1.0f / 256.0f, float lacunarity = 2.0f, float gain = 0.5f);
+
+        float sample(float x, float z) const;
+
+        // out[ix + countX * iz] = sample(x0 + ix * step, z0 + iz * step)
+        void sampleGrid(float x0, float z0, float step, int countX, int countZ, float* out) const;
+
+        // Evaluate `count` arbitrary points, 8 lanes at a time when AVX2 is available.
+        void sampleMany(const float* x, const float* z, float* out, size_t count) const;
+
+        uint32_t getSeed() const;
+        static bool hasAvx2();
+
+    private:
+        void sample8Scalar(const float* x, const float* z, float* out) const;
+        void sample8Avx2(const float* x, const float* z, float* out) const;
+
+    private:
+        uint32_t seed;
+        int octaves;
+        float frequency;
+        float lacunarity;
+        float gain;
+
+        // 256 entry permutation, repeated once so lookups of perm[perm[x] + z] never need a second wrap.
+        std::vector<int32_t> permutation;
+        // Per-octave offsets so the octaves don't all share a lattice point at the origin.
+        std::vector<float> octaveOffsetX;
+        std::vector<float> octaveOffsetZ;
+};
@@ -11,13 +11,25 @@
 #include <sstream>
 #include <iostream>
 
+#include "../../../headers/program_cache.hpp"
+#include "../../../headers/shader_reload.hpp"
+
 class Shader
 {
     public:
         unsigned int ID;
+        // The paths, a reload in flight and the uniform caches, for ShaderWatcher (see shader_reload.hpp).
+        ShaderReloader reloader;
+        // Goes through programCache, which loads the linked program from disk when enabled and already built once.
         Shader(const char* vertexPath, const char* fragmentPath);
 
         void use();
+
+        // Cached, and resolved again after every reload.
+        GLint getUniformLocation(const std::string &name) const;
+        // Kept and applied again after every reload.
+        void setUniformBlockBinding(const std::string &name, unsigned int binding);
+
         void setBool(const std::string &name, bool value) const;
         void setInt(const std::string &name, int value) const;
         void setFloat(const std::string &name, float value) const;
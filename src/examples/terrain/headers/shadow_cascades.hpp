@@ -0,0 +1,125 @@
+#pragma once
+
+#include "./frustum.hpp"
+#include "./shader.hpp"
+
+#include <glm/glm.hpp>
+
+#include <string>
+
+struct ShadowCascadeSettings {
+    float shadowDistance = 600.0f;      // shadows end this far from the camera
+    float splitLambda = 0.75f;          // 0 splits the distance evenly, 1 logarithmically
+    float casterDistance = 400.0f;      // how far towards the light casters outside a cascade are still drawn into it
+    unsigned int firstCachedCascade = 2;// cascades from here on are kept between frames
+    float cachePadding = 0.25f;         // cached cascades cover this much more, so the camera can move before they go stale
+    float lightAngleThreshold = 0.5f;   // degrees the light turns before cached cascades are redrawn
+    unsigned int casterChangeThreshold = 0; // casters that may appear or vanish inside a cached cascade before it is redrawn
+};
+
+struct ShadowCascadeStats {
+    float splitFar = 0.0f;              // view depth the cascade ends at
+    float radius = 0.0f;                // half the width it covers, in world units
+    unsigned int casters = 0;           // drawn the last time it was rendered
+    unsigned int renders = 0;
+    bool renderedThisFrame = false;
+    const char* reason = "";            // why it was (last) rendered
+    float gpuMs = 0.0f;                 // of the last render
+};
+
+/*
+ * Cascaded shadow maps for one directional light: the view frustum up to `shadowDistance` is split into cascades,
+ * each with its own layer of a depth texture array, drawn from the light with an orthographic projection.
+ *
+ *     cascades.setLightDirection(towardsSun);
+ *     cascades.update(view, glm::radians(fov), aspect, nearPlane);
+ *     for (unsigned int i = 0; i < cascades.getCascadeCount(); i++)
+ *     {
+ *         if (cascades.beginCascade(i))       // false while a cached cascade is still good
+ *         {
+ *             // draw the casters that pass cascades.getCasterFrustum(i) with cascades.getLightSpaceMatrix(i)
+ *             cascades.endCascade(i, casterCount);
+ *         }
+ *     }
+ *     cascades.bind(shader, unit);          // sampler2DArrayShadow shadowMap and the cascade uniforms
+ *
+ * Each cascade covers the bounding sphere of its slice of the view frustum, which has the same size however the camera
+ * turns, and its centre is snapped to whole shadow map texels, so shadow edges don't crawl when the camera moves.
+ *
+ * The far cascades change the least from frame to frame and cost the most to draw, so from `firstCachedCascade` on they
+ * are drawn a little larger than needed and kept until the camera leaves the padding, the light turns more than
+ * `lightAngleThreshold`, or more than `casterChangeThreshold` casters inside them changed (see markCastersChanged()).
+ */
+class ShadowCascades
+{
+    public:
+        static const unsigned int MAX_CASCADES = 4;
+
+        ShadowCascades(unsigned int cascadeCount = 4, unsigned int resolution = 2048);
+        ~ShadowCascades();
+
+        ShadowCascades(const ShadowCascades&) = delete;
+        ShadowCascades& operator=(const ShadowCascades&) = delete;
+
+        // Direction from the scene towards the light.
+        void setLightDirection(const glm::vec3& towardsLight);
+        // Place the cascades for this frame's camera and decide which of them have to be drawn.
+        void update(const glm::mat4& view, float fovY, float aspect, float nearPlane);
+        // A caster inside the box appeared, disappeared or changed shape.
+        void markCastersChanged(const glm::vec3& boundsMin, const glm::vec3& boundsMax);
+
+        // Bind the cascade's layer for drawing and clear it, or return false if the cached one is still good.
+        // endCascade() binds the previous framebuffer and viewport again.
+        bool beginCascade(unsigned int cascade);
+        void endCascade(unsigned int cascade, unsigned int casters);
+
+        // Shadow map texture on `textureUnit` and the cascade uniforms, `shader` has to be in use.
+        void bind(const Shader& shader, unsigned int textureUnit) const;
+
+        const glm::mat4& getLightSpaceMatrix(unsigned int cascade) const;
+        // To cull casters against: the light's view of the cascade, stretched `casterDistance` towards the light.
+        Frustum getCasterFrustum(unsigned int cascade) const;
+        const ShadowCascadeStats& getStats(unsigned int cascade) const;
+        unsigned int getCascadeCount() const;
+        unsigned int getResolution() const;
+
+        ShadowCascadeSettings settings;
+
+    private:
+        // Where a cascade sits in light space (see lightRotation), as drawn into its layer.
+        struct Placement {
+            glm::vec2 centre;
+            float radius;
+            float minDepth;     // light space z range of the receivers
+            float maxDepth;
+        };
+
+        struct Cascade {
+            Placement drawn;    // what the layer holds
+            glm::mat4 lightSpaceMatrix;
+            glm::vec3 drawnLightDirection;
+            unsigned int changedCasters = 0;
+            bool valid = false;
+            bool pendingRender = false;
+            unsigned int queries[2];
+            bool queryPending[2] = {false, false};
+            ShadowCascadeStats stats;
+        };
+
+        glm::mat4 placementMatrix(const Placement& placement) const;
+        bool covers(const Placement& drawn, const Placement& wanted) const;
+        void readTimer(Cascade& cascade, unsigned int query);
+
+    private:
+        unsigned int cascadeCount;
+        unsigned int resolution;
+        unsigned int depthTexture = 0;
+        unsigned int framebuffer = 0;
+
+        glm::vec3 lightDirection = glm::vec3(0.0f, 1.0f, 0.0f);
+        glm::mat4 lightRotation = glm::mat4(1.0f);
+        unsigned int frameIndex = 0;
+        int savedViewport[4] = {0, 0, 0, 0};
+        int savedFramebuffer = 0;
+        Cascade cascades[MAX_CASCADES];
+};
@@ -0,0 +1,31 @@
+#pragma once
+
+#include "./frustum.hpp"
+#include "./heightfield.hpp"
+
+#include <vector>
+
+// Separates the triangle strips of a chunk so each chunk can be submitted as a single range (see GL_PRIMITIVE_RESTART).
+const unsigned int TERRAIN_RESTART_INDEX = 0xFFFFFFFF;
+
+/*
+ * A square block of the height map grid.
+ * The chunk's strips are stored contiguously in the element buffer starting at `firstIndex`,
+ * and the bounding box covers the min/max height of every vertex in the chunk.
+ */
+struct TerrainChunk {
+    glm::vec3 boundsMin;
+    glm::vec3 boundsMax;
+    unsigned int firstIndex;
+    unsigned int indexCount;
+};
+
+struct TerrainCullStats {
+    unsigned int visibleChunks;
+    unsigned int totalChunks;
+    float cullTimeMs;
+};
+
+std::vector<TerrainChunk> buildTerrainChunks(const Heightfield& heightfield, int chunkSize, std::vector<unsigned int>& indices);
+void updateTerrainChunkBounds(std::vector<TerrainChunk>& chunks, const Heightfield& heightfield, int chunkSize, const HeightfieldRegion& region);
+TerrainCullStats cullTerrainChunks(const std::vector<TerrainChunk>& chunks, const Frustum& frustum, const glm::vec3& eyePos, std::vector<unsigned int>& visibleChunks);
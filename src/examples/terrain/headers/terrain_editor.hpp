@@ -0,0 +1,34 @@
+#pragma once
+
+#include "./heightfield.hpp"
+
+#include <vector>
+
+// Floats per terrain vertex: position (xyz) followed by normal (xyz).
+const int TERRAIN_VERTEX_FLOATS = 6;
+
+enum class TerrainBrushMode {
+    Raise = 0,
+    Lower = 1,
+    Smooth = 2
+};
+
+/*
+ * `radius` is in world units. `strength` is the height change per second at the brush centre;
+ * smoothing moves each sample towards its neighbourhood average at that rate, without overshooting it.
+ * The effect falls off smoothly to zero at the radius.
+ */
+struct TerrainBrush {
+    TerrainBrushMode mode;
+    float radius;
+    float strength;
+};
+
+// Apply `brush` at `center` for `deltaTime` seconds and return the samples it changed (empty if none).
+HeightfieldRegion applyTerrainBrush(Heightfield& heightfield, const TerrainBrush& brush, const glm::vec3& center, float deltaTime);
+
+// Grow `region` by the one sample ring whose normals depend on it, clamped to the grid.
+HeightfieldRegion expandForNormals(const Heightfield& heightfield, const HeightfieldRegion& region);
+
+// Interleaved position + normal for every sample of `region`, row-major with z fastest (same order as the vertex buffer).
+void buildTerrainVertices(const Heightfield& heightfield, const HeightfieldRegion& region, std::vector<float>& vertices);
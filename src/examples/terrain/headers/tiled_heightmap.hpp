@@ -0,0 +1,44 @@
+#pragma once
+
+#include "../../../headers/thread_pool.hpp"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+enum class HeightSampleFormat : uint32_t {
+    UInt16 = 0,     // heights normalised to [0, 1], stored as 16 bit integers
+    Float32 = 1,    // heights stored losslessly as 32 bit floats
+    UInt8 = 2       // heights normalised to [0, 1], stored as 8 bit integers
+};
+
+/*
+ * Height map samples in row-major order (`heights[column + width * row]`).
+ * Integer sources (8 and 16 bit images) are normalised to [0, 1], float sources are kept as they are.
+ * `format` records the source precision, so the samples can be stored again without loss.
+ */
+struct HeightmapImage {
+    int width;
+    int height;
+    HeightSampleFormat format;
+    std::vector<float> heights;
+};
+
+/*
+ * Tiled height map container (.htc).
+ *
+ * The map is cut into square tiles that are compressed independently, so they can be decoded in parallel
+ * (and later streamed individually). Each tile is stored as:
+ *   1. a 2D "gradient" prediction of every sample from its left, upper and upper-left neighbours (left + up - upLeft),
+ *   2. the zig-zag encoded prediction error, which is small for smooth terrain,
+ *   3. Golomb-Rice coding of those errors with a per-tile parameter chosen to minimise the tile size.
+ * Float samples are remapped to order-preserving integers first so both formats share the same coder, losslessly.
+ *
+ * Layout (little endian):
+ *   "HTC1", width, height, tileSize, format, then one (offset, size) pair per tile, then the tile payloads.
+ */
+std::vector<uint8_t> encodeTiledHeightmap(const HeightmapImage& image, int tileSize = 64);
+bool decodeTiledHeightmap(const std::vector<uint8_t>& bytes, HeightmapImage& image, ThreadPool* pool = nullptr);
+
+bool writeTiledHeightmap(const std::string& path, const HeightmapImage& image, int tileSize = 64);
+bool readTiledHeightmap(const std::string& path, HeightmapImage& image, ThreadPool* pool = nullptr);
@@ -0,0 +1,244 @@
+#include "../headers/chunk_streamer.hpp"
+#include "../headers/terrain_chunk.hpp"
+#include "../headers/terrain_editor.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+ChunkStreamer::ChunkStreamer(const FbmNoise& noise, ThreadPool& pool, int chunkSize, float heightScale)
+    : shared(std::make_shared<SharedState>(noise, chunkSize, heightScale)), pool(pool),
+      maxInFlight(pool.size() * 2 + 2), rateWindowStart(std::chrono::high_resolution_clock::now())
+{
+}
+
+// In-flight jobs hold their own reference to the shared state, so there is nothing to wait for.
+ChunkStreamer::~ChunkStreamer()
+{
+}
+
+int ChunkStreamer::getChunkSize() const
+{
+    return shared->chunkSize;
+}
+
+int64_t ChunkStreamer::key(glm::ivec2 coord)
+{
+    return ((int64_t)coord.x << 32) | (uint32_t)coord.y;
+}
+
+void ChunkStreamer::update(const glm::vec3& eyePos, int viewRadius, std::vector<glm::ivec2>& evicted)
+{
+    int chunkSize = shared->chunkSize;
+    centerChunk = glm::ivec2((int)std::floor(eyePos.x / chunkSize), (int)std::floor(eyePos.z / chunkSize));
+
+    // Keep chunks one ring past the view radius so moving back and forth over a border doesn't thrash.
+    int keepRadius2 = (viewRadius + 1) * (viewRadius + 1);
+    for (auto it = chunks.begin(); it != chunks.end();)
+    {
+        glm::ivec2 coord = glm::ivec2((int32_t)(it->first >> 32), (int32_t)(it->first & 0xFFFFFFFF));
+        glm::ivec2 offset = coord - centerChunk;
+        if (offset.x * offset.x + offset.y * offset.y <= keepRadius2)
+        {
+            ++it;
+            continue;
+        }
+        // A pending chunk is forgotten here and dropped when its job finishes.
+        if (it->second == ChunkState::Resident)
+        {
+            evicted.push_back(coord);
+        }
+        it = chunks.erase(it);
+    }
+
+    unsigned int available = maxInFlight - std::min(maxInFlight, shared->inFlight.load());
+    if (available > 0)
+    {
+        std::vector<std::pair<int, glm::ivec2>> missing;
+        int viewRadius2 = viewRadius * viewRadius;
+        for (int dx = -viewRadius; dx <= viewRadius; dx++)
+        {
+            for (int dz = -viewRadius; dz <= viewRadius; dz++)
+            {
+                int distance2 = dx * dx + dz * dz;
+                glm::ivec2 coord = centerChunk + glm::ivec2(dx, dz);
+                if (distance2 <= viewRadius2 && chunks.find(key(coord)) == chunks.end())
+                {
+                    missing.push_back({distance2, coord});
+                }
+            }
+        }
+
+        size_t submitCount = std::min<size_t>(available, missing.size());
+        std::partial_sort(missing.begin(), missing.begin() + submitCount, missing.end(),
+            [](const auto& a, const auto& b) { return a.first < b.first; });
+
+        for (size_t i = 0; i < submitCount; i++)
+        {
+            glm::ivec2 coord = missing[i].second;
+            chunks[key(coord)] = ChunkState::Pending;
+            shared->inFlight++;
+
+            std::shared_ptr<SharedState> state = shared;
+            pool.submit([state, coord]()
+            {
+                auto start = std::chrono::high_resolution_clock::now();
+                GeneratedChunk chunk = generateChunk(state->noise, coord, state->chunkSize, state->heightScale);
+                auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - start);
+
+                state->generationMicroseconds += elapsed.count();
+                state->generated++;
+                {
+                    std::lock_guard<std::mutex> lock(state->finishedMutex);
+                    state->finished.push_back(std::move(chunk));
+                    state->inFlight--;
+                }
+                state->generationDone.notify_all();
+            });
+        }
+    }
+
+    auto now = std::chrono::high_resolution_clock::now();
+    float windowSeconds = std::chrono::duration<float>(now - rateWindowStart).count();
+    if (windowSeconds >= 0.5f)
+    {
+        unsigned int generated = shared->generated.load();
+        chunksPerSecond = (generated - rateWindowGenerated) / windowSeconds;
+        rateWindowGenerated = generated;
+        rateWindowStart = now;
+    }
+}
+
+void ChunkStreamer::takeFinished(size_t budget, std::vector<GeneratedChunk>& ready)
+{
+    std::vector<GeneratedChunk> finished;
+    {
+        std::lock_guard<std::mutex> lock(shared->finishedMutex);
+        finished.swap(shared->finished);
+    }
+
+    // Nearest chunks first, whatever doesn't fit in the budget goes back to the queue for the next frame.
+    // Equally near chunks go by coordinate, not by which worker finished first.
+    std::sort(finished.begin(), finished.end(), [&](const GeneratedChunk& a, const GeneratedChunk& b)
+    {
+        glm::ivec2 da = a.coord - centerChunk, db = b.coord - centerChunk;
+        int distanceA = da.x * da.x + da.y * da.y, distanceB = db.x * db.x + db.y * db.y;
+        if (distanceA != distanceB)
+        {
+            return distanceA < distanceB;
+        }
+        return a.coord.x != b.coord.x ? a.coord.x < b.coord.x : a.coord.y < b.coord.y;
+    });
+
+    std::vector<GeneratedChunk> deferred;
+    for (GeneratedChunk& chunk : finished)
+    {
+        auto it = chunks.find(key(chunk.coord));
+        if (it == chunks.end() || it->second != ChunkState::Pending)
+        {
+            continue;
+        }
+        if (budget == 0)
+        {
+            deferred.push_back(std::move(chunk));
+            continue;
+        }
+        it->second = ChunkState::Resident;
+        ready.push_back(std::move(chunk));
+        budget--;
+    }
+
+    if (!deferred.empty())
+    {
+        std::lock_guard<std::mutex> lock(shared->finishedMutex);
+        for (GeneratedChunk& chunk : deferred)
+        {
+            shared->finished.push_back(std::move(chunk));
+        }
+    }
+}
+
+void ChunkStreamer::waitForGeneration() const
+{
+    // a job leaves inFlight under the same lock that puts its chunk in `finished`, then wakes this
+    std::unique_lock<std::mutex> lock(shared->finishedMutex);
+    shared->generationDone.wait(lock, [this]() { return shared->inFlight.load() == 0; });
+}
+
+ChunkStreamerStats ChunkStreamer::getStats() const
+{
+    unsigned int resident = std::count_if(chunks.begin(), chunks.end(), [](const auto& entry) { return entry.second == ChunkState::Resident; });
+    unsigned int generated = shared->generated.load();
+    float averageMs = generated > 0 ? shared->generationMicroseconds.load() / 1000.0f / generated : 0.0f;
+    return {resident, (unsigned int)chunks.size() - resident, generated, chunksPerSecond, averageMs};
+}
+
+/*
+ * The noise is sampled with a one sample border so normals on the chunk edges use the neighbouring chunk's
+ * heights, which keeps lighting continuous across chunk seams.
+ */
+GeneratedChunk ChunkStreamer::generateChunk(const FbmNoise& noise, glm::ivec2 coord, int chunkSize, float heightScale)
+{
+    int vertexCount = chunkSize + 1;
+    int sampleCount = vertexCount + 2;
+    float originX = (float)coord.x * chunkSize;
+    float originZ = (float)coord.y * chunkSize;
+
+    std::vector<float> heights((size_t)sampleCount * sampleCount);
+    noise.sampleGrid(originX - 1.0f, originZ - 1.0f, 1.0f, sampleCount, sampleCount, heights.data());
+    for (float& height : heights)
+    {
+        height *= heightScale;
+    }
+    // sampleGrid is x fastest, unlike the vertices which are z fastest.
+    auto heightAt = [&](int i, int j) { return heights[(i + 1) + sampleCount * (j + 1)]; };
+
+    GeneratedChunk chunk;
+    chunk.coord = coord;
+    chunk.vertices.resize((size_t)vertexCount * vertexCount * TERRAIN_VERTEX_FLOATS);
+    chunk.boundsMin = glm::vec3(originX, std::numeric_limits<float>::max(), originZ);
+    chunk.boundsMax = glm::vec3(originX + chunkSize, std::numeric_limits<float>::lowest(), originZ + chunkSize);
+
+    float* vertex = chunk.vertices.data();
+    for (int i = 0; i < vertexCount; i++)
+    {
+        for (int j = 0; j < vertexCount; j++)
+        {
+            float height = heightAt(i, j);
+            glm::vec3 normal = glm::normalize(glm::vec3(heightAt(i - 1, j) - heightAt(i + 1, j), 2.0f, heightAt(i, j - 1) - heightAt(i, j + 1)));
+
+            vertex[0] = originX + i;
+            vertex[1] = height;
+            vertex[2] = originZ + j;
+            vertex[3] = normal.x;
+            vertex[4] = normal.y;
+            vertex[5] = normal.z;
+            vertex += TERRAIN_VERTEX_FLOATS;
+
+            chunk.boundsMin.y = std::min(chunk.boundsMin.y, height);
+            chunk.boundsMax.y = std::max(chunk.boundsMax.y, height);
+        }
+    }
+    return chunk;
+}
+
+std::vector<unsigned int> buildChunkStripIndices(int chunkSize)
+{
+    int vertexCount = chunkSize + 1;
+    std::vector<unsigned int> indices;
+    for (int i = 0; i < chunkSize; i++)           // for each row a.k.a. each strip
+    {
+        if (i > 0)
+        {
+            indices.push_back(TERRAIN_RESTART_INDEX);
+        }
+        for (int j = 0; j < vertexCount; j++)      // for each column
+        {
+            for (int k = 0; k < 2; k++)              // for each side of the strip
+            {
+                indices.push_back(j + vertexCount * (i + k));
+            }
+        }
+    }
+    return indices;
+}
@@ -0,0 +1,44 @@
+#include "../headers/frustum.hpp"
+
+Frustum::Frustum(const glm::mat4& projectionView)
+{
+    // glm matrices are column-major, so row `i` of the matrix is (m[0][i], m[1][i], m[2][i], m[3][i]).
+    glm::vec4 row0 = glm::vec4(projectionView[0][0], projectionView[1][0], projectionView[2][0], projectionView[3][0]);
+    glm::vec4 row1 = glm::vec4(projectionView[0][1], projectionView[1][1], projectionView[2][1], projectionView[3][1]);
+    glm::vec4 row2 = glm::vec4(projectionView[0][2], projectionView[1][2], projectionView[2][2], projectionView[3][2]);
+    glm::vec4 row3 = glm::vec4(projectionView[0][3], projectionView[1][3], projectionView[2][3], projectionView[3][3]);
+
+    planes[0] = row3 + row0; // left
+    planes[1] = row3 - row0; // right
+    planes[2] = row3 + row1; // bottom
+    planes[3] = row3 - row1; // top
+    planes[4] = row3 + row2; // near
+    planes[5] = row3 - row2; // far
+
+    for (unsigned int i = 0; i < 6; i++)
+    {
+        planes[i] /= glm::length(glm::vec3(planes[i]));
+    }
+}
+
+/*
+ * Test the box against each plane using the "positive vertex": the corner of the box furthest along the plane normal.
+ * If that corner is behind any plane then the whole box is outside the frustum.
+ * This is conservative - a few boxes near the frustum corners will pass even though they are not visible.
+ */
+bool Frustum::isBoxVisible(const glm::vec3& boxMin, const glm::vec3& boxMax) const
+{
+    for (unsigned int i = 0; i < 6; i++)
+    {
+        glm::vec3 positiveVertex = glm::vec3(
+            planes[i].x >= 0.0f ? boxMax.x : boxMin.x,
+            planes[i].y >= 0.0f ? boxMax.y : boxMin.y,
+            planes[i].z >= 0.0f ? boxMax.z : boxMin.z);
+
+        if (glm::dot(glm::vec3(planes[i]), positiveVertex) + planes[i].w < 0.0f)
+        {
+            return false;
+        }
+    }
+    return true;
+}
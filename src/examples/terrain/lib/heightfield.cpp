@@ -0,0 +1,459 @@
+#include "../headers/heightfield.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+const size_t QUERY_BATCH_SIZE = 256;
+
+Heightfield::Heightfield() : xCount(0), zCount(0), origin(0.0f), spacing(1.0f)
+{
+}
+
+Heightfield::Heightfield(int xCount, int zCount, std::vector<float> heights, glm::vec3 origin, float spacing)
+    : xCount(xCount), zCount(zCount), origin(origin), spacing(spacing), heights(std::move(heights))
+{
+    buildMaxPyramid();
+}
+
+float Heightfield::sample(int xIndex, int zIndex) const
+{
+    xIndex = std::clamp(xIndex, 0, xCount - 1);
+    zIndex = std::clamp(zIndex, 0, zCount - 1);
+    return heights[zIndex + zCount * xIndex];
+}
+
+glm::vec3 Heightfield::samplePosition(int xIndex, int zIndex) const
+{
+    return origin + glm::vec3(xIndex * spacing, sample(xIndex, zIndex), zIndex * spacing);
+}
+
+// Central differences on the grid, matching normalAt() at sample positions.
+glm::vec3 Heightfield::sampleNormal(int xIndex, int zIndex) const
+{
+    float dx = sample(xIndex - 1, zIndex) - sample(xIndex + 1, zIndex);
+    float dz = sample(xIndex, zIndex - 1) - sample(xIndex, zIndex + 1);
+    return glm::normalize(glm::vec3(dx, 2.0f * spacing, dz));
+}
+
+HeightfieldRegion Heightfield::clampRegion(const HeightfieldRegion& region) const
+{
+    return {std::max(region.xBegin, 0), std::max(region.zBegin, 0), std::min(region.xEnd, xCount), std::min(region.zEnd, zCount)};
+}
+
+void Heightfield::setRegion(const HeightfieldRegion& region, const std::vector<float>& regionHeights)
+{
+    int regionZCount = region.zEnd - region.zBegin;
+    for (int x = region.xBegin; x < region.xEnd; x++)
+    {
+        std::copy_n(&regionHeights[(x - region.xBegin) * regionZCount], regionZCount, &heights[region.zBegin + zCount * x]);
+    }
+    updateMaxPyramid(region);
+}
+
+int Heightfield::getXCount() const
+{
+    return xCount;
+}
+
+int Heightfield::getZCount() const
+{
+    return zCount;
+}
+
+glm::vec3 Heightfield::getOrigin() const
+{
+    return origin;
+}
+
+float Heightfield::getSpacing() const
+{
+    return spacing;
+}
+
+/*
+ * Bilinear interpolation of the 4 samples surrounding (x, z).
+ * Positions outside the grid are clamped to the nearest edge.
+ */
+float Heightfield::heightAt(float x, float z) const
+{
+    if (xCount < 2 || zCount < 2)
+    {
+        return 0.0f;
+    }
+
+    float gridX = std::clamp((x - origin.x) / spacing, 0.0f, (float)(xCount - 1));
+    float gridZ = std::clamp((z - origin.z) / spacing, 0.0f, (float)(zCount - 1));
+
+    int xIndex = std::min((int)gridX, xCount - 2);
+    int zIndex = std::min((int)gridZ, zCount - 2);
+    float tx = gridX - xIndex;
+    float tz = gridZ - zIndex;
+
+    float h00 = heights[zIndex + zCount * xIndex];
+    float h10 = heights[zIndex + zCount * (xIndex + 1)];
+    float h01 = heights[(zIndex + 1) + zCount * xIndex];
+    float h11 = heights[(zIndex + 1) + zCount * (xIndex + 1)];
+
+    float h0 = h00 + (h10 - h00) * tx;
+    float h1 = h01 + (h11 - h01) * tx;
+    return origin.y + h0 + (h1 - h0) * tz;
+}
+
+// Central differences over one grid spacing of the bilinear surface.
+glm::vec3 Heightfield::normalAt(float x, float z) const
+{
+    float dx = heightAt(x - spacing, z) - heightAt(x + spacing, z);
+    float dz = heightAt(x, z - spacing) - heightAt(x, z + spacing);
+    return glm::normalize(glm::vec3(dx, 2.0f * spacing, dz));
+}
+
+void Heightfield::buildMaxPyramid()
+{
+    maxPyramid.clear();
+    levelCellsX.clear();
+    levelCellsZ.clear();
+
+    if (xCount < 2 || zCount < 2)
+    {
+        return;
+    }
+
+    // Level 0: one entry per grid cell, the highest of its 4 corners.
+    // The rendered triangles (and the bilinear patch) never rise above their corners, so this bound is exact.
+    int cellsX = xCount - 1;
+    int cellsZ = zCount - 1;
+    std::vector<float> level0(cellsX * cellsZ);
+    for (int cx = 0; cx < cellsX; cx++)
+    {
+        for (int cz = 0; cz < cellsZ; cz++)
+        {
+            level0[cz + cellsZ * cx] = std::max(
+                std::max(heights[cz + zCount * cx], heights[(cz + 1) + zCount * cx]),
+                std::max(heights[cz + zCount * (cx + 1)], heights[(cz + 1) + zCount * (cx + 1)]));
+        }
+    }
+    maxPyramid.push_back(std::move(level0));
+    levelCellsX.push_back(cellsX);
+    levelCellsZ.push_back(cellsZ);
+
+    while (cellsX > 1 || cellsZ > 1)
+    {
+        int parentX = (cellsX + 1) / 2;
+        int parentZ = (cellsZ + 1) / 2;
+        const std::vector<float>& child = maxPyramid.back();
+        std::vector<float> parent(parentX * parentZ, std::numeric_limits<float>::lowest());
+
+        for (int cx = 0; cx < cellsX; cx++)
+        {
+            for (int cz = 0; cz < cellsZ; cz++)
+            {
+                float& value = parent[(cz / 2) + parentZ * (cx / 2)];
+                value = std::max(value, child[cz + cellsZ * cx]);
+            }
+        }
+
+        maxPyramid.push_back(std::move(parent));
+        levelCellsX.push_back(parentX);
+        levelCellsZ.push_back(parentZ);
+        cellsX = parentX;
+        cellsZ = parentZ;
+    }
+}
+
+/*
+ * Recompute the level 0 cells touching the changed samples, then walk up the pyramid
+ * recomputing only the parents of those cells. Cost is proportional to the region, not the map.
+ */
+void Heightfield::updateMaxPyramid(const HeightfieldRegion& region)
+{
+    if (maxPyramid.empty() || region.isEmpty())
+    {
+        return;
+    }
+
+    // A sample is a corner of the cells to its lower-left up to itself.
+    int cellXBegin = std::max(region.xBegin - 1, 0);
+    int cellZBegin = std::max(region.zBegin - 1, 0);
+    int cellXEnd = std::min(region.xEnd, levelCellsX[0]);
+    int cellZEnd = std::min(region.zEnd, levelCellsZ[0]);
+
+    for (int cx = cellXBegin; cx < cellXEnd; cx++)
+    {
+        for (int cz = cellZBegin; cz < cellZEnd; cz++)
+        {
+            maxPyramid[0][cz + levelCellsZ[0] * cx] = std::max(
+                std::max(heights[cz + zCount * cx], heights[(cz + 1) + zCount * cx]),
+                std::max(heights[cz + zCount * (cx + 1)], heights[(cz + 1) + zCount * (cx + 1)]));
+        }
+    }
+
+    for (size_t level = 1; level < maxPyramid.size(); level++)
+    {
+        cellXBegin /= 2;
+        cellZBegin /= 2;
+        cellXEnd = (cellXEnd + 1) / 2;
+        cellZEnd = (cellZEnd + 1) / 2;
+
+        const std::vector<float>& child = maxPyramid[level - 1];
+        int childX = levelCellsX[level - 1];
+        int childZ = levelCellsZ[level - 1];
+        for (int px = cellXBegin; px < cellXEnd; px++)
+        {
+            for (int pz = cellZBegin; pz < cellZEnd; pz++)
+            {
+                float value = std::numeric_limits<float>::lowest();
+                for (int cx = px * 2; cx < std::min(px * 2 + 2, childX); cx++)
+                {
+                    for (int cz = pz * 2; cz < std::min(pz * 2 + 2, childZ); cz++)
+                    {
+                        value = std::max(value, child[cz + childZ * cx]);
+                    }
+                }
+                maxPyramid[level][pz + levelCellsZ[level] * px] = value;
+            }
+        }
+    }
+}
+
+float Heightfield::cellMax(int level, int cellX, int cellZ) const
+{
+    return origin.y + maxPyramid[level][cellZ + levelCellsZ[level] * cellX];
+}
+
+/*
+ * Exact test against the two triangles the terrain strips render for this cell.
+ * The strip order (x, z), (x+1, z), (x, z+1), (x+1, z+1) splits each cell along the (x+1, z) -> (x, z+1) diagonal.
+ */
+bool Heightfield::intersectCell(const TerrainRay& ray, int cellX, int cellZ, float tMin, float tMax, TerrainRayHit& hit) const
+{
+    auto corner = [&](int xIndex, int zIndex)
+    {
+        return origin + glm::vec3(xIndex * spacing, heights[zIndex + zCount * xIndex], zIndex * spacing);
+    };
+
+    glm::vec3 p00 = corner(cellX, cellZ);
+    glm::vec3 p10 = corner(cellX + 1, cellZ);
+    glm::vec3 p01 = corner(cellX, cellZ + 1);
+    glm::vec3 p11 = corner(cellX + 1, cellZ + 1);
+
+    const glm::vec3 triangles[2][3] = {{p00, p10, p01}, {p10, p01, p11}};
+
+    bool found = false;
+    float closest = tMax;
+    for (const auto& triangle : triangles)
+    {
+        // Möller–Trumbore ray/triangle intersection (two sided).
+        glm::vec3 edge1 = triangle[1] - triangle[0];
+        glm::vec3 edge2 = triangle[2] - triangle[0];
+        glm::vec3 p = glm::cross(ray.direction, edge2);
+        float determinant = glm::dot(edge1, p);
+        if (std::abs(determinant) < 1e-12f)
+        {
+            continue;
+        }
+        float inverseDeterminant = 1.0f / determinant;
+        glm::vec3 s = ray.origin - triangle[0];
+        float u = glm::dot(s, p) * inverseDeterminant;
+        if (u < 0.0f || u > 1.0f)
+        {
+            continue;
+        }
+        glm::vec3 q = glm::cross(s, edge1);
+        float v = glm::dot(ray.direction, q) * inverseDeterminant;
+        if (v < 0.0f || u + v > 1.0f)
+        {
+            continue;
+        }
+        float t = glm::dot(edge2, q) * inverseDeterminant;
+        if (t >= tMin && t <= closest)
+        {
+            glm::vec3 normal = glm::normalize(glm::cross(edge1, edge2));
+            hit.normal = normal.y < 0.0f ? -normal : normal;
+            closest = t;
+            found = true;
+        }
+    }
+
+    if (found)
+    {
+        hit.hit = true;
+        hit.distance = closest;
+        hit.position = ray.origin + ray.direction * closest;
+    }
+    return found;
+}
+
+/*
+ * Conservative hierarchical DDA over the max-height pyramid.
+ *
+ * At each step the ray is inside one cell of the current level, spanning [t, tExit] along the ray.
+ * - If the lowest point of the ray over that span is above the cell's max height, the whole cell is skipped
+ *   and the traversal moves up a level to try taking an even bigger step.
+ * - Otherwise the traversal descends a level, until at level 0 the cell's triangles are tested exactly.
+ * Every skip is justified by an upper bound on the terrain, so no intersection can be missed.
+ */
+TerrainRayHit Heightfield::raycast(const TerrainRay& inputRay) const
+{
+    TerrainRayHit hit = {false, 0.0f, glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f)};
+    if (maxPyramid.empty() || glm::length(inputRay.direction) == 0.0f)
+    {
+        return hit;
+    }
+
+    TerrainRay ray = inputRay;
+    ray.direction = glm::normalize(inputRay.direction);
+
+    // Clip the ray against the bounding box of the whole terrain.
+    int topLevel = maxPyramid.size() - 1;
+    glm::vec3 boundsMin = origin + glm::vec3(0.0f, std::numeric_limits<float>::lowest(), 0.0f);
+    glm::vec3 boundsMax = origin + glm::vec3((xCount - 1) * spacing, 0.0f, (zCount - 1) * spacing);
+    boundsMax.y = cellMax(topLevel, 0, 0);
+
+    float tStart = 0.0f;
+    float tEnd = ray.maxDistance;
+    for (int axis = 0; axis < 3; axis++)
+    {
+        if (ray.direction[axis] == 0.0f)
+        {
+            if (ray.origin[axis] < boundsMin[axis] || ray.origin[axis] > boundsMax[axis])
+            {
+                return hit;
+            }
+            continue;
+        }
+        float t0 = (boundsMin[axis] - ray.origin[axis]) / ray.direction[axis];
+        float t1 = (boundsMax[axis] - ray.origin[axis]) / ray.direction[axis];
+        tStart = std::max(tStart, std::min(t0, t1));
+        tEnd = std::min(tEnd, std::max(t0, t1));
+    }
+    if (tStart > tEnd)
+    {
+        return hit;
+    }
+
+    // Small distance used to move strictly past a cell boundary, it grows with `t` so it never drops below float precision.
+    auto tolerance = [&](float tAlongRay)
+    {
+        return 1e-4f * spacing + std::abs(tAlongRay) * 1e-6f;
+    };
+
+    int level = topLevel;
+    float t = tStart;
+    while (t <= tEnd)
+    {
+        glm::vec3 position = ray.origin + ray.direction * t;
+        float cellSize = spacing * (float)(1 << level);
+
+        int cellX = std::clamp((int)std::floor((position.x - origin.x) / cellSize), 0, levelCellsX[level] - 1);
+        int cellZ = std::clamp((int)std::floor((position.z - origin.z) / cellSize), 0, levelCellsZ[level] - 1);
+
+        float x0 = origin.x + cellX * cellSize;
+        float z0 = origin.z + cellZ * cellSize;
+        float tExitX = ray.direction.x > 0.0f ? (x0 + cellSize - ray.origin.x) / ray.direction.x
+                     : ray.direction.x < 0.0f ? (x0 - ray.origin.x) / ray.direction.x
+                     : std::numeric_limits<float>::max();
+        float tExitZ = ray.direction.z > 0.0f ? (z0 + cellSize - ray.origin.z) / ray.direction.z
+                     : ray.direction.z < 0.0f ? (z0 - ray.origin.z) / ray.direction.z
+                     : std::numeric_limits<float>::max();
+        // Clamping the cell index at the grid border can put the computed exit behind the current position.
+        float tExit = std::max(std::min(std::min(tExitX, tExitZ), tEnd), t);
+
+        float lowestRayY = std::min(ray.origin.y + ray.direction.y * t, ray.origin.y + ray.direction.y * tExit);
+        if (lowestRayY > cellMax(level, cellX, cellZ))
+        {
+            t = tExit + tolerance(tExit);
+            level = std::min(level + 1, topLevel);
+            continue;
+        }
+
+        if (level > 0)
+        {
+            level--;
+            continue;
+        }
+
+        if (intersectCell(ray, cellX, cellZ, std::max(t - tolerance(t), 0.0f), std::min(tExit + tolerance(tExit), tEnd), hit))
+        {
+            return hit;
+        }
+        t = tExit + tolerance(tExit);
+    }
+
+    return hit;
+}
+
+bool Heightfield::hasLineOfSight(const glm::vec3& from, const glm::vec3& to) const
+{
+    float distance = glm::length(to - from);
+    if (distance == 0.0f)
+    {
+        return true;
+    }
+    TerrainRay ray = {from, (to - from) / distance, distance};
+    return !raycast(ray).hit;
+}
+
+void Heightfield::heightsAt(const std::vector<glm::vec2>& points, std::vector<float>& heightsOut, ThreadPool* pool) const
+{
+    heightsOut.resize(points.size());
+    auto body = [&](size_t begin, size_t end)
+    {
+        for (size_t i = begin; i < end; i++)
+        {
+            heightsOut[i] = heightAt(points[i].x, points[i].y);
+        }
+    };
+
+    if (pool)
+    {
+        pool->parallelFor(points.size(), QUERY_BATCH_SIZE, body);
+    }
+    else
+    {
+        body(0, points.size());
+    }
+}
+
+void Heightfield::normalsAt(const std::vector<glm::vec2>& points, std::vector<glm::vec3>& normalsOut, ThreadPool* pool) const
+{
+    normalsOut.resize(points.size());
+    auto body = [&](size_t begin, size_t end)
+    {
+        for (size_t i = begin; i < end; i++)
+        {
+            normalsOut[i] = normalAt(points[i].x, points[i].y);
+        }
+    };
+
+    if (pool)
+    {
+        pool->parallelFor(points.size(), QUERY_BATCH_SIZE, body);
+    }
+    else
+    {
+        body(0, points.size());
+    }
+}
+
+void Heightfield::raycasts(const std::vector<TerrainRay>& rays, std::vector<TerrainRayHit>& hitsOut, ThreadPool* pool) const
+{
+    hitsOut.resize(rays.size());
+    auto body = [&](size_t begin, size_t end)
+    {
+        for (size_t i = begin; i < end; i++)
+        {
+            hitsOut[i] = raycast(rays[i]);
+        }
+    };
+
+    // Ray casts are far more expensive than height lookups, so hand them out in smaller batches.
+    if (pool)
+    {
+        pool->parallelFor(rays.size(), QUERY_BATCH_SIZE / 8, body);
+    }
+    else
+    {
+        body(0, rays.size());
+    }
+}
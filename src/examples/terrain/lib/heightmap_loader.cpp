@@ -0,0 +1,153 @@
+#include "../headers/heightmap_loader.hpp"
+#include "../../../headers/stb_image.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+
+namespace
+{
+    std::string lowerCaseExtension(const std::string& path)
+    {
+        std::string extension = std::filesystem::path(path).extension().string();
+        std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return std::tolower(c); });
+        return extension;
+    }
+
+    bool loadRawHeightmap(const std::string& path, HeightmapImage& image, int width, int height, size_t bytesPerSample)
+    {
+        std::ifstream file(path, std::ios::binary);
+        if (!file)
+        {
+            std::cout << "ERROR::HEIGHTMAP::FILE_NOT_FOUND: " << path << std::endl;
+            return false;
+        }
+        std::vector<uint8_t> bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+        size_t sampleCount = bytes.size() / bytesPerSample;
+        if (width <= 0 || height <= 0)
+        {
+            width = height = (int)std::lround(std::sqrt((double)sampleCount));
+        }
+        if ((size_t)width * height != sampleCount || sampleCount * bytesPerSample != bytes.size())
+        {
+            std::cout << "ERROR::HEIGHTMAP::RAW_SIZE_MISMATCH: " << path << " holds " << bytes.size() << " bytes" << std::endl;
+            return false;
+        }
+
+        image.width = width;
+        image.height = height;
+        image.heights.resize(sampleCount);
+        for (size_t i = 0; i < sampleCount; i++)
+        {
+            if (bytesPerSample == 2)
+            {
+                uint16_t sample = bytes[i * 2] | (bytes[i * 2 + 1] << 8);
+                image.heights[i] = sample / 65535.0f;
+            }
+            else
+            {
+                std::memcpy(&image.heights[i], &bytes[i * 4], 4);
+            }
+        }
+        image.format = bytesPerSample == 2 ? HeightSampleFormat::UInt16 : HeightSampleFormat::Float32;
+        return true;
+    }
+
+    bool loadImageHeightmap(const std::string& path, HeightmapImage& image)
+    {
+        int width, height, nChannels;
+        if (stbi_is_hdr(path.c_str()))
+        {
+            float* data = stbi_loadf(path.c_str(), &width, &height, &nChannels, 1);
+            if (!data)
+            {
+                std::cout << "ERROR::HEIGHTMAP::FAILED_TO_LOAD: " << path << std::endl;
+                return false;
+            }
+            image.heights.assign(data, data + width * height);
+            image.format = HeightSampleFormat::Float32;
+            stbi_image_free(data);
+        }
+        else if (stbi_is_16_bit(path.c_str()))
+        {
+            unsigned short* data = stbi_load_16(path.c_str(), &width, &height, &nChannels, 1);
+            if (!data)
+            {
+                std::cout << "ERROR::HEIGHTMAP::FAILED_TO_LOAD: " << path << std::endl;
+                return false;
+            }
+            image.heights.resize(width * height);
+            for (int i = 0; i < width * height; i++)
+            {
+                image.heights[i] = data[i] / 65535.0f;
+            }
+            image.format = HeightSampleFormat::UInt16;
+            stbi_image_free(data);
+        }
+        else
+        {
+            unsigned char* data = stbi_load(path.c_str(), &width, &height, &nChannels, 1);
+            if (!data)
+            {
+                std::cout << "ERROR::HEIGHTMAP::FAILED_TO_LOAD: " << path << std::endl;
+                return false;
+            }
+            image.heights.resize(width * height);
+            for (int i = 0; i < width * height; i++)
+            {
+                image.heights[i] = data[i] / 255.0f;
+            }
+            image.format = HeightSampleFormat::UInt8;
+            stbi_image_free(data);
+        }
+
+        image.width = width;
+        image.height = height;
+        return true;
+    }
+}
+
+bool loadHeightmap(const std::string& path, HeightmapImage& image, int rawWidth, int rawHeight, ThreadPool* pool)
+{
+    std::string extension = lowerCaseExtension(path);
+    if (extension == ".htc")
+    {
+        return readTiledHeightmap(path, image, pool);
+    }
+    if (extension == ".r16" || extension == ".raw")
+    {
+        return loadRawHeightmap(path, image, rawWidth, rawHeight, 2);
+    }
+    if (extension == ".r32" || extension == ".f32")
+    {
+        return loadRawHeightmap(path, image, rawWidth, rawHeight, 4);
+    }
+    return loadImageHeightmap(path, image);
+}
+
+bool loadHeightmapCached(const std::string& sourcePath, const std::string& cachePath, HeightmapImage& image, ThreadPool* pool)
+{
+    std::error_code error;
+    if (std::filesystem::exists(cachePath, error) &&
+        std::filesystem::last_write_time(cachePath, error) >= std::filesystem::last_write_time(sourcePath, error) &&
+        readTiledHeightmap(cachePath, image, pool))
+    {
+        return true;
+    }
+
+    if (!loadHeightmap(sourcePath, image))
+    {
+        return false;
+    }
+    if (!writeTiledHeightmap(cachePath, image))
+    {
+        std::cout << "WARNING::HEIGHTMAP::FAILED_TO_WRITE_CACHE: " << cachePath << std::endl;
+    }
+    return true;
+}
@@ -0,0 +1,229 @@
+#include "../headers/noise.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define NOISE_X86 1
+#endif
+
+namespace
+{
+    const int LANES = 8;
+
+    // 8 gradient directions, indexed by the low 3 bits of the lattice hash.
+    const float GRADIENT_X[8] = {1.0f, -1.0f, 1.0f, -1.0f, 1.0f, -1.0f, 0.0f, 0.0f};
+    const float GRADIENT_Z[8] = {1.0f, 1.0f, -1.0f, -1.0f, 0.0f, 0.0f, 1.0f, -1.0f};
+}
+
+FbmNoise::FbmNoise(uint32_t seed, int octaves, float frequency, float lacunarity, float gain)
+    : seed(seed), octaves(octaves), frequency(frequency), lacunarity(lacunarity), gain(gain)
+{
+    // std::shuffle's output isn't specified by the standard, so shuffle by hand to stay deterministic across compilers.
+    std::mt19937 generator(seed);
+    permutation.resize(512);
+    for (int i = 0; i < 256; i++)
+    {
+        permutation[i] = i;
+    }
+    for (int i = 255; i > 0; i--)
+    {
+        std::swap(permutation[i], permutation[generator() % (i + 1)]);
+    }
+    for (int i = 0; i < 256; i++)
+    {
+        permutation[i + 256] = permutation[i];
+    }
+
+    for (int i = 0; i < octaves; i++)
+    {
+        octaveOffsetX.push_back((generator() % 65536) / 256.0f);
+        octaveOffsetZ.push_back((generator() % 65536) / 256.0f);
+    }
+}
+
+uint32_t FbmNoise::getSeed() const
+{
+    return seed;
+}
+
+bool FbmNoise::hasAvx2()
+{
+#ifdef NOISE_X86
+    static const bool supported = __builtin_cpu_supports("avx2");
+    return supported;
+#else
+    return false;
+#endif
+}
+
+
+void FbmNoise::sampleMany(const float* x, const float* z, float* out, size_t count) const
+{
+    bool avx2 = hasAvx2();
+    size_t i = 0;
+    for (; i + LANES <= count; i += LANES)
+    {
+        avx2 ? sample8Avx2(x + i, z + i, out + i) : sample8Scalar(x + i, z + i, out + i);
+    }
+    if (i < count)
+    {
+        float xs[LANES] = {}, zs[LANES] = {}, tail[LANES];
+        std::copy(x + i, x + count, xs);
+        std::copy(z + i, z + count, zs);
+        avx2 ? sample8Avx2(xs, zs, tail) : sample8Scalar(xs, zs, tail);
+        std::copy(tail, tail + (count - i), out + i);
+    }
+}
+
+void FbmNoise::sampleGrid(float x0, float z0, float step, int countX, int countZ, float* out) const
+{
+    std::vector<float> xs(countX), zs(countX);
+    for (int ix = 0; ix < countX; ix++)
+    {
+        xs[ix] = x0 + ix * step;
+    }
+    for (int iz = 0; iz < countZ; iz++)
+    {
+        std::fill(zs.begin(), zs.end(), z0 + iz * step);
+        sampleMany(xs.data(), zs.data(), out + (size_t)countX * iz, countX);
+    }
+}
+
+/*
+ * Reference implementation.
+ * Every arithmetic step is written out so sample8Avx2 can mirror it instruction for instruction.
+ */
+float FbmNoise::sample(float x, float z) const
+{
+    float sum = 0.0f;
+    float amplitude = 1.0f;
+    float octaveFrequency = frequency;
+
+    for (int octave = 0; octave < octaves; octave++)
+    {
+        float px = x * octaveFrequency + octaveOffsetX[octave];
+        float pz = z * octaveFrequency + octaveOffsetZ[octave];
+        float cellX = std::floor(px);
+        float cellZ = std::floor(pz);
+        int ix = (int)cellX & 255;
+        int iz = (int)cellZ & 255;
+        float fx = px - cellX;
+        float fz = pz - cellZ;
+
+        // quintic fade, t^3 * (t * (t * 6 - 15) + 10)
+        float u = fx * fx * fx * ((fx * 6.0f - 15.0f) * fx + 10.0f);
+        float v = fz * fz * fz * ((fz * 6.0f - 15.0f) * fz + 10.0f);
+
+        int a = permutation[ix];
+        int b = permutation[ix + 1];
+        int h00 = permutation[a + iz] & 7;
+        int h10 = permutation[b + iz] & 7;
+        int h01 = permutation[a + iz + 1] & 7;
+        int h11 = permutation[b + iz + 1] & 7;
+
+        float n00 = GRADIENT_X[h00] * fx + GRADIENT_Z[h00] * fz;
+        float n10 = GRADIENT_X[h10] * (fx - 1.0f) + GRADIENT_Z[h10] * fz;
+        float n01 = GRADIENT_X[h01] * fx + GRADIENT_Z[h01] * (fz - 1.0f);
+        float n11 = GRADIENT_X[h11] * (fx - 1.0f) + GRADIENT_Z[h11] * (fz - 1.0f);
+
+        float nx0 = n00 + u * (n10 - n00);
+        float nx1 = n01 + u * (n11 - n01);
+        sum = sum + amplitude * (nx0 + v * (nx1 - nx0));
+
+        amplitude = amplitude * gain;
+        octaveFrequency = octaveFrequency * lacunarity;
+    }
+    return sum;
+}
+
+void FbmNoise::sample8Scalar(const float* x, const float* z, float* out) const
+{
+    for (int lane = 0; lane < LANES; lane++)
+    {
+        out[lane] = sample(x[lane], z[lane]);
+    }
+}
+
+#ifdef NOISE_X86
+namespace
+{
+    // quintic fade, t^3 * (t * (t * 6 - 15) + 10)
+    __attribute__((target("avx2")))
+    inline __m256 fade8(__m256 t)
+    {
+        __m256 inner = _mm256_add_ps(_mm256_mul_ps(_mm256_sub_ps(_mm256_mul_ps(t, _mm256_set1_ps(6.0f)), _mm256_set1_ps(15.0f)), t), _mm256_set1_ps(10.0f));
+        return _mm256_mul_ps(_mm256_mul_ps(_mm256_mul_ps(t, t), t), inner);
+    }
+
+    __attribute__((target("avx2")))
+    inline __m256 gradient8(__m256i hash, __m256 dx, __m256 dz)
+    {
+        __m256i index = _mm256_and_si256(hash, _mm256_set1_epi32(7));
+        __m256 gx = _mm256_i32gather_ps(GRADIENT_X, index, 4);
+        __m256 gz = _mm256_i32gather_ps(GRADIENT_Z, index, 4);
+        return _mm256_add_ps(_mm256_mul_ps(gx, dx), _mm256_mul_ps(gz, dz));
+    }
+}
+
+__attribute__((target("avx2")))
+void FbmNoise::sample8Avx2(const float* x, const float* z, float* out) const
+{
+    const __m256 one = _mm256_set1_ps(1.0f);
+    const __m256i mask255 = _mm256_set1_epi32(255);
+    const __m256i oneInt = _mm256_set1_epi32(1);
+    const int* perm = permutation.data();
+
+    __m256 vx = _mm256_loadu_ps(x);
+    __m256 vz = _mm256_loadu_ps(z);
+    __m256 sum = _mm256_setzero_ps();
+    float amplitude = 1.0f;
+    float octaveFrequency = frequency;
+
+    for (int octave = 0; octave < octaves; octave++)
+    {
+        __m256 frequencyLanes = _mm256_set1_ps(octaveFrequency);
+        __m256 px = _mm256_add_ps(_mm256_mul_ps(vx, frequencyLanes), _mm256_set1_ps(octaveOffsetX[octave]));
+        __m256 pz = _mm256_add_ps(_mm256_mul_ps(vz, frequencyLanes), _mm256_set1_ps(octaveOffsetZ[octave]));
+        __m256 cellX = _mm256_floor_ps(px);
+        __m256 cellZ = _mm256_floor_ps(pz);
+        __m256i ix = _mm256_and_si256(_mm256_cvttps_epi32(cellX), mask255);
+        __m256i iz = _mm256_and_si256(_mm256_cvttps_epi32(cellZ), mask255);
+        __m256 fx = _mm256_sub_ps(px, cellX);
+        __m256 fz = _mm256_sub_ps(pz, cellZ);
+
+        __m256 u = fade8(fx);
+        __m256 v = fade8(fz);
+
+        __m256i a = _mm256_i32gather_epi32(perm, ix, 4);
+        __m256i b = _mm256_i32gather_epi32(perm, _mm256_add_epi32(ix, oneInt), 4);
+        __m256i h00 = _mm256_i32gather_epi32(perm, _mm256_add_epi32(a, iz), 4);
+        __m256i h10 = _mm256_i32gather_epi32(perm, _mm256_add_epi32(b, iz), 4);
+        __m256i h01 = _mm256_i32gather_epi32(perm, _mm256_add_epi32(_mm256_add_epi32(a, iz), oneInt), 4);
+        __m256i h11 = _mm256_i32gather_epi32(perm, _mm256_add_epi32(_mm256_add_epi32(b, iz), oneInt), 4);
+
+        __m256 fx1 = _mm256_sub_ps(fx, one);
+        __m256 fz1 = _mm256_sub_ps(fz, one);
+        __m256 n00 = gradient8(h00, fx, fz);
+        __m256 n10 = gradient8(h10, fx1, fz);
+        __m256 n01 = gradient8(h01, fx, fz1);
+        __m256 n11 = gradient8(h11, fx1, fz1);
+
+        __m256 nx0 = _mm256_add_ps(n00, _mm256_mul_ps(u, _mm256_sub_ps(n10, n00)));
+        __m256 nx1 = _mm256_add_ps(n01, _mm256_mul_ps(u, _mm256_sub_ps(n11, n01)));
+        __m256 value = _mm256_add_ps(nx0, _mm256_mul_ps(v, _mm256_sub_ps(nx1, nx0)));
+        sum = _mm256_add_ps(sum, _mm256_mul_ps(_mm256_set1_ps(amplitude), value));
+
+        amplitude = amplitude * gain;
+        octaveFrequency = octaveFrequency * lacunarity;
+    }
+    _mm256_storeu_ps(out, sum);
+}
+#else
+void FbmNoise::sample8Avx2(const float* x, const float* z, float* out) const
+{
+    sample8Scalar(x, z, out);
+}
+#endif
@@ -0,0 +1,284 @@
+#include "../headers/shadow_cascades.hpp"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+ShadowCascades::ShadowCascades(unsigned int cascadeCount, unsigned int resolution)
+    : cascadeCount(std::min(std::max(cascadeCount, 1u), MAX_CASCADES)), resolution(resolution)
+{
+    glGenTextures(1, &depthTexture);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, depthTexture);
+    glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_DEPTH_COMPONENT24, resolution, resolution, this->cascadeCount, 0, GL_DEPTH_COMPONENT, GL_FLOAT, NULL);
+    // linear filtering on a comparing sampler blends the results of the 4 nearest texels, hardware PCF for free
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
+    const float lit[] = {1.0f, 1.0f, 1.0f, 1.0f};
+    glTexParameterfv(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_BORDER_COLOR, lit);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+    glGenFramebuffers(1, &framebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, depthTexture, 0, 0);
+    glDrawBuffer(GL_NONE);
+    glReadBuffer(GL_NONE);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+    {
+        std::cout << "ERROR::SHADOW_CASCADES::FRAMEBUFFER_INCOMPLETE" << std::endl;
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    for (unsigned int i = 0; i < this->cascadeCount; i++)
+    {
+        glGenQueries(2, cascades[i].queries);
+    }
+    setLightDirection(lightDirection);
+}
+
+ShadowCascades::~ShadowCascades()
+{
+    for (unsigned int i = 0; i < cascadeCount; i++)
+    {
+        glDeleteQueries(2, cascades[i].queries);
+    }
+    glDeleteFramebuffers(1, &framebuffer);
+    glDeleteTextures(1, &depthTexture);
+}
+
+void ShadowCascades::setLightDirection(const glm::vec3& towardsLight)
+{
+    lightDirection = glm::normalize(towardsLight);
+    glm::vec3 up = std::abs(lightDirection.y) > 0.99f ? glm::vec3(0.0f, 0.0f, 1.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+    // looking the way the light shines, from the origin: a point's distance from the light is -z
+    lightRotation = glm::lookAt(glm::vec3(0.0f), -lightDirection, up);
+}
+
+void ShadowCascades::update(const glm::mat4& view, float fovY, float aspect, float nearPlane)
+{
+    frameIndex++;
+
+    glm::mat4 inverseView = glm::inverse(view);
+    glm::vec3 eye = glm::vec3(inverseView[3]);
+    glm::vec3 forward = -glm::vec3(inverseView[2]);
+
+    // squared tangent of the angle between the view axis and a corner of the view frustum
+    float tanHalfY = std::tan(fovY * 0.5f);
+    float tanHalfX = tanHalfY * aspect;
+    float k2 = tanHalfX * tanHalfX + tanHalfY * tanHalfY;
+
+    float farShadow = std::max(settings.shadowDistance, nearPlane * 2.0f);
+    float sliceNear = nearPlane;
+    for (unsigned int i = 0; i < cascadeCount; i++)
+    {
+        Cascade& cascade = cascades[i];
+        for (unsigned int query = 0; query < 2; query++)
+        {
+            readTimer(cascade, query);
+        }
+
+        // practical split scheme: a blend of logarithmic splits (even texel density) and uniform ones
+        float fraction = (float)(i + 1) / cascadeCount;
+        float logSplit = nearPlane * std::pow(farShadow / nearPlane, fraction);
+        float uniformSplit = nearPlane + (farShadow - nearPlane) * fraction;
+        float sliceFar = settings.splitLambda * logSplit + (1.0f - settings.splitLambda) * uniformSplit;
+
+        // Bounding sphere of the slice: equally far from its near and far corners, or around the far rectangle when
+        // that already contains the near one. It only depends on the projection, so it doesn't change as the camera turns.
+        float centreDepth = 0.5f * (sliceFar + sliceNear) * (1.0f + k2);
+        if (centreDepth > sliceFar)
+        {
+            centreDepth = sliceFar;
+        }
+        float radius = std::sqrt((centreDepth - sliceNear) * (centreDepth - sliceNear) + sliceNear * sliceNear * k2);
+        radius = std::max(radius, std::sqrt((sliceFar - centreDepth) * (sliceFar - centreDepth) + sliceFar * sliceFar * k2));
+        glm::vec3 centre = eye + forward * centreDepth;
+
+        cascade.stats.splitFar = sliceFar;
+        cascade.stats.renderedThisFrame = false;
+        sliceNear = sliceFar;
+
+        bool cached = i >= settings.firstCachedCascade;
+        float lightTurned = glm::degrees(std::acos(glm::clamp(glm::dot(lightDirection, cascade.drawnLightDirection), -1.0f, 1.0f)));
+        const char* reason = nullptr;
+        if (!cascade.valid)
+        {
+            reason = "first frame";
+        }
+        else if (!cached)
+        {
+            reason = "every frame";
+        }
+        else if (lightTurned > settings.lightAngleThreshold)
+        {
+            reason = "light moved";
+        }
+        else if (cascade.changedCasters > settings.casterChangeThreshold)
+        {
+            reason = "casters changed";
+        }
+        else
+        {
+            // in the light space the layer was drawn in, which lags behind lightRotation by up to the angle threshold
+            glm::mat4 drawnRotation = glm::lookAt(glm::vec3(0.0f), -cascade.drawnLightDirection,
+                std::abs(cascade.drawnLightDirection.y) > 0.99f ? glm::vec3(0.0f, 0.0f, 1.0f) : glm::vec3(0.0f, 1.0f, 0.0f));
+            glm::vec3 lightSpaceCentre = glm::vec3(drawnRotation * glm::vec4(centre, 1.0f));
+            Placement wanted = {glm::vec2(lightSpaceCentre), radius, lightSpaceCentre.z - radius, lightSpaceCentre.z + radius};
+            if (!covers(cascade.drawn, wanted))
+            {
+                reason = "camera moved";
+            }
+        }
+        if (reason == nullptr)
+        {
+            continue;
+        }
+
+        // Snap the centre to whole texels of the layer: the rasterised casters then move by whole texels as well,
+        // instead of the shadow edges shimmering by a fraction of one.
+        glm::vec3 lightSpaceCentre = glm::vec3(lightRotation * glm::vec4(centre, 1.0f));
+        float drawnRadius = cached ? radius * (1.0f + settings.cachePadding) : radius;
+        float texel = 2.0f * drawnRadius / resolution;
+        glm::vec2 snapped = glm::floor(glm::vec2(lightSpaceCentre) / texel) * texel;
+        cascade.drawn = {snapped, drawnRadius, lightSpaceCentre.z - drawnRadius, lightSpaceCentre.z + drawnRadius};
+        cascade.lightSpaceMatrix = placementMatrix(cascade.drawn) * lightRotation;
+        cascade.drawnLightDirection = lightDirection;
+        cascade.pendingRender = true;
+        cascade.stats.reason = reason;
+        cascade.stats.radius = drawnRadius;
+    }
+}
+
+void ShadowCascades::markCastersChanged(const glm::vec3& boundsMin, const glm::vec3& boundsMax)
+{
+    for (unsigned int i = settings.firstCachedCascade; i < cascadeCount; i++)
+    {
+        if (cascades[i].valid && getCasterFrustum(i).isBoxVisible(boundsMin, boundsMax))
+        {
+            cascades[i].changedCasters++;
+        }
+    }
+}
+
+bool ShadowCascades::beginCascade(unsigned int cascade)
+{
+    Cascade& target = cascades[cascade];
+    if (!target.pendingRender)
+    {
+        return false;
+    }
+
+    glGetIntegerv(GL_VIEWPORT, savedViewport);
+    glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &savedFramebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, depthTexture, 0, cascade);
+    glViewport(0, 0, resolution, resolution);
+    glClear(GL_DEPTH_BUFFER_BIT);
+    // pushes the stored depth back along the slope of the caster, so lit surfaces don't shadow themselves
+    glEnable(GL_POLYGON_OFFSET_FILL);
+    glPolygonOffset(2.0f, 4.0f);
+
+    unsigned int query = frameIndex % 2;
+    readTimer(target, query);
+    glBeginQuery(GL_TIME_ELAPSED, target.queries[query]);
+    return true;
+}
+
+void ShadowCascades::endCascade(unsigned int cascade, unsigned int casters)
+{
+    Cascade& target = cascades[cascade];
+    glEndQuery(GL_TIME_ELAPSED);
+    target.queryPending[frameIndex % 2] = true;
+
+    glDisable(GL_POLYGON_OFFSET_FILL);
+    glBindFramebuffer(GL_FRAMEBUFFER, savedFramebuffer);
+    glViewport(savedViewport[0], savedViewport[1], savedViewport[2], savedViewport[3]);
+
+    target.pendingRender = false;
+    target.valid = true;
+    target.changedCasters = 0;
+    target.stats.casters = casters;
+    target.stats.renders++;
+    target.stats.renderedThisFrame = true;
+}
+
+void ShadowCascades::bind(const Shader& shader, unsigned int textureUnit) const
+{
+    glActiveTexture(GL_TEXTURE0 + textureUnit);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, depthTexture);
+    glActiveTexture(GL_TEXTURE0);
+
+    shader.setInt("shadowMap", textureUnit);
+    shader.setInt("cascadeCount", cascadeCount);
+    shader.setVec3("lightDirection", lightDirection);
+    for (unsigned int i = 0; i < cascadeCount; i++)
+    {
+        std::string index = "[" + std::to_string(i) + "]";
+        shader.setMat4("lightSpaceMatrices" + index, cascades[i].lightSpaceMatrix);
+        shader.setFloat("cascadeSplits" + index, cascades[i].stats.splitFar);
+        shader.setFloat("cascadeTexelSizes" + index, 2.0f * cascades[i].drawn.radius / resolution);
+    }
+}
+
+const glm::mat4& ShadowCascades::getLightSpaceMatrix(unsigned int cascade) const
+{
+    return cascades[cascade].lightSpaceMatrix;
+}
+
+Frustum ShadowCascades::getCasterFrustum(unsigned int cascade) const
+{
+    return Frustum(cascades[cascade].lightSpaceMatrix);
+}
+
+const ShadowCascadeStats& ShadowCascades::getStats(unsigned int cascade) const
+{
+    return cascades[cascade].stats;
+}
+
+unsigned int ShadowCascades::getCascadeCount() const
+{
+    return cascadeCount;
+}
+
+unsigned int ShadowCascades::getResolution() const
+{
+    return resolution;
+}
+
+// Orthographic projection of the placement, from `casterDistance` in front of the receivers to just behind them.
+glm::mat4 ShadowCascades::placementMatrix(const Placement& placement) const
+{
+    return glm::ortho(placement.centre.x - placement.radius, placement.centre.x + placement.radius,
+        placement.centre.y - placement.radius, placement.centre.y + placement.radius,
+        -(placement.maxDepth + settings.casterDistance), -placement.minDepth);
+}
+
+bool ShadowCascades::covers(const Placement& drawn, const Placement& wanted) const
+{
+    glm::vec2 offset = glm::abs(wanted.centre - drawn.centre);
+    return std::max(offset.x, offset.y) + wanted.radius <= drawn.radius
+        && wanted.minDepth >= drawn.minDepth && wanted.maxDepth <= drawn.maxDepth;
+}
+
+// Results come in a frame or more later; a cached cascade may not be drawn again for a long time.
+void ShadowCascades::readTimer(Cascade& cascade, unsigned int query)
+{
+    if (!cascade.queryPending[query])
+    {
+        return;
+    }
+    GLint available = 0;
+    glGetQueryObjectiv(cascade.queries[query], GL_QUERY_RESULT_AVAILABLE, &available);
+    if (available)
+    {
+        GLuint64 elapsed;
+        glGetQueryObjectui64v(cascade.queries[query], GL_QUERY_RESULT, &elapsed);
+        cascade.stats.gpuMs = elapsed / 1e6f;
+        cascade.queryPending[query] = false;
+    }
+}
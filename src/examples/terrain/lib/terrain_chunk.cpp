@@ -0,0 +1,144 @@
+#include "../headers/terrain_chunk.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <limits>
+
+namespace
+{
+    void computeChunkBounds(TerrainChunk& chunk, const Heightfield& heightfield, int rowStart, int rowEnd, int colStart, int colEnd)
+    {
+        chunk.boundsMin = glm::vec3(std::numeric_limits<float>::max());
+        chunk.boundsMax = glm::vec3(std::numeric_limits<float>::lowest());
+
+        for (int i = rowStart; i <= rowEnd; i++)
+        {
+            for (int j = colStart; j <= colEnd; j++)
+            {
+                glm::vec3 position = heightfield.samplePosition(i, j);
+                chunk.boundsMin = glm::min(chunk.boundsMin, position);
+                chunk.boundsMax = glm::max(chunk.boundsMax, position);
+            }
+        }
+    }
+}
+
+/*
+ * Split the (width x height) vertex grid into chunks of `chunkSize` x `chunkSize` quads.
+ * Neighbouring chunks share their border row/column of vertices so there are no cracks between them.
+ * The vertex buffer itself is untouched, only the index data is laid out chunk by chunk.
+ */
+std::vector<TerrainChunk> buildTerrainChunks(const Heightfield& heightfield, int chunkSize, std::vector<unsigned int>& indices)
+{
+    // Image rows run along x and columns along z, see Heightfield.
+    int width = heightfield.getZCount();
+    int height = heightfield.getXCount();
+    std::vector<TerrainChunk> chunks;
+    indices.clear();
+
+    for (int rowStart = 0; rowStart < height - 1; rowStart += chunkSize)
+    {
+        int rowEnd = std::min(rowStart + chunkSize, height - 1);
+        for (int colStart = 0; colStart < width - 1; colStart += chunkSize)
+        {
+            int colEnd = std::min(colStart + chunkSize, width - 1);
+
+            TerrainChunk chunk;
+            chunk.firstIndex = indices.size();
+            computeChunkBounds(chunk, heightfield, rowStart, rowEnd, colStart, colEnd);
+
+            for (int i = rowStart; i < rowEnd; i++)           // for each row a.k.a. each strip
+            {
+                if (i > rowStart)
+                {
+                    indices.push_back(TERRAIN_RESTART_INDEX);
+                }
+                for (int j = colStart; j <= colEnd; j++)      // for each column
+                {
+                    for (int k = 0; k < 2; k++)              // for each side of the strip
+                    {
+                        indices.push_back(j + width * (i + k));
+                    }
+                }
+            }
+
+            chunk.indexCount = indices.size() - chunk.firstIndex;
+            chunks.push_back(chunk);
+        }
+    }
+    return chunks;
+}
+
+/*
+ * Refit the bounding boxes of the chunks containing any sample of `region` after the heights changed.
+ * `chunkSize` must be the one the chunks were built with, which fixes their order in `chunks`.
+ */
+void updateTerrainChunkBounds(std::vector<TerrainChunk>& chunks, const Heightfield& heightfield, int chunkSize, const HeightfieldRegion& region)
+{
+    int width = heightfield.getZCount();
+    int height = heightfield.getXCount();
+    int chunkRows = (height - 1 + chunkSize - 1) / chunkSize;
+    int chunkCols = (width - 1 + chunkSize - 1) / chunkSize;
+    if (region.isEmpty() || chunks.size() != (size_t)chunkRows * chunkCols)
+    {
+        return;
+    }
+
+    // Border samples are shared, so a sample can belong to the chunk before it as well as its own.
+    int firstRow = std::max(region.xBegin - 1, 0) / chunkSize;
+    int lastRow = std::min((region.xEnd - 1) / chunkSize, chunkRows - 1);
+    int firstCol = std::max(region.zBegin - 1, 0) / chunkSize;
+    int lastCol = std::min((region.zEnd - 1) / chunkSize, chunkCols - 1);
+
+    for (int row = firstRow; row <= lastRow; row++)
+    {
+        for (int col = firstCol; col <= lastCol; col++)
+        {
+            int rowStart = row * chunkSize;
+            int colStart = col * chunkSize;
+            computeChunkBounds(chunks[col + chunkCols * row], heightfield,
+                rowStart, std::min(rowStart + chunkSize, height - 1), colStart, std::min(colStart + chunkSize, width - 1));
+        }
+    }
+}
+
+/*
+ * Fill `visibleChunks` with the indices of every chunk intersecting the frustum, sorted front-to-back
+ * by the distance from the eye to the closest point of the chunk's bounding box.
+ * Drawing near chunks first lets the depth test reject hidden fragments of the far chunks early (early-z).
+ */
+TerrainCullStats cullTerrainChunks(const std::vector<TerrainChunk>& chunks, const Frustum& frustum, const glm::vec3& eyePos, std::vector<unsigned int>& visibleChunks)
+{
+    auto start = std::chrono::high_resolution_clock::now();
+
+    std::vector<std::pair<float, unsigned int>> sortKeys;
+    sortKeys.reserve(chunks.size());
+
+    for (unsigned int i = 0; i < chunks.size(); i++)
+    {
+        const TerrainChunk& chunk = chunks[i];
+        if (!frustum.isBoxVisible(chunk.boundsMin, chunk.boundsMax))
+        {
+            continue;
+        }
+        glm::vec3 closestPoint = glm::clamp(eyePos, chunk.boundsMin, chunk.boundsMax);
+        glm::vec3 offset = closestPoint - eyePos;
+        sortKeys.emplace_back(glm::dot(offset, offset), i);
+    }
+
+    std::sort(sortKeys.begin(), sortKeys.end());
+
+    visibleChunks.clear();
+    for (const auto& key : sortKeys)
+    {
+        visibleChunks.push_back(key.second);
+    }
+
+    auto end = std::chrono::high_resolution_clock::now();
+
+    TerrainCullStats stats;
+    stats.visibleChunks = visibleChunks.size();
+    stats.totalChunks = chunks.size();
+    stats.cullTimeMs = std::chrono::duration<float, std::milli>(end - start).count();
+    return stats;
+}
@@ -0,0 +1,95 @@
+#include "../headers/terrain_editor.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+HeightfieldRegion applyTerrainBrush(Heightfield& heightfield, const TerrainBrush& brush, const glm::vec3& center, float deltaTime)
+{
+    glm::vec3 origin = heightfield.getOrigin();
+    float spacing = heightfield.getSpacing();
+    float gridX = (center.x - origin.x) / spacing;
+    float gridZ = (center.z - origin.z) / spacing;
+    float gridRadius = brush.radius / spacing;
+
+    HeightfieldRegion region = heightfield.clampRegion({
+        (int)std::floor(gridX - gridRadius), (int)std::floor(gridZ - gridRadius),
+        (int)std::ceil(gridX + gridRadius) + 1, (int)std::ceil(gridZ + gridRadius) + 1});
+    if (region.isEmpty() || gridRadius <= 0.0f)
+    {
+        return {0, 0, 0, 0};
+    }
+
+    int regionZCount = region.zEnd - region.zBegin;
+    std::vector<float> regionHeights((region.xEnd - region.xBegin) * regionZCount);
+    float maxStep = brush.strength * deltaTime;
+
+    // New heights only read the untouched heightfield, so smoothing doesn't depend on the visiting order.
+    for (int x = region.xBegin; x < region.xEnd; x++)
+    {
+        for (int z = region.zBegin; z < region.zEnd; z++)
+        {
+            float height = heightfield.sample(x, z);
+            float distance2 = ((x - gridX) * (x - gridX) + (z - gridZ) * (z - gridZ)) / (gridRadius * gridRadius);
+            float falloff = distance2 < 1.0f ? (1.0f - distance2) * (1.0f - distance2) : 0.0f;
+            float step = maxStep * falloff;
+
+            if (brush.mode == TerrainBrushMode::Raise)
+            {
+                height += step;
+            }
+            else if (brush.mode == TerrainBrushMode::Lower)
+            {
+                height -= step;
+            }
+            else if (step > 0.0f)
+            {
+                float average = 0.0f;
+                for (int dx = -1; dx <= 1; dx++)
+                {
+                    for (int dz = -1; dz <= 1; dz++)
+                    {
+                        average += heightfield.sample(x + dx, z + dz);
+                    }
+                }
+                average /= 9.0f;
+                height += std::clamp(average - height, -step, step);
+            }
+
+            regionHeights[(z - region.zBegin) + regionZCount * (x - region.xBegin)] = height;
+        }
+    }
+
+    heightfield.setRegion(region, regionHeights);
+    return region;
+}
+
+HeightfieldRegion expandForNormals(const Heightfield& heightfield, const HeightfieldRegion& region)
+{
+    if (region.isEmpty())
+    {
+        return region;
+    }
+    return heightfield.clampRegion({region.xBegin - 1, region.zBegin - 1, region.xEnd + 1, region.zEnd + 1});
+}
+
+void buildTerrainVertices(const Heightfield& heightfield, const HeightfieldRegion& region, std::vector<float>& vertices)
+{
+    vertices.resize((size_t)(region.xEnd - region.xBegin) * (region.zEnd - region.zBegin) * TERRAIN_VERTEX_FLOATS);
+
+    float* vertex = vertices.data();
+    for (int x = region.xBegin; x < region.xEnd; x++)
+    {
+        for (int z = region.zBegin; z < region.zEnd; z++)
+        {
+            glm::vec3 position = heightfield.samplePosition(x, z);
+            glm::vec3 normal = heightfield.sampleNormal(x, z);
+            vertex[0] = position.x;
+            vertex[1] = position.y;
+            vertex[2] = position.z;
+            vertex[3] = normal.x;
+            vertex[4] = normal.y;
+            vertex[5] = normal.z;
+            vertex += TERRAIN_VERTEX_FLOATS;
+        }
+    }
+}
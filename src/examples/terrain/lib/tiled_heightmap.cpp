@@ -0,0 +1,424 @@
+#include "../headers/tiled_heightmap.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+
+namespace
+{
+    const char TILED_HEIGHTMAP_MAGIC[4] = {'H', 'T', 'C', '1'};
+    const uint32_t HEADER_WORDS = 5;        // magic, width, height, tileSize, format
+    const uint32_t RICE_ESCAPE = 24;        // quotients this large are written as a raw 32 bit value instead
+    const uint32_t MAX_RICE_PARAMETER = 24;
+    const size_t MAX_SAMPLES = (size_t)1 << 28;     // 16k x 16k, 1 GiB of decoded floats
+
+    struct BitWriter {
+        std::vector<uint8_t>& bytes;
+        uint64_t buffer = 0;
+        int bitCount = 0;
+
+        void write(uint32_t value, int count)
+        {
+            buffer |= (uint64_t)value << bitCount;
+            bitCount += count;
+            while (bitCount >= 8)
+            {
+                bytes.push_back(buffer & 0xFF);
+                buffer >>= 8;
+                bitCount -= 8;
+            }
+        }
+
+        void writeOnes(uint32_t count)
+        {
+            while (count >= 16)
+            {
+                write(0xFFFF, 16);
+                count -= 16;
+            }
+            write((1u << count) - 1, count);
+        }
+
+        void flush()
+        {
+            if (bitCount > 0)
+            {
+                bytes.push_back(buffer & 0xFF);
+            }
+            buffer = 0;
+            bitCount = 0;
+        }
+    };
+
+    struct BitReader {
+        const uint8_t* data;
+        size_t size;
+        size_t position = 0;
+        uint64_t buffer = 0;
+        int bitCount = 0;
+
+        void refill()
+        {
+            while (bitCount <= 56)
+            {
+                uint64_t byte = position < size ? data[position] : 0;
+                position++;
+                buffer |= byte << bitCount;
+                bitCount += 8;
+            }
+        }
+
+        uint32_t read(int count)
+        {
+            if (count == 0)
+            {
+                return 0;
+            }
+            if (bitCount < count)
+            {
+                refill();
+            }
+            uint32_t value = buffer & ((1ull << count) - 1);
+            buffer >>= count;
+            bitCount -= count;
+            return value;
+        }
+
+        // Count (and consume) the run of 1 bits, stopping after `limit` ones without consuming a terminator.
+        uint32_t readOnes(uint32_t limit)
+        {
+            if (bitCount < 32)
+            {
+                refill();
+            }
+            uint32_t ones = ~buffer == 0 ? 64 : __builtin_ctzll(~buffer);
+            ones = std::min(ones, limit);
+            buffer >>= ones;
+            bitCount -= ones;
+            return ones;
+        }
+    };
+
+    // Floats are remapped so that integer order matches float order, keeping deltas of smooth float data small.
+    uint32_t floatToOrderedBits(float value)
+    {
+        uint32_t bits;
+        std::memcpy(&bits, &value, 4);
+        return (bits & 0x80000000u) ? ~bits : (bits | 0x80000000u);
+    }
+
+    float orderedBitsToFloat(uint32_t bits)
+    {
+        bits = (bits & 0x80000000u) ? (bits & 0x7FFFFFFFu) : ~bits;
+        float value;
+        std::memcpy(&value, &bits, 4);
+        return value;
+    }
+
+    uint32_t encodeSample(const HeightmapImage& image, float value)
+    {
+        if (image.format == HeightSampleFormat::Float32)
+        {
+            return floatToOrderedBits(value);
+        }
+        float maxValue = image.format == HeightSampleFormat::UInt8 ? 255.0f : 65535.0f;
+        return (uint32_t)std::lround(std::clamp(value, 0.0f, 1.0f) * maxValue);
+    }
+
+    float decodeSample(HeightSampleFormat format, uint32_t word)
+    {
+        if (format == HeightSampleFormat::Float32)
+        {
+            return orderedBitsToFloat(word);
+        }
+        if (format == HeightSampleFormat::UInt8)
+        {
+            return (word & 0xFF) / 255.0f;
+        }
+        return (word & 0xFFFF) / 65535.0f;
+    }
+
+    uint32_t predict(const uint32_t* words, int x, int y, int stride)
+    {
+        if (x == 0 && y == 0)
+        {
+            return 0;
+        }
+        if (y == 0)
+        {
+            return words[x - 1];
+        }
+        if (x == 0)
+        {
+            return words[x + (y - 1) * stride];
+        }
+        // Wrapping unsigned arithmetic is fine here, the decoder performs exactly the same operations.
+        return words[x - 1] + words[x + (y - 1) * stride] - words[(x - 1) + (y - 1) * stride];
+    }
+
+    uint32_t zigZag(uint32_t residual)
+    {
+        int32_t value = (int32_t)residual;
+        return ((uint32_t)value << 1) ^ (uint32_t)(value >> 31);
+    }
+
+    uint32_t unZigZag(uint32_t value)
+    {
+        return (value >> 1) ^ (0u - (value & 1));
+    }
+
+    void appendWord(std::vector<uint8_t>& bytes, uint32_t word)
+    {
+        uint8_t raw[4];
+        std::memcpy(raw, &word, 4);
+        bytes.insert(bytes.end(), raw, raw + 4);
+    }
+
+    uint32_t readWord(const std::vector<uint8_t>& bytes, size_t offset)
+    {
+        uint32_t word;
+        std::memcpy(&word, &bytes[offset], 4);
+        return word;
+    }
+
+    void encodeTile(const HeightmapImage& image, int tileX, int tileY, int tileSize, std::vector<uint8_t>& bytes)
+    {
+        int startX = tileX * tileSize;
+        int startY = tileY * tileSize;
+        int tileWidth = std::min(tileSize, image.width - startX);
+        int tileHeight = std::min(tileSize, image.height - startY);
+
+        std::vector<uint32_t> words(tileWidth * tileHeight);
+        for (int y = 0; y < tileHeight; y++)
+        {
+            for (int x = 0; x < tileWidth; x++)
+            {
+                words[x + y * tileWidth] = encodeSample(image, image.heights[(startX + x) + (startY + y) * image.width]);
+            }
+        }
+
+        std::vector<uint32_t> residuals(words.size());
+        for (int y = 0; y < tileHeight; y++)
+        {
+            for (int x = 0; x < tileWidth; x++)
+            {
+                residuals[x + y * tileWidth] = zigZag(words[x + y * tileWidth] - predict(words.data(), x, y, tileWidth));
+            }
+        }
+
+        // Pick the Rice parameter giving the smallest tile.
+        uint32_t bestParameter = 0;
+        uint64_t bestBits = UINT64_MAX;
+        for (uint32_t k = 0; k <= MAX_RICE_PARAMETER; k++)
+        {
+            uint64_t bits = 0;
+            for (uint32_t residual : residuals)
+            {
+                uint32_t quotient = residual >> k;
+                bits += quotient < RICE_ESCAPE ? quotient + 1 + k : RICE_ESCAPE + 32;
+            }
+            if (bits < bestBits)
+            {
+                bestBits = bits;
+                bestParameter = k;
+            }
+        }
+
+        bytes.push_back((uint8_t)bestParameter);
+        BitWriter writer{bytes};
+        for (uint32_t residual : residuals)
+        {
+            uint32_t quotient = residual >> bestParameter;
+            if (quotient < RICE_ESCAPE)
+            {
+                writer.writeOnes(quotient);
+                writer.write(0, 1);
+                writer.write(residual & ((1u << bestParameter) - 1), bestParameter);
+            }
+            else
+            {
+                writer.writeOnes(RICE_ESCAPE);
+                writer.write(residual, 32);
+            }
+        }
+        writer.flush();
+    }
+
+    bool decodeTile(const uint8_t* data, size_t size, HeightSampleFormat format, int tileX, int tileY, int tileSize, HeightmapImage& image)
+    {
+        if (size < 1)
+        {
+            return false;
+        }
+
+        int startX = tileX * tileSize;
+        int startY = tileY * tileSize;
+        int tileWidth = std::min(tileSize, image.width - startX);
+        int tileHeight = std::min(tileSize, image.height - startY);
+
+        uint32_t parameter = data[0];
+        if (parameter > MAX_RICE_PARAMETER)
+        {
+            return false;
+        }
+
+        BitReader reader{data + 1, size - 1};
+        std::vector<uint32_t> words(tileWidth * tileHeight);
+        for (int y = 0; y < tileHeight; y++)
+        {
+            for (int x = 0; x < tileWidth; x++)
+            {
+                uint32_t residual;
+                uint32_t quotient = reader.readOnes(RICE_ESCAPE);
+                if (quotient < RICE_ESCAPE)
+                {
+                    reader.read(1);
+                    residual = (quotient << parameter) | reader.read(parameter);
+                }
+                else
+                {
+                    residual = reader.read(32);
+                }
+
+                uint32_t word = unZigZag(residual) + predict(words.data(), x, y, tileWidth);
+                words[x + y * tileWidth] = word;
+                image.heights[(startX + x) + (startY + y) * image.width] = decodeSample(format, word);
+            }
+        }
+        return reader.position <= reader.size + 8;
+    }
+}
+
+std::vector<uint8_t> encodeTiledHeightmap(const HeightmapImage& image, int tileSize)
+{
+    int tilesX = (image.width + tileSize - 1) / tileSize;
+    int tilesY = (image.height + tileSize - 1) / tileSize;
+
+    std::vector<uint8_t> bytes(TILED_HEIGHTMAP_MAGIC, TILED_HEIGHTMAP_MAGIC + 4);
+    appendWord(bytes, image.width);
+    appendWord(bytes, image.height);
+    appendWord(bytes, tileSize);
+    appendWord(bytes, (uint32_t)image.format);
+
+    size_t directoryStart = bytes.size();
+    bytes.resize(directoryStart + tilesX * tilesY * 8);
+
+    std::vector<uint8_t> payload;
+    for (int tileY = 0; tileY < tilesY; tileY++)
+    {
+        for (int tileX = 0; tileX < tilesX; tileX++)
+        {
+            uint32_t offset = payload.size();
+            encodeTile(image, tileX, tileY, tileSize, payload);
+            uint32_t size = payload.size() - offset;
+
+            size_t entry = directoryStart + (tileX + tileY * tilesX) * 8;
+            std::memcpy(&bytes[entry], &offset, 4);
+            std::memcpy(&bytes[entry + 4], &size, 4);
+        }
+    }
+
+    bytes.insert(bytes.end(), payload.begin(), payload.end());
+    return bytes;
+}
+
+bool decodeTiledHeightmap(const std::vector<uint8_t>& bytes, HeightmapImage& image, ThreadPool* pool)
+{
+    if (bytes.size() < HEADER_WORDS * 4 || std::memcmp(bytes.data(), TILED_HEIGHTMAP_MAGIC, 4) != 0)
+    {
+        std::cout << "ERROR::TILED_HEIGHTMAP::NOT_A_TILED_HEIGHTMAP" << std::endl;
+        return false;
+    }
+
+    image.width = readWord(bytes, 4);
+    image.height = readWord(bytes, 8);
+    int tileSize = readWord(bytes, 12);
+    image.format = (HeightSampleFormat)readWord(bytes, 16);
+    if (tileSize <= 0 || image.width <= 0 || image.height <= 0 ||
+        (image.format != HeightSampleFormat::UInt16 && image.format != HeightSampleFormat::Float32 &&
+         image.format != HeightSampleFormat::UInt8))
+    {
+        std::cout << "ERROR::TILED_HEIGHTMAP::INVALID_HEADER" << std::endl;
+        return false;
+    }
+
+    // Everything below is sized from the header, so check it against the file before allocating anything:
+    // the directory takes 8 bytes per tile, and every sample takes at least one bit of the payload.
+    size_t tilesX = ((size_t)image.width + tileSize - 1) / tileSize;
+    size_t tilesY = ((size_t)image.height + tileSize - 1) / tileSize;
+    size_t tileCount = tilesX * tilesY;
+    size_t directoryStart = HEADER_WORDS * 4;
+    if (tileCount > (bytes.size() - directoryStart) / 8)
+    {
+        std::cout << "ERROR::TILED_HEIGHTMAP::TRUNCATED_DIRECTORY" << std::endl;
+        return false;
+    }
+    size_t payloadStart = directoryStart + tileCount * 8;
+    size_t sampleCount = (size_t)image.width * image.height;
+    if (sampleCount > MAX_SAMPLES || sampleCount > (bytes.size() - payloadStart) * 8)
+    {
+        std::cout << "ERROR::TILED_HEIGHTMAP::INVALID_SIZE: " << image.width << "x" << image.height << std::endl;
+        return false;
+    }
+
+    image.heights.assign(sampleCount, 0.0f);
+
+    std::vector<char> tileOk(tileCount, 0);
+    auto decodeTiles = [&](size_t begin, size_t end)
+    {
+        for (size_t tile = begin; tile < end; tile++)
+        {
+            uint32_t offset = readWord(bytes, directoryStart + tile * 8);
+            uint32_t size = readWord(bytes, directoryStart + tile * 8 + 4);
+            if ((size_t)offset + size > bytes.size() - payloadStart)
+            {
+                continue;
+            }
+            tileOk[tile] = decodeTile(&bytes[payloadStart + offset], size, image.format, (int)(tile % tilesX), (int)(tile / tilesX), tileSize, image);
+        }
+    };
+
+    // Tiles write disjoint regions of the output, so they decode independently on the pool.
+    if (pool)
+    {
+        pool->parallelFor(tileOk.size(), 1, decodeTiles);
+    }
+    else
+    {
+        decodeTiles(0, tileOk.size());
+    }
+
+    if (std::find(tileOk.begin(), tileOk.end(), 0) != tileOk.end())
+    {
+        std::cout << "ERROR::TILED_HEIGHTMAP::CORRUPT_TILE" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool writeTiledHeightmap(const std::string& path, const HeightmapImage& image, int tileSize)
+{
+    std::vector<uint8_t> bytes = encodeTiledHeightmap(image, tileSize);
+    std::ofstream file(path, std::ios::binary);
+    if (!file)
+    {
+        std::cout << "ERROR::TILED_HEIGHTMAP::FILE_NOT_WRITABLE: " << path << std::endl;
+        return false;
+    }
+    file.write((const char*)bytes.data(), bytes.size());
+    return (bool)file;
+}
+
+bool readTiledHeightmap(const std::string& path, HeightmapImage& image, ThreadPool* pool)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+    {
+        return false;
+    }
+    std::vector<uint8_t> bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    return decodeTiledHeightmap(bytes, image, pool);
+}
@@ -116,6 +116,9 @@ int main()
 		return -1;
 	}  
 
+	// programs linked on earlier runs are loaded from here instead of compiled again
+	programCache.enable("shader_cache", (GLADloadproc) glfwGetProcAddress);
+
 	// Viewport dictates how we want to display the data and coordinates with respect to the window
 	glfwSetFramebufferSizeCallback(window, framebuffer_size_callback); 
     glfwSetKeyCallback(window, key_callback);
@@ -166,6 +169,7 @@ int main()
 void render(GLFWwindow* window)
 {
     Shader shader("src/examples/terrain/data/shaders/shader.vs", "src/examples/terrain/data/shaders/shader.fs");
+    programCache.printReport();
 
     bool show_window = true;
     ImVec4 clear_color = ImVec4(0.00f, 0.00f, 0.00f, 1.00f);
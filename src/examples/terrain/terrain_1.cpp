@@ -19,6 +19,13 @@
 
 #include "./headers/shader.hpp"
 #include "./headers/model.hpp"
+#include "./headers/terrain_chunk.hpp"
+#include "./headers/heightfield.hpp"
+#include "./headers/heightmap_loader.hpp"
+#include "./headers/terrain_editor.hpp"
+
+#include <chrono>
+#include <random>
 
 // Function Declarations.
 void framebuffer_size_callback(GLFWwindow* window, int width, int height);
@@ -31,8 +38,11 @@ void scroll_callback(GLFWwindow* window, double xoffset, double yoffset);
 void render(GLFWwindow* window);
 void storeVertexDataOnGpu();
 void draw(Shader& shader);
-std::vector<float> buildPositionData(int width, int height, int nChannels, unsigned char* data);
-std::vector<unsigned int> buildIndiceData(int width, int height);
+void updateTerrainQueries();
+void runQueryBenchmark();
+void rebuildTerrainChunks();
+void editTerrain();
+std::vector<float> buildHeightData(const HeightmapImage& image);
 
 struct Joystick {
     float leftX;
@@ -68,6 +78,9 @@ glm::vec3 cameraPos   = glm::vec3(0.0f, 1.0f,  2.0f);
 glm::vec3 cameraFront = glm::vec3(0.0f, 0.0f, -1.0f);
 glm::vec3 cameraUp    = glm::vec3(0.0f, 1.0f,  0.0f);
 
+// The view matrix is shifted by this offset after the lookAt, so the actual eye sits at `cameraPos - VIEW_OFFSET`.
+const glm::vec3 VIEW_OFFSET = glm::vec3(0.0f, 0.0f, -8.0f);
+
 float deltaTime = 0.0f;	// Time between current frame and last frame
 float lastFrame = 0.0f; // Time of last frame
 unsigned int polygonMode = 0;
@@ -78,8 +91,59 @@ int MAX_TOTAL_TILES = 500;
 
 float CAMERA_BASE_SPEED = 75.0f;
 
-unsigned int NUM_STRIPS = 0;
-unsigned int NUM_VERTS_PER_STRIP = 0;
+int CHUNK_SIZE = 64;
+int builtChunkSize = CHUNK_SIZE; // CHUNK_SIZE follows the slider, this is what the current chunks were built with
+bool frustumCullingEnabled = true;
+
+std::vector<TerrainChunk> terrainChunks;
+std::vector<unsigned int> visibleChunks;
+TerrainCullStats cullStats = {0, 0, 0.0f};
+
+// Per-draw arguments for glMultiDrawElements, kept around to avoid reallocating every frame.
+std::vector<GLsizei> drawCounts;
+std::vector<void*> drawOffsets;
+
+// CPU side terrain queries (ground clamping, picking, line of sight)
+Heightfield terrainHeightfield;
+ThreadPool terrainQueryPool;
+
+bool groundClampEnabled = false;
+float CAMERA_EYE_HEIGHT = 2.0f;
+TerrainRayHit lookAtHit = {false, 0.0f, glm::vec3(0.0f), glm::vec3(0.0f)};
+
+// Height map source and its compressed tile cache (written next to the source on first run)
+const std::string HEIGHTMAP_PATH = "src/examples/terrain/data/maps/height_map.bmp";
+const std::string HEIGHTMAP_CACHE_PATH = "src/examples/terrain/data/maps/height_map.htc";
+
+struct HeightmapStats {
+    uintmax_t sourceBytes;
+    uintmax_t rawBytes;
+    uintmax_t cacheBytes;
+    float loadTimeMs;
+};
+HeightmapStats heightmapStats = {0, 0, 0, 0.0f};
+
+// Height editing, hold the left mouse button to apply the brush where the crosshair hits the terrain
+bool terrainEditingEnabled = false;
+bool terrainBrushHeld = false;
+TerrainBrush terrainBrush = {TerrainBrushMode::Raise, 16.0f, 20.0f};
+std::vector<float> editVertices;
+
+struct TerrainEditStats {
+    unsigned int dirtyVertices;
+    float editTimeMs;
+};
+TerrainEditStats editStats = {0, 0.0f};
+
+struct QueryBenchmark {
+    unsigned int heightQueries;
+    unsigned int rayQueries;
+    float serialHeightMs;
+    float pooledHeightMs;
+    float serialRayMs;
+    float pooledRayMs;
+};
+QueryBenchmark queryBenchmark = {0, 0, 0.0f, 0.0f, 0.0f, 0.0f};
 
 int main() 
 {
@@ -108,6 +172,9 @@ int main()
 		return -1;
 	}  
 
+	// programs linked on earlier runs are loaded from here instead of compiled again
+	programCache.enable("shader_cache", (GLADloadproc) glfwGetProcAddress);
+
 	// Viewport dictates how we want to display the data and coordinates with respect to the window
 	glfwSetFramebufferSizeCallback(window, framebuffer_size_callback); 
     glfwSetKeyCallback(window, key_callback);
@@ -158,6 +225,11 @@ int main()
 void render(GLFWwindow* window)
 {
     Shader shader("src/examples/terrain/data/shaders/shader.vs", "src/examples/terrain/data/shaders/shader.fs");
+    programCache.printReport();
+
+    // edit data/shaders/*.vs/*.fs while running, they are recompiled without restarting
+    ShaderWatcher shaderWatcher((GLADloadproc) glfwGetProcAddress);
+    shaderWatcher.add(shader);
 
     bool show_window = true;
     ImVec4 clear_color = ImVec4(0.00f, 0.00f, 0.00f, 1.00f);
@@ -166,6 +238,8 @@ void render(GLFWwindow* window)
 
 	while(!glfwWindowShouldClose(window))
 	{
+        shaderWatcher.update();
+
         // Start the Dear ImGui frame
         ImGui_ImplOpenGL3_NewFrame();
         ImGui_ImplGlfw_NewFrame();
@@ -182,6 +256,7 @@ void render(GLFWwindow* window)
 
 		// Input
 		processInput(window);
+        updateTerrainQueries();
 
         // ImGui Windows
         if (show_window)
@@ -192,11 +267,52 @@ void render(GLFWwindow* window)
             // Pass a pointer to our bool variable (the window will have a closing button that will clear the bool when clicked)
             ImGui::Text("Hello from ImGuI!");
             ImGui::SliderInt("Total vertices", &TOTAL_TILES, 0, MAX_TOTAL_TILES);            // Edit 1 float using a slider from 0.0f to 1.0f
+            ImGui::SliderInt("Chunk size", &CHUNK_SIZE, 8, 256);
             ImGui::ColorEdit3("clear color", (float*)&clear_color); // Edit 3 floats representing a color
 
+            ImGui::Checkbox("Frustum culling", &frustumCullingEnabled);
+            ImGui::Text("Visible chunks: %u / %u", cullStats.visibleChunks, cullStats.totalChunks);
+            ImGui::Text("Culling time: %.3f ms", cullStats.cullTimeMs);
+
+            ImGui::Text("Height map: %llu raw bytes, %llu compressed, loaded in %.2f ms",
+                (unsigned long long)heightmapStats.rawBytes, (unsigned long long)heightmapStats.cacheBytes, heightmapStats.loadTimeMs);
+
+            ImGui::Checkbox("Clamp camera to ground", &groundClampEnabled);
+            if (lookAtHit.hit)
+            {
+                ImGui::Text("Looking at: (%.1f, %.1f, %.1f), %.1f units away", lookAtHit.position.x, lookAtHit.position.y, lookAtHit.position.z, lookAtHit.distance);
+            }
+            else
+            {
+                ImGui::Text("Looking at: sky");
+            }
+
+            if (ImGui::Button("Run query benchmark"))
+            {
+                runQueryBenchmark();
+            }
+            if (queryBenchmark.heightQueries > 0)
+            {
+                ImGui::Text("%u heights: %.3f ms serial, %.3f ms on %u threads", queryBenchmark.heightQueries, queryBenchmark.serialHeightMs, queryBenchmark.pooledHeightMs, terrainQueryPool.size());
+                ImGui::Text("%u rays: %.3f ms serial, %.3f ms on %u threads", queryBenchmark.rayQueries, queryBenchmark.serialRayMs, queryBenchmark.pooledRayMs, terrainQueryPool.size());
+            }
+
+            ImGui::Checkbox("Edit terrain (hold left mouse)", &terrainEditingEnabled);
+            if (terrainEditingEnabled)
+            {
+                ImGui::RadioButton("Raise", (int*)&terrainBrush.mode, (int)TerrainBrushMode::Raise);
+                ImGui::SameLine();
+                ImGui::RadioButton("Lower", (int*)&terrainBrush.mode, (int)TerrainBrushMode::Lower);
+                ImGui::SameLine();
+                ImGui::RadioButton("Smooth", (int*)&terrainBrush.mode, (int)TerrainBrushMode::Smooth);
+                ImGui::SliderFloat("Brush radius", &terrainBrush.radius, 1.0f, 128.0f);
+                ImGui::SliderFloat("Brush strength", &terrainBrush.strength, 1.0f, 100.0f);
+                ImGui::Text("Last edit: %u vertices in %.3f ms", editStats.dirtyVertices, editStats.editTimeMs);
+            }
+
             if (ImGui::Button("Confirm"))
             {
-	            storeVertexDataOnGpu();
+	            rebuildTerrainChunks();
             }
 
             if (ImGui::Button("Close"))
@@ -317,6 +433,8 @@ void processInput(GLFWwindow *window)
         fov = 45.0f; 
     }
 
+    terrainBrushHeld = terrainEditingEnabled && !imGuiMode && glfwGetMouseButton(window, GLFW_MOUSE_BUTTON_LEFT) == GLFW_PRESS;
+
     joystick_callback(window, joystick.rightX, joystick.rightY);
 }
 
@@ -411,7 +529,7 @@ void draw(Shader& shader)
     view = glm::lookAt(cameraPos, // Camera Pos
                        cameraPos + cameraFront, // Target Pos
                        cameraUp); // Up Vector
-    view = glm::translate(view, glm::vec3(0.0f, 0.0f, -8.0f));
+    view = glm::translate(view, VIEW_OFFSET);
     shader.setMat4("view", view);
 
     glm::mat4 projection = glm::perspective(glm::radians(fov), (float)WINDOW_WIDTH / (float)WINDOW_HEIGHT, 0.1f, 10000.0f);
@@ -420,90 +538,220 @@ void draw(Shader& shader)
     glm::mat4 model = glm::mat4(1.0f);
     shader.setMat4("model", model);
 
-    glBindVertexArray(vaoId);
-    // TODO CHANGE INCREMENT ORDER AS TEST
-    for (unsigned int strip = 0; strip < NUM_STRIPS; ++strip)
+    // The terrain model matrix is the identity, so the frustum planes from projection * view are already in vertex space.
+    // The eye position is taken from the inverse view matrix as the view also carries an extra translation.
+    Frustum frustum(projection * view);
+    glm::vec3 eyePos = glm::vec3(glm::inverse(view)[3]);
+
+    if (frustumCullingEnabled)
+    {
+        cullStats = cullTerrainChunks(terrainChunks, frustum, eyePos, visibleChunks);
+    }
+    else
+    {
+        visibleChunks.resize(terrainChunks.size());
+        for (unsigned int i = 0; i < terrainChunks.size(); i++)
+        {
+            visibleChunks[i] = i;
+        }
+        cullStats = {(unsigned int) terrainChunks.size(), (unsigned int) terrainChunks.size(), 0.0f};
+    }
+
+    drawCounts.clear();
+    drawOffsets.clear();
+    for (unsigned int chunkIndex : visibleChunks)
     {
-        glDrawElements(GL_TRIANGLE_STRIP,   // primitive type
-                   NUM_VERTS_PER_STRIP, // number of indices to render
-                   GL_UNSIGNED_INT,     // index data type
-                   (void*)(sizeof(unsigned int) * NUM_VERTS_PER_STRIP * strip));
+        const TerrainChunk& chunk = terrainChunks[chunkIndex];
+        drawCounts.push_back(chunk.indexCount);
+        drawOffsets.push_back((void*)(sizeof(unsigned int) * chunk.firstIndex));
     }
+
+    // Each chunk's strips are joined with a restart index, so the whole visible set is one multi-draw call.
+    glEnable(GL_PRIMITIVE_RESTART);
+    glPrimitiveRestartIndex(TERRAIN_RESTART_INDEX);
+
+    glBindVertexArray(vaoId);
+    glMultiDrawElements(GL_TRIANGLE_STRIP, drawCounts.data(), GL_UNSIGNED_INT, drawOffsets.data(), drawCounts.size());
     glBindVertexArray(0);
+
+    glDisable(GL_PRIMITIVE_RESTART);
 }
 
 void storeVertexDataOnGpu()
 {
-    // load height map texture
-    int width, height, nChannels;
-    unsigned char *data = stbi_load("src/examples/terrain/data/maps/height_map.bmp",
-        &width, &height, &nChannels, 0);
-    std::cout << "width: " << width << "\nheight: " << height << "\nnChannels: " << nChannels << "\ndata: " << data << std::endl;
-    std::cout << sizeof(glm::vec3) << ", " << sizeof(float) << std::endl;
+    // load height map, going through the compressed tile cache after the first run
+    HeightmapImage image;
+    auto loadStart = std::chrono::high_resolution_clock::now();
+    if (!loadHeightmapCached(HEIGHTMAP_PATH, HEIGHTMAP_CACHE_PATH, image, &terrainQueryPool))
+    {
+        return;
+    }
+    heightmapStats.loadTimeMs = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - loadStart).count();
+
+    std::error_code error;
+    heightmapStats.sourceBytes = std::filesystem::file_size(HEIGHTMAP_PATH, error);
+    heightmapStats.cacheBytes = std::filesystem::file_size(HEIGHTMAP_CACHE_PATH, error);
+    heightmapStats.rawBytes = image.heights.size() * (image.format == HeightSampleFormat::UInt8 ? 1 : image.format == HeightSampleFormat::UInt16 ? 2 : 4);
+    std::cout << "Loaded " << image.width << "x" << image.height << " height map in " << heightmapStats.loadTimeMs << " ms ("
+              << heightmapStats.rawBytes << " raw bytes, " << heightmapStats.cacheBytes << " compressed)" << std::endl;
 
-    std::vector<float> vertices = buildPositionData(width, height, nChannels, data);
-    std::vector<unsigned int> indices = buildIndiceData(width, height);
+    // Image rows run along x and columns along z, the heightfield is the one copy of the heights that edits go to.
+    int width = image.width, height = image.height;
+    terrainHeightfield = Heightfield(height, width, buildHeightData(image), glm::vec3(-height / 2.0f, 0.0f, -width / 2.0f), 1.0f);
+
+    std::vector<float> vertices;
+    buildTerrainVertices(terrainHeightfield, {0, 0, height, width}, vertices);
+    std::cout << "Loaded " << vertices.size() / TERRAIN_VERTEX_FLOATS << " vertices" << std::endl;
 
     glGenVertexArrays(1, &vaoId);
     glBindVertexArray(vaoId);
 
+    // Edits rewrite parts of the vertex buffer every frame while the brush is held.
     glGenBuffers(1, &vboId);
     glBindBuffer(GL_ARRAY_BUFFER, vboId);
-    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), &vertices[0], GL_STATIC_DRAW);
+    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), &vertices[0], GL_DYNAMIC_DRAW);
 
     glEnableVertexAttribArray(0);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, TERRAIN_VERTEX_FLOATS * sizeof(float), (void*)0);
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, TERRAIN_VERTEX_FLOATS * sizeof(float), (void*)(3 * sizeof(float)));
 
+    // The element buffer stays bound to the VAO, rebuildTerrainChunks() only replaces its contents.
     glGenBuffers(1, &eboId);
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, eboId);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), &indices[0], GL_STATIC_DRAW);
 
     glBindBuffer(GL_ARRAY_BUFFER, 0);
     glBindVertexArray(0);
+
+    rebuildTerrainChunks();
 }
 
-std::vector<float> buildPositionData(int width, int height, int nChannels, unsigned char* data)
+void rebuildTerrainChunks()
 {
-    // vertex generation
-    std::vector<float> vertices;
-    float yScale = 64.0f / 256.0f, yShift = 16.0f;
-    int rez = 1;
-    unsigned bytePerPixel = nChannels;
+    std::vector<unsigned int> indices;
+    terrainChunks = buildTerrainChunks(terrainHeightfield, CHUNK_SIZE, indices);
+    builtChunkSize = CHUNK_SIZE;
+    std::cout << "Built " << terrainChunks.size() << " terrain chunks of " << CHUNK_SIZE << "x" << CHUNK_SIZE << std::endl;
+
+    glBindVertexArray(vaoId);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), &indices[0], GL_STATIC_DRAW);
+    glBindVertexArray(0);
+}
+
+std::vector<float> buildHeightData(const HeightmapImage& image)
+{
+    // heights are normalised to [0, 1] so 8 and 16 bit maps share the same vertical scale
+    float yScale = 64.0f, yShift = 16.0f;
 
-    for(int i = 0; i < height; i++)
+    std::vector<float> heights(image.heights.size());
+    for (size_t i = 0; i < heights.size(); i++)
     {
-        for(int j = 0; j < width; j++)
-        {
-            unsigned char* pixelOffset = data + (j + width * i) * bytePerPixel;
-            unsigned char y = pixelOffset[0];
+        heights[i] = image.heights[i] * yScale - yShift;
+    }
+    return heights;
+}
 
-            // vertex
-            vertices.push_back( -height/2.0f + height*i/(float)height );   // vx
-            vertices.push_back( (int) y * yScale - yShift);   // vy
-            vertices.push_back( -width/2.0f + width*j/(float)width );   // vz
-        }
+/*
+ * Apply the brush under the crosshair and push only what changed to the GPU:
+ * the edited samples plus the ring of neighbours whose normals depend on them.
+ * Each grid row of that region is contiguous in the vertex buffer, so it's one glBufferSubData per row.
+ */
+void editTerrain()
+{
+    auto start = std::chrono::high_resolution_clock::now();
+
+    HeightfieldRegion edited = applyTerrainBrush(terrainHeightfield, terrainBrush, lookAtHit.position, deltaTime);
+    if (edited.isEmpty())
+    {
+        return;
     }
+    updateTerrainChunkBounds(terrainChunks, terrainHeightfield, builtChunkSize, edited);
+
+    HeightfieldRegion dirty = expandForNormals(terrainHeightfield, edited);
+    buildTerrainVertices(terrainHeightfield, dirty, editVertices);
 
-    std::cout << "Loaded " << vertices.size() / 3 << " vertices" << std::endl;
+    int rowFloats = (dirty.zEnd - dirty.zBegin) * TERRAIN_VERTEX_FLOATS;
+    int zCount = terrainHeightfield.getZCount();
+    glBindBuffer(GL_ARRAY_BUFFER, vboId);
+    for (int x = dirty.xBegin; x < dirty.xEnd; x++)
+    {
+        GLintptr offset = ((GLintptr)dirty.zBegin + (GLintptr)zCount * x) * TERRAIN_VERTEX_FLOATS * sizeof(float);
+        glBufferSubData(GL_ARRAY_BUFFER, offset, rowFloats * sizeof(float), &editVertices[(x - dirty.xBegin) * rowFloats]);
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
 
-    NUM_STRIPS = height-1;
-    NUM_VERTS_PER_STRIP = width*2;
-    stbi_image_free(data);
-    return vertices;
+    editStats.dirtyVertices = (dirty.xEnd - dirty.xBegin) * (dirty.zEnd - dirty.zBegin);
+    editStats.editTimeMs = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
 }
 
-std::vector<unsigned int> buildIndiceData(int width, int height)
+void updateTerrainQueries()
 {
-    std::vector<unsigned int> indices;
-    for (unsigned int i = 0; i < height-1; i++)       // for each row a.k.a. each strip
+    glm::vec3 eyePos = cameraPos - VIEW_OFFSET;
+
+    if (groundClampEnabled)
     {
-        for (unsigned int j = 0; j < width; j++)      // for each column
+        float groundHeight = terrainHeightfield.heightAt(eyePos.x, eyePos.z) + CAMERA_EYE_HEIGHT;
+        if (eyePos.y < groundHeight)
         {
-            for (unsigned int k = 0; k < 2; k++)      // for each side of the strip
-            {
-                indices.push_back(j + width * (i + k));
-            }
+            cameraPos.y += groundHeight - eyePos.y;
+            eyePos.y = groundHeight;
         }
     }
-    return indices;
+
+    TerrainRay lookRay = {eyePos, cameraFront, 10000.0f};
+    lookAtHit = terrainHeightfield.raycast(lookRay);
+
+    if (terrainBrushHeld && lookAtHit.hit)
+    {
+        editTerrain();
+    }
+}
+
+/*
+ * Time a large batch of random queries both on this thread and spread across the query pool,
+ * to check how the batched API scales on this machine.
+ */
+void runQueryBenchmark()
+{
+    const unsigned int HEIGHT_QUERIES = 1000000;
+    const unsigned int RAY_QUERIES = 20000;
+
+    std::mt19937 generator(1234);
+    std::uniform_real_distribution<float> gridX(-terrainHeightfield.getXCount() / 2.0f, terrainHeightfield.getXCount() / 2.0f);
+    std::uniform_real_distribution<float> gridZ(-terrainHeightfield.getZCount() / 2.0f, terrainHeightfield.getZCount() / 2.0f);
+    std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+
+    std::vector<glm::vec2> points(HEIGHT_QUERIES);
+    for (glm::vec2& point : points)
+    {
+        point = glm::vec2(gridX(generator), gridZ(generator));
+    }
+
+    std::vector<TerrainRay> rays(RAY_QUERIES);
+    for (TerrainRay& ray : rays)
+    {
+        ray.origin = glm::vec3(gridX(generator), 100.0f, gridZ(generator));
+        ray.direction = glm::normalize(glm::vec3(unit(generator), -1.0f, unit(generator)));
+        ray.maxDistance = 10000.0f;
+    }
+
+    auto timeMs = [](auto&& query)
+    {
+        auto start = std::chrono::high_resolution_clock::now();
+        query();
+        return std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+    };
+
+    std::vector<float> heightResults;
+    std::vector<TerrainRayHit> rayResults;
+    queryBenchmark.heightQueries = HEIGHT_QUERIES;
+    queryBenchmark.rayQueries = RAY_QUERIES;
+    queryBenchmark.serialHeightMs = timeMs([&]() { terrainHeightfield.heightsAt(points, heightResults); });
+    queryBenchmark.pooledHeightMs = timeMs([&]() { terrainHeightfield.heightsAt(points, heightResults, &terrainQueryPool); });
+    queryBenchmark.serialRayMs = timeMs([&]() { terrainHeightfield.raycasts(rays, rayResults); });
+    queryBenchmark.pooledRayMs = timeMs([&]() { terrainHeightfield.raycasts(rays, rayResults, &terrainQueryPool); });
+
+    std::cout << "Query benchmark: " << HEIGHT_QUERIES << " heights " << queryBenchmark.serialHeightMs << "ms serial / "
+              << queryBenchmark.pooledHeightMs << "ms pooled, " << RAY_QUERIES << " rays " << queryBenchmark.serialRayMs << "ms serial / "
+              << queryBenchmark.pooledRayMs << "ms pooled (" << terrainQueryPool.size() << " threads)" << std::endl;
 }
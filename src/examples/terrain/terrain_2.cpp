@@ -0,0 +1,827 @@
+#include <glad/glad.h> 
+#include <GLFW/glfw3.h>
+
+#include "imgui.h"
+#include "imgui_impl_glfw.h"
+#include "imgui_impl_opengl3.h"
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#define STB_IMAGE_IMPLEMENTATION
+
+#include "stdlib.h"
+#include <iostream>
+#include <cstdint>
+#include <chrono>
+#include <unordered_map>
+#include <memory>
+#include <vector>
+
+#include "./headers/shader.hpp"
+#include "./headers/model.hpp"
+#include "./headers/terrain_chunk.hpp"
+#include "./headers/terrain_editor.hpp"
+#include "./headers/chunk_streamer.hpp"
+#include "./headers/shadow_cascades.hpp"
+#include "../../headers/camera_path.hpp"
+#include "../../headers/headless.hpp"
+#include "../../headers/profiler.hpp"
+
+// Function Declarations.
+void framebuffer_size_callback(GLFWwindow* window, int width, int height);
+void key_callback(GLFWwindow* window, int key, int scancode, int action, int mods);
+void processInput(GLFWwindow* window);
+void mouse_callback(GLFWwindow* window, double xpos, double ypos);
+void joystick_callback(GLFWwindow* window, double xpos, double ypos);
+void scroll_callback(GLFWwindow* window, double xoffset, double yoffset);
+
+void render(GLFWwindow* window);
+void storeVertexDataOnGpu();
+void draw(Shader& shader);
+void renderShadowCascades(Shader& depthShader);
+glm::vec3 sunDirection();
+void streamTerrainChunks();
+void uploadTerrainChunk(const GeneratedChunk& chunk);
+void releaseTerrainChunks();
+void resetTerrainStreamer();
+CameraState currentCameraState();
+void applyCameraState(const CameraState& state);
+
+struct Joystick {
+    float leftX;
+    float leftY;
+    float L2;
+    float rightX;
+    float rightY;
+    float R2;
+};
+
+// Variables
+size_t WINDOW_WIDTH = 1280;
+size_t WINDOW_HEIGHT = 720;
+
+float lastMouseX = WINDOW_WIDTH / 2;
+float lastMouseY = WINDOW_HEIGHT / 2;
+
+float pitch = -20.0f;
+float yaw = -90.0f;
+
+bool joystickPresent = false;
+bool firstMouse = true;
+bool imGuiMode = false;
+
+float fov = 45.0f;
+
+Joystick joystick = {0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f};
+
+unsigned int eboId;
+
+glm::vec3 cameraPos   = glm::vec3(0.0f, 100.0f,  0.0f);
+glm::vec3 cameraFront = glm::normalize(glm::vec3(0.0f, -0.35f, -1.0f));
+glm::vec3 cameraUp    = glm::vec3(0.0f, 1.0f,  0.0f);
+
+float deltaTime = 0.0f;	// Time between current frame and last frame
+float lastFrame = 0.0f; // Time of last frame
+unsigned int polygonMode = 0;
+
+float CAMERA_BASE_SPEED = 75.0f;
+
+// Procedural terrain settings, changing any of these regenerates every chunk
+const int CHUNK_SIZE = 64;
+int terrainSeed = 1337;
+int noiseOctaves = 6;
+float TERRAIN_HEIGHT_SCALE = 60.0f;
+
+int viewRadiusChunks = 8;
+int uploadBudgetPerFrame = 4; // chunks uploaded per frame at most, the rest wait for the next frame
+
+ThreadPool chunkGenerationPool;
+std::unique_ptr<ChunkStreamer> terrainStreamer;
+
+// GPU side of a resident chunk. Buffers of evicted chunks are kept in `freeChunkBuffers` and reused,
+// every chunk has the same size so a reused buffer only needs its contents replaced.
+struct GpuTerrainChunk {
+    unsigned int vaoId;
+    unsigned int vboId;
+    glm::vec3 boundsMin;
+    glm::vec3 boundsMax;
+};
+std::unordered_map<int64_t, GpuTerrainChunk> gpuChunks;
+std::vector<GpuTerrainChunk> freeChunkBuffers;
+unsigned int chunkIndexCount = 0;
+
+std::vector<GeneratedChunk> readyChunks;
+std::vector<glm::ivec2> evictedChunks;
+
+struct StreamingFrameStats {
+    unsigned int uploadedChunks;
+    float uploadTimeMs;
+    unsigned int drawnChunks;
+};
+StreamingFrameStats streamingStats = {0, 0.0f, 0};
+
+// Directional sun light and its cascaded shadow maps
+const float NEAR_PLANE = 0.1f;
+const float FAR_PLANE = 10000.0f;
+float sunAzimuth = -143.0f;     // degrees around the y axis
+float sunElevation = 35.0f;     // degrees above the horizon
+bool animateSun = false;
+float SUN_DEGREES_PER_SECOND = 2.0f;
+bool showCascades = false;
+std::unique_ptr<ShadowCascades> shadowCascades;
+
+bool showProfiler = true;
+
+int64_t chunkKey(glm::ivec2 coord)
+{
+    return ((int64_t)coord.x << 32) | (uint32_t)coord.y;
+}
+
+int main(int argc, char** argv)
+{
+    std::cout << "Hello, Endless Plane!" << std::endl;
+
+    // --headless renders a fixed number of frames offscreen and prints their statistics, see headless.hpp
+    // --record / --replay save the camera path of a run and fly it again, see camera_path.hpp
+    if (!cameraPath.parseArguments(argc, argv) || !headless.parseArguments(argc, argv) || !headless.initGlfw())
+    {
+        return -1;
+    }
+    if (headless.enabled)
+    {
+        WINDOW_WIDTH = headless.width;
+        WINDOW_HEIGHT = headless.height;
+    }
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+
+    GLFWwindow* window = glfwCreateWindow(WINDOW_WIDTH, WINDOW_HEIGHT, "Application", NULL, NULL);
+    if (window == NULL)
+    {
+        std::cout << "Failed to create GLFW window" << std::endl;
+        glfwTerminate();
+        return -1;
+    }
+
+	// Open Window
+    glfwMakeContextCurrent(window);
+
+	// Load openGL functions for this specific openGL Implementation via GLAD
+	if (!gladLoadGLLoader((GLADloadproc) glfwGetProcAddress))
+	{
+		std::cout << "Failed to initialize GLAD" << std::endl;
+		return -1;
+	}  
+
+	// programs linked on earlier runs are loaded from here instead of compiled again
+	programCache.enable("shader_cache", (GLADloadproc) glfwGetProcAddress);
+
+	if (!headless.createTarget())
+	{
+		glfwTerminate();
+		return -1;
+	}
+
+	// Viewport dictates how we want to display the data and coordinates with respect to the window
+	glfwSetFramebufferSizeCallback(window, framebuffer_size_callback); 
+    glfwSetKeyCallback(window, key_callback);
+    glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+
+    glEnable(GL_DEPTH_TEST);
+
+    // Register mouse callback - Each time mouse moves this will be called with the (x,y) coords of the mouse.
+    glfwSetCursorPosCallback(window, mouse_callback); 
+
+    // Scroll callback (change fov of perspective project based on y coordinate)
+    glfwSetScrollCallback(window, scroll_callback); 
+
+    // Default polygon mode
+    glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+
+    // Setup Dear ImGui context
+    IMGUI_CHECKVERSION();
+    ImGui::CreateContext();
+    ImGuiIO& io = ImGui::GetIO(); (void)io;
+    io.ConfigFlags |= ImGuiConfigFlags_NavEnableKeyboard;     // Enable Keyboard Controls
+    io.ConfigFlags |= ImGuiConfigFlags_NavEnableGamepad;      // Enable Gamepad Controls
+
+    // Setup Dear ImGui style
+    ImGui::StyleColorsDark();
+    //ImGui::StyleColorsLight();
+
+    // Setup Platform/Renderer backends
+    ImGui_ImplGlfw_InitForOpenGL(window, true);
+    ImGui_ImplOpenGL3_Init("#version 330");
+
+	render(window);
+
+    // Cleanup
+    releaseTerrainChunks();
+    glDeleteBuffers(1, &eboId);
+
+    ImGui_ImplOpenGL3_Shutdown();
+    ImGui_ImplGlfw_Shutdown();
+    ImGui::DestroyContext();
+
+    glfwDestroyWindow(window);
+	glfwTerminate();
+    return 0;
+}
+
+void render(GLFWwindow* window)
+{
+    Shader shader("src/examples/terrain/data/shaders/shadowed.vs", "src/examples/terrain/data/shaders/shadowed.fs");
+    Shader depthShader("src/examples/terrain/data/shaders/shadow_depth.vs", "src/examples/terrain/data/shaders/shadow_depth.fs");
+    programCache.printReport();
+
+    shadowCascades = std::make_unique<ShadowCascades>(4, 2048);
+
+    bool show_window = true;
+    ImVec4 clear_color = ImVec4(0.45f, 0.60f, 0.80f, 1.00f);
+
+	storeVertexDataOnGpu();
+
+	while(!glfwWindowShouldClose(window))
+	{
+        PROFILE_FRAME();
+
+        // Start the Dear ImGui frame
+        ImGui_ImplOpenGL3_NewFrame();
+        ImGui_ImplGlfw_NewFrame();
+        ImGui::NewFrame();
+
+        {
+            PROFILE_SCOPE("input");
+            joystickPresent = glfwJoystickPresent(GLFW_JOYSTICK_1);
+
+            if (joystickPresent)
+            {
+                int axesCount;
+                const float *axes = glfwGetJoystickAxes(GLFW_JOYSTICK_1, &axesCount);
+                joystick = {axes[0], axes[1], axes[2], axes[3], axes[4], axes[5]};
+            }
+
+            // Input
+            PROFILE_SCOPE("processInput");
+            processInput(window);
+
+            // a replayed path overrides whatever the input did, with a fixed timestep
+            if (cameraPath.isReplaying())
+            {
+                applyCameraState(cameraPath.next());
+                deltaTime = cameraPath.getTimestep();
+                if (cameraPath.isFinished())
+                {
+                    glfwSetWindowShouldClose(window, true);
+                }
+            }
+            else
+            {
+                cameraPath.record(deltaTime, currentCameraState());
+            }
+        }
+        {
+            PROFILE_SCOPE("streaming");
+            streamTerrainChunks();
+        }
+
+        // ImGui Windows
+        {
+            PROFILE_SCOPE("imgui");
+            // no UI during a replay: nothing to change the run halfway, no per-run timings in its frames
+            bool replaying = cameraPath.isReplaying();
+            if (showProfiler && !replaying)
+            {
+                profiler.drawOverlay(&showProfiler);
+            }
+            if (show_window && !replaying)
+            {
+                // Imgui
+                ImGui::Begin("My Window", &show_window);   
+
+                ImGui::ColorEdit3("clear color", (float*)&clear_color);
+
+                ImGui::InputInt("Seed", &terrainSeed);
+                ImGui::SliderInt("Octaves", &noiseOctaves, 1, 10);
+                ImGui::SliderFloat("Height scale", &TERRAIN_HEIGHT_SCALE, 1.0f, 200.0f);
+                if (ImGui::Button("Regenerate"))
+                {
+                    resetTerrainStreamer();
+                }
+
+                ImGui::SliderInt("View radius (chunks)", &viewRadiusChunks, 1, 32);
+                ImGui::SliderInt("Uploads per frame", &uploadBudgetPerFrame, 1, 64);
+
+                ChunkStreamerStats stats = terrainStreamer->getStats();
+                ImGui::Text("Noise: %s, %u generator threads", FbmNoise::hasAvx2() ? "AVX2 (8 lanes)" : "scalar", chunkGenerationPool.size());
+                ImGui::Text("Chunks: %u resident, %u pending, %u drawn", stats.residentChunks, stats.pendingChunks, streamingStats.drawnChunks);
+                ImGui::Text("Generation: %.1f chunks/s, %.2f ms per chunk", stats.chunksPerSecond, stats.averageGenerationMs);
+                ImGui::Text("Uploads this frame: %u in %.3f ms", streamingStats.uploadedChunks, streamingStats.uploadTimeMs);
+
+                ShadowCascadeSettings& shadowSettings = shadowCascades->settings;
+                ImGui::SliderFloat("Sun azimuth", &sunAzimuth, -180.0f, 180.0f);
+                ImGui::SliderFloat("Sun elevation", &sunElevation, 5.0f, 90.0f);
+                ImGui::Checkbox("Animate sun", &animateSun);
+                ImGui::Checkbox("Show cascades", &showCascades);
+                ImGui::SliderFloat("Shadow distance", &shadowSettings.shadowDistance, 50.0f, 3000.0f);
+                ImGui::SliderFloat("Split lambda", &shadowSettings.splitLambda, 0.0f, 1.0f);
+                int firstCachedCascade = shadowSettings.firstCachedCascade;
+                ImGui::SliderInt("First cached cascade", &firstCachedCascade, 0, shadowCascades->getCascadeCount());
+                shadowSettings.firstCachedCascade = firstCachedCascade;
+                ImGui::SliderFloat("Cache padding", &shadowSettings.cachePadding, 0.0f, 1.0f);
+                ImGui::SliderFloat("Light angle threshold", &shadowSettings.lightAngleThreshold, 0.0f, 10.0f);
+                int casterChangeThreshold = shadowSettings.casterChangeThreshold;
+                ImGui::SliderInt("Caster change threshold", &casterChangeThreshold, 0, 64);
+                shadowSettings.casterChangeThreshold = casterChangeThreshold;
+                for (unsigned int i = 0; i < shadowCascades->getCascadeCount(); i++)
+                {
+                    const ShadowCascadeStats& cascade = shadowCascades->getStats(i);
+                    ImGui::Text("Cascade %u: to %.0f, %u casters, %.3f ms GPU, %s (%s, %u renders)", i, cascade.splitFar, cascade.casters, cascade.gpuMs,
+                        cascade.renderedThisFrame ? "drawn" : "cached", cascade.reason, cascade.renders);
+                }
+
+                if (ImGui::Button("Close"))
+                {
+                    show_window = false;
+                }
+                ImGui::End();
+            }
+
+            ImGui::Render();
+        }
+
+        if (animateSun)
+        {
+            sunAzimuth = std::fmod(sunAzimuth + SUN_DEGREES_PER_SECOND * deltaTime + 540.0f, 360.0f) - 180.0f;
+        }
+        {
+            // CPU only, the cascades time themselves on the GPU and GL_TIME_ELAPSED queries can't nest
+            PROFILE_SCOPE("shadows");
+            renderShadowCascades(depthShader);
+        }
+
+        {
+            PROFILE_GPU_SCOPE("draw");
+            // the window, or the offscreen target when headless
+            glBindFramebuffer(GL_FRAMEBUFFER, headless.framebuffer());
+
+            // Clear the screen with a colour
+            glClearColor(clear_color.x * clear_color.w, clear_color.y * clear_color.w, clear_color.z * clear_color.w, clear_color.w);
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT); // also clear the depth buffer now!
+
+            // Rendering commands
+            draw(shader);
+        }
+
+        // no UI offscreen or in a replay, its live timings would end up in the screenshot
+        if (!headless.enabled && !cameraPath.isReplaying())
+        {
+            PROFILE_GPU_SCOPE("imgui draw");
+            ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+        }
+
+		// check and call events and swap the buffers
+        PROFILE_SCOPE("swap");
+		headless.present(window);
+		glfwPollEvents();    
+	}
+
+    headless.finish();
+    cameraPath.stopRecording();
+    shadowCascades.reset();
+    profiler.release();
+}
+
+void framebuffer_size_callback(GLFWwindow* window, int width, int height)
+{
+    glViewport(0, 0, width, height);
+}
+
+void key_callback(GLFWwindow* window, int key, int scancode, int action, int mods)
+{
+    if (key == GLFW_KEY_F && action == GLFW_PRESS)
+    {
+        if (imGuiMode) 
+        {
+            glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+        } 
+        else
+        {
+            glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_NORMAL);
+        }
+        imGuiMode = !imGuiMode;
+    }
+
+    if (key == GLFW_KEY_P && action == GLFW_PRESS)
+    {
+        showProfiler = !showProfiler;
+    }
+
+    if (key == GLFW_KEY_T && action == GLFW_PRESS)
+    {
+        profiler.exportChromeTrace("profile_trace.json");
+    }
+
+    if (key == GLFW_KEY_R && action == GLFW_PRESS && !cameraPath.isReplaying())
+    {
+        if (cameraPath.isRecording())
+        {
+            cameraPath.stopRecording();
+        }
+        else
+        {
+            cameraPath.startRecording("camera_path.cam");
+        }
+    }
+
+    if (key == GLFW_KEY_L && action == GLFW_PRESS)
+    {
+        if (polygonMode == 0)
+        {
+            std::cout << "lines" << std::endl;
+            glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
+            polygonMode = 1;
+        }
+        else if (polygonMode == 1)
+        {
+            std::cout << "points" << std::endl;
+            glPolygonMode(GL_FRONT_AND_BACK, GL_POINTS);
+            polygonMode = 2;
+        }
+        else 
+        {
+            std::cout << "fill" << std::endl;
+            glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+            polygonMode = 0;
+        }
+    }
+}
+
+void processInput(GLFWwindow *window)
+{
+    if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS) 
+    {
+		glfwSetWindowShouldClose(window, true);
+	}
+
+    float currentFrame = glfwGetTime();
+    deltaTime = currentFrame - lastFrame;
+    lastFrame = currentFrame;
+
+    const float cameraSpeed = CAMERA_BASE_SPEED * deltaTime; // adjust accordingly
+                                                //
+    if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS || joystick.leftY < -0.3)
+    {
+        cameraPos += (cameraSpeed * cameraFront);
+    }
+    if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS || joystick.leftY > 0.3)
+    {
+        cameraPos -= (cameraSpeed * cameraFront);
+    }
+    if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS || joystick.leftX < -0.3)
+    {
+        cameraPos -= (glm::normalize(glm::cross(cameraFront, cameraUp)) * cameraSpeed);
+    }
+    if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS || joystick.leftX > 0.3)
+    {
+        cameraPos += (glm::normalize(glm::cross(cameraFront, cameraUp)) * cameraSpeed);
+    }
+
+    if (joystickPresent)
+    {
+        if (joystick.R2 > -0.3)
+        {
+            fov -= (joystick.R2 + 1);
+        }
+        if (joystick.L2 > -0.3)
+        {
+            fov += (joystick.L2);
+        }
+    }
+
+    if (fov < 1.0f)
+    {
+        fov = 1.0f;
+    }
+    if (fov > 45.0f)
+    {
+        fov = 45.0f; 
+    }
+
+    joystick_callback(window, joystick.rightX, joystick.rightY);
+}
+
+/*
+    1. Calculate the mouse's offset since the last frame.
+    2. Add the offset values to the camera's yaw and pitch values.
+    3. Add some constraints to the minimum/maximum pitch values.
+    4. Calculate the direction vector.
+*/
+void mouse_callback(GLFWwindow* window, double xpos, double ypos)
+{
+    if (imGuiMode) 
+    {
+        return;
+    }
+    if (firstMouse)
+    {
+        lastMouseX = xpos;
+        lastMouseY = ypos;
+        firstMouse = false;
+    }
+
+    float xoffset = xpos - lastMouseX;
+    float yoffset = lastMouseY - ypos; // reversed since y-coordinates range from bottom to top
+    lastMouseX = xpos;
+    lastMouseY = ypos;
+
+    const float sensitivity = 0.1f;
+    xoffset *= sensitivity;
+    yoffset *= sensitivity;
+
+    yaw   += xoffset;
+    pitch += yoffset;
+
+    if (pitch > 89.0f)
+    {
+        pitch =  89.0f;
+    }
+    if (pitch < -89.0f)
+    {
+        pitch = -89.0f;
+    }
+
+    glm::vec3 direction;
+    direction.x = cos(glm::radians(yaw)) * cos(glm::radians(pitch));
+    direction.y = sin(glm::radians(pitch));
+    direction.z = sin(glm::radians(yaw)) * cos(glm::radians(pitch));
+    cameraFront = glm::normalize(direction);
+}
+
+void joystick_callback(GLFWwindow* window, double xpos, double ypos)
+{
+    if (xpos > 0.3 || xpos < -0.3 || ypos > 0.3 || ypos < -0.3)
+    {
+        lastMouseX -= xpos;
+        lastMouseY += ypos;
+        
+        const float sensitivity = 3.0f;
+        float xoffset = xpos * sensitivity;
+        float yoffset = ypos * sensitivity;
+
+        yaw   += xoffset;
+        pitch -= yoffset;
+
+        if (pitch > 89.0f)
+        {
+            pitch =  89.0f;
+        }
+        if (pitch < -89.0f)
+        {
+            pitch = -89.0f;
+        }
+
+        glm::vec3 direction;
+        direction.x = cos(glm::radians(yaw)) * cos(glm::radians(pitch));
+        direction.y = sin(glm::radians(pitch));
+        direction.z = sin(glm::radians(yaw)) * cos(glm::radians(pitch));
+        cameraFront = glm::normalize(direction);
+    }
+}
+
+void scroll_callback(GLFWwindow* window, double xoffset, double yoffset)
+{
+    fov -= (float)yoffset;
+}
+
+CameraState currentCameraState()
+{
+    return {cameraPos, cameraFront, yaw, pitch, fov};
+}
+
+void applyCameraState(const CameraState& state)
+{
+    cameraPos = state.position;
+    cameraFront = state.front;
+    yaw = state.yaw;
+    pitch = state.pitch;
+    fov = state.fov;
+}
+
+glm::vec3 sunDirection()
+{
+    float azimuth = glm::radians(sunAzimuth);
+    float elevation = glm::radians(sunElevation);
+    return glm::vec3(cos(elevation) * cos(azimuth), sin(elevation), cos(elevation) * sin(azimuth));
+}
+
+/*
+ * Draw the cascades that aren't cached from the sun, each with only the chunks inside its light frustum.
+ * The light frustum reaches `casterDistance` towards the sun, so hills outside the view still cast into it.
+ */
+void renderShadowCascades(Shader& depthShader)
+{
+    glm::mat4 view = glm::lookAt(cameraPos, cameraPos + cameraFront, cameraUp);
+    shadowCascades->setLightDirection(sunDirection());
+    shadowCascades->update(view, glm::radians(fov), (float)WINDOW_WIDTH / (float)WINDOW_HEIGHT, NEAR_PLANE);
+
+    depthShader.use();
+    depthShader.setMat4("model", glm::mat4(1.0f));
+
+    glEnable(GL_PRIMITIVE_RESTART);
+    glPrimitiveRestartIndex(TERRAIN_RESTART_INDEX);
+
+    for (unsigned int i = 0; i < shadowCascades->getCascadeCount(); i++)
+    {
+        if (!shadowCascades->beginCascade(i))
+        {
+            continue;
+        }
+        depthShader.setMat4("lightSpaceMatrix", shadowCascades->getLightSpaceMatrix(i));
+        Frustum casterFrustum = shadowCascades->getCasterFrustum(i);
+        unsigned int casters = 0;
+        for (const auto& [key, chunk] : gpuChunks)
+        {
+            if (!casterFrustum.isBoxVisible(chunk.boundsMin, chunk.boundsMax))
+            {
+                continue;
+            }
+            glBindVertexArray(chunk.vaoId);
+            glDrawElements(GL_TRIANGLE_STRIP, chunkIndexCount, GL_UNSIGNED_INT, 0);
+            casters++;
+        }
+        shadowCascades->endCascade(i, casters);
+    }
+    glBindVertexArray(0);
+
+    glDisable(GL_PRIMITIVE_RESTART);
+}
+
+void draw(Shader& shader)
+{
+    shader.use();
+
+    glm::mat4 view = glm::lookAt(cameraPos, cameraPos + cameraFront, cameraUp);
+    shader.setMat4("view", view);
+
+    glm::mat4 projection = glm::perspective(glm::radians(fov), (float)WINDOW_WIDTH / (float)WINDOW_HEIGHT, NEAR_PLANE, FAR_PLANE);
+    shader.setMat4("projection", projection);
+
+    glm::mat4 model = glm::mat4(1.0f);
+    shader.setMat4("model", model);
+
+    shadowCascades->bind(shader, 0);
+    shader.setBool("showCascades", showCascades);
+
+    // culled before drawing, so the profiler can tell the two apart
+    static std::vector<unsigned int> visibleChunks;
+    visibleChunks.clear();
+    {
+        PROFILE_SCOPE("culling");
+        Frustum frustum(projection * view);
+        for (const auto& [key, chunk] : gpuChunks)
+        {
+            if (frustum.isBoxVisible(chunk.boundsMin, chunk.boundsMax))
+            {
+                visibleChunks.push_back(chunk.vaoId);
+            }
+        }
+    }
+
+    glEnable(GL_PRIMITIVE_RESTART);
+    glPrimitiveRestartIndex(TERRAIN_RESTART_INDEX);
+
+    for (unsigned int vaoId : visibleChunks)
+    {
+        glBindVertexArray(vaoId);
+        glDrawElements(GL_TRIANGLE_STRIP, chunkIndexCount, GL_UNSIGNED_INT, 0);
+    }
+    streamingStats.drawnChunks = (unsigned int)visibleChunks.size();
+    glBindVertexArray(0);
+
+    glDisable(GL_PRIMITIVE_RESTART);
+}
+
+/*
+ * Every chunk has the same grid topology, so they all share one element buffer
+ * and only own a vertex buffer (plus the VAO tying the two together).
+ */
+void storeVertexDataOnGpu()
+{
+    std::vector<unsigned int> indices = buildChunkStripIndices(CHUNK_SIZE);
+    chunkIndexCount = indices.size();
+
+    glGenBuffers(1, &eboId);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, eboId);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), &indices[0], GL_STATIC_DRAW);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+
+    resetTerrainStreamer();
+}
+
+void resetTerrainStreamer()
+{
+    for (auto& [key, chunk] : gpuChunks)
+    {
+        freeChunkBuffers.push_back(chunk);
+    }
+    gpuChunks.clear();
+
+    FbmNoise noise(terrainSeed, noiseOctaves);
+    terrainStreamer = std::make_unique<ChunkStreamer>(noise, chunkGenerationPool, CHUNK_SIZE, TERRAIN_HEIGHT_SCALE);
+    std::cout << "Streaming terrain with seed " << terrainSeed << " (" << (FbmNoise::hasAvx2() ? "AVX2" : "scalar") << " noise)" << std::endl;
+}
+
+/*
+ * Queue the chunks around the camera, recycle the ones that fell out of range,
+ * then upload finished chunks up to this frame's budget.
+ */
+void streamTerrainChunks()
+{
+    evictedChunks.clear();
+    terrainStreamer->update(cameraPos, viewRadiusChunks, evictedChunks);
+    if (cameraPath.isReplaying())
+    {
+        // which chunks are ready mustn't depend on how fast the workers were, or no two replays would match
+        terrainStreamer->waitForGeneration();
+    }
+    for (glm::ivec2 coord : evictedChunks)
+    {
+        auto it = gpuChunks.find(chunkKey(coord));
+        if (it != gpuChunks.end())
+        {
+            shadowCascades->markCastersChanged(it->second.boundsMin, it->second.boundsMax);
+            freeChunkBuffers.push_back(it->second);
+            gpuChunks.erase(it);
+        }
+    }
+
+    auto start = std::chrono::high_resolution_clock::now();
+    readyChunks.clear();
+    terrainStreamer->takeFinished(uploadBudgetPerFrame, readyChunks);
+    for (const GeneratedChunk& chunk : readyChunks)
+    {
+        uploadTerrainChunk(chunk);
+    }
+    streamingStats.uploadedChunks = readyChunks.size();
+    streamingStats.uploadTimeMs = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+void uploadTerrainChunk(const GeneratedChunk& chunk)
+{
+    GpuTerrainChunk gpuChunk;
+    size_t vertexBytes = chunk.vertices.size() * sizeof(float);
+
+    if (!freeChunkBuffers.empty())
+    {
+        gpuChunk = freeChunkBuffers.back();
+        freeChunkBuffers.pop_back();
+
+        glBindBuffer(GL_ARRAY_BUFFER, gpuChunk.vboId);
+        glBufferSubData(GL_ARRAY_BUFFER, 0, vertexBytes, &chunk.vertices[0]);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+    else
+    {
+        glGenVertexArrays(1, &gpuChunk.vaoId);
+        glBindVertexArray(gpuChunk.vaoId);
+
+        glGenBuffers(1, &gpuChunk.vboId);
+        glBindBuffer(GL_ARRAY_BUFFER, gpuChunk.vboId);
+        glBufferData(GL_ARRAY_BUFFER, vertexBytes, &chunk.vertices[0], GL_DYNAMIC_DRAW);
+
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, TERRAIN_VERTEX_FLOATS * sizeof(float), (void*)0);
+        glEnableVertexAttribArray(1);
+        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, TERRAIN_VERTEX_FLOATS * sizeof(float), (void*)(3 * sizeof(float)));
+
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, eboId);
+
+        glBindVertexArray(0);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+
+    gpuChunk.boundsMin = chunk.boundsMin;
+    gpuChunk.boundsMax = chunk.boundsMax;
+    gpuChunks[chunkKey(chunk.coord)] = gpuChunk;
+    shadowCascades->markCastersChanged(chunk.boundsMin, chunk.boundsMax);
+}
+
+void releaseTerrainChunks()
+{
+    for (auto& [key, chunk] : gpuChunks)
+    {
+        freeChunkBuffers.push_back(chunk);
+    }
+    gpuChunks.clear();
+
+    for (GpuTerrainChunk& chunk : freeChunkBuffers)
+    {
+        glDeleteVertexArrays(1, &chunk.vaoId);
+        glDeleteBuffers(1, &chunk.vboId);
+    }
+    freeChunkBuffers.clear();
+}
@@ -0,0 +1,254 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Everything a demo's fly camera is made of.
+struct CameraState {
+    glm::vec3 position;
+    glm::vec3 front;
+    float yaw;
+    float pitch;
+    float fov;
+};
+
+/*
+ * Records the camera of a live run and plays it back, so benchmark and regression runs all see the same frames:
+ *
+ *     ./application.exe --record path.cam      // fly around, the path is written on exit (or toggle with a key)
+ *     ./application.exe --replay path.cam      // the same flight, one fixed timestep per frame, then exit
+ *
+ *     cameraPath.parseArguments(argc, argv);   // takes its own options out of argv, before other parsers see it
+ *     ... every frame, after input:
+ *     if (cameraPath.isReplaying())
+ *     {
+ *         CameraState state = cameraPath.next();      // instead of what the input did to the camera
+ *         deltaTime = cameraPath.getTimestep();
+ *     }
+ *     else if (cameraPath.isRecording())
+ *     {
+ *         cameraPath.record(deltaTime, state);
+ *     }
+ *
+ * Live frames come at whatever rate the machine manages, so stopRecording() resamples the recording to one state every
+ * `timestep` seconds, interpolating between the recorded frames. A replay then renders the same number of frames with
+ * the same cameras on every machine, and the demo's clock advances by exactly `timestep` each of them.
+ * Whatever else differs per run has to stay out of the frames too: the demos draw no UI while replaying, since it shows
+ * live timings and ImGui animates on wall-clock time.
+ *
+ * The file is the 16 byte header {"CAMP", version, frame count, timestep} and 36 bytes (9 floats) per frame, all in
+ * the byte order of the machine that wrote it: a minute at 60 frames per second is about 130 KB.
+ */
+class CameraPath
+{
+    public:
+        static constexpr uint32_t VERSION = 1;
+
+        // Removes --record FILE and --replay FILE from argv, false if a replay file can't be read.
+        bool parseArguments(int& argc, char** argv)
+        {
+            int kept = 1;
+            bool ok = true;
+            for (int i = 1; i < argc; i++)
+            {
+                std::string argument = argv[i];
+                if (argument == "--record" && i + 1 < argc)
+                {
+                    startRecording(argv[++i]);
+                }
+                else if (argument == "--replay" && i + 1 < argc)
+                {
+                    ok = startReplay(argv[++i]) && ok;
+                }
+                else
+                {
+                    argv[kept++] = argv[i];
+                }
+            }
+            argc = kept;
+            return ok;
+        }
+
+        void startRecording(const std::string& path, float timestep = 1.0f / 60.0f)
+        {
+            recordPath = path;
+            this->timestep = timestep;
+            recorded.clear();
+            recordedTimes.clear();
+            recordedTime = 0.0f;
+            recording = true;
+            replaying = false;
+            std::cout << "Recording the camera path to " << path << std::endl;
+        }
+
+        // The camera as it was rendered this frame, `deltaTime` seconds after the previous one.
+        void record(float deltaTime, const CameraState& state)
+        {
+            if (!recording)
+            {
+                return;
+            }
+            if (!recorded.empty())
+            {
+                recordedTime += std::max(deltaTime, 0.0f);
+            }
+            recordedTimes.push_back(recordedTime);
+            recorded.push_back(state);
+        }
+
+        // Resample what was recorded and write it, false if there was nothing or the file can't be written.
+        bool stopRecording()
+        {
+            if (!recording)
+            {
+                return false;
+            }
+            recording = false;
+            if (recorded.empty())
+            {
+                return false;
+            }
+
+            frames.clear();
+            size_t source = 0;
+            for (float time = 0.0f; time <= recordedTime; time = frames.size() * timestep)
+            {
+                while (source + 1 < recorded.size() && recordedTimes[source + 1] < time)
+                {
+                    source++;
+                }
+                if (source + 1 == recorded.size())
+                {
+                    frames.push_back(recorded.back());
+                    continue;
+                }
+                float span = recordedTimes[source + 1] - recordedTimes[source];
+                float t = span > 0.0f ? (time - recordedTimes[source]) / span : 1.0f;
+                frames.push_back(interpolate(recorded[source], recorded[source + 1], glm::clamp(t, 0.0f, 1.0f)));
+            }
+
+            std::ofstream file(recordPath, std::ios::binary);
+            if (!file)
+            {
+                std::cout << "ERROR::CAMERA_PATH::FILE_NOT_WRITTEN: " << recordPath << std::endl;
+                return false;
+            }
+            uint32_t frameCount = (uint32_t)frames.size();
+            file.write("CAMP", 4);
+            file.write((const char*)&VERSION, sizeof(VERSION));
+            file.write((const char*)&frameCount, sizeof(frameCount));
+            file.write((const char*)&timestep, sizeof(timestep));
+            file.write((const char*)frames.data(), frames.size() * sizeof(CameraState));
+            std::cout << "Camera path: " << recorded.size() << " recorded frames over " << recordedTime << " s, "
+                      << frameCount << " frames at " << 1.0f / timestep << " fps written to " << recordPath << std::endl;
+            return true;
+        }
+
+        bool startReplay(const std::string& path)
+        {
+            std::ifstream file(path, std::ios::binary);
+            char magic[4] = {};
+            uint32_t version = 0, frameCount = 0;
+            float fileTimestep = 0.0f;
+            file.read(magic, 4);
+            file.read((char*)&version, sizeof(version));
+            file.read((char*)&frameCount, sizeof(frameCount));
+            file.read((char*)&fileTimestep, sizeof(fileTimestep));
+            if (!file || std::memcmp(magic, "CAMP", 4) != 0 || version != VERSION || fileTimestep <= 0.0f)
+            {
+                std::cout << "ERROR::CAMERA_PATH::NOT_A_CAMERA_PATH: " << path << std::endl;
+                return false;
+            }
+            // the count comes from the file, it mustn't ask for more frames than the file holds
+            std::streamoff headerEnd = file.tellg();
+            file.seekg(0, std::ios::end);
+            std::streamoff remaining = file.tellg() - headerEnd;
+            file.seekg(headerEnd);
+            if (frameCount == 0 || (uint64_t)frameCount * sizeof(CameraState) > (uint64_t)remaining)
+            {
+                std::cout << "ERROR::CAMERA_PATH::TRUNCATED: " << path << std::endl;
+                return false;
+            }
+            frames.resize(frameCount);
+            file.read((char*)frames.data(), frames.size() * sizeof(CameraState));
+            if (!file)
+            {
+                std::cout << "ERROR::CAMERA_PATH::TRUNCATED: " << path << std::endl;
+                frames.clear();
+                return false;
+            }
+
+            timestep = fileTimestep;
+            nextFrame = 0;
+            replaying = true;
+            recording = false;
+            std::cout << "Replaying " << frameCount << " camera frames at " << 1.0f / timestep << " fps from " << path << std::endl;
+            return true;
+        }
+
+        // The camera for this frame. Past the end it stays on the last one and isFinished() is true.
+        CameraState next()
+        {
+            CameraState state = frames[std::min(nextFrame, frames.size() - 1)];
+            nextFrame++;
+            return state;
+        }
+
+        bool isRecording() const
+        {
+            return recording;
+        }
+
+        bool isReplaying() const
+        {
+            return replaying;
+        }
+
+        // Every frame of the replay has been handed out.
+        bool isFinished() const
+        {
+            return replaying && nextFrame >= frames.size();
+        }
+
+        float getTimestep() const
+        {
+            return timestep;
+        }
+
+    private:
+        static CameraState interpolate(const CameraState& a, const CameraState& b, float t)
+        {
+            glm::vec3 front = glm::mix(a.front, b.front, t);
+            return {
+                glm::mix(a.position, b.position, t),
+                glm::length(front) > 0.0f ? glm::normalize(front) : b.front,
+                glm::mix(a.yaw, b.yaw, t),
+                glm::mix(a.pitch, b.pitch, t),
+                glm::mix(a.fov, b.fov, t)
+            };
+        }
+
+        static_assert(sizeof(CameraState) == 9 * sizeof(float), "CameraState is written to the file as 9 floats");
+
+    private:
+        bool recording = false;
+        bool replaying = false;
+        float timestep = 1.0f / 60.0f;
+
+        std::string recordPath;
+        std::vector<CameraState> recorded;
+        std::vector<float> recordedTimes;
+        float recordedTime = 0.0f;
+
+        std::vector<CameraState> frames;    // at `timestep` apart, saved or replayed
+        size_t nextFrame = 0;
+};
+
+inline CameraPath cameraPath;
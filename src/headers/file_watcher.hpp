@@ -0,0 +1,122 @@
+#pragma once
+
+#include <filesystem>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+/*
+ * Reports files that were written since the last poll(), without blocking:
+ *
+ *     FileWatcher watcher;
+ *     watcher.watch("data/shaders/shader.fs");
+ *     for (const std::string& path : watcher.poll()) { ... }   // once a frame
+ *
+ * On Linux the parent directories are watched with inotify, so editors that save through a temporary file
+ * and a rename are noticed as well. Elsewhere poll() compares modification times, which is fine for the
+ * handful of files a demo watches. Paths are reported exactly as they were passed to watch().
+ */
+class FileWatcher
+{
+    public:
+        FileWatcher()
+        {
+#ifdef __linux__
+            inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+#endif
+        }
+
+        ~FileWatcher()
+        {
+#ifdef __linux__
+            if (inotifyFd >= 0)
+            {
+                close(inotifyFd);
+            }
+#endif
+        }
+
+        FileWatcher(const FileWatcher&) = delete;
+        FileWatcher& operator=(const FileWatcher&) = delete;
+
+        void watch(const std::string& path)
+        {
+            std::filesystem::path file(path);
+            std::string directory = file.has_parent_path() ? file.parent_path().string() : std::string(".");
+            watched[directory + '/' + file.filename().string()] = path;
+
+            std::error_code error;
+            modified[path] = std::filesystem::last_write_time(path, error);
+
+#ifdef __linux__
+            if (inotifyFd >= 0 && watchedDirectories.count(directory) == 0)
+            {
+                int wd = inotify_add_watch(inotifyFd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+                if (wd >= 0)
+                {
+                    directories[wd] = directory;
+                    watchedDirectories.insert(directory);
+                }
+            }
+#endif
+        }
+
+        // Watched files written since the last call, each reported once however many events it caused.
+        std::vector<std::string> poll()
+        {
+            std::unordered_set<std::string> changed;
+#ifdef __linux__
+            if (inotifyFd >= 0)
+            {
+                alignas(inotify_event) char buffer[4096];
+                ssize_t length;
+                while ((length = read(inotifyFd, buffer, sizeof(buffer))) > 0)
+                {
+                    for (char* next = buffer; next < buffer + length; )
+                    {
+                        const inotify_event* event = (const inotify_event*) next;
+                        next += sizeof(inotify_event) + event->len;
+                        auto directory = directories.find(event->wd);
+                        if (event->len == 0 || directory == directories.end())
+                        {
+                            continue;
+                        }
+                        auto file = watched.find(directory->second + '/' + event->name);
+                        if (file != watched.end())
+                        {
+                            changed.insert(file->second);
+                        }
+                    }
+                }
+                return std::vector<std::string>(changed.begin(), changed.end());
+            }
+#endif
+            for (auto& [path, lastWrite] : modified)
+            {
+                std::error_code error;
+                auto writeTime = std::filesystem::last_write_time(path, error);
+                if (!error && writeTime != lastWrite)
+                {
+                    lastWrite = writeTime;
+                    changed.insert(path);
+                }
+            }
+            return std::vector<std::string>(changed.begin(), changed.end());
+        }
+
+    private:
+        // directory + '/' + file name -> path as given to watch()
+        std::unordered_map<std::string, std::string> watched;
+        std::unordered_map<std::string, std::filesystem::file_time_type> modified;
+#ifdef __linux__
+        int inotifyFd = -1;
+        std::unordered_map<int, std::string> directories;
+        std::unordered_set<std::string> watchedDirectories;
+#endif
+};
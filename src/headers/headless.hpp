@@ -0,0 +1,339 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+/*
+ * Runs a demo without showing anything, for benchmarks on machines with no display and no GPU (Mesa llvmpipe):
+ *
+ *     ./application.exe --headless --frames 500 --warmup 20 --size 1920x1080 --screenshot last_frame.png
+ *
+ *     headless.parseArguments(argc, argv);
+ *     headless.initGlfw();                          // instead of glfwInit(), before the window hints
+ *     ... create the window (headless.width x headless.height when enabled), load glad ...
+ *     if (!headless.createTarget()) return -1;      // false when --size is more than the driver can render
+ *     while (!glfwWindowShouldClose(window))
+ *     {
+ *         ... draw into headless.framebuffer() wherever the demo drew into 0 ...
+ *         ... the UI only if !headless.enabled, its live timings would make every screenshot different ...
+ *         headless.present(window);                 // instead of glfwSwapBuffers(window)
+ *     }
+ *     headless.finish();                            // statistics and screenshot, while the context is still there
+ *
+ * Without --headless all of these do what the demo did before: present() swaps and framebuffer() is 0.
+ *
+ * With it the window is never shown and everything goes to an RGBA8 + depth/stencil framebuffer object, so it doesn't
+ * matter whether the window has a surface at all. With neither DISPLAY nor WAYLAND_DISPLAY set, GLFW 3.4 is started on
+ * its null platform with an EGL context, which Mesa makes surfaceless (LIBGL_ALWAYS_SOFTWARE=1 forces llvmpipe).
+ * Older GLFW needs a display, an invisible window on Xvfb does the job.
+ *
+ * present() waits for the GPU with glFinish(), so a frame's time covers its rendering and not only its submission,
+ * and closes the window after `frames` frames. finish() prints mean, p50, p95 and p99 over the frames after the warm
+ * up, and writes the last frame as a PNG if asked to.
+ */
+class HeadlessMode
+{
+    public:
+        bool enabled = false;
+        unsigned int frames = 300;
+        unsigned int warmupFrames = 10;     // not in the statistics: shader compiles, first uploads, caches filling
+        int width = 1280;
+        int height = 720;
+        std::string screenshotPath;
+
+        // Picks out the options above, false (after printing the usage) on anything it doesn't know.
+        bool parseArguments(int argc, char** argv)
+        {
+            for (int i = 1; i < argc; i++)
+            {
+                std::string argument = argv[i];
+                bool hasValue = i + 1 < argc;
+                if (argument == "--headless")
+                {
+                    enabled = true;
+                }
+                else if (argument == "--frames" && hasValue)
+                {
+                    frames = std::max(1, std::atoi(argv[++i]));
+                }
+                else if (argument == "--warmup" && hasValue)
+                {
+                    warmupFrames = std::max(0, std::atoi(argv[++i]));
+                }
+                else if (argument == "--size" && hasValue)
+                {
+                    // the upper limit is GL_MAX_RENDERBUFFER_SIZE, checked in createTarget() once GL is loaded
+                    int sizeWidth = 0, sizeHeight = 0;
+                    char trailing;
+                    if (std::sscanf(argv[++i], "%dx%d%c", &sizeWidth, &sizeHeight, &trailing) != 2 || sizeWidth <= 0 || sizeHeight <= 0)
+                    {
+                        std::cout << "Invalid size " << argv[i] << ", ";
+                        printUsage(argv[0]);
+                        return false;
+                    }
+                    width = sizeWidth;
+                    height = sizeHeight;
+                }
+                else if (argument == "--screenshot" && hasValue)
+                {
+                    screenshotPath = argv[++i];
+                }
+                else
+                {
+                    std::cout << "Unknown argument " << argument << ", ";
+                    printUsage(argv[0]);
+                    return false;
+                }
+            }
+            program = argv[0];
+            return true;
+        }
+
+        bool initGlfw()
+        {
+#if defined(__linux__) && defined(GLFW_PLATFORM_NULL)
+            if (enabled && std::getenv("DISPLAY") == nullptr && std::getenv("WAYLAND_DISPLAY") == nullptr)
+            {
+                glfwInitHint(GLFW_PLATFORM, GLFW_PLATFORM_NULL);
+                nullPlatform = true;
+            }
+#endif
+            if (!glfwInit())
+            {
+                return false;
+            }
+            if (enabled)
+            {
+                glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+            }
+            if (nullPlatform)
+            {
+                glfwWindowHint(GLFW_CONTEXT_CREATION_API, GLFW_EGL_CONTEXT_API);
+            }
+            return true;
+        }
+
+        // The framebuffer object everything is drawn into, once the GL functions are loaded.
+        // False (after printing the usage) when --size asked for more than a renderbuffer can hold.
+        bool createTarget()
+        {
+            if (!enabled)
+            {
+                return true;
+            }
+            GLint maxSize = 0;
+            glGetIntegerv(GL_MAX_RENDERBUFFER_SIZE, &maxSize);
+            if (width > maxSize || height > maxSize)
+            {
+                std::cout << "Invalid size " << width << "x" << height << ", at most " << maxSize << "x" << maxSize << " here, ";
+                printUsage(program.c_str());
+                return false;
+            }
+            glGenFramebuffers(1, &target);
+            glGenRenderbuffers(2, renderbuffers);
+            glBindRenderbuffer(GL_RENDERBUFFER, renderbuffers[0]);
+            glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+            glBindRenderbuffer(GL_RENDERBUFFER, renderbuffers[1]);
+            glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
+            glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+            glBindFramebuffer(GL_FRAMEBUFFER, target);
+            glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, renderbuffers[0]);
+            glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, renderbuffers[1]);
+            if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+            {
+                std::cout << "ERROR::HEADLESS::FRAMEBUFFER_INCOMPLETE" << std::endl;
+            }
+            glViewport(0, 0, width, height);
+
+            const char* renderer = (const char*)glGetString(GL_RENDERER);
+            std::cout << "Headless: " << frames << " frames at " << width << "x" << height << " on " << (renderer ? renderer : "?")
+                      << (nullPlatform ? " (GLFW null platform, EGL)" : " (invisible window)") << std::endl;
+            lastPresent = std::chrono::steady_clock::now();
+            return true;
+        }
+
+        unsigned int framebuffer() const
+        {
+            return target;
+        }
+
+        void present(GLFWwindow* window)
+        {
+            if (!enabled)
+            {
+                glfwSwapBuffers(window);
+                return;
+            }
+            glFinish();
+            auto now = std::chrono::steady_clock::now();
+            frameMs.push_back(std::chrono::duration<float, std::milli>(now - lastPresent).count());
+            lastPresent = now;
+            if (frameMs.size() >= frames)
+            {
+                glfwSetWindowShouldClose(window, true);
+            }
+        }
+
+        void finish()
+        {
+            if (!enabled)
+            {
+                return;
+            }
+            printStatistics();
+            if (!screenshotPath.empty())
+            {
+                writeScreenshot(screenshotPath);
+            }
+            glBindFramebuffer(GL_FRAMEBUFFER, 0);
+            glDeleteFramebuffers(1, &target);
+            glDeleteRenderbuffers(2, renderbuffers);
+            target = 0;
+        }
+
+    private:
+        static void printUsage(const char* program)
+        {
+            std::cout << "usage: " << program
+                      << " [--headless] [--frames N] [--warmup N] [--size WIDTHxHEIGHT] [--screenshot file.png]" << std::endl;
+        }
+
+        void printStatistics() const
+        {
+            if (frameMs.size() <= warmupFrames)
+            {
+                std::cout << "Headless: only " << frameMs.size() << " frames, all of them warm up" << std::endl;
+                return;
+            }
+            std::vector<float> sorted(frameMs.begin() + warmupFrames, frameMs.end());
+            std::sort(sorted.begin(), sorted.end());
+            double total = 0.0;
+            for (float ms : sorted)
+            {
+                total += ms;
+            }
+            float mean = (float)(total / sorted.size());
+            std::cout << "Headless: " << sorted.size() << " frames after " << warmupFrames << " warm up, "
+                      << "mean " << mean << " ms (" << 1000.0f / mean << " fps), "
+                      << "p50 " << percentile(sorted, 0.50f) << " ms, p95 " << percentile(sorted, 0.95f) << " ms, "
+                      << "p99 " << percentile(sorted, 0.99f) << " ms, min " << sorted.front() << " ms, max " << sorted.back() << " ms" << std::endl;
+        }
+
+        // nearest rank, `sorted` ascending
+        static float percentile(const std::vector<float>& sorted, float fraction)
+        {
+            size_t rank = (size_t)std::ceil(fraction * sorted.size());
+            return sorted[std::min(std::max(rank, (size_t)1), sorted.size()) - 1];
+        }
+
+        /*
+         * The colour attachment as an 8 bit RGB PNG. The image data goes into stored (uncompressed) deflate blocks,
+         * which every PNG reader accepts, so this needs no zlib; a 1280x720 frame is about 2.7 MB.
+         */
+        void writeScreenshot(const std::string& path) const
+        {
+            std::vector<unsigned char> pixels((size_t)width * height * 3);
+            glBindFramebuffer(GL_READ_FRAMEBUFFER, target);
+            glPixelStorei(GL_PACK_ALIGNMENT, 1);
+            glReadPixels(0, 0, width, height, GL_RGB, GL_UNSIGNED_BYTE, pixels.data());
+
+            // filter type 0 in front of every row, rows top down where GL reads them bottom up
+            size_t rowSize = (size_t)width * 3;
+            std::vector<unsigned char> raw;
+            raw.reserve((rowSize + 1) * height);
+            for (int y = height - 1; y >= 0; y--)
+            {
+                raw.push_back(0);
+                raw.insert(raw.end(), pixels.begin() + y * rowSize, pixels.begin() + (y + 1) * rowSize);
+            }
+
+            std::vector<unsigned char> zlib = {0x78, 0x01};
+            for (size_t offset = 0; offset < raw.size(); offset += 65535)
+            {
+                size_t length = std::min(raw.size() - offset, (size_t)65535);
+                zlib.push_back(offset + length == raw.size() ? 1 : 0);
+                zlib.push_back(length & 0xff);
+                zlib.push_back(length >> 8);
+                zlib.push_back(~length & 0xff);
+                zlib.push_back((~length >> 8) & 0xff);
+                zlib.insert(zlib.end(), raw.begin() + offset, raw.begin() + offset + length);
+            }
+            uint32_t a = 1, b = 0;
+            for (unsigned char byte : raw)
+            {
+                a = (a + byte) % 65521;
+                b = (b + a) % 65521;
+            }
+            appendBigEndian(zlib, (b << 16) | a);
+
+            std::vector<unsigned char> header;
+            appendBigEndian(header, (uint32_t)width);
+            appendBigEndian(header, (uint32_t)height);
+            header.insert(header.end(), {8, 2, 0, 0, 0});   // 8 bits, RGB, deflate, no filter, no interlace
+
+            std::ofstream file(path, std::ios::binary);
+            if (!file)
+            {
+                std::cout << "ERROR::HEADLESS::SCREENSHOT_NOT_WRITTEN: " << path << std::endl;
+                return;
+            }
+            const unsigned char signature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n'};
+            file.write((const char*)signature, 8);
+            writeChunk(file, "IHDR", header);
+            writeChunk(file, "IDAT", zlib);
+            writeChunk(file, "IEND", {});
+            std::cout << "Headless: last frame written to " << path << std::endl;
+        }
+
+        static void appendBigEndian(std::vector<unsigned char>& bytes, uint32_t value)
+        {
+            for (int shift = 24; shift >= 0; shift -= 8)
+            {
+                bytes.push_back((value >> shift) & 0xff);
+            }
+        }
+
+        static void writeChunk(std::ofstream& file, const char* type, const std::vector<unsigned char>& data)
+        {
+            std::vector<unsigned char> chunk;
+            appendBigEndian(chunk, (uint32_t)data.size());
+            chunk.insert(chunk.end(), type, type + 4);
+            chunk.insert(chunk.end(), data.begin(), data.end());
+
+            // CRC-32 of the type and the data
+            uint32_t crc = 0xffffffff;
+            for (size_t i = 4; i < chunk.size(); i++)
+            {
+                crc ^= chunk[i];
+                for (int bit = 0; bit < 8; bit++)
+                {
+                    crc = (crc >> 1) ^ (0xedb88320 & (0u - (crc & 1)));
+                }
+            }
+            appendBigEndian(chunk, ~crc);
+            file.write((const char*)chunk.data(), chunk.size());
+        }
+
+    private:
+        std::string program;
+        bool nullPlatform = false;
+        unsigned int target = 0;
+        unsigned int renderbuffers[2] = {0, 0};
+        std::chrono::steady_clock::time_point lastPresent;
+        std::vector<float> frameMs;
+};
+
+inline HeadlessMode headless;
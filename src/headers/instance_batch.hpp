@@ -0,0 +1,183 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+
+/*
+ * Per-instance data as instanced vertex attributes (divisor 1), for any struct that lists its members:
+ *
+ *     struct WallInstance {
+ *         glm::vec3 offset;
+ *         glm::vec4 color;
+ *         static constexpr auto attributes = std::make_tuple(&WallInstance::offset, &WallInstance::color);
+ *     };
+ *
+ *     InstanceBatch<WallInstance> walls(2);   // offset at location 2, color at location 3
+ *     walls.attach(vaoId);
+ *     walls.upload(instances);                // once, or whenever the instances change
+ *     walls.drawElements(GL_TRIANGLES, indexCount);
+ *
+ * The attribute types, locations and stride are worked out at compile time from the member types
+ * (float, int and unsigned scalars and vectors, mat3 and mat4 which take one location per column).
+ * There is no instance limit beyond GPU memory, and nothing per instance happens on the CPU when drawing.
+ */
+
+template <typename Attribute>
+struct InstanceAttributeTraits;
+
+template <glm::length_t Components, typename Scalar, GLenum Type, bool Integer>
+struct InstanceAttributeTraitsBase {
+    static constexpr GLint components = Components;
+    static constexpr GLenum type = Type;
+    static constexpr bool integer = Integer;   // read through glVertexAttribIPointer, as int/uint in the shader
+    static constexpr unsigned int columns = 1;
+    static constexpr size_t columnSize = Components * sizeof(Scalar);
+};
+
+template <> struct InstanceAttributeTraits<float> : InstanceAttributeTraitsBase<1, float, GL_FLOAT, false> {};
+template <> struct InstanceAttributeTraits<int> : InstanceAttributeTraitsBase<1, int, GL_INT, true> {};
+template <> struct InstanceAttributeTraits<unsigned int> : InstanceAttributeTraitsBase<1, unsigned int, GL_UNSIGNED_INT, true> {};
+template <glm::length_t L, glm::qualifier Q>
+struct InstanceAttributeTraits<glm::vec<L, float, Q>> : InstanceAttributeTraitsBase<L, float, GL_FLOAT, false> {};
+template <glm::length_t L, glm::qualifier Q>
+struct InstanceAttributeTraits<glm::vec<L, int, Q>> : InstanceAttributeTraitsBase<L, int, GL_INT, true> {};
+template <glm::length_t L, glm::qualifier Q>
+struct InstanceAttributeTraits<glm::vec<L, unsigned int, Q>> : InstanceAttributeTraitsBase<L, unsigned int, GL_UNSIGNED_INT, true> {};
+
+// Square matrices are passed column by column: a mat4 member is `layout (location = n) in mat4` and uses n .. n + 3.
+template <glm::length_t C, glm::length_t R, glm::qualifier Q>
+struct InstanceAttributeTraits<glm::mat<C, R, float, Q>> : InstanceAttributeTraitsBase<R, float, GL_FLOAT, false> {
+    static constexpr unsigned int columns = C;
+};
+
+template <typename Instance, typename Members>
+struct InstanceLayout;
+
+template <typename Instance, typename... Attributes>
+struct InstanceLayout<Instance, std::tuple<Attributes Instance::*...>> {
+    static constexpr unsigned int locationCount = (InstanceAttributeTraits<Attributes>::columns + ... + 0u);
+};
+
+template <typename Instance>
+class InstanceBatch
+{
+    static_assert(std::is_trivially_copyable<Instance>::value, "instances are copied to the GPU byte for byte");
+    static_assert(std::is_default_constructible<Instance>::value, "member offsets are measured on a default constructed instance");
+
+    public:
+        // Vertex attribute locations [firstLocation, firstLocation + locationCount) hold the instance members, in declaration order.
+        static constexpr unsigned int locationCount = InstanceLayout<Instance, std::decay_t<decltype(Instance::attributes)>>::locationCount;
+
+        explicit InstanceBatch(unsigned int firstLocation)
+            : firstLocation(firstLocation)
+        {
+            glGenBuffers(1, &buffer);
+        }
+
+        ~InstanceBatch()
+        {
+            glDeleteBuffers(1, &buffer);
+        }
+
+        InstanceBatch(const InstanceBatch&) = delete;
+        InstanceBatch& operator=(const InstanceBatch&) = delete;
+
+        // Point the instance attributes of `vertexArray` at this batch, the vertex data stays as it is.
+        void attach(unsigned int vertexArray)
+        {
+            vao = vertexArray;
+            glBindVertexArray(vao);
+            glBindBuffer(GL_ARRAY_BUFFER, buffer);
+
+            Instance probe{};
+            unsigned int location = firstLocation;
+            std::apply([&](auto... members) { (attachMember(probe, members, location), ...); }, Instance::attributes);
+
+            glBindVertexArray(0);
+            glBindBuffer(GL_ARRAY_BUFFER, 0);
+        }
+
+        // Replace every instance with one buffer upload (the old storage is orphaned, so the GPU never waits on it).
+        void upload(const Instance* instances, size_t count)
+        {
+            glBindBuffer(GL_ARRAY_BUFFER, buffer);
+            if (count > capacity)
+            {
+                capacity = count;
+            }
+            glBufferData(GL_ARRAY_BUFFER, capacity * sizeof(Instance), NULL, GL_STATIC_DRAW);
+            glBufferSubData(GL_ARRAY_BUFFER, 0, count * sizeof(Instance), instances);
+            glBindBuffer(GL_ARRAY_BUFFER, 0);
+            instanceCount = count;
+        }
+
+        void upload(const std::vector<Instance>& instances)
+        {
+            upload(instances.data(), instances.size());
+        }
+
+        // Overwrite [first, first + count) of the uploaded instances in place.
+        void update(size_t first, size_t count, const Instance* instances)
+        {
+            glBindBuffer(GL_ARRAY_BUFFER, buffer);
+            glBufferSubData(GL_ARRAY_BUFFER, first * sizeof(Instance), count * sizeof(Instance), instances);
+            glBindBuffer(GL_ARRAY_BUFFER, 0);
+        }
+
+        // Draw every uploaded instance of the attached vertex array's indexed mesh.
+        void drawElements(GLenum mode, GLsizei indexCount, GLenum indexType = GL_UNSIGNED_INT) const
+        {
+            glBindVertexArray(vao);
+            glDrawElementsInstanced(mode, indexCount, indexType, 0, static_cast<GLsizei>(instanceCount));
+        }
+
+        void drawArrays(GLenum mode, GLint firstVertex, GLsizei vertexCount) const
+        {
+            glBindVertexArray(vao);
+            glDrawArraysInstanced(mode, firstVertex, vertexCount, static_cast<GLsizei>(instanceCount));
+        }
+
+        size_t size() const
+        {
+            return instanceCount;
+        }
+
+        unsigned int id() const
+        {
+            return buffer;
+        }
+
+    private:
+        template <typename Attribute>
+        static void attachMember(const Instance& probe, Attribute Instance::* member, unsigned int& location)
+        {
+            using Traits = InstanceAttributeTraits<Attribute>;
+            size_t offset = reinterpret_cast<const char*>(&(probe.*member)) - reinterpret_cast<const char*>(&probe);
+            for (unsigned int column = 0; column < Traits::columns; column++, location++)
+            {
+                const void* pointer = (const void*)(offset + column * Traits::columnSize);
+                if (Traits::integer)
+                {
+                    glVertexAttribIPointer(location, Traits::components, Traits::type, sizeof(Instance), pointer);
+                }
+                else
+                {
+                    glVertexAttribPointer(location, Traits::components, Traits::type, GL_FALSE, sizeof(Instance), pointer);
+                }
+                glEnableVertexAttribArray(location);
+                glVertexAttribDivisor(location, 1);
+            }
+        }
+
+    private:
+        unsigned int buffer = 0;
+        unsigned int vao = 0;
+        unsigned int firstLocation;
+        size_t instanceCount = 0;
+        size_t capacity = 0;
+};
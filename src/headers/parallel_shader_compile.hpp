@@ -0,0 +1,43 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include <string>
+
+#ifndef GL_COMPLETION_STATUS_KHR
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+#endif
+
+/*
+ * Let the driver compile and link on its own threads (GL_KHR_parallel_shader_compile, or the ARB version).
+ * glCompileShader and glLinkProgram then only queue the work: queue every program first and query them after,
+ * or poll GL_COMPLETION_STATUS_KHR, and nothing waits for a compile that isn't needed yet.
+ * glad only loads GL 3.3, so the entry point comes from `load`. False if neither extension is exposed.
+ */
+inline bool enableParallelShaderCompile(GLADloadproc load)
+{
+    typedef void (APIENTRYP MaxShaderCompilerThreadsProc)(GLuint count);
+    MaxShaderCompilerThreadsProc maxShaderCompilerThreads = nullptr;
+    GLint extensionCount = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &extensionCount);
+    for (GLint i = 0; i < extensionCount && !maxShaderCompilerThreads; i++)
+    {
+        std::string extension = (const char*) glGetStringi(GL_EXTENSIONS, i);
+        if (extension == "GL_KHR_parallel_shader_compile")
+        {
+            maxShaderCompilerThreads = (MaxShaderCompilerThreadsProc) load("glMaxShaderCompilerThreadsKHR");
+        }
+        else if (extension == "GL_ARB_parallel_shader_compile")
+        {
+            maxShaderCompilerThreads = (MaxShaderCompilerThreadsProc) load("glMaxShaderCompilerThreadsARB");
+        }
+    }
+
+    if (!maxShaderCompilerThreads)
+    {
+        return false;
+    }
+    // as many threads as the driver likes
+    maxShaderCompilerThreads(0xFFFFFFFF);
+    return true;
+}
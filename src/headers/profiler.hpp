@@ -0,0 +1,397 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include "imgui.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+/*
+ * Where the frame time goes, on the CPU and on the GPU:
+ *
+ *     PROFILE_FRAME();                        // first thing in the render loop
+ *     {
+ *         PROFILE_SCOPE("input");             // CPU time until the end of the block
+ *         processInput(window);
+ *     }
+ *     {
+ *         PROFILE_GPU_SCOPE("draw");          // CPU time and a GL_TIME_ELAPSED query around the block
+ *         draw(shader);
+ *     }
+ *     profiler.drawOverlay(&open);            // between ImGui::NewFrame() and ImGui::Render()
+ *     profiler.exportChromeTrace("profile_trace.json");
+ *
+ * Scopes nest, the overlay indents them and chrome://tracing (or ui.perfetto.dev) stacks them. GL_TIME_ELAPSED
+ * queries can't nest though, so a GPU scope opened inside another one is timed on the CPU only.
+ * A query is only read once GL_QUERY_RESULT_AVAILABLE says so, a few frames later, and queries come from a pool that
+ * grows to however many are in flight, so reading them never waits for the GPU.
+ *
+ * The last HISTORY frames are kept for the graphs and the trace. GPU scopes go on their own track in the trace, starting
+ * where their CPU scope started: GL_TIME_ELAPSED has durations, not timestamps, so that is only where they were queued.
+ *
+ * Compile with -DPROFILER_ENABLED=0 and the macros expand to nothing, the overlay and trace stay empty.
+ * release() deletes the queries and has to be called while the GL context is still there.
+ */
+
+#ifndef PROFILER_ENABLED
+#define PROFILER_ENABLED 1
+#endif
+
+class Profiler
+{
+    public:
+        static const unsigned int HISTORY = 240;
+
+        struct Event {
+            const char* name;
+            double startMs;         // since the profiler was created
+            double cpuMs;
+            double gpuMs;           // negative for CPU only scopes and while the query is in flight
+            unsigned int depth;
+            unsigned int query;     // 0 for CPU only scopes
+        };
+
+        Profiler()
+            : origin(std::chrono::steady_clock::now())
+        {
+        }
+
+        Profiler(const Profiler&) = delete;
+        Profiler& operator=(const Profiler&) = delete;
+
+        // Close the previous frame, read the queries that finished since, and start the next frame.
+        void beginFrame()
+        {
+            double now = elapsedMs();
+            if (frameOpen)
+            {
+                Frame& last = frames[frameCount % HISTORY];
+                last.cpuMs = now - last.startMs;
+                recordCpu(last);
+                frameCount++;
+            }
+            resolveQueries();
+
+            Frame& frame = frames[frameCount % HISTORY];
+            for (const Event& event : frame.events)
+            {
+                if (event.query != 0 && event.gpuMs < 0.0)
+                {
+                    freeQueries.push_back(event.query);     // HISTORY frames and still not back, reused unread
+                }
+            }
+            frame.index = frameCount;
+            frame.startMs = now;
+            frame.cpuMs = 0.0;
+            frame.events.clear();
+            frameOpen = true;
+            depth = 0;
+            openGpuEvent = -1;
+        }
+
+        // The index of the new event, for endScope(). Prefer the PROFILE_ macros, which pair the two up.
+        int beginScope(const char* name, bool gpu)
+        {
+            if (!frameOpen)
+            {
+                return -1;
+            }
+            Frame& frame = frames[frameCount % HISTORY];
+            Event event = {name, elapsedMs(), 0.0, -1.0, depth++, 0};
+            if (gpu && openGpuEvent < 0)
+            {
+                event.query = acquireQuery();
+                glBeginQuery(GL_TIME_ELAPSED, event.query);
+                openGpuEvent = (int)frame.events.size();
+            }
+            frame.events.push_back(event);
+            return (int)frame.events.size() - 1;
+        }
+
+        void endScope(int index)
+        {
+            Frame& frame = frames[frameCount % HISTORY];
+            if (index < 0 || index >= (int)frame.events.size())
+            {
+                return;
+            }
+            Event& event = frame.events[index];
+            event.cpuMs = elapsedMs() - event.startMs;
+            if (index == openGpuEvent)
+            {
+                glEndQuery(GL_TIME_ELAPSED);
+                inFlight.push_back({frame.index, (unsigned int)index});
+                openGpuEvent = -1;
+            }
+            depth--;
+        }
+
+        // A window with the frame time and every scope seen so far: the last CPU and GPU times and their graphs.
+        void drawOverlay(bool* open)
+        {
+            if (!ImGui::Begin("Profiler", open))
+            {
+                ImGui::End();
+                return;
+            }
+            unsigned int offset = frameCount % HISTORY;   // the oldest frame, so the graphs run left to right
+            float lastFrameMs = frameCount > 0 ? frameMs[(frameCount - 1) % HISTORY] : 0.0f;
+            ImGui::Text("Frame %.2f ms (%.0f fps)", lastFrameMs, lastFrameMs > 0.0f ? 1000.0f / lastFrameMs : 0.0f);
+            ImGui::PlotLines("##frame", frameMs, HISTORY, offset, nullptr, 0.0f, graphScale(frameMs), ImVec2(0.0f, 60.0f));
+            for (const Series& scope : series)
+            {
+                // the "CPU" / "GPU" graphs repeat for every scope, the scope names (unique among the series) keep their IDs apart
+                ImGui::PushID(scope.name);
+                ImGui::Indent(12.0f * (scope.depth + 1));
+                if (scope.gpu)
+                {
+                    ImGui::Text("%s: CPU %.3f ms, GPU %.3f ms", scope.name, scope.lastCpuMs, scope.lastGpuMs);
+                    ImGui::PlotLines("CPU", scope.cpuMs, HISTORY, offset, nullptr, 0.0f, graphScale(scope.cpuMs), ImVec2(0.0f, 30.0f));
+                    ImGui::PlotLines("GPU", scope.gpuMs, HISTORY, offset, nullptr, 0.0f, graphScale(scope.gpuMs), ImVec2(0.0f, 30.0f));
+                }
+                else
+                {
+                    ImGui::Text("%s: CPU %.3f ms", scope.name, scope.lastCpuMs);
+                    ImGui::PlotLines("CPU", scope.cpuMs, HISTORY, offset, nullptr, 0.0f, graphScale(scope.cpuMs), ImVec2(0.0f, 30.0f));
+                }
+                ImGui::Unindent(12.0f * (scope.depth + 1));
+                ImGui::PopID();
+            }
+            ImGui::End();
+        }
+
+        // The kept frames as Chrome trace events (the JSON object format), for chrome://tracing or ui.perfetto.dev.
+        bool exportChromeTrace(const std::string& path) const
+        {
+            std::ofstream file(path);
+            if (!file)
+            {
+                std::cout << "ERROR::PROFILER::TRACE_NOT_WRITTEN: " << path << std::endl;
+                return false;
+            }
+            file << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n";
+            file << "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": 1, \"args\": {\"name\": \"CPU\"}},\n";
+            file << "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": 2, \"args\": {\"name\": \"GPU\"}}";
+
+            unsigned int events = 0;
+            uint64_t first = frameCount > HISTORY ? frameCount - HISTORY : 0;
+            for (uint64_t index = first; index < frameCount; index++)
+            {
+                const Frame& frame = frames[index % HISTORY];
+                writeTraceEvent(file, "frame", 1, frame.startMs, frame.cpuMs);
+                for (const Event& event : frame.events)
+                {
+                    writeTraceEvent(file, event.name, 1, event.startMs, event.cpuMs);
+                    if (event.gpuMs >= 0.0)
+                    {
+                        writeTraceEvent(file, event.name, 2, event.startMs, event.gpuMs);
+                    }
+                }
+                events += (unsigned int)frame.events.size();
+            }
+            file << "\n]}\n";
+            std::cout << "Profiler: " << frameCount - first << " frames, " << events << " scopes written to " << path << std::endl;
+            return true;
+        }
+
+        void release()
+        {
+            for (const InFlight& pending : inFlight)
+            {
+                const Frame& frame = frames[pending.frame % HISTORY];
+                if (frame.index == pending.frame)
+                {
+                    freeQueries.push_back(frame.events[pending.event].query);
+                }
+            }
+            inFlight.clear();
+            if (!freeQueries.empty())
+            {
+                glDeleteQueries((GLsizei)freeQueries.size(), freeQueries.data());
+            }
+            freeQueries.clear();
+        }
+
+    private:
+        struct Frame {
+            uint64_t index = 0;
+            double startMs = 0.0;
+            double cpuMs = 0.0;
+            std::vector<Event> events;
+        };
+
+        // One scope name over the kept frames, its times summed where it ran more than once in a frame.
+        struct Series {
+            const char* name;
+            unsigned int depth;     // where it was first seen
+            bool gpu;
+            float lastCpuMs;
+            float lastGpuMs;
+            float cpuMs[HISTORY];
+            float gpuMs[HISTORY];
+        };
+
+        struct InFlight {
+            uint64_t frame;
+            unsigned int event;
+        };
+
+        double elapsedMs() const
+        {
+            return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - origin).count();
+        }
+
+        Series& findSeries(const Event& event)
+        {
+            for (Series& scope : series)
+            {
+                if (std::strcmp(scope.name, event.name) == 0)
+                {
+                    return scope;
+                }
+            }
+            series.push_back({event.name, event.depth, false, 0.0f, 0.0f, {}, {}});
+            return series.back();
+        }
+
+        void recordCpu(const Frame& frame)
+        {
+            unsigned int slot = frame.index % HISTORY;
+            frameMs[slot] = (float)frame.cpuMs;
+            for (Series& scope : series)
+            {
+                scope.cpuMs[slot] = 0.0f;
+                scope.gpuMs[slot] = 0.0f;
+            }
+            for (const Event& event : frame.events)
+            {
+                Series& scope = findSeries(event);
+                scope.cpuMs[slot] += (float)event.cpuMs;
+                scope.gpu = scope.gpu || event.query != 0;
+            }
+            for (Series& scope : series)
+            {
+                scope.lastCpuMs = scope.cpuMs[slot];
+            }
+        }
+
+        // Read the queries whose results are there, leave the others for a later frame.
+        void resolveQueries()
+        {
+            size_t kept = 0;
+            for (const InFlight& pending : inFlight)
+            {
+                Frame& frame = frames[pending.frame % HISTORY];
+                if (frame.index != pending.frame)
+                {
+                    continue;   // overwritten before the GPU got to it, beginFrame() took the query back
+                }
+                Event& event = frame.events[pending.event];
+                GLint available = 0;
+                glGetQueryObjectiv(event.query, GL_QUERY_RESULT_AVAILABLE, &available);
+                if (!available)
+                {
+                    inFlight[kept++] = pending;
+                    continue;
+                }
+                GLuint64 elapsed = 0;
+                glGetQueryObjectui64v(event.query, GL_QUERY_RESULT, &elapsed);
+                event.gpuMs = elapsed / 1e6;
+                freeQueries.push_back(event.query);
+
+                Series& scope = findSeries(event);
+                scope.gpuMs[pending.frame % HISTORY] += (float)event.gpuMs;
+                scope.lastGpuMs = scope.gpuMs[pending.frame % HISTORY];
+            }
+            inFlight.resize(kept);
+        }
+
+        unsigned int acquireQuery()
+        {
+            if (freeQueries.empty())
+            {
+                unsigned int query;
+                glGenQueries(1, &query);
+                return query;
+            }
+            unsigned int query = freeQueries.back();
+            freeQueries.pop_back();
+            return query;
+        }
+
+        static float graphScale(const float* values)
+        {
+            float highest = *std::max_element(values, values + HISTORY);
+            return std::max(highest * 1.1f, 0.1f);
+        }
+
+        static void writeTraceEvent(std::ofstream& file, const char* name, int track, double startMs, double durationMs)
+        {
+            file << ",\n{\"name\": \"";
+            for (const char* c = name; *c; c++)
+            {
+                if (*c == '"' || *c == '\\')
+                {
+                    file << '\\';
+                }
+                file << *c;
+            }
+            file << "\", \"ph\": \"X\", \"pid\": 1, \"tid\": " << track
+                 << ", \"ts\": " << (uint64_t)(startMs * 1000.0) << ", \"dur\": " << (uint64_t)(durationMs * 1000.0) << "}";
+        }
+
+    private:
+        std::chrono::steady_clock::time_point origin;
+        Frame frames[HISTORY];
+        uint64_t frameCount = 0;    // closed frames
+        bool frameOpen = false;
+        unsigned int depth = 0;
+        int openGpuEvent = -1;
+
+        float frameMs[HISTORY] = {};
+        std::vector<Series> series;
+        std::vector<InFlight> inFlight;
+        std::vector<unsigned int> freeQueries;
+};
+
+inline Profiler profiler;
+
+// Ends the scope it was made in when it goes out of scope, see the PROFILE_ macros.
+class ProfileScope
+{
+    public:
+        ProfileScope(const char* name, bool gpu)
+            : event(profiler.beginScope(name, gpu))
+        {
+        }
+
+        ~ProfileScope()
+        {
+            profiler.endScope(event);
+        }
+
+        ProfileScope(const ProfileScope&) = delete;
+        ProfileScope& operator=(const ProfileScope&) = delete;
+
+    private:
+        int event;
+};
+
+#if PROFILER_ENABLED
+#define PROFILER_CONCAT_INNER(a, b) a##b
+#define PROFILER_CONCAT(a, b) PROFILER_CONCAT_INNER(a, b)
+#define PROFILE_FRAME() profiler.beginFrame()
+#define PROFILE_SCOPE(name) ProfileScope PROFILER_CONCAT(profileScope, __LINE__)(name, false)
+#define PROFILE_GPU_SCOPE(name) ProfileScope PROFILER_CONCAT(profileScope, __LINE__)(name, true)
+#else
+#define PROFILE_FRAME() ((void)0)
+#define PROFILE_SCOPE(name) ((void)0)
+#define PROFILE_GPU_SCOPE(name) ((void)0)
+#endif
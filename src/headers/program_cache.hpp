@@ -0,0 +1,294 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <initializer_list>
+#include <iostream>
+#include <string>
+#include <vector>
+
+/*
+ * Linked programs saved to disk with glGetProgramBinary and loaded back with glProgramBinary on later runs:
+ *
+ *     programCache.enable("shader_cache", (GLADloadproc) glfwGetProcAddress);   // once, after gladLoadGLLoader
+ *     unsigned int program = programCache.build("cube", {vertexSource, fragmentSource}, [&]()
+ *     {
+ *         ... compile, programCache.prepare(program), link, return program ...
+ *     });
+ *     programCache.printReport();                                              // hits against compiles, with timings
+ *
+ * A binary is keyed by a hash of the exact sources handed to glShaderSource and of the GL vendor, renderer and
+ * version strings, so editing a shader or updating the driver simply misses. A binary the driver no longer accepts
+ * (another format, a rebuilt driver with the same version string) fails to link, is deleted and compiled again.
+ * Without enable(), or on a driver with no binary formats, build() always compiles and only the timings are kept.
+ *
+ * Program binaries are GL 4.1 (or ARB_get_program_binary), glad only loads 3.3, so the entry points are loaded here.
+ */
+
+#ifndef GL_PROGRAM_BINARY_RETRIEVABLE_HINT
+#define GL_PROGRAM_BINARY_RETRIEVABLE_HINT 0x8257
+#endif
+#ifndef GL_PROGRAM_BINARY_LENGTH
+#define GL_PROGRAM_BINARY_LENGTH 0x8741
+#endif
+#ifndef GL_NUM_PROGRAM_BINARY_FORMATS
+#define GL_NUM_PROGRAM_BINARY_FORMATS 0x87FE
+#endif
+#ifndef GL_PROGRAM_BINARY_FORMATS
+#define GL_PROGRAM_BINARY_FORMATS 0x87FF
+#endif
+
+typedef void (APIENTRYP GetProgramBinaryProc)(GLuint program, GLsizei bufSize, GLsizei* length, GLenum* binaryFormat, void* binary);
+typedef void (APIENTRYP ProgramBinaryProc)(GLuint program, GLenum binaryFormat, const void* binary, GLsizei length);
+typedef void (APIENTRYP ProgramParameteriProc)(GLuint program, GLenum pname, GLint value);
+
+class ProgramCache
+{
+    public:
+        // Cache binaries under `directory`, false (and compile every time) if the driver can't save programs.
+        bool enable(const std::string& directory, GLADloadproc load)
+        {
+            getProgramBinary = (GetProgramBinaryProc) load("glGetProgramBinary");
+            programBinary = (ProgramBinaryProc) load("glProgramBinary");
+            programParameteri = (ProgramParameteriProc) load("glProgramParameteri");
+
+            GLint formats = 0;
+            if (getProgramBinary && programBinary && programParameteri)
+            {
+                glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+            }
+            if (formats <= 0)
+            {
+                std::cout << "Program cache disabled: the driver has no program binary formats" << std::endl;
+                enabled = false;
+                return false;
+            }
+
+            binaryFormats.resize(formats);
+            glGetIntegerv(GL_PROGRAM_BINARY_FORMATS, binaryFormats.data());
+
+            std::error_code error;
+            std::filesystem::create_directories(directory, error);
+            this->directory = directory;
+            driver = std::string((const char*) glGetString(GL_VENDOR)) + '\n' +
+                (const char*) glGetString(GL_RENDERER) + '\n' + (const char*) glGetString(GL_VERSION);
+            enabled = true;
+            return true;
+        }
+
+        bool isEnabled() const
+        {
+            return enabled;
+        }
+
+        // Ask the driver to keep the binary around, call it on a program before glLinkProgram.
+        void prepare(unsigned int program) const
+        {
+            if (enabled)
+            {
+                programParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+            }
+        }
+
+        // Load the program for `sources` from the cache, or create it with `compileAndLink` and save it.
+        unsigned int build(const std::string& label, std::initializer_list<const char*> sources, const std::function<unsigned int()>& compileAndLink)
+        {
+            unsigned int program = load(label, sources);
+            if (program != 0)
+            {
+                return program;
+            }
+
+            auto start = std::chrono::steady_clock::now();
+            program = compileAndLink();
+            store(label, sources, program, elapsedMilliseconds(start));
+            return program;
+        }
+
+        // The two halves of build(), for callers that compile several programs at once.
+        // The cached program for `sources` (recorded as a hit), or 0 if it has to be compiled.
+        unsigned int load(const std::string& label, std::initializer_list<const char*> sources)
+        {
+            if (!enabled)
+            {
+                return 0;
+            }
+            auto start = std::chrono::steady_clock::now();
+            unsigned int program = readBinary(binaryPath(sources));
+            if (program != 0)
+            {
+                entries.push_back({label, true, elapsedMilliseconds(start)});
+            }
+            return program;
+        }
+
+        // Record a compile that took `compileMilliseconds` and save the program if it linked.
+        void store(const std::string& label, std::initializer_list<const char*> sources, unsigned int program, double compileMilliseconds)
+        {
+            entries.push_back({label, false, compileMilliseconds});
+            if (enabled)
+            {
+                writeBinary(binaryPath(sources), program);
+            }
+        }
+
+        void printReport() const
+        {
+            int hits = 0;
+            double hitMilliseconds = 0.0, compileMilliseconds = 0.0;
+            for (const Entry& entry : entries)
+            {
+                hits += entry.hit ? 1 : 0;
+                (entry.hit ? hitMilliseconds : compileMilliseconds) += entry.milliseconds;
+            }
+
+            std::cout << "Program cache" << (enabled ? " (" + directory + ")" : std::string(" (disabled)")) << ": "
+                      << hits << " hits in " << hitMilliseconds << " ms, "
+                      << entries.size() - hits << " compiles in " << compileMilliseconds << " ms" << std::endl;
+            for (const Entry& entry : entries)
+            {
+                std::cout << "    " << (entry.hit ? "hit     " : "compile ") << entry.milliseconds << " ms  " << entry.label << std::endl;
+            }
+        }
+
+    private:
+        struct Entry {
+            std::string label;
+            bool hit;
+            double milliseconds;
+        };
+
+        struct BinaryHeader {
+            char magic[4];
+            uint32_t format;
+            uint32_t length;
+        };
+
+        // 64 bit FNV-1a of the driver strings and the sources, as 16 hex digits.
+        std::string key(std::initializer_list<const char*> sources) const
+        {
+            uint64_t hash = 14695981039346656037ull;
+            auto add = [&hash](const char* text, size_t length)
+            {
+                for (size_t i = 0; i < length; i++)
+                {
+                    hash = (hash ^ (unsigned char) text[i]) * 1099511628211ull;
+                }
+            };
+            add(driver.data(), driver.size());
+            for (const char* source : sources)
+            {
+                add(source, std::char_traits<char>::length(source) + 1);   // with the terminator, so stages can't run into each other
+            }
+
+            char hex[17];
+            std::snprintf(hex, sizeof(hex), "%016llx", (unsigned long long) hash);
+            return hex;
+        }
+
+        std::string binaryPath(std::initializer_list<const char*> sources) const
+        {
+            return directory + '/' + key(sources) + ".bin";
+        }
+
+        unsigned int readBinary(const std::string& path) const
+        {
+            std::ifstream file(path, std::ios::binary);
+            BinaryHeader header;
+            if (!file.read((char*) &header, sizeof(header)) || std::string(header.magic, 4) != "PRG1")
+            {
+                return 0;
+            }
+            // a corrupted length mustn't turn into a huge allocation, it has to fit in what the file has left
+            std::error_code sizeError;
+            uintmax_t fileSize = std::filesystem::file_size(path, sizeError);
+            if (sizeError || header.length == 0 || header.length > fileSize - sizeof(header))
+            {
+                return 0;
+            }
+            std::vector<char> binary(header.length);
+            if (!file.read(binary.data(), binary.size()))
+            {
+                return 0;
+            }
+            file.close();
+
+            // another driver's format is rejected without asking, glProgramBinary would raise GL_INVALID_ENUM
+            unsigned int program = 0;
+            GLint success = GL_FALSE;
+            if (std::find(binaryFormats.begin(), binaryFormats.end(), (GLint) header.format) != binaryFormats.end())
+            {
+                program = glCreateProgram();
+                programBinary(program, header.format, binary.data(), (GLsizei) binary.size());
+                glGetProgramiv(program, GL_LINK_STATUS, &success);
+            }
+
+            if (!success)
+            {
+                // rejected by this driver, drop it so the recompiled program takes its place
+                if (program != 0)
+                {
+                    glDeleteProgram(program);
+                }
+                std::error_code error;
+                std::filesystem::remove(path, error);
+                return 0;
+            }
+            return program;
+        }
+
+        void writeBinary(const std::string& path, unsigned int program) const
+        {
+            GLint linked = GL_FALSE, length = 0;
+            glGetProgramiv(program, GL_LINK_STATUS, &linked);
+            glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+            if (!linked || length <= 0)
+            {
+                return;
+            }
+
+            std::vector<char> binary(length);
+            GLenum format = 0;
+            getProgramBinary(program, length, &length, &format, binary.data());
+            BinaryHeader header = {{'P', 'R', 'G', '1'}, format, (uint32_t) length};
+
+            // written next to the final name first, so an interrupted run never leaves half a binary behind
+            std::string partialPath = path + ".part";
+            {
+                std::ofstream file(partialPath, std::ios::binary);
+                file.write((const char*) &header, sizeof(header));
+                file.write(binary.data(), length);
+                if (!file)
+                {
+                    std::cout << "WARNING::PROGRAM_CACHE::FAILED_TO_WRITE: " << path << std::endl;
+                    return;
+                }
+            }
+            std::error_code error;
+            std::filesystem::rename(partialPath, path, error);
+        }
+
+        static double elapsedMilliseconds(std::chrono::steady_clock::time_point start)
+        {
+            return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        }
+
+    private:
+        bool enabled = false;
+        std::string directory;
+        std::string driver;
+        std::vector<GLint> binaryFormats;
+        GetProgramBinaryProc getProgramBinary = nullptr;
+        ProgramBinaryProc programBinary = nullptr;
+        ProgramParameteriProc programParameteri = nullptr;
+        std::vector<Entry> entries;
+};
+
+inline ProgramCache programCache;
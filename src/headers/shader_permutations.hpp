@@ -0,0 +1,192 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include "./program_cache.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/*
+ * Variants of one vertex + fragment shader pair, told apart by which of the declared features are switched on:
+ *
+ *     ShaderPermutations cube("cube", vertexSource, fragmentSource, {"AMBIENT", "DIFFUSE", "SPECULAR"});
+ *     cube.precompile({0b001, 0b011, 0b111});        // optional, all compiled side by side at startup
+ *     glUseProgram(cube.get(0b011));                 // AMBIENT and DIFFUSE, compiled here if it wasn't yet
+ *
+ * Bit n of a key switches on features[n], which is passed to both stages as `#define <feature>` right after
+ * the #version line, so the sources select code with #ifdef and each variant only contains what it uses.
+ * Programs go through programCache and belong to this object, so it must go before the GL context does.
+ */
+class ShaderPermutations
+{
+    public:
+        ShaderPermutations(const std::string& name, const char* vertexSource, const char* fragmentSource, const std::vector<std::string>& features)
+            : name(name), vertexSource(vertexSource), fragmentSource(fragmentSource), features(features)
+        {
+        }
+
+        ~ShaderPermutations()
+        {
+            for (auto& [key, variant] : variants)
+            {
+                finish(variant);
+                glDeleteProgram(variant.program);
+            }
+        }
+
+        ShaderPermutations(const ShaderPermutations&) = delete;
+        ShaderPermutations& operator=(const ShaderPermutations&) = delete;
+
+        // Compile every variant in `keys` that isn't built yet. All compiles are queued before any result is asked for,
+        // so a driver that compiles in parallel (see enableParallelShaderCompile) works on all of them at once.
+        void precompile(const std::vector<uint32_t>& keys)
+        {
+            for (uint32_t key : keys)
+            {
+                if (variants.count(key) == 0)
+                {
+                    start(key);
+                }
+            }
+            for (uint32_t key : keys)
+            {
+                finish(variants[key]);
+            }
+        }
+
+        // The program for `key`, compiled on first use unless precompile() already did.
+        unsigned int get(uint32_t key)
+        {
+            auto variant = variants.find(key);
+            if (variant == variants.end())
+            {
+                variant = variants.find(start(key));
+            }
+            finish(variant->second);
+            return variant->second.program;
+        }
+
+        // The source handed to GL for `key`: the defines of the switched on features after the #version line.
+        std::string preprocess(const std::string& source, uint32_t key) const
+        {
+            std::string defines;
+            for (size_t feature = 0; feature < features.size(); feature++)
+            {
+                if (key & (1u << feature))
+                {
+                    defines += "#define " + features[feature] + "\n";
+                }
+            }
+
+            size_t version = source.find("#version");
+            size_t afterVersion = version == std::string::npos ? 0 : source.find('\n', version);
+            afterVersion = afterVersion == std::string::npos ? source.size() : afterVersion + 1;
+            return source.substr(0, afterVersion) + defines + source.substr(afterVersion);
+        }
+
+        // "name [FEATURE FEATURE]", as the variant shows up in the program cache report.
+        std::string label(uint32_t key) const
+        {
+            if (key == 0)
+            {
+                return name;
+            }
+            std::string label = name + " [";
+            for (size_t feature = 0; feature < features.size(); feature++)
+            {
+                if (key & (1u << feature))
+                {
+                    label += (label.back() == '[' ? "" : " ") + features[feature];
+                }
+            }
+            return label + "]";
+        }
+
+    private:
+        struct Variant {
+            std::string label;
+            std::string vertexCode;
+            std::string fragmentCode;
+            unsigned int program = 0;
+            unsigned int vertex = 0;
+            unsigned int fragment = 0;
+            bool compiling = false;
+            std::chrono::steady_clock::time_point compileStart;
+        };
+
+        // Take the variant from the program cache, or queue its compile and link without waiting for them.
+        uint32_t start(uint32_t key)
+        {
+            Variant& variant = variants[key];
+            variant.label = label(key);
+            variant.vertexCode = preprocess(vertexSource, key);
+            variant.fragmentCode = preprocess(fragmentSource, key);
+            variant.program = programCache.load(variant.label, {variant.vertexCode.c_str(), variant.fragmentCode.c_str()});
+            if (variant.program != 0)
+            {
+                return key;
+            }
+
+            variant.compileStart = std::chrono::steady_clock::now();
+            const char* vertexCode = variant.vertexCode.c_str();
+            const char* fragmentCode = variant.fragmentCode.c_str();
+            variant.vertex = glCreateShader(GL_VERTEX_SHADER);
+            glShaderSource(variant.vertex, 1, &vertexCode, NULL);
+            glCompileShader(variant.vertex);
+            variant.fragment = glCreateShader(GL_FRAGMENT_SHADER);
+            glShaderSource(variant.fragment, 1, &fragmentCode, NULL);
+            glCompileShader(variant.fragment);
+
+            variant.program = glCreateProgram();
+            glAttachShader(variant.program, variant.vertex);
+            glAttachShader(variant.program, variant.fragment);
+            programCache.prepare(variant.program);
+            glLinkProgram(variant.program);
+            variant.compiling = true;
+            return key;
+        }
+
+        // Wait for a queued compile, report its errors and save it to the program cache.
+        void finish(Variant& variant)
+        {
+            if (!variant.compiling)
+            {
+                return;
+            }
+            variant.compiling = false;
+
+            GLint success;
+            char infoLog[1024];
+            for (unsigned int shader : {variant.vertex, variant.fragment})
+            {
+                glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+                if (!success)
+                {
+                    glGetShaderInfoLog(shader, 1024, NULL, infoLog);
+                    std::cout << "ERROR::SHADER_PERMUTATION::COMPILATION_FAILED: " << variant.label << "\n" << infoLog << std::endl;
+                }
+                glDeleteShader(shader);
+            }
+            glGetProgramiv(variant.program, GL_LINK_STATUS, &success);
+            if (!success)
+            {
+                glGetProgramInfoLog(variant.program, 1024, NULL, infoLog);
+                std::cout << "ERROR::SHADER_PERMUTATION::LINKING_FAILED: " << variant.label << "\n" << infoLog << std::endl;
+            }
+
+            double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - variant.compileStart).count();
+            programCache.store(variant.label, {variant.vertexCode.c_str(), variant.fragmentCode.c_str()}, variant.program, milliseconds);
+        }
+
+    private:
+        std::string name;
+        std::string vertexSource;
+        std::string fragmentSource;
+        std::vector<std::string> features;
+        std::unordered_map<uint32_t, Variant> variants;
+};
@@ -0,0 +1,273 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "./file_watcher.hpp"
+#include "./parallel_shader_compile.hpp"
+
+/*
+ * The part of a vertex + fragment Shader that survives its program being rebuilt: the file paths, a reload that is
+ * still compiling, the cached uniform locations and the uniform block bindings. The demos' Shader classes keep one
+ * next to their program ID:
+ *
+ *     Shader::Shader(const char* vertexPath, const char* fragmentPath) : reloader(vertexPath, fragmentPath)
+ *     GLint Shader::getUniformLocation(const std::string& name) const { return reloader.getUniformLocation(ID, name); }
+ *
+ * reload() only queues the compile and link, poll() swaps the new program into `program` once it is done. A reload
+ * that fails prints the logs and keeps the program that was there; one that succeeds drops the cached locations
+ * and applies the block bindings again.
+ */
+class ShaderReloader
+{
+    public:
+        ShaderReloader(const std::string& vertexPath, const std::string& fragmentPath)
+            : vertexPath(vertexPath), fragmentPath(fragmentPath) {}
+
+        bool readSources(std::string& vertexCode, std::string& fragmentCode) const
+        {
+            std::ifstream vShaderFile;
+            std::ifstream fShaderFile;
+            // ensure ifstream objects can throw exceptions:
+            vShaderFile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
+            fShaderFile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
+            try
+            {
+                vShaderFile.open(vertexPath);
+                fShaderFile.open(fragmentPath);
+                std::stringstream vShaderStream, fShaderStream;
+                vShaderStream << vShaderFile.rdbuf();
+                fShaderStream << fShaderFile.rdbuf();
+                vertexCode = vShaderStream.str();
+                fragmentCode = fShaderStream.str();
+            }
+            catch (std::ifstream::failure& e)
+            {
+                std::cout << "ERROR::SHADER::FILE_NOT_SUCCESSFULLY_READ: " << e.what() << std::endl;
+                return false;
+            }
+            return true;
+        }
+
+        // The compile and link calls only queue the work when the driver compiles in parallel, nothing here waits for them.
+        void reload()
+        {
+            std::string vertexCode;
+            std::string fragmentCode;
+            if (!readSources(vertexCode, fragmentCode))
+            {
+                return;
+            }
+
+            // a newer edit replaces a reload that is still compiling
+            if (pendingProgram != 0)
+            {
+                glDeleteProgram(pendingProgram);
+                glDeleteShader(pendingVertex);
+                glDeleteShader(pendingFragment);
+            }
+
+            const char* vShaderCode = vertexCode.c_str();
+            const char* fShaderCode = fragmentCode.c_str();
+            pendingVertex = glCreateShader(GL_VERTEX_SHADER);
+            glShaderSource(pendingVertex, 1, &vShaderCode, NULL);
+            glCompileShader(pendingVertex);
+            pendingFragment = glCreateShader(GL_FRAGMENT_SHADER);
+            glShaderSource(pendingFragment, 1, &fShaderCode, NULL);
+            glCompileShader(pendingFragment);
+
+            pendingProgram = glCreateProgram();
+            glAttachShader(pendingProgram, pendingVertex);
+            glAttachShader(pendingProgram, pendingFragment);
+            glLinkProgram(pendingProgram);
+        }
+
+        // Swap a finished reload into `program`, true if it changed. Without parallel compile the first poll waits for it.
+        bool poll(bool parallelCompile, unsigned int& program)
+        {
+            if (pendingProgram == 0)
+            {
+                return false;
+            }
+            if (parallelCompile)
+            {
+                GLint completed = GL_FALSE;
+                glGetProgramiv(pendingProgram, GL_COMPLETION_STATUS_KHR, &completed);
+                if (!completed)
+                {
+                    return false;
+                }
+            }
+
+            GLint linked = GL_FALSE;
+            glGetProgramiv(pendingProgram, GL_LINK_STATUS, &linked);
+            if (linked)
+            {
+                // the old program is only freed once it is no longer bound, the next use() binds the new one
+                glDeleteProgram(program);
+                program = pendingProgram;
+                uniformLocations.clear();
+                for (const auto& [name, binding] : blockBindings)
+                {
+                    setUniformBlockBinding(program, name, binding);
+                }
+                std::cout << "Reloaded shader: " << vertexPath << " + " << fragmentPath << std::endl;
+            }
+            else
+            {
+                std::cout << "ERROR::SHADER::RELOAD_FAILED, keeping the previous program: " << vertexPath << " + " << fragmentPath << std::endl;
+                printLog(pendingVertex, "VERTEX");
+                printLog(pendingFragment, "FRAGMENT");
+                printLog(pendingProgram, "PROGRAM");
+                glDeleteProgram(pendingProgram);
+            }
+
+            glDeleteShader(pendingVertex);
+            glDeleteShader(pendingFragment);
+            pendingProgram = pendingVertex = pendingFragment = 0;
+            return linked;
+        }
+
+        bool isReloading() const
+        {
+            return pendingProgram != 0;
+        }
+
+        const std::string& getVertexPath() const
+        {
+            return vertexPath;
+        }
+
+        const std::string& getFragmentPath() const
+        {
+            return fragmentPath;
+        }
+
+        GLint getUniformLocation(unsigned int program, const std::string& name) const
+        {
+            auto cached = uniformLocations.find(name);
+            if (cached != uniformLocations.end())
+            {
+                return cached->second;
+            }
+            GLint location = glGetUniformLocation(program, name.c_str());
+            uniformLocations[name] = location;
+            return location;
+        }
+
+        void setUniformBlockBinding(unsigned int program, const std::string& name, unsigned int binding)
+        {
+            blockBindings[name] = binding;
+            unsigned int index = glGetUniformBlockIndex(program, name.c_str());
+            if (index != GL_INVALID_INDEX)
+            {
+                glUniformBlockBinding(program, index, binding);
+            }
+        }
+
+    private:
+        static void printLog(GLuint object, const std::string& type)
+        {
+            GLint success;
+            GLchar infoLog[1024];
+            if (type != "PROGRAM")
+            {
+                glGetShaderiv(object, GL_COMPILE_STATUS, &success);
+                if (!success)
+                {
+                    glGetShaderInfoLog(object, 1024, NULL, infoLog);
+                    std::cout << "ERROR::SHADER_COMPILATION_ERROR of type: " << type << "\n" << infoLog << "\n -- --------------------------------------------------- -- " << std::endl;
+                }
+            }
+            else
+            {
+                glGetProgramiv(object, GL_LINK_STATUS, &success);
+                if (!success)
+                {
+                    glGetProgramInfoLog(object, 1024, NULL, infoLog);
+                    std::cout << "ERROR::PROGRAM_LINKING_ERROR of type: " << type << "\n" << infoLog << "\n -- --------------------------------------------------- -- " << std::endl;
+                }
+            }
+        }
+
+    private:
+        std::string vertexPath;
+        std::string fragmentPath;
+        unsigned int pendingProgram = 0;
+        unsigned int pendingVertex = 0;
+        unsigned int pendingFragment = 0;
+        mutable std::unordered_map<std::string, GLint> uniformLocations;
+        std::unordered_map<std::string, unsigned int> blockBindings;
+};
+
+/*
+ * Reloads shaders whose files change on disk, call update() once a frame:
+ *
+ *     ShaderWatcher shaderWatcher((GLADloadproc) glfwGetProcAddress);
+ *     shaderWatcher.add(rockShader);       // any Shader with an `ID` and a `reloader`
+ *     ...
+ *     shaderWatcher.update();
+ *
+ * Where GL_KHR_parallel_shader_compile (or the ARB version) is available the driver compiles on its own threads
+ * and update() only polls GL_COMPLETION_STATUS, so editing a shader never stalls the frame loop.
+ * The shaders have to outlive the watcher.
+ */
+class ShaderWatcher
+{
+    public:
+        ShaderWatcher(GLADloadproc load)
+        {
+            // completion is polled in ShaderReloader::poll, so the compile never blocks a frame
+            parallelCompile = enableParallelShaderCompile(load);
+            std::cout << "Shader hot reload: watching for changes, parallel compile " << (parallelCompile ? "on" : "unavailable") << std::endl;
+        }
+
+        template <typename ShaderType>
+        void add(ShaderType& shader)
+        {
+            add(shader.reloader, shader.ID);
+        }
+
+        void add(ShaderReloader& reloader, unsigned int& program)
+        {
+            shaders.push_back({&reloader, &program});
+            files.watch(reloader.getVertexPath());
+            files.watch(reloader.getFragmentPath());
+        }
+
+        void update()
+        {
+            for (const std::string& path : files.poll())
+            {
+                for (auto& [reloader, program] : shaders)
+                {
+                    if (reloader->getVertexPath() == path || reloader->getFragmentPath() == path)
+                    {
+                        reloader->reload();
+                    }
+                }
+            }
+
+            for (auto& [reloader, program] : shaders)
+            {
+                reloader->poll(parallelCompile, *program);
+            }
+        }
+
+        bool hasParallelCompile() const
+        {
+            return parallelCompile;
+        }
+
+    private:
+        FileWatcher files;
+        std::vector<std::pair<ShaderReloader*, unsigned int*>> shaders;
+        bool parallelCompile = false;
+};
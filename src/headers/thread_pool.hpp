@@ -0,0 +1,144 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+/*
+ * A fixed set of worker threads pulling jobs from a shared queue, shared by the terrain, asteroid field and
+ * many lights demos:
+ *
+ *     ThreadPool pool;
+ *     pool.parallelFor(rocks.size(), 4096, [&](size_t begin, size_t end) { ... });
+ *     pool.submit([]() { ... });
+ *
+ * `submit` is fire-and-forget, `parallelFor` splits a range into batches, runs them on the workers
+ * (and the calling thread) and only returns once every batch has completed.
+ */
+class ThreadPool
+{
+    public:
+        ThreadPool(unsigned int threadCount = std::thread::hardware_concurrency())
+        {
+            threadCount = std::max(1u, threadCount);
+            for (unsigned int i = 0; i < threadCount; i++)
+            {
+                workers.emplace_back(&ThreadPool::workerLoop, this);
+            }
+        }
+
+        ~ThreadPool()
+        {
+            {
+                std::lock_guard<std::mutex> lock(jobsMutex);
+                stopping = true;
+            }
+            jobsAvailable.notify_all();
+            for (std::thread& worker : workers)
+            {
+                worker.join();
+            }
+        }
+
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+
+        void submit(std::function<void()> job)
+        {
+            {
+                std::lock_guard<std::mutex> lock(jobsMutex);
+                jobs.push(std::move(job));
+            }
+            jobsAvailable.notify_one();
+        }
+
+        /*
+         * Batches are claimed through an atomic counter rather than queued one by one,
+         * so uneven batches balance out and the calling thread helps instead of sitting idle.
+         * The counters live in a shared block: a helper that only gets scheduled after the loop has finished
+         * finds no batches left and never touches `body` or this stack frame.
+         */
+        void parallelFor(size_t count, size_t batchSize, const std::function<void(size_t begin, size_t end)>& body)
+        {
+            if (count == 0)
+            {
+                return;
+            }
+
+            struct LoopState {
+                std::atomic<size_t> nextBatch = 0;
+                std::atomic<size_t> batchesDone = 0;
+                size_t batchCount = 0;
+                std::mutex doneMutex;
+                std::condition_variable allDone;
+            };
+
+            batchSize = std::max<size_t>(1, batchSize);
+            auto state = std::make_shared<LoopState>();
+            state->batchCount = (count + batchSize - 1) / batchSize;
+            const std::function<void(size_t, size_t)>* loopBody = &body;
+
+            auto runBatches = [state, loopBody, batchSize, count]()
+            {
+                size_t batch;
+                while ((batch = state->nextBatch.fetch_add(1)) < state->batchCount)
+                {
+                    size_t begin = batch * batchSize;
+                    (*loopBody)(begin, std::min(begin + batchSize, count));
+                    if (state->batchesDone.fetch_add(1) + 1 == state->batchCount)
+                    {
+                        std::lock_guard<std::mutex> lock(state->doneMutex);
+                        state->allDone.notify_all();
+                    }
+                }
+            };
+
+            size_t helpers = std::min<size_t>(workers.size(), state->batchCount - 1);
+            for (size_t i = 0; i < helpers; i++)
+            {
+                submit(runBatches);
+            }
+            runBatches();
+
+            std::unique_lock<std::mutex> lock(state->doneMutex);
+            state->allDone.wait(lock, [&]() { return state->batchesDone.load() == state->batchCount; });
+        }
+
+        unsigned int size() const
+        {
+            return workers.size();
+        }
+
+    private:
+        void workerLoop()
+        {
+            while (true)
+            {
+                std::function<void()> job;
+                {
+                    std::unique_lock<std::mutex> lock(jobsMutex);
+                    jobsAvailable.wait(lock, [this]() { return stopping || !jobs.empty(); });
+                    if (stopping && jobs.empty())
+                    {
+                        return;
+                    }
+                    job = std::move(jobs.front());
+                    jobs.pop();
+                }
+                job();
+            }
+        }
+
+    private:
+        std::vector<std::thread> workers;
+        std::queue<std::function<void()>> jobs;
+        std::mutex jobsMutex;
+        std::condition_variable jobsAvailable;
+        bool stopping = false;
+};